@@ -0,0 +1,26 @@
+#ifndef _SDL2X11_EMULATION_H_
+#define _SDL2X11_EMULATION_H_
+
+/*
+ * Functions of the emulation that are not part of Xlib.
+ * Programs that also build against a real Xlib have to guard their use.
+ */
+
+#include <X11/Xlib.h>
+
+_XFUNCPROTOBEGIN
+
+/*
+ * Returns True if the emulation runs headless: it was opened with SDL2X11_HEADLESS=1,
+ * uses an offscreen SDL video driver and keeps all windows in memory.
+ */
+extern Bool SDL2X11IsHeadless(void);
+/*
+ * Write the content of the window or pixmap, including its mapped child windows,
+ * to a binary PPM file. Returns 0 on failure.
+ */
+extern Status SDL2X11WriteSnapshot(Display* display, Drawable drawable, _Xconst char* fileName);
+
+_XFUNCPROTOEND
+
+#endif /* _SDL2X11_EMULATION_H_ */
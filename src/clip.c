@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include "clip.h"
+#include "drawing.h"
+#include "pixmanBackend.h"
+#include "rendererState.h"
+#include "statistics.h"
+
+/*
+ * SDL renderers can't use a texture as a mask operand, so for the SDL renderer backend clip masks
+ * are converted into regions once and cached until their pixmap changes. Clipping with a mask then
+ * works like clipping with rectangles.
+ */
+typedef struct ClipMask {
+    Pixmap pixmap;
+    unsigned long serial;
+    pixman_region16_t region;
+    struct ClipMask* next;
+} ClipMask;
+
+static ClipMask* clipMasks = NULL;
+
+void freeClipMaskOfPixmap(Pixmap pixmap) {
+    ClipMask** maskPointer = &clipMasks;
+    while (*maskPointer != NULL) {
+        ClipMask* mask = *maskPointer;
+        if (mask->pixmap == pixmap) {
+            *maskPointer = mask->next;
+            pixman_region_fini(&mask->region);
+            free(mask);
+            return;
+        }
+        maskPointer = &mask->next;
+    }
+}
+
+/* Add a box for every run of set pixels in the rows of the mask. Every pixel that is not 0 is set. */
+static Bool convertClipMask(PixmapStruct* pixmapStruct, pixman_region16_t* region) {
+    int width = (int) pixmapStruct->width, height = (int) pixmapStruct->height;
+    Uint32* pixels;
+    int stride;
+    Uint32 setBits;
+    if (pixmapStruct->image != NULL) {
+        pixels = pixman_image_get_data(pixmapStruct->image);
+        stride = pixman_image_get_stride(pixmapStruct->image) / (int) sizeof(uint32_t);
+        setBits = 0x00FFFFFF;
+    } else {
+        pixels = readPixmapPixels(pixmapStruct);
+        if (pixels == NULL) { return False; }
+        stride = width;
+        setBits = 0xFFFFFFFF;
+    }
+    pixman_box16_t* boxes = NULL;
+    int numBoxes = 0, capacity = 0, x, y;
+    Bool success = True;
+    for (y = 0; y < height && success; y++) {
+        Uint32* row = &pixels[y * stride];
+        for (x = 0; x < width; x++) {
+            if (!(row[x] & setBits)) { continue; }
+            int start = x;
+            while (x < width && (row[x] & setBits)) { x++; }
+            if (numBoxes == capacity) {
+                capacity = capacity == 0 ? 64 : capacity * 2;
+                pixman_box16_t* newBoxes = realloc(boxes, sizeof(pixman_box16_t) * capacity);
+                if (newBoxes == NULL) {
+                    success = False;
+                    break;
+                }
+                boxes = newBoxes;
+            }
+            pixman_box16_t* box = &boxes[numBoxes++];
+            box->x1 = (int16_t) start;
+            box->y1 = (int16_t) y;
+            box->x2 = (int16_t) x;
+            box->y2 = (int16_t) (y + 1);
+        }
+    }
+    if (pixmapStruct->image == NULL) {
+        free(pixels);
+    }
+    // Runs of equal rows are coalesced into a single band.
+    success = success && pixman_region_init_rects(region, boxes, numBoxes);
+    free(boxes);
+    return success;
+}
+
+pixman_region16_t* getClipMaskRegion(Pixmap pixmap) {
+    unsigned long serial = GET_PIXMAP_STRUCT(pixmap)->serial;
+    ClipMask* mask;
+    for (mask = clipMasks; mask != NULL; mask = mask->next) {
+        if (mask->pixmap == pixmap) {
+            if (mask->serial == serial) { return &mask->region; }
+            break;
+        }
+    }
+    if (mask == NULL) {
+        mask = malloc(sizeof(ClipMask));
+        if (mask == NULL) { return NULL; }
+        mask->pixmap = pixmap;
+        mask->next = clipMasks;
+        clipMasks = mask;
+    } else {
+        pixman_region_fini(&mask->region);
+    }
+    mask->serial = serial;
+    if (!convertClipMask(GET_PIXMAP_STRUCT(pixmap), &mask->region)) {
+        LOG("Failed to convert the clip mask in %s\n", __func__);
+        pixman_region_init(&mask->region);
+        freeClipMaskOfPixmap(pixmap);
+        return NULL;
+    }
+    return &mask->region;
+}
+
+Bool initClipIterator(ClipIterator* clip, Drawable drawable, GraphicContext* gContext, const SDL_Rect* area) {
+    SDL_Rect drawableRect = {0, 0, 0, 0};
+    getDrawableSize(drawable, &drawableRect.w, &drawableRect.h);
+    clip->boxes = NULL;
+    clip->numBoxes = 0;
+    clip->next = 0;
+    clip->originX = clip->originY = 0;
+    clip->mask = None;
+    clip->renderer = NULL;
+    Bool visible;
+    if (area == NULL) {
+        clip->bounds = drawableRect;
+        visible = !SDL_RectEmpty(&drawableRect);
+    } else {
+        visible = SDL_IntersectRect(area, &drawableRect, &clip->bounds);
+    }
+    pixman_region16_t* region = NULL;
+    if (visible && gContext != NULL) {
+        if (gContext->hasClipRegion) {
+            region = &gContext->clipRegion;
+        } else if (gContext->clipMask != None && pixmanBackendEnabled) {
+            // Only the extents of the mask are clipped here, the operation is composited through it.
+            PixmapStruct* maskStruct = GET_PIXMAP_STRUCT(gContext->clipMask);
+            SDL_Rect maskRect = {gContext->clipOriginX, gContext->clipOriginY,
+                                 (int) maskStruct->width, (int) maskStruct->height};
+            visible = SDL_IntersectRect(&clip->bounds, &maskRect, &clip->bounds);
+            clip->mask = gContext->clipMask;
+            clip->originX = gContext->clipOriginX;
+            clip->originY = gContext->clipOriginY;
+        } else if (gContext->clipMask != None) {
+            // If the mask can't be converted, the operation is drawn unclipped.
+            region = getClipMaskRegion(gContext->clipMask);
+        }
+    }
+    if (region != NULL) {
+        clip->originX = gContext->clipOriginX;
+        clip->originY = gContext->clipOriginY;
+        // An empty clip region has empty extents and clips everything.
+        pixman_box16_t* extents = pixman_region_extents(region);
+        SDL_Rect clipExtents = {extents->x1 + clip->originX, extents->y1 + clip->originY,
+                                extents->x2 - extents->x1, extents->y2 - extents->y1};
+        visible = SDL_IntersectRect(&clip->bounds, &clipExtents, &clip->bounds);
+        clip->boxes = pixman_region_rectangles(region, &clip->numBoxes);
+    }
+    if (!visible) {
+        clip->bounds.w = clip->bounds.h = 0;
+        clip->numBoxes = 0;
+        statistics.clippedOperations++;
+    }
+    return visible;
+}
+
+Bool nextClipRect(ClipIterator* clip, SDL_Renderer* renderer) {
+    if (clip->boxes == NULL) {
+        // Without a clip region the bounds are visited once, the renderer clips to its viewport.
+        if (clip->next++ > 0 || SDL_RectEmpty(&clip->bounds)) { return False; }
+        clip->rect = clip->bounds;
+        return True;
+    }
+    while (clip->next < clip->numBoxes) {
+        const pixman_box16_t* box = &clip->boxes[clip->next++];
+        SDL_Rect boxRect = {box->x1 + clip->originX, box->y1 + clip->originY, box->x2 - box->x1, box->y2 - box->y1};
+        // The boxes are sorted by their top edge.
+        if (boxRect.y >= clip->bounds.y + clip->bounds.h) { break; }
+        if (!SDL_IntersectRect(&boxRect, &clip->bounds, &clip->rect)) { continue; }
+        // A box that covers the whole operation is the only one that overlaps it.
+        if (renderer != NULL && !SDL_RectEquals(&clip->rect, &clip->bounds)) {
+            setRenderClipRect(renderer, &clip->rect);
+            clip->renderer = renderer;
+        }
+        return True;
+    }
+    clip->next = clip->numBoxes;
+    if (clip->renderer != NULL) {
+        setRenderClipRect(clip->renderer, NULL);
+        clip->renderer = NULL;
+    }
+    return False;
+}
@@ -0,0 +1,46 @@
+#ifndef _CLIP_H_
+#define _CLIP_H_
+
+#include <SDL2/SDL.h>
+#include <pixman.h>
+#include "X11/Xlib.h"
+#include "gc.h"
+
+/*
+ * Walks the rectangles of the clip region or clip mask of a graphic context that overlap a drawing
+ * operation, in drawable coordinates. Without a clip the area of the operation is visited once.
+ * When a renderer is given, its clip rect is set to each rectangle and reset after the last one,
+ * so the operation can be issued once per rectangle. A single rectangle that covers the whole
+ * operation doesn't need the renderer to clip at all. The pixman backend doesn't walk a clip mask,
+ * it only limits the bounds and the operation is composited through the mask instead.
+ */
+typedef struct ClipIterator {
+    /* The part of the drawable the operation can change. Empty if it is clipped away. */
+    SDL_Rect bounds;
+    /* The current clip rectangle, it lies inside of the bounds. */
+    SDL_Rect rect;
+    const pixman_box16_t* boxes;
+    int numBoxes;
+    int next;
+    int originX, originY;
+    /* The clip mask that the pixman backend composites the operation through, or None. */
+    Pixmap mask;
+    /* The renderer whose clip rect is set. */
+    SDL_Renderer* renderer;
+} ClipIterator;
+
+/*
+ * Start clipping an operation that changes the area (NULL for the whole drawable).
+ * The graphic context may be NULL. Returns False if nothing of the operation is visible.
+ */
+Bool initClipIterator(ClipIterator* clip, Drawable drawable, GraphicContext* gContext, const SDL_Rect* area);
+/* Advance to the next clip rectangle. The renderer may be NULL to clip geometrically. */
+Bool nextClipRect(ClipIterator* clip, SDL_Renderer* renderer);
+/*
+ * Get the region of the pixels that are set in the clip mask pixmap, or NULL on failure.
+ * Only the SDL renderer backend clips with it.
+ */
+pixman_region16_t* getClipMaskRegion(Pixmap pixmap);
+void freeClipMaskOfPixmap(Pixmap pixmap);
+
+#endif /* _CLIP_H_ */
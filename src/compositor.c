@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <string.h>
+#include "compositor.h"
+#include "pixmanBackend.h"
+#include "statistics.h"
+#include "util.h"
+
+Bool compositorEnabled = False;
+
+void initCompositor() {
+    const char* compositor = getenv("SDL2X11_COMPOSITOR");
+    compositorEnabled = compositor != NULL && compositor[0] != '\0' && strcmp(compositor, "0") != 0;
+    if (compositorEnabled && !pixmanBackendEnabled) {
+        LOG("The compositor needs the pixman backend, set SDL2X11_BACKEND=pixman to use it\n");
+        compositorEnabled = False;
+    }
+    LOG("The compositor is %s\n", compositorEnabled ? "enabled" : "disabled");
+}
+
+Window getCompositedArea(Window window, SDL_Rect* area) {
+    while (!IS_TOP_LEVEL(window)) {
+        WindowStruct* windowStruct = GET_WINDOW_STRUCT(window);
+        if (window == SCREEN_WINDOW || windowStruct->mapState != Mapped) { return None; }
+        area->x += windowStruct->x;
+        area->y += windowStruct->y;
+        window = windowStruct->parent;
+        SDL_Rect parentRect = {0, 0, 0, 0};
+        GET_WINDOW_DIMS(window, parentRect.w, parentRect.h);
+        if (!SDL_IntersectRect(area, &parentRect, area)) { return None; }
+    }
+    return window;
+}
+
+/*
+ * Copy the part of the window inside of the clip rectangle into the frame, followed by its mapped
+ * children. The window is at the given position in the frame. Returns the number of pixels copied.
+ */
+static unsigned long compositeWindowTree(WindowStruct* windowStruct, pixman_image_t* frame, int x, int y,
+                                         const SDL_Rect* clip) {
+    SDL_Rect windowRect = {x, y, (int) windowStruct->w, (int) windowStruct->h};
+    if (!SDL_IntersectRect(&windowRect, clip, &windowRect)) { return 0; }
+    unsigned long pixels = 0;
+    if (windowStruct->backingImage != NULL) {
+        pixman_image_composite32(PIXMAN_OP_SRC, windowStruct->backingImage, NULL, frame,
+                                 windowRect.x - x, windowRect.y - y, 0, 0, windowRect.x, windowRect.y,
+                                 windowRect.w, windowRect.h);
+        pixels = (unsigned long) windowRect.w * windowRect.h;
+    }
+    // The children are stored from the bottom to the top of the stack.
+    Window* children = (Window*) windowStruct->children.array;
+    size_t i;
+    for (i = 0; i < windowStruct->children.length; i++) {
+        WindowStruct* child = GET_WINDOW_STRUCT(children[i]);
+        if (child->mapState == Mapped && !child->inputOnly) {
+            pixels += compositeWindowTree(child, frame, x + child->x, y + child->y, &windowRect);
+        }
+    }
+    return pixels;
+}
+
+pixman_image_t* compositeWindowFrame(WindowStruct* windowStruct, const SDL_Rect* rects, int numRects) {
+    pixman_image_t* frame = windowStruct->frameImage;
+    if (frame == NULL || pixman_image_get_width(frame) != (int) windowStruct->w
+        || pixman_image_get_height(frame) != (int) windowStruct->h) {
+        // The frame doesn't need the old content, every presented rectangle is recomposited.
+        if (frame != NULL) { pixman_image_unref(frame); }
+        frame = windowStruct->frameImage = createBackingImage(windowStruct->w, windowStruct->h);
+        if (frame == NULL) {
+            LOG("Failed to create the frame image in %s\n", __func__);
+            return NULL;
+        }
+    }
+    unsigned long pixels = 0;
+    int i;
+    for (i = 0; i < numRects; i++) {
+        // The top level window is at the origin of its frame.
+        pixels += compositeWindowTree(windowStruct, frame, 0, 0, &rects[i]);
+    }
+    recordCompositedPixels(pixels);
+    return frame;
+}
@@ -0,0 +1,29 @@
+#ifndef _COMPOSITOR_H_
+#define _COMPOSITOR_H_
+
+#include <SDL2/SDL.h>
+#include <pixman.h>
+#include "X11/Xlib.h"
+#include "window.h"
+
+/*
+ * The compositor keeps a retained backing image for every window instead of merging mapped
+ * child windows into the image of their top level window. Drawing only changes the image of
+ * the window, the damaged parts of a top level window are recomposited from the images of
+ * its window tree in stacking order when they are presented. Mapping, unmapping, moving and
+ * restacking a child window only damages its old and new area, the client doesn't redraw anything.
+ * It is enabled by setting SDL2X11_COMPOSITOR=1 together with the pixman backend.
+ */
+extern Bool compositorEnabled;
+
+void initCompositor(void);
+/*
+ * Translate the area of the window into the coordinates of its top level window,
+ * clipped to the window and all of its ancestors.
+ * Returns the top level window or None if nothing of the area is viewable.
+ */
+Window getCompositedArea(Window window, SDL_Rect* area);
+/* Recomposite the rectangles of the top level window and return the image holding its frame. */
+pixman_image_t* compositeWindowFrame(WindowStruct* windowStruct, const SDL_Rect* rects, int numRects);
+
+#endif /* _COMPOSITOR_H_ */
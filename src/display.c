@@ -9,6 +9,12 @@
 #include "events.h"
 #include "colors.h"
 #include "drawing.h"
+#include "glyphAtlas.h"
+#include "texturePool.h"
+#include "statistics.h"
+#include "pixmanBackend.h"
+#include "compositor.h"
+#include "headless.h"
 #include "display.h"
 #include "atoms.h"
 #include "visual.h"
@@ -38,6 +44,7 @@ static const int releaseVersion = 1;
 int XCloseDisplay(Display* display) {
     // https://tronche.com/gui/x/xlib/display/XCloseDisplay.html
     if (numDisplaysOpen == 1) {
+        printStatistics();
         freeAtomStorage();
         freeFontStorage();
         TTF_Quit();
@@ -72,8 +79,7 @@ Display* XOpenDisplay(_Xconst char* display_name) {
     }
     if (!SDL_WasInit(SDL_INIT_VIDEO)) {
         SDL_SetMainReady();
-        if (SDL_Init(SDL_INIT_VIDEO) == -1) {
-            LOG("Failed to initialize SDL: %s\n", SDL_GetError());
+        if (!initVideo()) {
             free(display);
             return NULL;
         }
@@ -91,6 +97,13 @@ Display* XOpenDisplay(_Xconst char* display_name) {
              free(display);
              return NULL;
          }
+         initPresentMode();
+         initRenderBackend();
+         initCompositor();
+         initGlyphAtlas();
+         initTexturePool();
+         initRendererState();
+         initStatistics();
     }
     numDisplaysOpen++;
 
@@ -8,17 +8,163 @@
 #include "gc.h"
 #include "colors.h"
 #include "events.h"
+#include "statistics.h"
+#include "pixmanBackend.h"
+#include "fillPattern.h"
+#include "texturePool.h"
+#include "rasterizer.h"
+#include "clip.h"
+#include "compositor.h"
 
 #define SDL_VIEWPORT_INCORRECT_COORDINATE_ORIGIN
 
+/*
+ * If set, every drawing operation presents its window right away instead of waiting for the
+ * next flush point (XFlush, XSync, XPending, XNextEvent). Useful for debugging drawing code.
+ */
+static Bool immediatePresentMode = False;
+
+void initPresentMode() {
+    const char* mode = getenv("SDL2X11_PRESENT_MODE");
+    immediatePresentMode = mode != NULL && strcmp(mode, "immediate") == 0;
+    LOG("Using %s present mode\n", immediatePresentMode ? "immediate" : "deferred");
+}
+
+/*
+ * Upload the damaged parts of a top level window to the screen and clear its damage.
+ * Returns the number of pixels that were presented.
+ */
+static unsigned long presentWindowDamage(WindowStruct* windowStruct) {
+    int numRects, i;
+    pixman_box16_t* boxes = pixman_region_rectangles(&windowStruct->damage, &numRects);
+    if (numRects == 0) { return 0; }
+    unsigned long pixels = 0;
+    SDL_Rect extentsRect;
+    SDL_Rect* rects = malloc(sizeof(SDL_Rect) * numRects);
+    if (rects == NULL) {
+        // Without memory for the rectangles, present the bounding box of the damage.
+        boxes = pixman_region_extents(&windowStruct->damage);
+        numRects = 1;
+        rects = &extentsRect;
+    }
+    for (i = 0; i < numRects; i++) {
+        rects[i].x = boxes[i].x1;
+        rects[i].y = boxes[i].y1;
+        rects[i].w = boxes[i].x2 - boxes[i].x1;
+        rects[i].h = boxes[i].y2 - boxes[i].y1;
+        pixels += (unsigned long) rects[i].w * rects[i].h;
+    }
+    SDL_RendererInfo rendererInfo;
+    if (windowStruct->sdlRenderer == NULL) {
+        // The pixman backend draws into the backing image, blit it to the window surface.
+        pixmanPresentWindow(windowStruct, rects, numRects);
+    } else if (SDL_GetRendererInfo(windowStruct->sdlRenderer, &rendererInfo) == 0
+        && rendererInfo.flags & SDL_RENDERER_SOFTWARE) {
+        // The software renderer draws directly into the window surface,
+        // so we only need to push the damaged rectangles to the screen.
+        #if SDL_VERSION_ATLEAST(2, 0, 10)
+        SDL_RenderFlush(windowStruct->sdlRenderer);
+        #endif
+        if (SDL_UpdateWindowSurfaceRects(windowStruct->sdlWindow, rects, numRects) != 0) {
+            LOG("SDL_UpdateWindowSurfaceRects failed in %s: %s\n", __func__, SDL_GetError());
+            SDL_RenderPresent(windowStruct->sdlRenderer);
+        }
+    } else {
+        // Accelerated renderers can only present the whole window.
+        SDL_RenderPresent(windowStruct->sdlRenderer);
+        pixels = (unsigned long) windowStruct->w * windowStruct->h;
+    }
+    if (rects != &extentsRect) {
+        free(rects);
+    }
+    pixman_region_fini(&windowStruct->damage);
+    pixman_region_init(&windowStruct->damage);
+    return pixels;
+}
+
+/*
+ * Find the window whose renderer, texture or image the given window is drawn into
+ * and the position of the given window in it.
+ */
+Window getRenderWindow(Window window, int* offsetX, int* offsetY) {
+    int x, y;
+    *offsetX = 0;
+    *offsetY = 0;
+    if (compositorEnabled) {
+        // Every window keeps its own backing image.
+        return window;
+    }
+    while (GET_PARENT(window) != None && GET_WINDOW_STRUCT(window)->sdlWindow == NULL
+           && GET_WINDOW_STRUCT(window)->mapState != UnMapped) {
+        GET_WINDOW_POS(window, x, y);
+        *offsetX += x;
+        *offsetY += y;
+        window = GET_PARENT(window);
+    }
+    return window;
+}
+
+void damageDrawable(Drawable drawable, int x, int y, unsigned int width, unsigned int height) {
+    if (IS_TYPE(drawable, PIXMAP)) {
+        GET_PIXMAP_STRUCT(drawable)->serial++;
+        return;
+    }
+    if (!IS_TYPE(drawable, WINDOW) || width == 0 || height == 0) { return; }
+    SDL_Rect damageRect = {x, y, width, height};
+    SDL_Rect windowRect = {0, 0, 0, 0};
+    GET_WINDOW_DIMS(drawable, windowRect.w, windowRect.h);
+    if (!SDL_IntersectRect(&damageRect, &windowRect, &damageRect)) { return; }
+    Window window;
+    if (compositorEnabled) {
+        // The top level window is recomposited where the window is visible.
+        window = getCompositedArea(drawable, &damageRect);
+        if (window == None) { return; }
+    } else {
+        int offsetX, offsetY;
+        window = getRenderWindow(drawable, &offsetX, &offsetY);
+        damageRect.x += offsetX;
+        damageRect.y += offsetY;
+    }
+    WindowStruct* windowStruct = GET_WINDOW_STRUCT(window);
+    if (windowStruct->sdlWindow == NULL
+        || (windowStruct->sdlRenderer == NULL && windowStruct->backingImage == NULL && !compositorEnabled)) {
+        // Drawing went into an offscreen texture or image, there is nothing to present.
+        return;
+    }
+    GET_WINDOW_DIMS(window, windowRect.w, windowRect.h);
+    if (!SDL_IntersectRect(&damageRect, &windowRect, &damageRect)) { return; }
+    pixman_region_union_rect(&windowStruct->damage, &windowStruct->damage, damageRect.x,
+                             damageRect.y, (unsigned int) damageRect.w, (unsigned int) damageRect.h);
+    if (immediatePresentMode) {
+        recordPresentedFrame(presentWindowDamage(windowStruct));
+        trimTexturePool();
+    }
+}
+
+void markDrawableDirty(Drawable drawable) {
+    if (!IS_TYPE(drawable, WINDOW)) { return; }
+    unsigned int width, height;
+    GET_WINDOW_DIMS(drawable, width, height);
+    damageDrawable(drawable, 0, 0, width, height);
+}
+
 void drawWindowDataToScreen() {
+    if (SCREEN_WINDOW == None) { return; }
     Window* children = GET_CHILDREN(SCREEN_WINDOW);
+    unsigned long pixelsPresented = 0;
+    Bool presented = False;
     int i;
     for (i = 0; i < GET_WINDOW_STRUCT(SCREEN_WINDOW)->children.length; i++) {
-        if (GET_WINDOW_STRUCT(children[i])->sdlRenderer != NULL) {
-            SDL_RenderPresent(GET_WINDOW_STRUCT(children[i])->sdlRenderer);
+        WindowStruct* windowStruct = GET_WINDOW_STRUCT(children[i]);
+        if (windowStruct->sdlWindow != NULL && pixman_region_not_empty(&windowStruct->damage)) {
+            pixelsPresented += presentWindowDamage(windowStruct);
+            presented = True;
         }
     }
+    if (presented) {
+        recordPresentedFrame(pixelsPresented);
+        trimTexturePool();
+    }
     #ifdef DEBUG_WINDOWS
     printWindowsHierarchy();
     //drawDebugWindowSurfacePlanes();
@@ -29,17 +175,8 @@ void drawWindowDataToScreen() {
 SDL_Renderer* getWindowRenderer(Window window) {
     SDL_Rect viewPort;
     SDL_Renderer* renderer = NULL;
-    int x = 0, y = 0;
-    viewPort.x = 0;
-    viewPort.y = 0;
     GET_WINDOW_DIMS(window, viewPort.w, viewPort.h);
-    while (GET_PARENT(window) != None && GET_WINDOW_STRUCT(window)->sdlWindow == NULL
-           && GET_WINDOW_STRUCT(window)->mapState != UnMapped) {
-        GET_WINDOW_POS(window, x, y);
-        viewPort.x += x;
-        viewPort.y += y;
-        window = GET_PARENT(window);
-    }
+    window = getRenderWindow(window, &viewPort.x, &viewPort.y);
     renderer = GET_WINDOW_STRUCT(window)->sdlRenderer;
     if (renderer == NULL) {
         if (IS_MAPPED_TOP_LEVEL_WINDOW(window)) {
@@ -63,8 +200,8 @@ SDL_Renderer* getWindowRenderer(Window window) {
                 } else {
                     GET_WINDOW_STRUCT(window)->sdlTexture = texture;
                 }
-                SDL_SetRenderTarget(renderer, texture);
             }
+            setRenderTarget(renderer, texture);
         } else {
             GET_WINDOW_STRUCT(window)->sdlRenderer = renderer;
         }
@@ -75,7 +212,7 @@ SDL_Renderer* getWindowRenderer(Window window) {
     viewPort.y = h - viewPort.y - viewPort.h;
     #endif
     LOG("Setting viewport to {x = %d, y = %d, w = %d, h = %d}\n", viewPort.x, viewPort.y, viewPort.w, viewPort.h);
-    if (SDL_RenderSetViewport(renderer, &viewPort)) {
+    if (!setRenderViewport(renderer, &viewPort)) {
         LOG("SDL_RenderSetViewport failed in %s: %s\n", __func__, SDL_GetError());
     }
     return renderer;
@@ -149,56 +286,6 @@ Uint32 getPixel(SDL_Surface *surface, unsigned int x, unsigned int y) {
     return 0;
 }
 
-#define APPLY_OPERATION_TO_SURFACE(surface, operation, startX, startY, w, h) {\
-    LOCK_SURFACE(surface);\
-    int bytesPerPixel = SDL_SURFACE_DEPTH / 8;\
-    if (surface->format->BytesPerPixel != bytesPerPixel) {\
-        LOG("Got invalid depth in %s\n", __func__);\
-    }\
-    Uint32 *pixelPointer;\
-    int y, i;\
-    for (y = startY; y < h; y++) {\
-        pixelPointer = (Uint32 *) surface->pixels + y * (surface->pitch / bytesPerPixel) + startX;\
-        for (i = 0; i < w; i++) operation\
-    }\
-    UNLOCK_SURFACE(surface);\
-}
-
-void clipSurface(SDL_Surface* surface, SDL_Surface* clipSurface, int originX, int originY) {
-    LOCK_SURFACE(clipSurface);
-    Uint32* clipPixel = clipSurface->pixels;
-    APPLY_OPERATION_TO_SURFACE(surface, { pixelPointer[i] &= 0xFFFFFF00 | *clipPixel++; }, originX, originY, clipSurface->w, clipSurface->h);
-    UNLOCK_SURFACE(clipSurface);
-}
-
-void colorClipped(SDL_Surface* surface, SDL_Surface* clipSurface, int originX, int originY, long color) {
-    LOCK_SURFACE(clipSurface);
-    Uint32* clipPixel = clipSurface->pixels;
-    APPLY_OPERATION_TO_SURFACE(surface, { if (*clipPixel++ & 0x000000FF && 0) {pixelPointer[i] = color; LOG("clipping with fg color\n");} }, originX, originY, clipSurface->w, clipSurface->h);
-    UNLOCK_SURFACE(clipSurface);
-}
-
-int XFillPolygon(Display* display, Drawable d, GC gc, XPoint *points, int npoints, int shape, int mode) {
-    // https://tronche.com/gui/x/xlib/graphics/filling-areas/XFillPolygon.html
-    SET_X_SERVER_REQUEST(display, X_FillPoly);
-    WARN_UNIMPLEMENTED;
-    return 1;
-}
-
-int XFillArc(Display *display, Drawable d, GC gc, int x, int y, unsigned int width, unsigned int height, int angle1, int angle2) {
-    // https://tronche.com/gui/x/xlib/graphics/filling-areas/XFillArc.html
-    SET_X_SERVER_REQUEST(display, X_PolyFillArc);
-    WARN_UNIMPLEMENTED;
-    return 1;
-}
-
-int XDrawArc(Display *display, Drawable d, GC gc, int x, int y, unsigned int width, unsigned int height, int angle1, int angle2) {
-    // https://tronche.com/gui/x/xlib/graphics/drawing/XDrawArc.html
-    SET_X_SERVER_REQUEST(display, X_PolyArc);
-    WARN_UNIMPLEMENTED;
-    return 1;
-}
-
 int XCopyPlane(Display *display, Drawable src, Drawable dest, GC gc, int src_x, int src_y, unsigned int width, unsigned int height, int dest_x, int dest_y, unsigned long plane) {
     // https://tronche.com/gui/x/xlib/graphics/XCopyPlane.html
     SET_X_SERVER_REQUEST(display, X_CopyPlane);
@@ -209,6 +296,14 @@ int XCopyPlane(Display *display, Drawable src, Drawable dest, GC gc, int src_x,
 
 
 
+/* Draw in the foreground color of the graphic context, replacing the pixels. */
+static void setForegroundDrawColor(SDL_Renderer* renderer, GraphicContext* gContext) {
+    long color = gContext->foreground;
+    setRenderDrawColor(renderer, GET_RED_FROM_COLOR(color), GET_GREEN_FROM_COLOR(color),
+                           GET_BLUE_FROM_COLOR(color), GET_ALPHA_FROM_COLOR(color));
+    setRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
+
 int XDrawLines(Display *display, Drawable d, GC gc, XPoint *points, int npoints, int mode) {
     // https://tronche.com/gui/x/xlib/graphics/drawing/XDrawLines.html
     SET_X_SERVER_REQUEST(display, X_PolyLine);
@@ -219,14 +314,6 @@ int XDrawLines(Display *display, Drawable d, GC gc, XPoint *points, int npoints,
         handleError(0, display, None, 0, BadValue, 0);
         return 0;
     }
-    SDL_Renderer* renderer = NULL;
-    GET_RENDERER(d, renderer);
-    if (renderer == NULL) {
-        LOG("Failed to create renderer in %s: %s\n", __func__, SDL_GetError());
-        handleError(0, display, d, 0, BadDrawable, 0);
-        return 0;
-    }
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
     SDL_Point sdlPoints[npoints];
     int i;
     if (mode == CoordModeOrigin) {
@@ -250,35 +337,310 @@ int XDrawLines(Display *display, Drawable d, GC gc, XPoint *points, int npoints,
 //    }
 
     GraphicContext* gContext = GET_GC(gc);
-    long color = gContext->foreground;
-    SDL_SetRenderDrawColor(renderer, (color >> 24) & 0xFF, (color >> 16) & 0xFF, (color >> 8) & 0xFF, 0xFF);
-    if (SDL_RenderDrawLines(renderer, &sdlPoints[0], npoints)) {
-        LOG("SDL_RenderDrawLines failed in %s: %s\n", __func__, SDL_GetError());
+    SDL_Rect bounds;
+    ClipIterator clip;
+    SDL_EnclosePoints(&sdlPoints[0], npoints, NULL, &bounds);
+    if (!initClipIterator(&clip, d, gContext, &bounds)) { return 1; }
+    if (beginSoftwareDrawing(d, gContext, &clip.bounds, None, NULL)) {
+        Bool drawn = pixmanDrawLines(d, gContext, &clip, &sdlPoints[0], npoints);
+        endSoftwareDrawing();
+        if (!drawn) {
+            LOG("Failed to get the image of the drawable in %s\n", __func__);
+            handleError(0, display, d, 0, BadDrawable, 0);
+            return 0;
+        }
+    } else {
+        SDL_Renderer* renderer = NULL;
+        GET_RENDERER(d, renderer);
+        if (renderer == NULL) {
+            LOG("Failed to create renderer in %s: %s\n", __func__, SDL_GetError());
+            handleError(0, display, d, 0, BadDrawable, 0);
+            return 0;
+        }
+        setForegroundDrawColor(renderer, gContext);
+        while (nextClipRect(&clip, renderer)) {
+            if (SDL_RenderDrawLines(renderer, &sdlPoints[0], npoints)) {
+                LOG("SDL_RenderDrawLines failed in %s: %s\n", __func__, SDL_GetError());
+            }
+        }
     }
-    SDL_RenderPresent(renderer);
+    damageDrawable(d, clip.bounds.x, clip.bounds.y, clip.bounds.w, clip.bounds.h);
     return 1;
 }
 
-int XClearArea ( register Display *dpy, Window w, int x, int y, unsigned int width, unsigned int height, Bool exposures) {
-    // https://tronche.com/gui/x/xlib/graphics/XClearArea.html
-    WindowStruct* windowStruct = GET_WINDOW_STRUCT(w);
+/*
+ * Get the texture that holds the content of the drawable and the position of the drawable in it.
+ * Returns NULL if the drawable is rendered directly into a window.
+ */
+static SDL_Texture* getDrawableTexture(Drawable drawable, int* offsetX, int* offsetY) {
+    if (IS_TYPE(drawable, PIXMAP)) {
+        *offsetX = 0;
+        *offsetY = 0;
+        return GET_PIXMAP_TEXTURE(drawable);
+    }
+    Window window = getRenderWindow(drawable, offsetX, offsetY);
+    if (GET_WINDOW_STRUCT(window)->sdlWindow != NULL) {
+        return NULL;
+    }
+    return GET_WINDOW_STRUCT(window)->sdlTexture;
+}
 
-    if (width == 0) width = windowStruct->w - x;
-    if (height == 0) height = windowStruct->h - y;
+void getDrawableSize(Drawable drawable, int* width, int* height) {
+    if (IS_TYPE(drawable, PIXMAP)) {
+        *width = GET_PIXMAP_STRUCT(drawable)->width;
+        *height = GET_PIXMAP_STRUCT(drawable)->height;
+    } else {
+        GET_WINDOW_DIMS(drawable, *width, *height);
+    }
+}
 
-    // TODO: this could be faster without tmp GC creation (just call SDL directly ?)
-    GC tmpGC = XCreateGC(dpy, w, 0, NULL);
-    GraphicContext* tmpGContext = GET_GC(tmpGC);
-    tmpGContext->fillStyle = FillSolid;
-    tmpGContext->foreground = windowStruct->backgroundColor;
-    XFillRectangle(dpy, w, tmpGC, x, y, width, height);
+/*
+ * Copy an area between drawables that can't be copied directly on the GPU
+ * by reading back the source rectangle (and only that) into memory.
+ */
+static Bool copyAreaThroughMemory(Drawable src, Drawable dest, SDL_Rect* srcRect, SDL_Rect* destRect) {
+    SDL_Renderer* destRenderer = NULL;
+    GET_RENDERER(dest, destRenderer);
+    if (destRenderer == NULL) { return False; }
+    SDL_Texture* texture = acquirePoolTexture(destRenderer, SDL_PIXELFORMAT_RGBA8888, srcRect->w, srcRect->h);
+    if (texture == NULL) { return False; }
+    SDL_Renderer* srcRenderer = NULL;
+    GET_RENDERER(src, srcRenderer);
+    if (srcRenderer == NULL) {
+        releasePoolTexture(texture);
+        return False;
+    }
+    // SDL_RenderReadPixels expects the rect relative to the render target, not to the viewport.
+    SDL_Rect viewPort, readRect = *srcRect;
+    SDL_RenderGetViewport(srcRenderer, &viewPort);
+    readRect.x += viewPort.x;
+    readRect.y += viewPort.y;
+    // The pixels are read straight into the memory of the texture.
+    SDL_Rect textureRect = {0, 0, srcRect->w, srcRect->h};
+    void* pixels;
+    int pitch;
+    Bool success = SDL_LockTexture(texture, &textureRect, &pixels, &pitch) == 0;
+    if (success) {
+        success = SDL_RenderReadPixels(srcRenderer, &readRect, SDL_PIXELFORMAT_RGBA8888, pixels, pitch) == 0;
+        SDL_UnlockTexture(texture);
+    }
+    if (!success) {
+        LOG("Failed to read the pixels into the texture in %s: %s\n", __func__, SDL_GetError());
+        releasePoolTexture(texture);
+        return False;
+    }
+    GET_RENDERER(dest, destRenderer);
+    setRenderDrawBlendMode(destRenderer, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    if (SDL_RenderCopy(destRenderer, texture, &textureRect, destRect) != 0) {
+        LOG("SDL_RenderCopy failed in %s: %s\n", __func__, SDL_GetError());
+        success = False;
+    }
+    releasePoolTexture(texture);
+    return success;
+}
 
-    if (exposures) {
-        SDL_Rect exposeRect = {x, y, width, height};
-        postExposeEvent(dpy, w, &exposeRect, 1);
+/* A texture of the screen renderer used to copy overlapping areas within one texture. */
+static SDL_Texture* scratchTexture = NULL;
+
+void freeScratchTexture() {
+    if (scratchTexture != NULL) {
+        forgetRenderTarget(scratchTexture);
+        SDL_DestroyTexture(scratchTexture);
+        scratchTexture = NULL;
     }
+}
 
-    return 1;
+static SDL_Texture* getScratchTexture(SDL_Renderer* renderer, int width, int height) {
+    int scratchWidth = 0, scratchHeight = 0;
+    if (scratchTexture != NULL) {
+        SDL_QueryTexture(scratchTexture, NULL, NULL, &scratchWidth, &scratchHeight);
+        if (scratchWidth >= width && scratchHeight >= height) {
+            return scratchTexture;
+        }
+        freeScratchTexture();
+    }
+    scratchTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                       MAX(width, scratchWidth), MAX(height, scratchHeight));
+    if (scratchTexture == NULL) {
+        LOG("SDL_CreateTexture failed in %s: %s\n", __func__, SDL_GetError());
+    }
+    return scratchTexture;
+}
+
+/*
+ * Copy an area within one texture of the screen renderer. The source and destination
+ * may overlap, so the area is copied through the scratch texture.
+ */
+static Bool copyAreaInTexture(SDL_Renderer* renderer, SDL_Texture* texture, SDL_Rect* srcRect,
+                              SDL_Rect* destRect) {
+    SDL_Rect scratchRect = {0, 0, srcRect->w, srcRect->h};
+    SDL_Texture* scratch = getScratchTexture(renderer, srcRect->w, srcRect->h);
+    if (scratch == NULL) { return False; }
+    // Setting the render target resets the viewport, so the rects are relative to the texture.
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+    SDL_SetTextureBlendMode(scratch, SDL_BLENDMODE_NONE);
+    if (!setRenderTarget(renderer, scratch)
+        || SDL_RenderCopy(renderer, texture, srcRect, &scratchRect) != 0
+        || !setRenderTarget(renderer, texture)
+        || SDL_RenderCopy(renderer, scratch, &scratchRect, destRect) != 0) {
+        LOG("Failed to copy through the scratch texture in %s: %s\n", __func__, SDL_GetError());
+        return False;
+    }
+    return True;
+}
+
+/* Move an area of the surface to (destX, destY). The source and destination may overlap. */
+void moveSurfaceArea(SDL_Surface* surface, SDL_Rect* srcRect, int destX, int destY) {
+    SDL_Rect bounds = {0, 0, surface->w, surface->h};
+    SDL_Rect rect;
+    // Clip both the source and the destination to the surface.
+    if (!SDL_IntersectRect(srcRect, &bounds, &rect)) { return; }
+    destX += rect.x - srcRect->x;
+    destY += rect.y - srcRect->y;
+    SDL_Rect destRect = {destX, destY, rect.w, rect.h};
+    if (!SDL_IntersectRect(&destRect, &bounds, &destRect)) { return; }
+    rect.x += destRect.x - destX;
+    rect.y += destRect.y - destY;
+    rect.w = destRect.w;
+    rect.h = destRect.h;
+    int bytesPerPixel = surface->format->BytesPerPixel;
+    size_t rowLength = (size_t) rect.w * bytesPerPixel;
+    int row;
+    LOCK_SURFACE(surface);
+    Uint8* pixels = surface->pixels;
+    if (destRect.y > rect.y) {
+        // Moving down, copy from the bottom so we don't overwrite rows we still need.
+        for (row = rect.h - 1; row >= 0; row--) {
+            memmove(pixels + (destRect.y + row) * surface->pitch + destRect.x * bytesPerPixel,
+                    pixels + (rect.y + row) * surface->pitch + rect.x * bytesPerPixel, rowLength);
+        }
+    } else {
+        for (row = 0; row < rect.h; row++) {
+            memmove(pixels + (destRect.y + row) * surface->pitch + destRect.x * bytesPerPixel,
+                    pixels + (rect.y + row) * surface->pitch + rect.x * bytesPerPixel, rowLength);
+        }
+    }
+    UNLOCK_SURFACE(surface);
+}
+
+/*
+ * Copy an area between two windows that are drawn directly into the same window surface
+ * by moving the pixels in place. Returns False if the windows don't share a software rendered surface.
+ */
+static Bool copyAreaInWindowSurface(Window src, Window dest, SDL_Rect* srcRect, SDL_Rect* destRect) {
+    int offsetX, offsetY;
+    Window renderWindow = getRenderWindow(dest, &offsetX, &offsetY);
+    if (getRenderWindow(src, &offsetX, &offsetY) != renderWindow
+        || GET_WINDOW_STRUCT(renderWindow)->sdlWindow == NULL) {
+        return False;
+    }
+    SDL_RendererInfo rendererInfo;
+    SDL_Rect srcViewPort, destViewPort;
+    SDL_Renderer* renderer = getWindowRenderer(src);
+    if (renderer == NULL || SDL_GetRendererInfo(renderer, &rendererInfo) != 0
+        || !(rendererInfo.flags & SDL_RENDERER_SOFTWARE)) {
+        return False;
+    }
+    SDL_RenderGetViewport(renderer, &srcViewPort);
+    getWindowRenderer(dest);
+    SDL_RenderGetViewport(renderer, &destViewPort);
+    SDL_Surface* surface = SDL_GetWindowSurface(GET_WINDOW_STRUCT(renderWindow)->sdlWindow);
+    if (surface == NULL) {
+        LOG("SDL_GetWindowSurface failed in %s: %s\n", __func__, SDL_GetError());
+        return False;
+    }
+    // The surface also holds the parent and the siblings, so clip the source and destination to their windows.
+    SDL_Rect srcBounds = {0, 0, 0, 0}, destBounds = {0, 0, 0, 0}, clippedSrcRect, clippedDestRect;
+    getDrawableSize(src, &srcBounds.w, &srcBounds.h);
+    getDrawableSize(dest, &destBounds.w, &destBounds.h);
+    if (!SDL_IntersectRect(srcRect, &srcBounds, &clippedSrcRect)) { return True; }
+    int destX = destRect->x + clippedSrcRect.x - srcRect->x, destY = destRect->y + clippedSrcRect.y - srcRect->y;
+    clippedDestRect = (SDL_Rect) {destX, destY, clippedSrcRect.w, clippedSrcRect.h};
+    if (!SDL_IntersectRect(&clippedDestRect, &destBounds, &clippedDestRect)) { return True; }
+    clippedSrcRect.x += clippedDestRect.x - destX;
+    clippedSrcRect.y += clippedDestRect.y - destY;
+    clippedSrcRect.w = clippedDestRect.w;
+    clippedSrcRect.h = clippedDestRect.h;
+    #if SDL_VERSION_ATLEAST(2, 0, 10)
+    SDL_RenderFlush(renderer);
+    #endif
+    SDL_Rect surfaceRect = {srcViewPort.x + clippedSrcRect.x, srcViewPort.y + clippedSrcRect.y,
+                            clippedSrcRect.w, clippedSrcRect.h};
+    moveSurfaceArea(surface, &surfaceRect, destViewPort.x + clippedDestRect.x, destViewPort.y + clippedDestRect.y);
+    return True;
+}
+
+/*
+ * Send GraphicsExpose events for the parts of the destination whose source area
+ * lies outside of the source drawable, or a NoExpose event if there are none.
+ */
+static void postGraphicsExposeEvents(Display* display, Drawable dest, SDL_Rect* requestedSrcRect,
+                                     SDL_Rect* srcBounds, int dest_x, int dest_y) {
+    pixman_region16_t exposed, available;
+    pixman_region_init_rect(&exposed, requestedSrcRect->x, requestedSrcRect->y,
+                            (unsigned int) requestedSrcRect->w, (unsigned int) requestedSrcRect->h);
+    pixman_region_init_rect(&available, srcBounds->x, srcBounds->y,
+                            (unsigned int) srcBounds->w, (unsigned int) srcBounds->h);
+    pixman_region_subtract(&exposed, &exposed, &available);
+    pixman_region_translate(&exposed, dest_x - requestedSrcRect->x, dest_y - requestedSrcRect->y);
+    int destWidth, destHeight;
+    getDrawableSize(dest, &destWidth, &destHeight);
+    pixman_region_intersect_rect(&exposed, &exposed, 0, 0, (unsigned int) destWidth,
+                                 (unsigned int) destHeight);
+    int numRects, i;
+    pixman_box16_t* boxes = pixman_region_rectangles(&exposed, &numRects);
+    if (numRects == 0) {
+        postEvent(display, dest, NoExpose, X_CopyArea, 0);
+    }
+    for (i = 0; i < numRects; i++) {
+        SDL_Rect exposeRect = {boxes[i].x1, boxes[i].y1, boxes[i].x2 - boxes[i].x1, boxes[i].y2 - boxes[i].y1};
+        postEvent(display, dest, GraphicsExpose, &exposeRect, numRects - i - 1, X_CopyArea, 0);
+    }
+    pixman_region_fini(&available);
+    pixman_region_fini(&exposed);
+}
+
+/*
+ * Copy the area with the SDL renderer, using the cheapest path the drawables allow.
+ * The pixels are copied as they are, so the caller clips the area.
+ */
+static Bool copyAreaWithRenderer(Display* display, Drawable src, Drawable dest, SDL_Rect* srcRect, SDL_Rect* destRect) {
+    SDL_Renderer* destRenderer = NULL;
+    GET_RENDERER(dest, destRenderer);
+    if (destRenderer == NULL) {
+        LOG("Failed to get the renderer of the destination in %s: %s\n", __func__, SDL_GetError());
+        handleError(0, display, dest, 0, BadDrawable, 0);
+        return False;
+    }
+    int srcOffsetX, srcOffsetY, destOffsetX, destOffsetY;
+    SDL_Texture* srcTexture = getDrawableTexture(src, &srcOffsetX, &srcOffsetY);
+    SDL_Texture* destTexture = getDrawableTexture(dest, &destOffsetX, &destOffsetY);
+    Bool copied = False;
+    if (srcTexture != NULL && destTexture != NULL) {
+        // The fallback below expects the rects relative to the drawables, so they are offset in a copy.
+        SDL_Rect textureSrcRect = {srcRect->x + srcOffsetX, srcRect->y + srcOffsetY, srcRect->w, srcRect->h};
+        if (srcTexture != destTexture) {
+            // Both drawables are textures of the screen renderer, copy on the GPU.
+            setRenderDrawBlendMode(destRenderer, SDL_BLENDMODE_BLEND);
+            SDL_SetTextureBlendMode(srcTexture, SDL_BLENDMODE_BLEND);
+            copied = SDL_RenderCopy(destRenderer, srcTexture, &textureSrcRect, destRect) == 0;
+        } else {
+            // Scrolling within a texture, the source and destination might overlap.
+            SDL_Rect textureDestRect = {destRect->x + destOffsetX, destRect->y + destOffsetY,
+                                        destRect->w, destRect->h};
+            copied = copyAreaInTexture(destRenderer, destTexture, &textureSrcRect, &textureDestRect);
+        }
+    } else if (srcTexture == NULL && destTexture == NULL) {
+        // Scrolling within a window, move the pixels directly in the window surface.
+        copied = copyAreaInWindowSurface(src, dest, srcRect, destRect);
+    }
+    if (!copied && !copyAreaThroughMemory(src, dest, srcRect, destRect)) {
+        LOG("Failed to copy the area in %s: %s\n", __func__, SDL_GetError());
+        handleError(0, display, src, 0, BadMatch, 0);
+        return False;
+    }
+    return True;
 }
 
 int XCopyArea(Display* display, Drawable src, Drawable dest, GC gc, int src_x, int src_y,
@@ -293,75 +655,311 @@ int XCopyArea(Display* display, Drawable src, Drawable dest, GC gc, int src_x, i
             LOG("BadMatch: Got input only window as the source in %s!\n", __func__);
             handleError(0, display, src, 0, BadMatch, 0);
             return 0;
-        } else if (GET_WINDOW_STRUCT(src)->mapState == UnMapped && GET_WINDOW_STRUCT(src)->sdlTexture == NULL) {
+        } else if (GET_WINDOW_STRUCT(src)->mapState == UnMapped && GET_WINDOW_STRUCT(src)->sdlTexture == NULL
+                   && GET_WINDOW_STRUCT(src)->backingImage == NULL) {
             return 0;
         }
     }
-    if (IS_TYPE(dest, WINDOW)) {
-        if (IS_INPUT_ONLY(dest)) {
-            LOG("BadMatch: Got input only window as the destination in %s!\n", __func__);
-            handleError(0, display, dest, 0, BadMatch, 0);
-            return 0;
-        }
-        SDL_Renderer* destRenderer = getWindowRenderer(dest);
-        SDL_Renderer* srcRenderer;
-        GET_RENDERER(src, srcRenderer);
-        SDL_Surface* srcSurface = getRenderSurface(srcRenderer);
-        if (srcSurface == NULL) {
-            handleError(0, display, src, 0, BadMatch, 0);
-        }
-        SDL_Texture* srcTexture = SDL_CreateTextureFromSurface(destRenderer, srcSurface);
-        SDL_FreeSurface(srcSurface);
-        SDL_SetRenderDrawBlendMode(destRenderer, SDL_BLENDMODE_BLEND);
-        SDL_SetTextureBlendMode(srcTexture, SDL_BLENDMODE_BLEND);
-        SDL_Rect srcRect, destRect;
-        srcRect.x = src_x;
-        srcRect.y = src_y;
-        destRect.x = dest_x;
-        destRect.y = dest_y;
-        srcRect.w = destRect.w = width;
-        srcRect.h = destRect.h = height;
-        if (SDL_RenderCopy(destRenderer, srcTexture, &srcRect, &destRect) != 0) {
-            LOG("SDL_RenderCopy failed in %s: %s\n", __func__, SDL_GetError());
-            handleError(0, display, src, 0, BadMatch, 0);
-            return 0;
+    if (IS_TYPE(dest, WINDOW) && IS_INPUT_ONLY(dest)) {
+        LOG("BadMatch: Got input only window as the destination in %s!\n", __func__);
+        handleError(0, display, dest, 0, BadMatch, 0);
+        return 0;
+    }
+    // Only the part of the source that lies inside the source drawable is copied.
+    SDL_Rect requestedSrcRect = {src_x, src_y, width, height};
+    SDL_Rect srcRect, destRect, srcBounds = {0, 0, 0, 0};
+    ClipIterator clip;
+    getDrawableSize(src, &srcBounds.w, &srcBounds.h);
+    Bool visible = SDL_IntersectRect(&requestedSrcRect, &srcBounds, &srcRect);
+    if (visible) {
+        destRect = (SDL_Rect) {dest_x + srcRect.x - src_x, dest_y + srcRect.y - src_y, srcRect.w, srcRect.h};
+        visible = initClipIterator(&clip, dest, gc == NULL ? NULL : GET_GC(gc), &destRect);
+    }
+    if (visible) {
+        GraphicContext* gContext = gc == NULL ? NULL : GET_GC(gc);
+        // Only the source of the visible part of the destination is needed.
+        SDL_Rect srcArea = {srcRect.x + clip.bounds.x - destRect.x, srcRect.y + clip.bounds.y - destRect.y,
+                            clip.bounds.w, clip.bounds.h};
+        if (beginSoftwareDrawing(dest, gContext, &clip.bounds, src, &srcArea)) {
+            Bool copied = pixmanCopyArea(src, dest, gContext, &clip, &srcRect, &destRect);
+            endSoftwareDrawing();
+            if (!copied) {
+                LOG("Failed to copy the area in %s\n", __func__);
+                handleError(0, display, src, 0, BadMatch, 0);
+                return 0;
+            }
+        } else {
+            // The copies within one texture go through another render target, so they are clipped by hand.
+            while (nextClipRect(&clip, NULL)) {
+                SDL_Rect partDestRect = clip.rect;
+                SDL_Rect partSrcRect = {srcRect.x + clip.rect.x - destRect.x, srcRect.y + clip.rect.y - destRect.y,
+                                        clip.rect.w, clip.rect.h};
+                if (!copyAreaWithRenderer(display, src, dest, &partSrcRect, &partDestRect)) {
+                    return 0;
+                }
+            }
         }
-        SDL_DestroyTexture(srcTexture);
-        SDL_RenderPresent(destRenderer);
-    } else {
-        LOG("Hit unimplemented type in %s: %d\n", __func__, GET_XID_TYPE(dest));
+        damageDrawable(dest, clip.bounds.x, clip.bounds.y, clip.bounds.w, clip.bounds.h);
+    }
+    if (gc != NULL && GET_GC(gc)->graphicsExposures) {
+        postGraphicsExposeEvents(display, dest, &requestedSrcRect, &srcBounds, dest_x, dest_y);
     }
-
-    // TODO: Events
     return 1;
 }
 
 int XDrawRectangle(Display *display, Drawable d, GC gc, int x, int y, unsigned int width, unsigned int height) {
     // https://tronche.com/gui/x/xlib/graphics/drawing/XDrawRectangle.html
+    XRectangle rect = { x, y, width, height };
+    return XDrawRectangles(display, d, gc, &rect, 1);
+}
+
+int XDrawRectangles(Display *display, Drawable d, GC gc, XRectangle *rectangles, int nrectangles) {
+    // https://tronche.com/gui/x/xlib/graphics/drawing/XDrawRectangles.html
     SET_X_SERVER_REQUEST(display, X_PolyRectangle);
     TYPE_CHECK(d, DRAWABLE, display, 0);
-    LOG("%s: Drawing on %p\n", __func__, d);
-    SDL_Renderer* renderer = NULL;
-    GET_RENDERER(d, renderer);
-    if (renderer == NULL) {
-        LOG("Failed to create renderer in %s: %s\n", __func__, SDL_GetError());
+    LOG("%s: Drawing %d rectangles on %p\n", __func__, nrectangles, d);
+    if (nrectangles < 1) { return 1; }
+    // Each outline becomes its top, bottom, left and right edge. The same allocation
+    // holds the outlines themselves for the software drawing functions.
+    SDL_Rect* edges = malloc(sizeof(SDL_Rect) * 5 * nrectangles);
+    if (edges == NULL) {
+        handleOutOfMemory(0, display, 0, 0);
+        return 0;
+    }
+    int i, numEdges = 0;
+    SDL_Rect bounds = {0, 0, 0, 0};
+    for (i = 0; i < nrectangles; i++) {
+        SDL_Rect rect = {rectangles[i].x, rectangles[i].y, rectangles[i].width, rectangles[i].height};
+        if (rect.w <= 0 || rect.h <= 0) { continue; }
+        edges[numEdges++] = (SDL_Rect) {rect.x, rect.y, rect.w, 1};
+        if (rect.h > 1) {
+            edges[numEdges++] = (SDL_Rect) {rect.x, rect.y + rect.h - 1, rect.w, 1};
+        }
+        if (rect.h > 2) {
+            edges[numEdges++] = (SDL_Rect) {rect.x, rect.y + 1, 1, rect.h - 2};
+            if (rect.w > 1) {
+                edges[numEdges++] = (SDL_Rect) {rect.x + rect.w - 1, rect.y + 1, 1, rect.h - 2};
+            }
+        }
+        if (bounds.w == 0) {
+            bounds = rect;
+        } else {
+            SDL_UnionRect(&bounds, &rect, &bounds);
+        }
+    }
+    GraphicContext* gContext = GET_GC(gc);
+    ClipIterator clip;
+    if (numEdges == 0 || !initClipIterator(&clip, d, gContext, &bounds)) {
+        free(edges);
+        return 1;
+    }
+    Bool success = True;
+    if (beginSoftwareDrawing(d, gContext, &clip.bounds, None, NULL)) {
+        SDL_Rect* sdlRectangles = edges + 4 * nrectangles;
+        for (i = 0; i < nrectangles; i++) {
+            sdlRectangles[i].x = rectangles[i].x;
+            sdlRectangles[i].y = rectangles[i].y;
+            sdlRectangles[i].w = rectangles[i].width;
+            sdlRectangles[i].h = rectangles[i].height;
+        }
+        success = pixmanDrawRectangles(d, gContext, &clip, sdlRectangles, nrectangles);
+        endSoftwareDrawing();
+    } else {
+        SDL_Renderer* renderer = NULL;
+        GET_RENDERER(d, renderer);
+        if (renderer == NULL) {
+            success = False;
+        } else {
+            setForegroundDrawColor(renderer, gContext);
+            while (nextClipRect(&clip, renderer)) {
+                if (SDL_RenderFillRects(renderer, edges, numEdges)) {
+                    LOG("SDL_RenderFillRects failed in %s: %s\n", __func__, SDL_GetError());
+                }
+            }
+        }
+    }
+    free(edges);
+    if (!success) {
+        LOG("Failed to draw on the drawable in %s: %s\n", __func__, SDL_GetError());
         handleError(0, display, d, 0, BadDrawable, 0);
         return 0;
     }
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    SDL_Rect sdlRect;
-    sdlRect.x = x;
-    sdlRect.y = y;
-    sdlRect.w = (int) width;
-    sdlRect.h = (int) height;
-    LOG("{x = %d, y = %d, w = %d, h = %d}\n", sdlRect.x, sdlRect.y, sdlRect.w, sdlRect.h);
+    damageDrawable(d, clip.bounds.x, clip.bounds.y, (unsigned int) clip.bounds.w, (unsigned int) clip.bounds.h);
+    return 1;
+}
+
+int XDrawPoint(Display *display, Drawable d, GC gc, int x, int y) {
+    // https://tronche.com/gui/x/xlib/graphics/drawing/XDrawPoint.html
+    XPoint point = { x, y };
+    return XDrawPoints(display, d, gc, &point, 1, CoordModeOrigin);
+}
+
+int XDrawPoints(Display *display, Drawable d, GC gc, XPoint *points, int npoints, int mode) {
+    // https://tronche.com/gui/x/xlib/graphics/drawing/XDrawPoints.html
+    SET_X_SERVER_REQUEST(display, X_PolyPoint);
+    TYPE_CHECK(d, DRAWABLE, display, 0);
+    LOG("%s: Drawing %d points on %p\n", __func__, npoints, d);
+    if (mode != CoordModeOrigin && mode != CoordModePrevious) {
+        handleError(0, display, None, 0, BadValue, 0);
+        return 0;
+    }
+    if (npoints < 1) { return 1; }
+    SDL_Point* sdlPoints = malloc(sizeof(SDL_Point) * npoints);
+    if (sdlPoints == NULL) {
+        handleOutOfMemory(0, display, 0, 0);
+        return 0;
+    }
+    int i;
+    sdlPoints[0].x = points[0].x;
+    sdlPoints[0].y = points[0].y;
+    for (i = 1; i < npoints; i++) {
+        sdlPoints[i].x = points[i].x + (mode == CoordModePrevious ? sdlPoints[i - 1].x : 0);
+        sdlPoints[i].y = points[i].y + (mode == CoordModePrevious ? sdlPoints[i - 1].y : 0);
+    }
     GraphicContext* gContext = GET_GC(gc);
-    long color = gContext->foreground;
-    SDL_SetRenderDrawColor(renderer, (color >> 24) & 0xFF, (color >> 16) & 0xFF, (color >> 8) & 0xFF, 0xFF);
-    if (SDL_RenderDrawRect(renderer, &sdlRect)) {
-        LOG("SDL_RenderDrawRect failed in %s: %s\n", __func__, SDL_GetError());
+    SDL_Rect bounds;
+    ClipIterator clip;
+    SDL_EnclosePoints(sdlPoints, npoints, NULL, &bounds);
+    if (!initClipIterator(&clip, d, gContext, &bounds)) {
+        free(sdlPoints);
+        return 1;
     }
-    SDL_RenderPresent(renderer);
+    Bool success = True;
+    if (beginSoftwareDrawing(d, gContext, &clip.bounds, None, NULL)) {
+        success = pixmanDrawPoints(d, gContext, &clip, sdlPoints, npoints);
+        endSoftwareDrawing();
+    } else {
+        SDL_Renderer* renderer = NULL;
+        GET_RENDERER(d, renderer);
+        if (renderer == NULL) {
+            success = False;
+        } else {
+            setForegroundDrawColor(renderer, gContext);
+            while (nextClipRect(&clip, renderer)) {
+                if (SDL_RenderDrawPoints(renderer, sdlPoints, npoints)) {
+                    LOG("SDL_RenderDrawPoints failed in %s: %s\n", __func__, SDL_GetError());
+                }
+            }
+        }
+    }
+    free(sdlPoints);
+    if (!success) {
+        LOG("Failed to draw on the drawable in %s: %s\n", __func__, SDL_GetError());
+        handleError(0, display, d, 0, BadDrawable, 0);
+        return 0;
+    }
+    damageDrawable(d, clip.bounds.x, clip.bounds.y, (unsigned int) clip.bounds.w, (unsigned int) clip.bounds.h);
+    return 1;
+}
+
+/*
+ * Add the pixels of a one pixel wide line as runs of pixels in the same row or column,
+ * so a line needs one rectangle per row (or column if it is steep) instead of one per pixel.
+ * This walks the same pixels as the line drawing of the pixman backend.
+ */
+static int addLineRuns(SDL_Rect* runs, const SDL_Point* from, const SDL_Point* to) {
+    int x = from->x, y = from->y, count = 0;
+    int dx = abs(to->x - x), dy = -abs(to->y - y);
+    int stepX = x < to->x ? 1 : -1, stepY = y < to->y ? 1 : -1;
+    int error = dx + dy, error2;
+    SDL_Rect* run = NULL;
+    while (True) {
+        if (run != NULL && run->h == 1 && y == run->y && (x == run->x - 1 || x == run->x + run->w)) {
+            run->x = MIN(run->x, x);
+            run->w++;
+        } else if (run != NULL && run->w == 1 && x == run->x && (y == run->y - 1 || y == run->y + run->h)) {
+            run->y = MIN(run->y, y);
+            run->h++;
+        } else {
+            run = &runs[count++];
+            run->x = x;
+            run->y = y;
+            run->w = run->h = 1;
+        }
+        if (x == to->x && y == to->y) { break; }
+        error2 = 2 * error;
+        if (error2 >= dy) {
+            error += dy;
+            x += stepX;
+        }
+        if (error2 <= dx) {
+            error += dx;
+            y += stepY;
+        }
+    }
+    return count;
+}
+
+int XDrawLine(Display *display, Drawable d, GC gc, int x1, int y1, int x2, int y2) {
+    // https://tronche.com/gui/x/xlib/graphics/drawing/XDrawLine.html
+    XSegment segment = { x1, y1, x2, y2 };
+    return XDrawSegments(display, d, gc, &segment, 1);
+}
+
+int XDrawSegments(Display *display, Drawable d, GC gc, XSegment *segments, int nsegments) {
+    // https://tronche.com/gui/x/xlib/graphics/drawing/XDrawSegments.html
+    SET_X_SERVER_REQUEST(display, X_PolySegment);
+    TYPE_CHECK(d, DRAWABLE, display, 0);
+    LOG("%s: Drawing %d segments on %p\n", __func__, nsegments, d);
+    if (nsegments < 1) { return 1; }
+    SDL_Point* endpoints = malloc(sizeof(SDL_Point) * 2 * nsegments);
+    if (endpoints == NULL) {
+        handleOutOfMemory(0, display, 0, 0);
+        return 0;
+    }
+    int i;
+    size_t maxRuns = 0;
+    for (i = 0; i < nsegments; i++) {
+        endpoints[2 * i].x = segments[i].x1;
+        endpoints[2 * i].y = segments[i].y1;
+        endpoints[2 * i + 1].x = segments[i].x2;
+        endpoints[2 * i + 1].y = segments[i].y2;
+        // A line has one run per row or column along its shorter side.
+        maxRuns += (size_t) MIN(abs(segments[i].x2 - segments[i].x1), abs(segments[i].y2 - segments[i].y1)) + 1;
+    }
+    GraphicContext* gContext = GET_GC(gc);
+    SDL_Rect bounds;
+    ClipIterator clip;
+    SDL_EnclosePoints(endpoints, 2 * nsegments, NULL, &bounds);
+    if (!initClipIterator(&clip, d, gContext, &bounds)) {
+        free(endpoints);
+        return 1;
+    }
+    Bool success = True;
+    if (beginSoftwareDrawing(d, gContext, &clip.bounds, None, NULL)) {
+        success = pixmanDrawSegments(d, gContext, &clip, endpoints, nsegments);
+        endSoftwareDrawing();
+    } else {
+        SDL_Renderer* renderer = NULL;
+        GET_RENDERER(d, renderer);
+        SDL_Rect* runs = renderer == NULL ? NULL : malloc(sizeof(SDL_Rect) * maxRuns);
+        if (runs != NULL) {
+            int numRuns = 0;
+            for (i = 0; i < nsegments; i++) {
+                numRuns += addLineRuns(&runs[numRuns], &endpoints[2 * i], &endpoints[2 * i + 1]);
+            }
+            setForegroundDrawColor(renderer, gContext);
+            while (nextClipRect(&clip, renderer)) {
+                if (SDL_RenderFillRects(renderer, runs, numRuns)) {
+                    LOG("SDL_RenderFillRects failed in %s: %s\n", __func__, SDL_GetError());
+                }
+            }
+            free(runs);
+        } else if (renderer != NULL) {
+            free(endpoints);
+            handleOutOfMemory(0, display, 0, 0);
+            return 0;
+        } else {
+            success = False;
+        }
+    }
+    free(endpoints);
+    if (!success) {
+        LOG("Failed to draw on the drawable in %s: %s\n", __func__, SDL_GetError());
+        handleError(0, display, d, 0, BadDrawable, 0);
+        return 0;
+    }
+    damageDrawable(d, clip.bounds.x, clip.bounds.y, (unsigned int) clip.bounds.w, (unsigned int) clip.bounds.h);
     return 1;
 }
 
@@ -370,8 +968,86 @@ int XFillRectangle(Display *dpy, Drawable d, GC gc, int x, int y, unsigned int w
     return XFillRectangles(dpy, d, gc, &rect, 1);
 }
 
+/*
+ * Fill the rectangles with the fill style of the graphic context, with a single call to the backend
+ * for each style and clip rectangle. The caller damages the filled area.
+ */
+static Bool fillRectangles(Display* display, Drawable d, GraphicContext* gContext, SDL_Rect* rectangles,
+                           int nrectangles) {
+    SDL_Rect bounds = {0, 0, 0, 0};
+    int i;
+    for (i = 0; i < nrectangles; i++) {
+        if (SDL_RectEmpty(&rectangles[i])) { continue; }
+        if (SDL_RectEmpty(&bounds)) {
+            bounds = rectangles[i];
+        } else {
+            SDL_UnionRect(&bounds, &rectangles[i], &bounds);
+        }
+    }
+    ClipIterator clip;
+    if (!initClipIterator(&clip, d, gContext, &bounds)) { return True; }
+    if (beginSoftwareDrawing(d, gContext, &clip.bounds, None, NULL)) {
+        Bool filled = pixmanFillRectangles(d, gContext, &clip, rectangles, nrectangles);
+        endSoftwareDrawing();
+        if (!filled) {
+            LOG("Failed to get the image of the drawable in %s\n", __func__);
+            handleError(0, display, d, 0, BadDrawable, 0);
+            return False;
+        }
+        return True;
+    }
+    SDL_Renderer* renderer = NULL;
+    GET_RENDERER(d, renderer);
+    if (renderer == NULL) {
+        LOG("Failed to create renderer in %s: %s\n", __func__, SDL_GetError());
+        handleError(0, display, d, 0, BadDrawable, 0);
+        return False;
+    }
+    LOG("bgColor: 0x%08lx, fgColor: 0x%08lx\n", gContext->background, gContext->foreground);
+    // Getting a pattern may switch the render target, which drops the clip rect, so it comes first.
+    FillPattern* pattern = NULL;
+    Bool stippled = gContext->fillStyle == FillOpaqueStippled || gContext->fillStyle == FillStippled;
+    if (gContext->fillStyle == FillTiled) {
+        LOG("Fill_style is %s\n", "FillTiled");
+        if (IS_TYPE(gContext->tile, PIXMAP)) {
+            pattern = getFillPatternTexture(renderer, gContext->tile, False);
+        }
+    } else if (stippled) {
+        LOG("Fill_style is %s\n", gContext->fillStyle == FillStippled ? "FillStippled" : "FillOpaqueStippled");
+        if (IS_TYPE(gContext->stipple, PIXMAP)) {
+            pattern = getFillPatternTexture(renderer, gContext->stipple, True);
+        }
+        if (pattern != NULL) {
+            long color = gContext->foreground;
+            SDL_SetTextureColorMod(pattern->texture, GET_RED_FROM_COLOR(color), GET_GREEN_FROM_COLOR(color),
+                                   GET_BLUE_FROM_COLOR(color));
+        }
+    } else {
+        LOG("Fill_style is %s\n", "FillSolid");
+    }
+    Bool fillsSolid = gContext->fillStyle == FillSolid || gContext->fillStyle == FillOpaqueStippled;
+    if (fillsSolid) {
+        // Opaque stipples fill the background first.
+        long color = gContext->fillStyle == FillSolid ? gContext->foreground : gContext->background;
+        setRenderDrawColor(renderer, GET_RED_FROM_COLOR(color), GET_GREEN_FROM_COLOR(color),
+                           GET_BLUE_FROM_COLOR(color), GET_ALPHA_FROM_COLOR(color));
+        setRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    }
+    while (nextClipRect(&clip, renderer)) {
+        if (fillsSolid && SDL_RenderFillRects(renderer, rectangles, nrectangles)) {
+            LOG("SDL_RenderFillRects failed in %s: %s\n", __func__, SDL_GetError());
+        }
+        if (pattern != NULL) {
+            fillRectanglesWithPattern(renderer, pattern, gContext->tileStipOriginX, gContext->tileStipOriginY,
+                                      rectangles, nrectangles);
+        }
+    }
+    return True;
+}
+
 int XFillRectangles(Display *display, Drawable d, GC gc, XRectangle *rectangles, int nrectangles) {
     // https://tronche.com/gui/x/xlib/graphics/filling-areas/XFillRectangles.html
+    int i;
     SET_X_SERVER_REQUEST(display, X_PolyFillRectangle);
     TYPE_CHECK(d, DRAWABLE, display, 0);
     LOG("%s: Drawing on %p\n", __func__, d);
@@ -380,16 +1056,7 @@ int XFillRectangles(Display *display, Drawable d, GC gc, XRectangle *rectangles,
         handleError(0, display, None, 0, BadValue, 0);
         return 0;
     }
-    SDL_Renderer* renderer = NULL;
-    GET_RENDERER(d, renderer);
-    if (renderer == NULL) {
-        LOG("Failed to create renderer in %s: %s\n", __func__, SDL_GetError());
-        handleError(0, display, d, 0, BadDrawable, 0);
-        return 0;
-    }
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
     SDL_Rect sdlRectangles[nrectangles];
-    int i;
     for (i = 0; i < nrectangles; i++) {
         sdlRectangles[i].x = (int) rectangles[i].x;
         sdlRectangles[i].y = (int) rectangles[i].y;
@@ -398,50 +1065,172 @@ int XFillRectangles(Display *display, Drawable d, GC gc, XRectangle *rectangles,
         LOG("{x = %d, y = %d, w = %d, h = %d}\n", sdlRectangles[i].x,
                 sdlRectangles[i].y, sdlRectangles[i].w, sdlRectangles[i].h);
     }
+    if (!fillRectangles(display, d, GET_GC(gc), sdlRectangles, nrectangles)) {
+        return 0;
+    }
+    for (i = 0; i < nrectangles; i++) {
+        damageDrawable(d, sdlRectangles[i].x, sdlRectangles[i].y, sdlRectangles[i].w, sdlRectangles[i].h);
+    }
+    return 1;
+}
+
+void paintWindowBackground(Display* display, Window window, const SDL_Rect* area) {
+    if (IS_INPUT_ONLY(window)) { return; }
+    SDL_Rect rect = {0, 0, 0, 0};
+    GET_WINDOW_DIMS(window, rect.w, rect.h);
+    if (!SDL_IntersectRect(area, &rect, &rect)) { return; }
+    // A ParentRelative background is the background of the parent, aligned with the parent.
+    Window source = window;
+    int originX = 0, originY = 0;
+    while (GET_WINDOW_STRUCT(source)->background == ParentRelative && GET_PARENT(source) != None) {
+        originX -= GET_WINDOW_STRUCT(source)->x;
+        originY -= GET_WINDOW_STRUCT(source)->y;
+        source = GET_PARENT(source);
+    }
+    WindowStruct* sourceStruct = GET_WINDOW_STRUCT(source);
+    // Like on an X server, a window without a background keeps the content of the exposed area.
+    if (sourceStruct->background == None && !sourceStruct->hasBackgroundPixel) { return; }
+    GraphicContext gContext;
+    initGraphicContext(&gContext);
+    if (sourceStruct->background != ParentRelative && IS_TYPE(sourceStruct->background, PIXMAP)) {
+        gContext.fillStyle = FillTiled;
+        gContext.tile = sourceStruct->background;
+        gContext.tileStipOriginX = originX;
+        gContext.tileStipOriginY = originY;
+    } else {
+        gContext.foreground = sourceStruct->backgroundColor;
+    }
+    if (fillRectangles(display, window, &gContext, &rect, 1)) {
+        damageDrawable(window, rect.x, rect.y, (unsigned int) rect.w, (unsigned int) rect.h);
+    }
+}
+
+int XClearArea(Display *display, Window w, int x, int y, unsigned int width, unsigned int height, Bool exposures) {
+    // https://tronche.com/gui/x/xlib/graphics/XClearArea.html
+    SET_X_SERVER_REQUEST(display, X_ClearArea);
+    TYPE_CHECK(w, WINDOW, display, 0);
+    if (IS_INPUT_ONLY(w)) {
+        handleError(0, display, w, 0, BadMatch, 0);
+        return 0;
+    }
+    WindowStruct* windowStruct = GET_WINDOW_STRUCT(w);
+    SDL_Rect area = {x, y, (int) width, (int) height};
+    if (width == 0) area.w = (int) windowStruct->w - x;
+    if (height == 0) area.h = (int) windowStruct->h - y;
+    if (area.w <= 0 || area.h <= 0) { return 1; }
+    if (exposures) {
+        // Exposing the area paints the background.
+        postExposeEvent(display, w, &area, 1);
+    } else {
+        paintWindowBackground(display, w, &area);
+    }
+    return 1;
+}
+
+int XClearWindow(Display *display, Window w) {
+    // https://tronche.com/gui/x/xlib/graphics/XClearWindow.html
+    return XClearArea(display, w, 0, 0, 0, 0, False);
+}
+
+/* Fill the spans of a rasterized shape as one batch of rectangles and damage their bounds. */
+static Bool fillSpans(Display* display, Drawable d, GraphicContext* gContext, SpanBuffer* spans) {
+    if (spans->failed) {
+        handleOutOfMemory(0, display, 0, 0);
+        return False;
+    }
+    SDL_Rect bounds;
+    if (!getSpanBounds(spans, &bounds)) { return True; }
+    statistics.rasterizedShapes++;
+    statistics.rasterizedRectangles += spans->numRectangles;
+    if (!fillRectangles(display, d, gContext, spans->rectangles, spans->numRectangles)) {
+        return False;
+    }
+    damageDrawable(d, bounds.x, bounds.y, (unsigned int) bounds.w, (unsigned int) bounds.h);
+    return True;
+}
+
+/* Only rasterize the part of the shape that the clip region of the graphic context lets through. */
+static void initDrawableSpanBuffer(SpanBuffer* spans, Drawable d, GraphicContext* gContext) {
+    ClipIterator clip;
+    initClipIterator(&clip, d, gContext, NULL);
+    initSpanBuffer(spans, &clip.bounds);
+}
+
+int XFillPolygon(Display* display, Drawable d, GC gc, XPoint *points, int npoints, int shape, int mode) {
+    // https://tronche.com/gui/x/xlib/graphics/filling-areas/XFillPolygon.html
+    SET_X_SERVER_REQUEST(display, X_FillPoly);
+    TYPE_CHECK(d, DRAWABLE, display, 0);
+    LOG("%s: Drawing %d points on %p\n", __func__, npoints, d);
+    (void) shape;
+    if (npoints < 3) { return 1; }
     GraphicContext* gContext = GET_GC(gc);
-    LOG("bgColor: 0x%08lx, fgColor: 0x%08lx\n", gContext->background, gContext->foreground);
-    if (gContext->fillStyle == FillSolid) {
-        LOG("Fill_style is %s\n", "FillSolid");
-        long color = gContext->foreground;
-        SDL_SetRenderDrawColor(renderer,
-                               GET_RED_FROM_COLOR(color),
-                               GET_GREEN_FROM_COLOR(color),
-                               GET_BLUE_FROM_COLOR(color),
-                               GET_ALPHA_FROM_COLOR(color));
-        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
-        if (SDL_RenderFillRects(renderer, &sdlRectangles[0], nrectangles)) {
-            LOG("SDL_RenderFillRects failed in %s: %s\n", __func__, SDL_GetError());
-        }
-    } else if (gContext->fillStyle == FillTiled) {
-        LOG("Fill_style is %s\n", "FillTiled");
-    } else if (gContext->fillStyle == FillOpaqueStippled) {
-        LOG("Fill_style is %s\n", "FillOpaqueStippled");
-        SDL_Rect viewPort;
-        SDL_RenderGetViewport(renderer, &viewPort);
-        SDL_Surface* renderSurface = SDL_CreateRGBSurface(0, viewPort.w, viewPort.h, SDL_SURFACE_DEPTH, DEFAULT_RED_MASK,
-                                                          DEFAULT_GREEN_MASK, DEFAULT_BLUE_MASK,
-                                                          DEFAULT_ALPHA_MASK);
-        if (renderSurface == NULL) {
-            LOG("Failed to create rendering surface in %s: %s\n", __func__, SDL_GetError());
-            return 0;
-        }
-        if (SDL_FillRects(renderSurface, &sdlRectangles[0], nrectangles, gContext->background)) {
-            LOG("SDL_FillRects failed in %s: %s\n", __func__, SDL_GetError());
-            SDL_FreeSurface(renderSurface);
+    XPoint* absolutePoints = points;
+    if (mode == CoordModePrevious) {
+        absolutePoints = malloc(sizeof(XPoint) * npoints);
+        if (absolutePoints == NULL) {
+            handleOutOfMemory(0, display, 0, 0);
             return 0;
         }
-//        colorClipped(renderSurface, GET_SURFACE(gc->stipple), gc->ts_x_origin, gc->ts_y_origin, gc->foreground);
-        SDL_Texture* renderTexture = SDL_CreateTextureFromSurface(renderer, renderSurface);
-        if (renderTexture == NULL) {
-            LOG("Failed to create texture in %s: %s\n", __func__, SDL_GetError());
-        } else {
-            SDL_RenderCopy(renderer, renderTexture, NULL, NULL);
+        int i;
+        absolutePoints[0] = points[0];
+        for (i = 1; i < npoints; i++) {
+            absolutePoints[i].x = absolutePoints[i - 1].x + points[i].x;
+            absolutePoints[i].y = absolutePoints[i - 1].y + points[i].y;
         }
-        SDL_DestroyTexture(renderTexture);
-        SDL_FreeSurface(renderSurface);
-    } else if (gContext->fillStyle == FillStippled) {
-        LOG("Fill_style is %s\n", "FillStippled");
     }
-    SDL_RenderPresent(renderer);
-    return 1;
+    SpanBuffer spans;
+    initDrawableSpanBuffer(&spans, d, gContext);
+    fillPolygonSpans(&spans, absolutePoints, npoints, gContext->fillRule);
+    if (absolutePoints != points) { free(absolutePoints); }
+    Bool success = fillSpans(display, d, gContext, &spans);
+    freeSpanBuffer(&spans);
+    return success ? 1 : 0;
+}
+
+int XFillArcs(Display *display, Drawable d, GC gc, XArc *arcs, int narcs) {
+    // https://tronche.com/gui/x/xlib/graphics/filling-areas/XFillArcs.html
+    SET_X_SERVER_REQUEST(display, X_PolyFillArc);
+    TYPE_CHECK(d, DRAWABLE, display, 0);
+    LOG("%s: Drawing %d arcs on %p\n", __func__, narcs, d);
+    GraphicContext* gContext = GET_GC(gc);
+    SpanBuffer spans;
+    int i;
+    initDrawableSpanBuffer(&spans, d, gContext);
+    for (i = 0; i < narcs; i++) {
+        fillArcSpans(&spans, arcs[i].x, arcs[i].y, arcs[i].width, arcs[i].height,
+                     arcs[i].angle1, arcs[i].angle2, gContext->arcMode);
+    }
+    Bool success = fillSpans(display, d, gContext, &spans);
+    freeSpanBuffer(&spans);
+    return success ? 1 : 0;
+}
+
+int XFillArc(Display *display, Drawable d, GC gc, int x, int y, unsigned int width, unsigned int height, int angle1, int angle2) {
+    // https://tronche.com/gui/x/xlib/graphics/filling-areas/XFillArc.html
+    XArc arc = { x, y, width, height, angle1, angle2 };
+    return XFillArcs(display, d, gc, &arc, 1);
+}
+
+int XDrawArcs(Display *display, Drawable d, GC gc, XArc *arcs, int narcs) {
+    // https://tronche.com/gui/x/xlib/graphics/drawing/XDrawArcs.html
+    SET_X_SERVER_REQUEST(display, X_PolyArc);
+    TYPE_CHECK(d, DRAWABLE, display, 0);
+    LOG("%s: Drawing %d arcs on %p\n", __func__, narcs, d);
+    GraphicContext* gContext = GET_GC(gc);
+    SpanBuffer spans;
+    int i;
+    initDrawableSpanBuffer(&spans, d, gContext);
+    for (i = 0; i < narcs; i++) {
+        strokeArcSpans(&spans, arcs[i].x, arcs[i].y, arcs[i].width, arcs[i].height,
+                       arcs[i].angle1, arcs[i].angle2, gContext->lineWidth);
+    }
+    Bool success = fillSpans(display, d, gContext, &spans);
+    freeSpanBuffer(&spans);
+    return success ? 1 : 0;
+}
+
+int XDrawArc(Display *display, Drawable d, GC gc, int x, int y, unsigned int width, unsigned int height, int angle1, int angle2) {
+    // https://tronche.com/gui/x/xlib/graphics/drawing/XDrawArc.html
+    XArc arc = { x, y, width, height, angle1, angle2 };
+    return XDrawArcs(display, d, gc, &arc, 1);
 }
@@ -4,6 +4,8 @@
 #include <SDL2/SDL.h>
 #include "resourceTypes.h"
 #include "window.h"
+#include "pixmap.h"
+#include "rendererState.h"
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN || 1
 #  define DEFAULT_RED_MASK   0xFF000000
@@ -20,13 +22,13 @@
 
 #define LOCK_SURFACE(surface)   if (SDL_MUSTLOCK(surface)) SDL_LockSurface(surface)
 #define UNLOCK_SURFACE(surface) if (SDL_MUSTLOCK(surface)) SDL_UnlockSurface(surface)
-#define GET_PIXMAP_TEXTURE(pixmap) (IS_TYPE(pixmap, PIXMAP) ? ((SDL_Texture*) GET_XID_VALUE(pixmap)) : NULL)
+#define GET_PIXMAP_TEXTURE(pixmap) (IS_TYPE(pixmap, PIXMAP) ? GET_PIXMAP_STRUCT(pixmap)->texture : NULL)
 #define GET_RENDERER(drawable, renderer) \
 if (IS_TYPE(drawable, WINDOW)) {\
     renderer = getWindowRenderer(drawable);\
 } else if (IS_TYPE(drawable, PIXMAP)) {\
     renderer = GET_WINDOW_STRUCT(SCREEN_WINDOW)->sdlRenderer;\
-    if (SDL_SetRenderTarget(renderer, GET_PIXMAP_TEXTURE(drawable)) != 0) {\
+    if (!setRenderTarget(renderer, GET_PIXMAP_TEXTURE(drawable)) || !setRenderViewport(renderer, NULL)) {\
         fprintf(stderr, "SDL_SetRenderTarget failed while trying to get renderer in %s, %s, %d: %s\n", __FILE__, __func__, __LINE__, SDL_GetError());\
     }\
 } else {\
@@ -39,8 +41,17 @@ void drawDebugWindowSurfacePlanes();
 #endif
 void putPixel(SDL_Surface *surface, unsigned int x, unsigned int y, Uint32 pixel);
 Uint32 getPixel(SDL_Surface *surface, unsigned int x, unsigned int y);
+Window getRenderWindow(Window window, int* offsetX, int* offsetY);
 SDL_Renderer* getWindowRenderer(Window window);
+void getDrawableSize(Drawable drawable, int* width, int* height);
+void moveSurfaceArea(SDL_Surface* surface, SDL_Rect* srcRect, int destX, int destY);
 SDL_Surface* getRenderSurface(SDL_Renderer* renderer);
+void initPresentMode(void);
+void damageDrawable(Drawable drawable, int x, int y, unsigned int width, unsigned int height);
+/* Paint the area of the window (in window coordinates) with the background color or tiled background pixmap. */
+void paintWindowBackground(Display* display, Window window, const SDL_Rect* area);
+void markDrawableDirty(Drawable drawable);
 void drawWindowDataToScreen(void);
+void freeScratchTexture(void);
 
 #endif /* _DRAWING_H_ */
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "errors.h"
 #include <stdio.h>
 #include "display.h"
+#include "shm.h"
 
 typedef int (*errorHandlerFunction)(Display*, XErrorEvent*);
 errorHandlerFunction error_handler = defaultErrorHandler;
@@ -48,6 +49,9 @@ int defaultErrorHandler(Display* display, XErrorEvent* event) {
         case BadColor:
             fprintf(stderr, "Parameter invalid: A parameter did not name a defined color for request %d!\n", event->request_code);
             break;
+        case SHM_FIRST_ERROR + BadShmSeg:
+            fprintf(stderr, "Parameter invalid: A parameter was not a shared memory segment for request %d!\n", event->request_code);
+            break;
         default:
             fprintf(stderr, "An unknown error occurred for request %d: %u\n", event->request_code, event->error_code);
             break;
@@ -87,6 +91,8 @@ unsigned char resourceTypeToErrorCode(XResourceType resourceType) {
             return BadFont;
         case CURSOR:
             return BadCursor;
+        case SHM_SEGMENT:
+            return SHM_FIRST_ERROR + BadShmSeg;
         default:
             return BadMatch;
     }
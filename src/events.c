@@ -42,7 +42,12 @@ Bool getRectIntersection(const SDL_Rect* rect1, const SDL_Rect* rect2, SDL_Rect
 }
 
 void postExposeEvent(Display* display, Window window, const SDL_Rect* damagedAreaList, size_t numAreas) {
-    size_t i = numAreas, j;
+    size_t i, j;
+    // Like an X server without backing store, the exposed areas are cleared to the background first.
+    for (i = 0; i < numAreas; i++) {
+        paintWindowBackground(display, window, &damagedAreaList[i]);
+    }
+    i = numAreas;
     while (i-- > 0) {
         postEvent(display, window, Expose, &damagedAreaList[i], i);
     }
@@ -681,7 +686,11 @@ int convertEvent(Display* display, SDL_Event* sdlEvent, XEvent* xEvent, Bool fre
                             memcpy(&xEvent->xclient, allocEvent, sizeof(XClientMessageEvent)); break;
                         case MappingNotify:
                             memcpy(&xEvent->xmapping, allocEvent, sizeof(XMappingEvent)); break;
-                        default: break;
+                        default:
+                            if (type >= LASTEvent) {
+                                memcpy(xEvent, allocEvent, sizeof(XEvent));
+                            }
+                            break;
                     }
                     if (freeInternalEvents) free(allocEvent);
                     break;
@@ -775,6 +784,8 @@ int XNextEvent(Display* display, XEvent* event_return) {
     // https://tronche.com/gui/x/xlib/event-handling/manipulating-event-queue/XNextEvent.html
     SDL_Event event;
     Bool done = False;
+    // Everything drawn so far has to be visible before we block waiting for input
+    drawWindowDataToScreen();
     while (!done) {
         int qlen;
         getEventQueueLength(&qlen);
@@ -920,8 +931,11 @@ Bool XFilterEvent(XEvent *event, Window w) {
 int XEventsQueued(Display *display, int mode) {
     // https://tronche.com/gui/x/xlib/event-handling/XEventsQueued.html
 //    SET_X_SERVER_REQUEST(display, XCB_);
-    if (GET_DISPLAY(display)->qlen == 0 && mode != QueuedAlready) {
-        SDL_PumpEvents();
+    if (mode != QueuedAlready) {
+        drawWindowDataToScreen();
+        if (GET_DISPLAY(display)->qlen == 0) {
+            SDL_PumpEvents();
+        }
     }
     return GET_DISPLAY(display)->qlen;
 }
@@ -929,8 +943,8 @@ int XEventsQueued(Display *display, int mode) {
 int XFlush(Display *display) {
     // https://tronche.com/gui/x/xlib/event-handling/XFlush.html
     //SET_X_SERVER_REQUEST(display, XCB_);
+    drawWindowDataToScreen();
     SDL_PumpEvents(); // TODO: This locks up the main thread
-    //drawWindowDataToScreen();
     return 1;
 }
 
@@ -1185,6 +1199,36 @@ Bool postEvent(Display* display, Window eventWindow, unsigned int eventId, ...)
             eventData = event;
             break;
         }
+        case GraphicsExpose: {
+            XGraphicsExposeEvent* event = malloc(sizeof(XGraphicsExposeEvent));
+            if (event == NULL) break;
+            event->type = eventId;
+            event->send_event = False;
+            event->display = display;
+            event->drawable = eventWindow;
+            SDL_Rect* exposeRect = va_arg(args, SDL_Rect*);
+            event->x = exposeRect->x;
+            event->y = exposeRect->y;
+            event->width = exposeRect->w;
+            event->height = exposeRect->h;
+            event->count = va_arg(args, int);
+            event->major_code = va_arg(args, int);
+            event->minor_code = va_arg(args, int);
+            eventData = event;
+            break;
+        }
+        case NoExpose: {
+            XNoExposeEvent* event = malloc(sizeof(XNoExposeEvent));
+            if (event == NULL) break;
+            event->type = eventId;
+            event->send_event = False;
+            event->display = display;
+            event->drawable = eventWindow;
+            event->major_code = va_arg(args, int);
+            event->minor_code = va_arg(args, int);
+            eventData = event;
+            break;
+        }
         case KeyRelease:
         case KeyPress:
 //            memcpy(&xEvent->xkey, allocEvent, sizeof(XKeyEvent)); break;
@@ -1201,10 +1245,7 @@ Bool postEvent(Display* display, Window eventWindow, unsigned int eventId, ...)
 //            memcpy(&xEvent->xfocus, allocEvent, sizeof(XFocusChangeEvent)); break;
         case KeymapNotify:
 //            memcpy(&xEvent->xexpose, allocEvent, sizeof(XExposeEvent)); break;
-        case GraphicsExpose:
-//            memcpy(&xEvent->xgraphicsexpose, allocEvent, sizeof(XGraphicsExposeEvent)); break;
-        case NoExpose:
-            /*memcpy(&xEvent->xnoexpose, allocEvent, sizeof(XNoExposeEvent)); */break; // TODO
+            break;
         case VisibilityNotify:
 //            memcpy(&xEvent->xvisibility, allocEvent, sizeof(XVisibilityEvent)); break;
         case GravityNotify:
@@ -12,6 +12,8 @@
 int initEventPipe(Display* display);
 unsigned int convertModifierState(Uint16 mod);
 Bool postEvent(Display* display, Window eventWindow, unsigned int eventId, ...);
+/* Queue the allocated event, extension events must be allocated with the size of an XEvent. */
+Bool enqueueEvent(Display* display, Window eventWindow, void* event);
 void postExposeEvent(Display* display, Window window, const SDL_Rect* damagedAreaList, size_t numAreas);
 
 #endif /* _EVENTS_H_ */
@@ -0,0 +1,216 @@
+#include <stdlib.h>
+#include "fillPattern.h"
+#include "drawing.h"
+#include "pixmap.h"
+#include "window.h"
+#include "util.h"
+
+/* Small patterns are repeated in their texture until it is at least this large. */
+#define MIN_FILL_PATTERN_TEXTURE_SIZE 128
+
+static FillPattern* fillPatterns = NULL;
+
+static void freeFillPattern(FillPattern* pattern) {
+    if (pattern->texture != NULL) {
+        SDL_DestroyTexture(pattern->texture);
+    }
+    if (pattern->image != NULL) {
+        pixman_image_unref(pattern->image);
+    }
+    free(pattern);
+}
+
+static void freeFillPatterns(Pixmap pixmap, SDL_Renderer* renderer) {
+    FillPattern** patternPointer = &fillPatterns;
+    while (*patternPointer != NULL) {
+        FillPattern* pattern = *patternPointer;
+        if (pattern->pixmap == pixmap || (renderer != NULL && pattern->renderer == renderer)) {
+            *patternPointer = pattern->next;
+            freeFillPattern(pattern);
+        } else {
+            patternPointer = &pattern->next;
+        }
+    }
+}
+
+void freeFillPatternsOfPixmap(Pixmap pixmap) {
+    freeFillPatterns(pixmap, NULL);
+}
+
+void freeFillPatternsOfRenderer(SDL_Renderer* renderer) {
+    freeFillPatterns(None, renderer);
+}
+
+/* Find the pattern of the pixmap, creating an empty one if it does not exist or is outdated. */
+static FillPattern* findFillPattern(SDL_Renderer* renderer, Pixmap pixmap, Bool stipple, Bool* valid) {
+    unsigned long serial = GET_PIXMAP_STRUCT(pixmap)->serial;
+    FillPattern* pattern;
+    FillPattern* previous = NULL;
+    for (pattern = fillPatterns; pattern != NULL; previous = pattern, pattern = pattern->next) {
+        if (pattern->pixmap == pixmap && pattern->stipple == stipple && pattern->renderer == renderer) {
+            if (previous != NULL) {
+                // Move to the front, the same few patterns are usually used over and over again.
+                previous->next = pattern->next;
+                pattern->next = fillPatterns;
+                fillPatterns = pattern;
+            }
+            *valid = pattern->serial == serial && (pattern->texture != NULL || pattern->image != NULL);
+            if (!*valid) {
+                if (pattern->texture != NULL) SDL_DestroyTexture(pattern->texture);
+                if (pattern->image != NULL) pixman_image_unref(pattern->image);
+                pattern->texture = NULL;
+                pattern->image = NULL;
+                pattern->serial = serial;
+            }
+            return pattern;
+        }
+    }
+    *valid = False;
+    pattern = calloc(1, sizeof(FillPattern));
+    if (pattern == NULL) { return NULL; }
+    pattern->pixmap = pixmap;
+    pattern->stipple = stipple;
+    pattern->renderer = renderer;
+    pattern->serial = serial;
+    pattern->next = fillPatterns;
+    fillPatterns = pattern;
+    return pattern;
+}
+
+FillPattern* getFillPatternTexture(SDL_Renderer* renderer, Pixmap pixmap, Bool stipple) {
+    Bool valid;
+    FillPattern* pattern = findFillPattern(renderer, pixmap, stipple, &valid);
+    if (pattern == NULL || valid) { return pattern; }
+    PixmapStruct* pixmapStruct = GET_PIXMAP_STRUCT(pixmap);
+    int pixmapWidth = (int) pixmapStruct->width, pixmapHeight = (int) pixmapStruct->height;
+    Uint32* pixmapPixels = readPixmapPixels(pixmapStruct);
+    if (pixmapPixels == NULL) { return NULL; }
+    pattern->width = pixmapWidth * MAX(1, MIN_FILL_PATTERN_TEXTURE_SIZE / pixmapWidth);
+    pattern->height = pixmapHeight * MAX(1, MIN_FILL_PATTERN_TEXTURE_SIZE / pixmapHeight);
+    Uint32* pixels = malloc(sizeof(Uint32) * pattern->width * pattern->height);
+    if (pixels == NULL) {
+        free(pixmapPixels);
+        return NULL;
+    }
+    int x, y;
+    for (y = 0; y < pattern->height; y++) {
+        Uint32* row = &pixmapPixels[(y % pixmapHeight) * pixmapWidth];
+        for (x = 0; x < pattern->width; x++) {
+            Uint32 pixel = row[x % pixmapWidth];
+            // Stipples are bitmaps, every pixel that is not 0 is set.
+            pixels[y * pattern->width + x] = stipple ? (pixel != 0 ? 0xFFFFFFFF : 0x00000000) : pixel;
+        }
+    }
+    free(pixmapPixels);
+    pattern->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC,
+                                         pattern->width, pattern->height);
+    if (pattern->texture == NULL || SDL_UpdateTexture(pattern->texture, NULL, pixels,
+                                                      pattern->width * (int) sizeof(Uint32)) != 0) {
+        LOG("Failed to create the pattern texture in %s: %s\n", __func__, SDL_GetError());
+        free(pixels);
+        if (pattern->texture != NULL) SDL_DestroyTexture(pattern->texture);
+        pattern->texture = NULL;
+        return NULL;
+    }
+    free(pixels);
+    SDL_SetTextureBlendMode(pattern->texture, stipple ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+    return pattern;
+}
+
+/* Get the start of the pattern repetition at or before the coordinate. */
+static int getPatternStart(int coordinate, int origin, int size) {
+    int offset = (coordinate - origin) % size;
+    if (offset < 0) offset += size;
+    return coordinate - offset;
+}
+
+void fillRectanglesWithPattern(SDL_Renderer* renderer, FillPattern* pattern, int originX, int originY,
+                               const SDL_Rect* rectangles, int numRectangles) {
+    int i, x, y;
+    for (i = 0; i < numRectangles; i++) {
+        const SDL_Rect* rect = &rectangles[i];
+        if (rect->w <= 0 || rect->h <= 0) { continue; }
+        for (y = getPatternStart(rect->y, originY, pattern->height); y < rect->y + rect->h; y += pattern->height) {
+            for (x = getPatternStart(rect->x, originX, pattern->width); x < rect->x + rect->w; x += pattern->width) {
+                SDL_Rect patternRect = {x, y, pattern->width, pattern->height}, destRect;
+                SDL_IntersectRect(&patternRect, rect, &destRect);
+                SDL_Rect srcRect = {destRect.x - x, destRect.y - y, destRect.w, destRect.h};
+                if (SDL_RenderCopy(renderer, pattern->texture, &srcRect, &destRect) != 0) {
+                    LOG("SDL_RenderCopy failed in %s: %s\n", __func__, SDL_GetError());
+                    return;
+                }
+            }
+        }
+    }
+}
+
+/* Create an a8 mask which is opaque wherever a pixel is set in the stipple. */
+static pixman_image_t* createStippleMask(PixmapStruct* pixmapStruct) {
+    pixman_image_t* mask = pixman_image_create_bits(PIXMAN_a8, pixmapStruct->width,
+                                                    pixmapStruct->height, NULL, 0);
+    if (mask == NULL) { return NULL; }
+    // Stipples drawn with raster operations by the SDL renderer backend are read from their texture.
+    uint32_t* srcPixels = pixmapStruct->image != NULL ? pixman_image_get_data(pixmapStruct->image)
+                                                      : readPixmapPixels(pixmapStruct);
+    if (srcPixels == NULL) {
+        pixman_image_unref(mask);
+        return NULL;
+    }
+    int srcStride = pixmapStruct->image != NULL
+                    ? pixman_image_get_stride(pixmapStruct->image) / (int) sizeof(uint32_t)
+                    : (int) pixmapStruct->width;
+    uint32_t setBits = pixmapStruct->image != NULL ? 0x00FFFFFF : 0xFFFFFFFF;
+    uint8_t* maskPixels = (uint8_t*) pixman_image_get_data(mask);
+    int maskStride = pixman_image_get_stride(mask);
+    unsigned int x, y;
+    for (y = 0; y < pixmapStruct->height; y++) {
+        for (x = 0; x < pixmapStruct->width; x++) {
+            maskPixels[y * maskStride + x] = (srcPixels[y * srcStride + x] & setBits) ? 0xFF : 0x00;
+        }
+    }
+    if (pixmapStruct->image == NULL) {
+        free(srcPixels);
+    }
+    return mask;
+}
+
+/* Create an image which shares the pixels of the tile pixmap, or holds a copy of its texture. */
+static pixman_image_t* createTileImage(PixmapStruct* pixmapStruct) {
+    pixman_image_t* tileImage = pixmapStruct->image;
+    if (tileImage != NULL) {
+        return pixman_image_create_bits(PIXMAN_x8r8g8b8, pixman_image_get_width(tileImage),
+                                        pixman_image_get_height(tileImage), pixman_image_get_data(tileImage),
+                                        pixman_image_get_stride(tileImage));
+    }
+    Uint32* pixels = readPixmapPixels(pixmapStruct);
+    if (pixels == NULL) { return NULL; }
+    tileImage = pixman_image_create_bits(PIXMAN_x8r8g8b8, (int) pixmapStruct->width,
+                                         (int) pixmapStruct->height, NULL, 0);
+    if (tileImage != NULL) {
+        uint32_t* tilePixels = pixman_image_get_data(tileImage);
+        int tileStride = pixman_image_get_stride(tileImage) / (int) sizeof(uint32_t);
+        unsigned int x, y;
+        for (y = 0; y < pixmapStruct->height; y++) {
+            for (x = 0; x < pixmapStruct->width; x++) {
+                // RGBA to ARGB
+                Uint32 pixel = pixels[y * pixmapStruct->width + x];
+                tilePixels[y * tileStride + x] = pixel >> 8 | pixel << 24;
+            }
+        }
+    }
+    free(pixels);
+    return tileImage;
+}
+
+pixman_image_t* getFillPatternImage(Pixmap pixmap, Bool stipple) {
+    Bool valid;
+    FillPattern* pattern = findFillPattern(NULL, pixmap, stipple, &valid);
+    if (pattern == NULL || valid) { return pattern == NULL ? NULL : pattern->image; }
+    PixmapStruct* pixmapStruct = GET_PIXMAP_STRUCT(pixmap);
+    pattern->image = stipple ? createStippleMask(pixmapStruct) : createTileImage(pixmapStruct);
+    if (pattern->image == NULL) { return NULL; }
+    pixman_image_set_repeat(pattern->image, PIXMAN_REPEAT_NORMAL);
+    pattern->width = (int) pixmapStruct->width;
+    pattern->height = (int) pixmapStruct->height;
+    return pattern->image;
+}
@@ -0,0 +1,36 @@
+#ifndef _FILL_PATTERN_H_
+#define _FILL_PATTERN_H_
+
+#include <SDL2/SDL.h>
+#include <pixman.h>
+#include "X11/Xlib.h"
+
+/*
+ * Fill patterns cache the tiles and stipples of graphic contexts in a form that can be
+ * repeated over a filled area: a texture of the renderer that draws the fill, or a
+ * repeating pixman image. A pattern is recreated when the serial of its pixmap changes.
+ * Stipple textures are white where the stipple is set and transparent elsewhere,
+ * stipple images are a8 masks. Images of texture pixmaps hold a copy of their pixels.
+ */
+typedef struct FillPattern {
+    Pixmap pixmap;
+    Bool stipple;
+    /* The renderer of the texture, or NULL if the pattern is a pixman image. */
+    SDL_Renderer* renderer;
+    SDL_Texture* texture;
+    pixman_image_t* image;
+    /* The size of the texture, a multiple of the pixmap size, so few copies cover large areas. */
+    int width, height;
+    unsigned long serial;
+    struct FillPattern* next;
+} FillPattern;
+
+FillPattern* getFillPatternTexture(SDL_Renderer* renderer, Pixmap pixmap, Bool stipple);
+pixman_image_t* getFillPatternImage(Pixmap pixmap, Bool stipple);
+/* Fill the rectangles by repeating the texture of the pattern, starting at the origin. */
+void fillRectanglesWithPattern(SDL_Renderer* renderer, FillPattern* pattern, int originX, int originY,
+                               const SDL_Rect* rectangles, int numRectangles);
+void freeFillPatternsOfPixmap(Pixmap pixmap);
+void freeFillPatternsOfRenderer(SDL_Renderer* renderer);
+
+#endif /* _FILL_PATTERN_H_ */
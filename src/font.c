@@ -1,6 +1,5 @@
 #include "X11/Xatom.h"
 #include <stdio.h>
-#include <wchar.h>
 #include <sys/stat.h>
 #include <errno.h>
 #include <dirent.h>
@@ -12,12 +11,20 @@
 #include "resourceTypes.h"
 #include "atoms.h"
 #include "drawing.h"
+#include "glyphAtlas.h"
+#include "texturePool.h"
+#include "pixmanBackend.h"
+#include "rasterOp.h"
 #include "display.h"
 #include "gc.h"
+#include "clip.h"
 #include "util.h"
 #include "font.h"
+#include "fontMetricsCache.h"
+#include "fontDirectoryIndex.h"
+#include "fontNameIndex.h"
+#include "statistics.h"
 
-// TODO: Maybe implement character atlas
 // TODO: Convert text decoding to Utf-8
 // http://www.cprogramming.com/tutorial/unicode.html
 
@@ -26,9 +33,34 @@ typedef struct {
     char* XLFName;
 } FontCacheEntry;
 
-#define GET_FONT(fontXID) ((TTF_Font*) GET_XID_VALUE(fontXID))
+#define FONT_METRICS_PAGE_SIZE 256
+#define NUM_FONT_METRICS_PAGES (0x10000 / FONT_METRICS_PAGE_SIZE)
+
+/* An opened font file at one size and style, shared by all font XIDs which were loaded with them. */
+typedef struct {
+    TTF_Font* ttfFont;
+    char* filePath;
+    int size;
+    int style;
+    unsigned int referenceCount;
+    /* The metrics of the characters in the BMP, loaded in pages of FONT_METRICS_PAGE_SIZE when first used. */
+    XCharStruct* metrics[NUM_FONT_METRICS_PAGES];
+} FontInstance;
+
+#define GET_FONT_INSTANCE(fontXID) ((FontInstance*) GET_XID_VALUE(fontXID))
+#define GET_FONT(fontXID) (GET_FONT_INSTANCE(fontXID)->ttfFont)
 #define FONT_SIZE 12
 
+/* Fields of an XLFD name, counted from the empty field before the first dash. */
+#define XLFD_WEIGHT_NAME_FIELD 3
+#define XLFD_SLANT_FIELD 4
+#define XLFD_PIXEL_SIZE_FIELD 7
+#define XLFD_POINT_SIZE_FIELD 8
+#define XLFD_RESOLUTION_X_FIELD 9
+#define XLFD_RESOLUTION_Y_FIELD 10
+#define XLFD_AVERAGE_WIDTH_FIELD 12
+#define DEFAULT_FONT_RESOLUTION 75
+
 // Only search for fonts in the folder fonts
 static const char* DEFAULT_FONT_SEARCH_PATHS[] = {
     "fonts"
@@ -38,6 +70,10 @@ static const char* DEFAULT_FONT_SEARCH_PATHS[] = {
 // Has to be initialized via XSetFontPath(display, NULL, 0);
 Array* fontSearchPaths = NULL;
 Array* fontCache = NULL;
+// An index over the XLFD names of the fonts in the font cache, rebuilt whenever the cache changes.
+static FontNameIndex* fontNameIndex = NULL;
+// The opened fonts, see FontInstance.
+static Array fontInstances = {NULL, 0, 0};
 
 // Check if the given path points to an existing directory
 Bool checkFontPath(const char* path) {
@@ -53,20 +89,17 @@ Bool checkFontPath(const char* path) {
     return False;
 }
 
-char* getFontXLFDName(TTF_Font* font) {
+static char* formatFontXLFDName(const char* familyName, int fontStyle, Bool fixedWidth) {
     /* FOUNDRY - FAMILY_NAME - WEIGHT_NAME - SLANT - SETWIDTH_NAME - ADD_STYLE - PIXEL_SIZE -
        POINT_SIZE - RESOLUTION_X - RESOLUTION_Y - SPACING - AVERAGE_WIDTH - CHARSET_REGISTRY -
        CHARSET_ENCODING */
-    int fontStyle = TTF_GetFontStyle(font);
     static char* emptyValue = "";
     char* foundry = emptyValue;
-    char* familyName = TTF_FontFaceFamilyName(font);
-    if (familyName == NULL) familyName = emptyValue;
     char* weightName = fontStyle & TTF_STYLE_BOLD ? "bold" : "medium";
     char slant = (char) (fontStyle & TTF_STYLE_ITALIC ? 'i' : 'r');
     char* setWidth = "normal";
     int pointSize = 0;
-    char spacing = (char) (TTF_FontFaceIsFixedWidth(font) ? 'm' : 'p');
+    char spacing = (char) (fixedWidth ? 'm' : 'p');
     short averageWidth = 0;
     char* charset = "iso10646"; // Unicode
     int charsetEncoding = 1;
@@ -84,6 +117,39 @@ char* getFontXLFDName(TTF_Font* font) {
     return name;
 }
 
+static const char* getFontFamilyName(TTF_Font* font) {
+    const char* familyName = TTF_FontFaceFamilyName(font);
+    return familyName == NULL ? "" : familyName;
+}
+
+char* getFontXLFDName(TTF_Font* font) {
+    return formatFontXLFDName(getFontFamilyName(font), TTF_GetFontStyle(font),
+                              TTF_FontFaceIsFixedWidth(font) ? True : False);
+}
+
+/*
+ * Get the XLFD name of the font file in the directory, either from the index of the
+ * directory or by opening the font if it was added or changed since the index was written.
+ */
+static char* getFontFileXLFDName(FontDirectoryIndex* index, const char* fileName, const char* filePath) {
+    struct stat fileStat;
+    if (stat(filePath, &fileStat) != 0) return NULL;
+    FontIndexEntry* indexEntry = index == NULL ? NULL : findFontDirectoryIndexEntry(index, fileName, &fileStat);
+    if (indexEntry != NULL) {
+        return formatFontXLFDName(indexEntry->familyName, indexEntry->style, indexEntry->fixedWidth);
+    }
+    TTF_Font* font = TTF_OpenFont(filePath, FONT_SIZE);
+    if (font == NULL) return NULL;
+    int style = TTF_GetFontStyle(font);
+    Bool fixedWidth = TTF_FontFaceIsFixedWidth(font) ? True : False;
+    if (index != NULL) {
+        addFontDirectoryIndexEntry(index, fileName, &fileStat, getFontFamilyName(font), style, fixedWidth);
+    }
+    char* name = formatFontXLFDName(getFontFamilyName(font), style, fixedWidth);
+    TTF_CloseFont(font);
+    return name;
+}
+
 Bool fontCacheEntryFileNameCmp(void* entry, void* name) {
     size_t nameLen = strlen(name);
     size_t pathLen = strlen(((FontCacheEntry*) entry)->filePath);
@@ -91,8 +157,30 @@ Bool fontCacheEntryFileNameCmp(void* entry, void* name) {
     return strcmp(&((FontCacheEntry*) entry)->filePath[pathLen - nameLen], name) == 0;
 }
 
-Bool fontCmp(void* entry, void* fontWildCard) {
-    return matchWildcard(fontWildCard, ((FontCacheEntry*) entry)->XLFName);
+static void updateFontNameIndex() {
+    size_t i;
+    char** names = malloc(sizeof(char*) * MAX(1, fontCache->length));
+    if (names == NULL) return;
+    for (i = 0; i < fontCache->length; i++) {
+        names[i] = ((FontCacheEntry*) fontCache->array[i])->XLFName;
+    }
+    fontNameIndex = createFontNameIndex(names, fontCache->length);
+    free(names);
+}
+
+/* Find the indices of up to maxMatches fonts in the font cache whose name matches the pattern. */
+static size_t findFontCacheEntries(const char* pattern, size_t* matches, size_t maxMatches) {
+    size_t i, numMatches = 0;
+    if (fontNameIndex != NULL) {
+        return findFontNames(fontNameIndex, pattern, matches, maxMatches);
+    }
+    // Without the index, e.g. because we ran out of memory while building it, fall back to a linear search.
+    for (i = 0; i < fontCache->length && numMatches < maxMatches; i++) {
+        if (matchWildcard(pattern, ((FontCacheEntry*) fontCache->array[i])->XLFName)) {
+            matches[numMatches++] = i;
+        }
+    }
+    return numMatches;
 }
 
 Bool updateFontCache() {
@@ -101,6 +189,9 @@ Bool updateFontCache() {
     DIR* fontDirectory;
     struct dirent* entry;
     char pathBuffer[512];
+    // The index refers to positions in the font cache, which are about to change.
+    freeFontNameIndex(fontNameIndex);
+    fontNameIndex = NULL;
     for (i = 0; i < fontSearchPaths->length; i++) {
         char* fontDirPath = fontSearchPaths->array[i];
         fontDirectory = opendir(fontDirPath);
@@ -109,6 +200,9 @@ Bool updateFontCache() {
             i--;
             continue;
         }
+        // The index is only opened once a font is missing from the cache.
+        FontDirectoryIndex* directoryIndex = NULL;
+        Bool directoryIndexOpened = False;
         while ((entry = readdir(fontDirectory)) != NULL) {
             // We add all missing fonts to the cache, swapping their position to the front.
             // We can be sure, that the fonts with an index lower than fontCacheIndex are valid.
@@ -118,30 +212,27 @@ Bool updateFontCache() {
                                                 fontCacheIndex, &fontCacheEntryFileNameCmp);
                 
                 if (index == -1) {
+                    if (!directoryIndexOpened) {
+                        directoryIndex = openFontDirectoryIndex(fontDirPath);
+                        directoryIndexOpened = True;
+                    }
                     snprintf(pathBuffer, 512, "%s/%s", fontDirPath, entry->d_name);
-                    TTF_Font* font = TTF_OpenFont(pathBuffer, FONT_SIZE);
-                    if (font == NULL) continue;
+                    char* XLFName = getFontFileXLFDName(directoryIndex, entry->d_name, pathBuffer);
+                    if (XLFName == NULL) continue;
                     FontCacheEntry* fontCacheEntry = malloc(sizeof(FontCacheEntry));
                     if (fontCacheEntry == NULL) {
-                        TTF_CloseFont(font);
+                        free(XLFName);
+                        if (directoryIndex != NULL) closeFontDirectoryIndex(directoryIndex);
                         closedir(fontDirectory);
                         return False;
                     }
                     fontCacheEntry->filePath = strdup(pathBuffer);
-                    fontCacheEntry->XLFName = getFontXLFDName(font);
-                    if (fontCacheEntry->filePath == NULL ||  fontCacheEntry->XLFName == NULL) {
+                    fontCacheEntry->XLFName = XLFName;
+                    if (fontCacheEntry->filePath == NULL || !insertArray(fontCache, fontCacheEntry)) {
                         if (fontCacheEntry->filePath != NULL) free(fontCacheEntry->filePath);
-                        if (fontCacheEntry->XLFName != NULL) free(fontCacheEntry->XLFName);
-                        free(fontCacheEntry);
-                        TTF_CloseFont(font);
-                        closedir(fontDirectory);
-                        return False;
-                    }
-                    if (!insertArray(fontCache, fontCacheEntry)) {
-                        free(fontCacheEntry->filePath);
                         free(fontCacheEntry->XLFName);
                         free(fontCacheEntry);
-                        TTF_CloseFont(font);
+                        if (directoryIndex != NULL) closeFontDirectoryIndex(directoryIndex);
                         closedir(fontDirectory);
                         return False;
                     }
@@ -153,6 +244,7 @@ Bool updateFontCache() {
                 fontCacheIndex++;
             }
         }
+        if (directoryIndex != NULL) closeFontDirectoryIndex(directoryIndex);
         closedir(fontDirectory);
     }
     while (fontCache->length > fontCacheIndex) {
@@ -162,10 +254,72 @@ Bool updateFontCache() {
         free(cacheEntry->XLFName);
         free(cacheEntry);
     }
+    updateFontNameIndex();
     return True;
 }
 
 
+static void freeFontInstance(FontInstance* fontInstance) {
+    size_t i;
+    freeGlyphAtlasesOfFont(fontInstance->ttfFont);
+    TTF_CloseFont(fontInstance->ttfFont);
+    free(fontInstance->filePath);
+    for (i = 0; i < NUM_FONT_METRICS_PAGES; i++) {
+        free(fontInstance->metrics[i]);
+    }
+    free(fontInstance);
+    statistics.fontInstances--;
+}
+
+/* Get the opened font for the file, size and style and take a reference to it. */
+static FontInstance* acquireFontInstance(const char* filePath, int size, int style) {
+    size_t i;
+    for (i = 0; i < fontInstances.length; i++) {
+        FontInstance* fontInstance = fontInstances.array[i];
+        if (fontInstance->size == size && fontInstance->style == style
+            && strcmp(fontInstance->filePath, filePath) == 0) {
+            fontInstance->referenceCount++;
+            statistics.fontInstanceHits++;
+            return fontInstance;
+        }
+    }
+    FontInstance* fontInstance = calloc(1, sizeof(FontInstance));
+    if (fontInstance == NULL) return NULL;
+    fontInstance->ttfFont = TTF_OpenFont(filePath, size);
+    fontInstance->filePath = strdup(filePath);
+    fontInstance->size = size;
+    fontInstance->style = style;
+    fontInstance->referenceCount = 1;
+    if (fontInstance->ttfFont == NULL || fontInstance->filePath == NULL
+        || !insertArray(&fontInstances, fontInstance)) {
+        if (fontInstance->ttfFont != NULL) TTF_CloseFont(fontInstance->ttfFont);
+        free(fontInstance->filePath);
+        free(fontInstance);
+        return NULL;
+    }
+    statistics.fontInstances++;
+    if (style != TTF_STYLE_NORMAL) {
+        TTF_SetFontStyle(fontInstance->ttfFont, style);
+    }
+    return fontInstance;
+}
+
+static void releaseFontInstance(FontInstance* fontInstance) {
+    if (--fontInstance->referenceCount > 0) return;
+    ssize_t index = findInArray(&fontInstances, fontInstance);
+    if (index != -1) {
+        removeArray(&fontInstances, (size_t) index, False);
+    }
+    freeFontInstance(fontInstance);
+}
+
+static void freeFontInstances() {
+    while (fontInstances.length > 0) {
+        freeFontInstance(removeArray(&fontInstances, fontInstances.length - 1, False));
+    }
+    freeArray(&fontInstances);
+}
+
 Bool initFontStorage() {
     size_t fontCount = 0;
     DIR* fontDirectory;
@@ -229,9 +383,89 @@ void freeFontStorage() {
         free(fontCache);
         fontCache = NULL;
     }
+    freeFontNameIndex(fontNameIndex);
+    fontNameIndex = NULL;
+    freeFontInstances();
+}
+
+void printFontInstanceStatistics() {
+    size_t i, page;
+    for (i = 0; i < fontInstances.length; i++) {
+        FontInstance* fontInstance = fontInstances.array[i];
+        size_t memory = sizeof(FontInstance) + getGlyphAtlasMemoryOfFont(fontInstance->ttfFont);
+        for (page = 0; page < NUM_FONT_METRICS_PAGES; page++) {
+            if (fontInstance->metrics[page] != NULL) {
+                memory += sizeof(XCharStruct) * FONT_METRICS_PAGE_SIZE;
+            }
+        }
+        fprintf(stderr, "[SDL2X11]     %s %dpx (style %d): %u references, %zu bytes of metrics and glyphs\n",
+                fontInstance->filePath, fontInstance->size, fontInstance->style,
+                fontInstance->referenceCount, memory);
+    }
+}
+
+/*
+ * All fonts are scalable, so the size fields of a font name only select the size of the instance.
+ * Copy the name into pattern with the numeric size fields replaced by wildcards, so it matches
+ * the names in the font cache, and return the requested pixel size or 0 if the name has none.
+ */
+static int parseFontSize(const char* name, char* pattern) {
+    int pixelSize = 0, pointSize = 0, resolutionY = DEFAULT_FONT_RESOLUTION;
+    unsigned int field = 0;
+    const char* fieldStart = name;
+    if (name[0] != '-') {
+        strcpy(pattern, name);
+        return 0;
+    }
+    while (True) {
+        const char* fieldEnd = strchr(fieldStart, '-');
+        if (fieldEnd == NULL) fieldEnd = fieldStart + strlen(fieldStart);
+        size_t length = (size_t) (fieldEnd - fieldStart);
+        Bool numeric = length > 0 && strspn(fieldStart, "0123456789") == length;
+        if (numeric && (field == XLFD_PIXEL_SIZE_FIELD || field == XLFD_POINT_SIZE_FIELD
+                        || field == XLFD_RESOLUTION_X_FIELD || field == XLFD_RESOLUTION_Y_FIELD
+                        || field == XLFD_AVERAGE_WIDTH_FIELD)) {
+            int value = atoi(fieldStart);
+            if (field == XLFD_PIXEL_SIZE_FIELD) pixelSize = value;
+            else if (field == XLFD_POINT_SIZE_FIELD) pointSize = value;
+            else if (field == XLFD_RESOLUTION_Y_FIELD && value > 0) resolutionY = value;
+            *pattern++ = '*';
+        } else {
+            memcpy(pattern, fieldStart, length);
+            pattern += length;
+        }
+        if (*fieldEnd == '\0') break;
+        *pattern++ = '-';
+        fieldStart = fieldEnd + 1;
+        field++;
+    }
+    *pattern = '\0';
+    if (pixelSize == 0 && pointSize > 0) {
+        // The point size is given in decipoints.
+        pixelSize = (pointSize * resolutionY + 360) / 720;
+    }
+    return pixelSize;
+}
+
+/* Get the TTF style which matches the weight and slant in the XLFD name. */
+static int getFontNameStyle(const char* name) {
+    int style = TTF_STYLE_NORMAL;
+    unsigned int field = 0;
+    const char* fieldStart;
+    for (fieldStart = name; fieldStart != NULL; fieldStart = strchr(fieldStart, '-'), field++) {
+        if (field > 0) fieldStart++;
+        if (field == XLFD_WEIGHT_NAME_FIELD && strncasecmp(fieldStart, "bold-", 5) == 0) {
+            style |= TTF_STYLE_BOLD;
+        } else if (field == XLFD_SLANT_FIELD && (strncasecmp(fieldStart, "i-", 2) == 0
+                                                 || strncasecmp(fieldStart, "o-", 2) == 0)) {
+            style |= TTF_STYLE_ITALIC;
+        }
+    }
+    return style;
 }
 
 Font XLoadFont(Display* display, _Xconst char* name) {
+    // https://tronche.com/gui/x/xlib/graphics/font-metrics/XLoadFont.html
     SET_X_SERVER_REQUEST(display, X_OpenFont);
     XID font = ALLOC_XID();
     if (font == None) {
@@ -240,15 +474,27 @@ Font XLoadFont(Display* display, _Xconst char* name) {
     }
     SET_XID_TYPE(font, FONT);
     int fontSize = FONT_SIZE;
+    int fontStyle = TTF_STYLE_NORMAL;
     const char* fontPath = NULL;
     if (strcmp(name, "fixed") == 0 || strcmp(name, "cursor") == 0) {
         // Update the hardcoded path to match your local directory structure
         fontPath = "fonts/FreeMono.ttf";
     } else {
-        ssize_t index = findInArrayCmp(fontCache, (void *) name, &fontCmp);
-        if (index != -1) {
-            fontPath = ((FontCacheEntry*) fontCache->array[index])->filePath;
+        char* pattern = malloc(strlen(name) + 1);
+        if (pattern == NULL) {
+            FREE_XID(font);
+            handleOutOfMemory(0, display, 0, 0);
+            return None;
         }
+        int pixelSize = parseFontSize(name, pattern);
+        if (pixelSize > 0) fontSize = pixelSize;
+        size_t index;
+        if (findFontCacheEntries(pattern, &index, 1) == 1) {
+            FontCacheEntry* fontCacheEntry = fontCache->array[index];
+            fontPath = fontCacheEntry->filePath;
+            fontStyle = getFontNameStyle(fontCacheEntry->XLFName);
+        }
+        free(pattern);
     }
 
     if (fontPath == NULL) {
@@ -257,16 +503,50 @@ Font XLoadFont(Display* display, _Xconst char* name) {
         handleError(0, display, None, 0, BadName, 0);
         return None;
     }
-    SET_XID_VALUE(font, TTF_OpenFont(fontPath, fontSize));
-    if (GET_XID_VALUE(font) == NULL){
+    FontInstance* fontInstance = acquireFontInstance(fontPath, fontSize, fontStyle);
+    if (fontInstance == NULL) {
         FREE_XID(font);
         LOG("Failed to load font %s!\n", name);
         handleError(0, display, None, 0, BadName, 0);
         return None;
     }
+    SET_XID_VALUE(font, fontInstance);
     return font;
 }
 
+int XUnloadFont(Display* display, Font font) {
+    // https://tronche.com/gui/x/xlib/graphics/font-metrics/XUnloadFont.html
+    SET_X_SERVER_REQUEST(display, X_CloseFont);
+    TYPE_CHECK(font, FONT, display, 0);
+    releaseFontInstance(GET_FONT_INSTANCE(font));
+    FREE_XID(font);
+    return 1;
+}
+
+static XCharStruct* getCharacterMetrics(FontInstance* fontInstance, Uint16 character) {
+    XCharStruct* page = fontInstance->metrics[character / FONT_METRICS_PAGE_SIZE];
+    if (page == NULL) {
+        page = malloc(sizeof(XCharStruct) * FONT_METRICS_PAGE_SIZE);
+        if (page == NULL) { return NULL; }
+        unsigned int i, firstCharacter = character - character % FONT_METRICS_PAGE_SIZE;
+        int minX, maxX, minY, maxY, advance;
+        for (i = 0; i < FONT_METRICS_PAGE_SIZE; i++) {
+            if (TTF_GlyphMetrics(fontInstance->ttfFont, (Uint16) (firstCharacter + i),
+                                 &minX, &maxX, &minY, &maxY, &advance) == -1) {
+                minX = maxX = minY = maxY = advance = 0;
+            }
+            page[i].lbearing = (short) minX;
+            page[i].rbearing = (short) maxX;
+            page[i].width = (short) advance;
+            page[i].ascent = (short) maxY;
+            page[i].descent = (short) -minY;
+            page[i].attributes = 0;
+        }
+        fontInstance->metrics[character / FONT_METRICS_PAGE_SIZE] = page;
+    }
+    return &page[character % FONT_METRICS_PAGE_SIZE];
+}
+
 int XFreeFontPath(char** list) {
     free(list);
     return 1;
@@ -313,25 +593,23 @@ int XSetFontPath(Display* display, char** directories, int ndirs) {
 char** XListFonts(Display* display, _Xconst char* pattern, int maxnames, int* actual_count_return) {
     // https://tronche.com/gui/x/xlib/graphics/font-metrics/XListFonts.html
     SET_X_SERVER_REQUEST(display, X_ListFonts);
-    Array names;
-    initArray(&names, 0);
-    size_t i;
-    for (i = 0; i < fontCache->length; i++) {
-        char* name = ((FontCacheEntry*) fontCache->array[i])->XLFName;
-        if (matchWildcard(pattern, name)) {
-            insertArray(&names, name);
-            if (names.length >= maxnames) break;
-        }
-    }
-    *actual_count_return = (int) names.length;
-    if (names.length == 0) return NULL;
-    char** list = malloc(sizeof(char*) * names.length);
-    if (list == NULL) {
-        *actual_count_return = 0;
+    size_t i, numMatches;
+    *actual_count_return = 0;
+    if (maxnames <= 0 || fontCache->length == 0) return NULL;
+    size_t* matches = malloc(sizeof(size_t) * MIN((size_t) maxnames, fontCache->length));
+    if (matches == NULL) {
+        handleOutOfMemory(0, display, 0, 0);
         return NULL;
     }
-    memcpy(list, names.array, sizeof(char*) * names.length);
-    freeArray(&names);
+    numMatches = findFontCacheEntries(pattern, matches, MIN((size_t) maxnames, fontCache->length));
+    char** list = numMatches == 0 ? NULL : malloc(sizeof(char*) * numMatches);
+    if (list != NULL) {
+        for (i = 0; i < numMatches; i++) {
+            list[i] = ((FontCacheEntry*) fontCache->array[matches[i]])->XLFName;
+        }
+        *actual_count_return = (int) numMatches;
+    }
+    free(matches);
     return list;
 }
 
@@ -352,7 +630,7 @@ void freeFontStruct(XFontStruct* font_struct) {
 int XFreeFont(Display* display, XFontStruct* font_struct) {
     // https://tronche.com/gui/x/xlib/graphics/font-metrics/XFreeFont.html
     SET_X_SERVER_REQUEST(display, X_CloseFont);
-    TTF_CloseFont(GET_FONT(font_struct->fid));
+    releaseFontInstance(GET_FONT_INSTANCE(font_struct->fid));
     freeFontStruct(font_struct);
     return 1;
 }
@@ -383,15 +661,58 @@ Bool XGetFontProperty(XFontStruct* font_struct, Atom atom, unsigned long* value_
     return res;
 }
 
-Bool fillXCharStruct(TTF_Font* font, unsigned int character, XCharStruct* charStruct) {
-    int minX, maxX, minY, maxY, advance;
-    if (TTF_GlyphMetrics(font, (Uint16) character, &minX, &maxX, &minY, &maxY, &advance) == -1) {
-        LOG("Failed to determine metrics for character '%u': %s\n", character, TTF_GetError());
-        return False;
+/* Gather the metrics of the font with FreeType, this needs to look at every glyph of the BMP. */
+static void computeFontMetrics(FontInstance* fontInstance, FontMetrics* metrics) {
+    TTF_Font* font = fontInstance->ttfFont;
+    unsigned int character;
+    Bool first = True;
+    memset(metrics, 0, sizeof(FontMetrics));
+    metrics->ascent = TTF_FontAscent(font);
+    metrics->descent = abs(TTF_FontDescent(font));
+    metrics->fixedWidth = TTF_FontFaceIsFixedWidth(font) != 0;
+    for (character = 0; character < 0x10000; character++) {
+        if (TTF_GlyphIsProvided(font, (Uint16) character)) {
+            metrics->coverage[character / 8] |= 1 << (character % 8);
+            if (first) {
+                metrics->minChar = character;
+                first = False;
+            }
+        }
+    }
+    // TODO: Only the first byte of the BMP is reported for now.
+    metrics->maxChar = 255;
+    metrics->minChar = MIN(metrics->minChar, metrics->maxChar);
+    metrics->allCharsExist = True;
+    first = True;
+    for (character = metrics->minChar; character <= metrics->maxChar; character++) {
+        XCharStruct* charStruct = &metrics->perChar[character - metrics->minChar];
+        XCharStruct* characterMetrics = NULL;
+        if (IS_CHARACTER_COVERED(metrics, character)) {
+            characterMetrics = getCharacterMetrics(fontInstance, (Uint16) character);
+        }
+        if (characterMetrics == NULL) {
+            // Non existing characters have all metrics set to zero.
+            metrics->allCharsExist = False;
+            continue;
+        }
+        *charStruct = *characterMetrics;
+        if (first) {
+            metrics->minBounds = *charStruct;
+            metrics->maxBounds = *charStruct;
+            first = False;
+            continue;
+        }
+        metrics->minBounds.lbearing = MIN(metrics->minBounds.lbearing, charStruct->lbearing);
+        metrics->minBounds.rbearing = MIN(metrics->minBounds.rbearing, charStruct->rbearing);
+        metrics->minBounds.width = MIN(metrics->minBounds.width, charStruct->width);
+        metrics->minBounds.ascent = MIN(metrics->minBounds.ascent, charStruct->ascent);
+        metrics->minBounds.descent = MIN(metrics->minBounds.descent, charStruct->descent);
+        metrics->maxBounds.lbearing = MAX(metrics->maxBounds.lbearing, charStruct->lbearing);
+        metrics->maxBounds.rbearing = MAX(metrics->maxBounds.rbearing, charStruct->rbearing);
+        metrics->maxBounds.width = MAX(metrics->maxBounds.width, charStruct->width);
+        metrics->maxBounds.ascent = MAX(metrics->maxBounds.ascent, charStruct->ascent);
+        metrics->maxBounds.descent = MAX(metrics->maxBounds.descent, charStruct->descent);
     }
-    charStruct->width = (short) advance;
-    charStruct->rbearing = (short) maxX;
-    return True;
 }
 
 XFontStruct* XLoadQueryFont(Display* display, _Xconst char* name) {
@@ -405,79 +726,54 @@ XFontStruct* XLoadQueryFont(Display* display, _Xconst char* name) {
 
 XFontStruct *XQueryFont(Display *display, XID fontId) {
     // https://tronche.com/gui/x/xlib/graphics/font-metrics/XQueryFont.html
-    TTF_Font* font = GET_FONT(fontId);
     SET_X_SERVER_REQUEST(display, X_QueryFont);
+    FontInstance* fontInstance = GET_FONT_INSTANCE(fontId);
     XFontStruct* fontStruct = malloc(sizeof(XFontStruct));
-    if (fontStruct == NULL) {
+    FontMetrics* metrics = malloc(sizeof(FontMetrics));
+    if (fontStruct == NULL || metrics == NULL) {
+        free(fontStruct);
+        free(metrics);
         handleOutOfMemory(0, display, 0, 0);
-        TTF_CloseFont(font);
+        releaseFontInstance(fontInstance);
+        FREE_XID(fontId);
         return NULL;
     }
+    // The metrics cache is keyed by the size only, so fonts with a synthesized style are not cached.
+    if (fontInstance->style != TTF_STYLE_NORMAL
+        || !loadFontMetrics(fontInstance->filePath, fontInstance->size, metrics)) {
+        computeFontMetrics(fontInstance, metrics);
+        if (fontInstance->style == TTF_STYLE_NORMAL) {
+            storeFontMetrics(fontInstance->filePath, fontInstance->size, metrics);
+        }
+    }
+    fontStruct->ext_data = NULL;
     fontStruct->fid = fontId;
-    fontStruct->ascent = TTF_FontAscent(font);
-    fontStruct->descent = abs(TTF_FontDescent(font));
+    fontStruct->direction = FontLeftToRight;
+    fontStruct->min_char_or_byte2 = metrics->minChar;
+    fontStruct->max_char_or_byte2 = metrics->maxChar;
+    fontStruct->min_byte1 = 0;
+    fontStruct->max_byte1 = 0;
+    fontStruct->all_chars_exist = metrics->allCharsExist;
+    fontStruct->default_char = 0;
+    fontStruct->n_properties = 0;
+    fontStruct->properties = NULL;
+    fontStruct->min_bounds = metrics->minBounds;
+    fontStruct->max_bounds = metrics->maxBounds;
+    fontStruct->ascent = metrics->ascent;
+    fontStruct->descent = metrics->descent;
     fontStruct->per_char = NULL;
-    unsigned int numChars = 0;
-    unsigned int i;
-    for (i = 0; i < 65536 /* 2^16 */; i++) {
-        if (TTF_GlyphIsProvided(font, (Uint16) i)) {
-            if (numChars == 0) {
-                fontStruct->min_char_or_byte2 = i;
-            }
-            fontStruct->max_char_or_byte2 = i;
-            numChars++;
-        }
-    }
-//    if (numChars >= 256) {
-//        fontStruct->min_byte1 = fontStruct->min_char_or_byte2 / 256;
-//        fontStruct->max_byte1 = fontStruct->max_char_or_byte2 / 256;
-//        fontStruct->min_char_or_byte2 = 0;
-//    } else {
-        fontStruct->min_byte1 = 0;
-        fontStruct->max_byte1 = 0;
-//    }
-    // TODO: This is debugging
-    fontStruct->max_char_or_byte2 = 255;
-    // Build per_char
-    int monospace = TTF_FontFaceIsFixedWidth(font);
-    XCharStruct charStruct;
-    if (!monospace) {
+    if (!metrics->fixedWidth) {
+        size_t numChars = metrics->maxChar - metrics->minChar + 1;
         fontStruct->per_char = malloc(sizeof(XCharStruct) * numChars);
         if (fontStruct->per_char == NULL) {
+            free(metrics);
             handleOutOfMemory(0, display, 0, 0);
             XFreeFont(display, fontStruct);
             return NULL;
         }
-        charStruct = fontStruct->per_char[0];
-    }
-    if (fillXCharStruct(font, fontStruct->min_char_or_byte2, &charStruct) == False) {
-        XFreeFont(display, fontStruct);
-        return NULL;
-    }
-    fontStruct->max_bounds = charStruct;
-    fontStruct->min_bounds = charStruct;
-    if (monospace) {
-        fontStruct->per_char = NULL;
-    } else {
-        int counter = 1;
-        for (i = fontStruct->min_char_or_byte2 + 1; i < 65536 /* 2^16 */; ++i) {
-            if (TTF_GlyphIsProvided(font, (Uint16) i)) {
-                charStruct = fontStruct->per_char[counter];
-                if (fillXCharStruct(font, i, &charStruct) == False) {
-                    XFreeFont(display, fontStruct);
-                    return NULL;
-                }
-                // I think rbearing (aka. advance) is the value that matters here
-                if (fontStruct->max_bounds.rbearing < charStruct.rbearing) {
-                    fontStruct->max_bounds = charStruct;
-                } else if (fontStruct->min_bounds.rbearing > charStruct.rbearing) {
-                    fontStruct->max_bounds = charStruct;
-                }
-                counter++;
-            }
-        }
+        memcpy(fontStruct->per_char, metrics->perChar, sizeof(XCharStruct) * numChars);
     }
-    fontStruct->n_properties = 0;
+    free(metrics);
     return fontStruct;
 }
 
@@ -538,61 +834,211 @@ char* decodeString(const char* string, int count) {
     return text;
 }
 
-int getTextWidth(XFontStruct* font_struct, const char* string) {
-    int width, height;
-    if (TTF_SizeUTF8(GET_FONT(font_struct->fid), string, &width, &height) != 0) {
-        LOG("Failed to calculate the text with in XTextWidth[16]: %s! "
-                    "Returning max width of font.\n", TTF_GetError());
-        return (int) (font_struct->max_bounds.rbearing * strlen(string));
+/* Iterates over the characters of a text without copying it. */
+typedef struct {
+    /* 8 bit text is UTF-8 with the escape sequences understood by decodeString. */
+    const char* string;
+    const XChar2b* string16;
+    int count;
+    int index;
+    Uint8 pending[2];
+    int numPending;
+} TextIterator;
+
+static void initTextIterator(TextIterator* iterator, const char* string, const XChar2b* string16, int count) {
+    iterator->string = string;
+    iterator->string16 = string16;
+    iterator->count = count;
+    iterator->index = 0;
+    iterator->numPending = 0;
+}
+
+static int nextEscapedHexByte(TextIterator* iterator) {
+    int value = 0, i;
+    for (i = 0; i < 2 && iterator->index < iterator->count; i++) {
+        value = value << 4 | hexCharToNum(iterator->string[iterator->index++]);
     }
-    return width;
+    return value & 0xFF;
 }
 
-char* decodeMbString(const wchar_t* string, size_t* length) {
-    *length = wcstombs(NULL, string, 0);
-    char* text = malloc(sizeof(char*) * (*length + 1));
-    if (text == NULL) {
-        return NULL;
+/* Get the next byte of the 8 bit text the same way decodeString would produce it, or -1 at the end. */
+static int nextTextByte(TextIterator* iterator) {
+    if (iterator->numPending > 0) {
+        return iterator->pending[--iterator->numPending];
     }
-    if (wcstombs(text, string, (*length + 1)) == (size_t) -1) {
-        free(text);
-        return NULL;
+    if (iterator->index >= iterator->count) { return -1; }
+    char chr = iterator->string[iterator->index++];
+    if (chr != '\\' || iterator->index >= iterator->count) { return (Uint8) chr; }
+    chr = iterator->string[iterator->index++];
+    int byte;
+    switch (chr) {
+        case 'x': return nextEscapedHexByte(iterator);
+        case 'u':
+            byte = nextEscapedHexByte(iterator);
+            iterator->pending[iterator->numPending++] = (Uint8) nextEscapedHexByte(iterator);
+            return byte;
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 'a': return '\a';
+        case 'b': return '\b';
+        case 't': return '\t';
+        case 'v': return '\v';
+        case 'f': return '\f';
+        default:
+            iterator->pending[iterator->numPending++] = (Uint8) chr;
+            return '\\';
     }
-    char* decodedText = decodeString(text, *length );
-    free(text);
-    return decodedText;
+}
+
+/* Get the next character of the text. Invalid UTF-8 and characters outside of the BMP become U+FFFD. */
+static Bool nextTextCharacter(TextIterator* iterator, Uint16* character) {
+    if (iterator->string16 != NULL) {
+        if (iterator->index >= iterator->count) { return False; }
+        const XChar2b* char2b = &iterator->string16[iterator->index++];
+        *character = (Uint16) (char2b->byte1 << 8 | char2b->byte2);
+        return True;
+    }
+    int byte = nextTextByte(iterator);
+    // Like the decoded string, the text ends at the first null byte.
+    if (byte <= 0) { return False; }
+    Uint32 codepoint = (Uint32) byte;
+    int length, i;
+    if (codepoint < 0x80) {
+        length = 1;
+    } else if ((codepoint & 0xE0) == 0xC0) {
+        length = 2;
+        codepoint &= 0x1F;
+    } else if ((codepoint & 0xF0) == 0xE0) {
+        length = 3;
+        codepoint &= 0x0F;
+    } else if ((codepoint & 0xF8) == 0xF0) {
+        length = 4;
+        codepoint &= 0x07;
+    } else {
+        *character = 0xFFFD;
+        return True;
+    }
+    for (i = 1; i < length; i++) {
+        byte = nextTextByte(iterator);
+        if (byte == -1 || (byte & 0xC0) != 0x80) {
+            if (byte != -1) {
+                iterator->pending[iterator->numPending++] = (Uint8) byte;
+            }
+            *character = 0xFFFD;
+            return True;
+        }
+        codepoint = codepoint << 6 | (byte & 0x3F);
+    }
+    *character = (Uint16) (codepoint > 0xFFFF ? 0xFFFD : codepoint);
+    return True;
+}
+
+/*
+ * Sum up the metrics of the characters of the text, the origin of each character is the
+ * sum of the widths of the characters before it. Kerning is applied if the font uses it,
+ * so the result matches the drawn text. Returns the width of the text.
+ */
+static int measureText(FontInstance* fontInstance, TextIterator* iterator, XCharStruct* overall) {
+    TTF_Font* font = fontInstance->ttfFont;
+    Bool kerning = TTF_GetFontKerning(font) != 0;
+    Bool first = True;
+    Uint16 character, previous = 0;
+    int x = 0;
+    if (overall != NULL) {
+        memset(overall, 0, sizeof(XCharStruct));
+    }
+    while (nextTextCharacter(iterator, &character)) {
+        if (kerning && previous != 0) {
+            x += TTF_GetFontKerningSizeGlyphs(font, previous, character);
+        }
+        previous = character;
+        XCharStruct* metrics = getCharacterMetrics(fontInstance, character);
+        if (metrics == NULL) {
+            LOG("Out of memory: Failed to load the metrics of character '%u' in %s!\n", character, __func__);
+            continue;
+        }
+        if (overall != NULL) {
+            if (first || x + metrics->lbearing < overall->lbearing) {
+                overall->lbearing = (short) (x + metrics->lbearing);
+            }
+            if (first || x + metrics->rbearing > overall->rbearing) {
+                overall->rbearing = (short) (x + metrics->rbearing);
+            }
+            overall->ascent = MAX(overall->ascent, metrics->ascent);
+            overall->descent = MAX(overall->descent, metrics->descent);
+            first = False;
+        }
+        x += metrics->width;
+    }
+    if (overall != NULL) {
+        overall->width = (short) x;
+    }
+    return x;
+}
+
+/* Convert the 16 bit text to UTF-8 for SDL_ttf. */
+static char* decodeChar2bString(const XChar2b* string, int count) {
+    char* text = malloc(sizeof(char) * (3 * count + 1));
+    if (text == NULL) { return NULL; }
+    int i, length = 0;
+    for (i = 0; i < count; i++) {
+        Uint16 character = (Uint16) (string[i].byte1 << 8 | string[i].byte2);
+        if (character == 0) { break; }
+        if (character < 0x80) {
+            text[length++] = (char) character;
+        } else if (character < 0x800) {
+            text[length++] = (char) (0xC0 | character >> 6);
+            text[length++] = (char) (0x80 | (character & 0x3F));
+        } else {
+            text[length++] = (char) (0xE0 | character >> 12);
+            text[length++] = (char) (0x80 | (character >> 6 & 0x3F));
+            text[length++] = (char) (0x80 | (character & 0x3F));
+        }
+    }
+    text[length] = '\0';
+    return text;
 }
 
 int XTextWidth16(XFontStruct* font_struct, _Xconst XChar2b* string, int count) {
     // https://tronche.com/gui/x/xlib/graphics/font-metrics/XTextWidth16.html
-    // TODO: Rethink this
-    size_t length;
-    char* text = decodeMbString((const wchar_t *) string, &length);
-    if (text == NULL) {
-        LOG("Out of memory: Failed to allocate memory in %s! "
-                    "Returning max width of font.\n", __func__);
-        return font_struct->max_bounds.rbearing * count;
-    }
-    int width = getTextWidth(font_struct, text);
-    free(text);
-    return width;
-    
+    TextIterator iterator;
+    initTextIterator(&iterator, NULL, string, count);
+    return measureText(GET_FONT_INSTANCE(font_struct->fid), &iterator, NULL);
 }
 
 int XTextWidth(XFontStruct* font_struct, _Xconst char* string, int count) {
     // https://tronche.com/gui/x/xlib/graphics/font-metrics/XTextWidth.html
-    char* text = decodeString(string, count);
-    if (text == NULL) {
-        LOG("Out of memory: Failed to allocate memory in XTextWidth! "
-                    "Returning max width of font.\n");
-        return font_struct->max_bounds.rbearing * count;
-    }
-    int width = getTextWidth(font_struct, text);
-    free(text);
-    return width;
+    TextIterator iterator;
+    initTextIterator(&iterator, string, NULL, count);
+    return measureText(GET_FONT_INSTANCE(font_struct->fid), &iterator, NULL);
+}
+
+int XTextExtents16(XFontStruct* font_struct, _Xconst XChar2b* string, int nchars, int* direction_return,
+                   int* font_ascent_return, int* font_descent_return, XCharStruct* overall_return) {
+    // https://tronche.com/gui/x/xlib/graphics/font-metrics/XTextExtents16.html
+    TextIterator iterator;
+    initTextIterator(&iterator, NULL, string, nchars);
+    measureText(GET_FONT_INSTANCE(font_struct->fid), &iterator, overall_return);
+    *direction_return = FontLeftToRight;
+    *font_ascent_return = font_struct->ascent;
+    *font_descent_return = font_struct->descent;
+    return 1;
+}
+
+int XTextExtents(XFontStruct* font_struct, _Xconst char* string, int nchars, int* direction_return,
+                 int* font_ascent_return, int* font_descent_return, XCharStruct* overall_return) {
+    // https://tronche.com/gui/x/xlib/graphics/font-metrics/XTextExtents.html
+    TextIterator iterator;
+    initTextIterator(&iterator, string, NULL, nchars);
+    measureText(GET_FONT_INSTANCE(font_struct->fid), &iterator, overall_return);
+    *direction_return = FontLeftToRight;
+    *font_ascent_return = font_struct->ascent;
+    *font_descent_return = font_struct->descent;
+    return 1;
 }
 
-Bool renderText(Display *display, SDL_Renderer *renderer, GC gc, int x, int y, const char *string) {
+Bool renderText(Display *display, Drawable drawable, SDL_Renderer *renderer, GC gc, int x, int y,
+                const char *string) {
     LOG("Rendering text: '%s'\n", string);
     if (string == NULL || string[0] == '\0') { return True; }
     GraphicContext* gContext = GET_GC(gc);
@@ -603,30 +1049,71 @@ Bool renderText(Display *display, SDL_Renderer *renderer, GC gc, int x, int y, c
             GET_ALPHA_FROM_COLOR(gContext->foreground),
     };
     if (gContext->font == None) {
-        // TODO: do we care about XUnloadFont ?
+        // The font instance of "fixed" is shared, so this only costs an XID per graphic context.
         gContext->font = XLoadFont(display, "fixed");
     }
+    ClipIterator clip;
+    if (!initClipIterator(&clip, drawable, gContext, NULL)) { return True; }
+    SDL_Rect bounds = {0, 0, 0, 0};
+    // The glyph atlas can only blend, raster operations are drawn in software.
+    if (renderer != NULL && !hasRasterOp(gContext)) {
+        // Core X colors have no alpha, the glyph coverage alone decides the blending.
+        SDL_Color tint = {color.r, color.g, color.b, 0xFF};
+        int top = y - TTF_FontAscent(GET_FONT(gContext->font));
+        Bool drawn = True;
+        while (nextClipRect(&clip, renderer)) {
+            drawn = drawTextWithGlyphAtlas(renderer, GET_FONT(gContext->font), string, tint, x, top, &bounds)
+                    && drawn;
+        }
+        if (drawn) {
+            if (SDL_IntersectRect(&bounds, &clip.bounds, &bounds)) {
+                damageDrawable(drawable, bounds.x, bounds.y, bounds.w, bounds.h);
+            }
+            return True;
+        }
+        initClipIterator(&clip, drawable, gContext, NULL);
+    }
     SDL_Surface* fontSurface = TTF_RenderUTF8_Blended(GET_FONT(gContext->font), string, color);
     if (fontSurface == NULL) {
         return False;
     }
-    SDL_Rect destR;
+    SDL_Rect destR, area;
+    destR.x = x;
+    destR.y = y - TTF_FontAscent(GET_FONT(gContext->font))/* - 6*/;
     destR.w = fontSurface->w;
     destR.h = fontSurface->h;
-    SDL_Texture* fontTexture = SDL_CreateTextureFromSurface(renderer, fontSurface);
+    if (!SDL_IntersectRect(&destR, &clip.bounds, &area)) {
+        SDL_FreeSurface(fontSurface);
+        return True;
+    }
+    if (beginSoftwareDrawing(drawable, gContext, &area, None, NULL)) {
+        // The pixman backend blends the text directly into the image of the drawable.
+        Bool res = pixmanCompositeSurface(drawable, gContext, &clip, fontSurface, destR.x, destR.y);
+        endSoftwareDrawing();
+        SDL_FreeSurface(fontSurface);
+        if (res) {
+            damageDrawable(drawable, area.x, area.y, area.w, area.h);
+        }
+        return res;
+    }
+    // TTF_RenderUTF8_Blended renders into ARGB8888 surfaces.
+    SDL_Texture* fontTexture = uploadToPoolTexture(renderer, fontSurface->format->format, fontSurface->pixels,
+                                                   fontSurface->pitch, fontSurface->w, fontSurface->h);
     SDL_FreeSurface(fontSurface);
     if (fontTexture == NULL) {
         return False;
     }
-    destR.x = x;
-    destR.y = y - TTF_FontAscent(GET_FONT(gContext->font))/* - 6*/;
-    // h and w are ignored
-    if (SDL_RenderCopy(renderer, fontTexture, NULL, &destR) != 0) {
-        return False;
+    SDL_Rect srcR = {0, 0, destR.w, destR.h};
+    SDL_SetTextureBlendMode(fontTexture, SDL_BLENDMODE_BLEND);
+    Bool res = True;
+    while (nextClipRect(&clip, renderer)) {
+        res = SDL_RenderCopy(renderer, fontTexture, &srcR, &destR) == 0 && res;
     }
-    SDL_DestroyTexture(fontTexture);
-    SDL_RenderPresent(renderer);
-    return True;
+    releasePoolTexture(fontTexture);
+    if (res) {
+        damageDrawable(drawable, area.x, area.y, area.w, area.h);
+    }
+    return res;
 }
 
 int XDrawString16(Display* display, Drawable drawable, GC gc, int x, int y, _Xconst XChar2b* string, int length) {
@@ -639,25 +1126,25 @@ int XDrawString16(Display* display, Drawable drawable, GC gc, int x, int y, _Xco
         return 0;
     }
     if (length == 0 || ((Uint16*) string)[0] == 0) { return 1; }
-    SDL_Renderer* renderer;
-    GET_RENDERER(drawable, renderer);
-    if (renderer == NULL) {
-        LOG("Failed to get the render target in %s\n", __func__);
-        handleError(0, display, None, 0, BadDrawable, 0);
-        return 0;
+    SDL_Renderer* renderer = NULL;
+    if (!pixmanBackendEnabled) {
+        GET_RENDERER(drawable, renderer);
+        if (renderer == NULL) {
+            LOG("Failed to get the render target in %s\n", __func__);
+            handleError(0, display, None, 0, BadDrawable, 0);
+            return 0;
+        }
     }
-    size_t size;
-    char * text = decodeMbString((const wchar_t *) string, &size);
+    char* text = decodeChar2bString(string, length);
     if (text == NULL) {
         LOG("Out of memory: Failed to allocate memory in XDrawString16, raising BadMatch error.\n");
         handleError(0, display, drawable, 0, BadMatch, 0);
         return 0;
     }
     int res = 1;
-    if (!renderText(display, renderer, gc, x, y, text)) {
+    if (!renderText(display, drawable, renderer, gc, x, y, text)) {
         LOG("Rendering the text failed in %s: %s\n", __func__, SDL_GetError());
         handleError(0, display, drawable, 0, BadMatch, 0);
-        free(text);
         res = 0;
     }
     free(text);
@@ -674,12 +1161,14 @@ int XDrawString(Display* display, Drawable drawable, GC gc, int x, int y, _Xcons
         return 0;
     }
     if (length == 0 || string[0] == 0) { return 1; }
-    SDL_Renderer* renderer;
-    GET_RENDERER(drawable, renderer);
-    if (renderer == NULL) {
-        LOG("Failed to get the render target in %s\n", __func__);
-        handleError(0, display, None, 0, BadDrawable, 0);
-        return 0;
+    SDL_Renderer* renderer = NULL;
+    if (!pixmanBackendEnabled) {
+        GET_RENDERER(drawable, renderer);
+        if (renderer == NULL) {
+            LOG("Failed to get the render target in %s\n", __func__);
+            handleError(0, display, None, 0, BadDrawable, 0);
+            return 0;
+        }
     }
     char* text = decodeString(string, length);
     if (text == NULL) {
@@ -689,7 +1178,7 @@ int XDrawString(Display* display, Drawable drawable, GC gc, int x, int y, _Xcons
         return 0;
     }
     int res = 1;
-    if (!renderText(display, renderer, gc, x, y, text)) {
+    if (!renderText(display, drawable, renderer, gc, x, y, text)) {
         LOG("Rendering the text failed in %s: %s\n", __func__, SDL_GetError());
         handleError(0, display, drawable, 0, BadMatch, 0);
         res = 0;
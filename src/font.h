@@ -5,5 +5,7 @@
 
 extern void freeFontStorage(void);
 Bool initFontStorage(void);
+/* Print the references and memory of every opened font to stderr. */
+void printFontInstanceStatistics(void);
 
 #endif /* FONT_H */
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include "fontDirectoryIndex.h"
+#include "fontMetricsCache.h"
+
+#define FONT_DIRECTORY_INDEX_HEADER "sdl2X11Emulation font directory index 1"
+
+static void freeIndexEntry(FontIndexEntry* entry) {
+    free(entry->fileName);
+    free(entry->familyName);
+    free(entry);
+}
+
+static int compareIndexEntries(const void* entry1, const void* entry2) {
+    return strcmp((*(FontIndexEntry**) entry1)->fileName, (*(FontIndexEntry**) entry2)->fileName);
+}
+
+/* Names containing a tab or a line break can not be stored in the index. */
+static Bool isIndexableName(const char* name) {
+    return strpbrk(name, "\t\n") == NULL;
+}
+
+/* Parse one line of the index: size, modification time, style, spacing, family name and file name. */
+static FontIndexEntry* parseIndexEntry(char* line) {
+    char* fields[6];
+    size_t numFields = 0;
+    char* field = line;
+    while (numFields < ARRAY_LENGTH(fields)) {
+        fields[numFields++] = field;
+        field = strchr(field, '\t');
+        if (field == NULL) break;
+        *field++ = '\0';
+    }
+    if (numFields != ARRAY_LENGTH(fields) || fields[5][0] == '\0') { return NULL; }
+    FontIndexEntry* entry = malloc(sizeof(FontIndexEntry));
+    if (entry == NULL) { return NULL; }
+    entry->fileSize = strtoll(fields[0], NULL, 10);
+    entry->modificationTime = strtoll(fields[1], NULL, 10);
+    entry->style = atoi(fields[2]);
+    entry->fixedWidth = fields[3][0] == 'm';
+    entry->stale = False;
+    entry->familyName = strdup(fields[4]);
+    entry->fileName = strdup(fields[5]);
+    if (entry->familyName == NULL || entry->fileName == NULL) {
+        freeIndexEntry(entry);
+        return NULL;
+    }
+    return entry;
+}
+
+static void readIndexFile(FontDirectoryIndex* index) {
+    FILE* file = fopen(index->indexPath, "r");
+    if (file == NULL) { return; }
+    char* line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t lineLength;
+    // The header and the directory guard against other versions and hash collisions.
+    Bool valid = getline(&line, &lineCapacity, file) > 0
+                 && strcmp(line, FONT_DIRECTORY_INDEX_HEADER "\n") == 0
+                 && (lineLength = getline(&line, &lineCapacity, file)) > 0
+                 && strncmp(line, index->directory, (size_t) lineLength - 1) == 0
+                 && strcmp(&line[lineLength - 1], "\n") == 0
+                 && index->directory[lineLength - 1] == '\0';
+    while (valid && (lineLength = getline(&line, &lineCapacity, file)) > 0) {
+        // An incomplete last line means the index was truncated.
+        if (line[lineLength - 1] != '\n') break;
+        line[lineLength - 1] = '\0';
+        FontIndexEntry* entry = parseIndexEntry(line);
+        if (entry != NULL && !insertArray(&index->entries, entry)) {
+            freeIndexEntry(entry);
+            break;
+        }
+    }
+    free(line);
+    fclose(file);
+    qsort(index->entries.array, index->entries.length, sizeof(void*), &compareIndexEntries);
+    LOG("Loaded %zu entries of the font directory index %s\n", index->entries.length, index->indexPath);
+}
+
+FontDirectoryIndex* openFontDirectoryIndex(const char* directory) {
+    char absoluteDirectory[PATH_MAX], indexPath[PATH_MAX];
+    if (realpath(directory, absoluteDirectory) == NULL
+        || !getFontCacheFilePath(absoluteDirectory, ".index", indexPath)) {
+        return NULL;
+    }
+    FontDirectoryIndex* index = malloc(sizeof(FontDirectoryIndex));
+    if (index == NULL) { return NULL; }
+    index->indexPath = strdup(indexPath);
+    index->directory = strdup(absoluteDirectory);
+    index->changed = False;
+    initArray(&index->entries, 0);
+    initArray(&index->addedEntries, 0);
+    if (index->indexPath == NULL || index->directory == NULL) {
+        free(index->indexPath);
+        free(index->directory);
+        free(index);
+        return NULL;
+    }
+    readIndexFile(index);
+    return index;
+}
+
+FontIndexEntry* findFontDirectoryIndexEntry(FontDirectoryIndex* index, const char* fileName,
+                                            const struct stat* fileStat) {
+    FontIndexEntry key;
+    FontIndexEntry* keyPointer = &key;
+    key.fileName = (char*) fileName;
+    FontIndexEntry** match = bsearch(&keyPointer, index->entries.array, index->entries.length,
+                                     sizeof(void*), &compareIndexEntries);
+    if (match == NULL) { return NULL; }
+    if ((*match)->fileSize != (Sint64) fileStat->st_size
+        || (*match)->modificationTime != (Sint64) fileStat->st_mtime) {
+        (*match)->stale = True;
+        index->changed = True;
+        return NULL;
+    }
+    return *match;
+}
+
+void addFontDirectoryIndexEntry(FontDirectoryIndex* index, const char* fileName,
+                                const struct stat* fileStat, const char* familyName,
+                                int style, Bool fixedWidth) {
+    if (!isIndexableName(fileName) || !isIndexableName(familyName)) { return; }
+    FontIndexEntry* entry = malloc(sizeof(FontIndexEntry));
+    if (entry == NULL) { return; }
+    entry->fileName = strdup(fileName);
+    entry->familyName = strdup(familyName);
+    entry->fileSize = (Sint64) fileStat->st_size;
+    entry->modificationTime = (Sint64) fileStat->st_mtime;
+    entry->style = style;
+    entry->fixedWidth = fixedWidth;
+    entry->stale = False;
+    if (entry->fileName == NULL || entry->familyName == NULL || !insertArray(&index->addedEntries, entry)) {
+        freeIndexEntry(entry);
+        return;
+    }
+    index->changed = True;
+}
+
+/* Write the entries of files which still exist and have not changed. */
+static Bool writeIndexEntries(FILE* file, const char* directory, Array* entries) {
+    char filePath[PATH_MAX];
+    size_t i;
+    for (i = 0; i < entries->length; i++) {
+        FontIndexEntry* entry = entries->array[i];
+        if (entry->stale || snprintf(filePath, sizeof(filePath), "%s/%s", directory, entry->fileName) >= PATH_MAX
+            || access(filePath, F_OK) != 0) {
+            continue;
+        }
+        if (fprintf(file, "%lld\t%lld\t%d\t%c\t%s\t%s\n",
+                    (long long) entry->fileSize, (long long) entry->modificationTime,
+                    entry->style, entry->fixedWidth ? 'm' : 'p', entry->familyName, entry->fileName) < 0) {
+            return False;
+        }
+    }
+    return True;
+}
+
+static void writeIndexFile(FontDirectoryIndex* index) {
+    char temporaryPath[PATH_MAX];
+    if (snprintf(temporaryPath, sizeof(temporaryPath), "%s.%d", index->indexPath, (int) getpid()) >= PATH_MAX) {
+        return;
+    }
+    FILE* file = fopen(temporaryPath, "w");
+    if (file == NULL) {
+        LOG("Failed to create the font directory index %s: %s\n", temporaryPath, strerror(errno));
+        return;
+    }
+    Bool written = fprintf(file, "%s\n%s\n", FONT_DIRECTORY_INDEX_HEADER, index->directory) > 0
+                   && writeIndexEntries(file, index->directory, &index->entries)
+                   && writeIndexEntries(file, index->directory, &index->addedEntries);
+    if (fclose(file) != 0 || !written || rename(temporaryPath, index->indexPath) != 0) {
+        LOG("Failed to write the font directory index %s\n", index->indexPath);
+        unlink(temporaryPath);
+    }
+}
+
+static void freeIndexEntries(Array* entries) {
+    while (entries->length > 0) {
+        freeIndexEntry(removeArray(entries, entries->length - 1, False));
+    }
+    freeArray(entries);
+}
+
+void closeFontDirectoryIndex(FontDirectoryIndex* index) {
+    // Entries of removed fonts are only dropped once the index is rewritten for new or changed fonts.
+    if (index->changed) {
+        writeIndexFile(index);
+    }
+    freeIndexEntries(&index->entries);
+    freeIndexEntries(&index->addedEntries);
+    free(index->indexPath);
+    free(index->directory);
+    free(index);
+}
@@ -0,0 +1,44 @@
+#ifndef _FONT_DIRECTORY_INDEX_H_
+#define _FONT_DIRECTORY_INDEX_H_
+
+#include <sys/stat.h>
+#include <SDL2/SDL.h>
+#include "X11/Xlib.h"
+#include "util.h"
+
+/*
+ * The index of a font directory remembers the XLFD fields of every font file in it,
+ * so scanning the directory again only needs to open the files that were added or
+ * changed since the index was written. The index files are kept in the font cache
+ * directory next to the font metrics (see fontMetricsCache.h).
+ */
+typedef struct {
+    char* fileName;
+    Sint64 fileSize;
+    Sint64 modificationTime;
+    char* familyName;
+    int style;
+    Bool fixedWidth;
+    /* Set if the file was changed since the entry was written. */
+    Bool stale;
+} FontIndexEntry;
+
+typedef struct {
+    char* indexPath;
+    char* directory;
+    /* The entries read from the index file, sorted by file name. */
+    Array entries;
+    /* The entries of fonts that were opened during this scan. */
+    Array addedEntries;
+    Bool changed;
+} FontDirectoryIndex;
+
+FontDirectoryIndex* openFontDirectoryIndex(const char* directory);
+FontIndexEntry* findFontDirectoryIndexEntry(FontDirectoryIndex* index, const char* fileName,
+                                            const struct stat* fileStat);
+void addFontDirectoryIndexEntry(FontDirectoryIndex* index, const char* fileName,
+                                const struct stat* fileStat, const char* familyName,
+                                int style, Bool fixedWidth);
+void closeFontDirectoryIndex(FontDirectoryIndex* index);
+
+#endif /* _FONT_DIRECTORY_INDEX_H_ */
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "fontMetricsCache.h"
+#include "util.h"
+
+#define FONT_METRICS_CACHE_MAGIC "S2XFMETR"
+#define FONT_METRICS_CACHE_VERSION 1
+#define FONT_METRICS_CACHE_NAME "sdl2X11Emulation"
+
+/* The header of a cache file. It is followed by the FontMetrics and the path of the font file. */
+typedef struct {
+    char magic[8];
+    Uint32 version;
+    /* Protects against reading files written by a build with a different FontMetrics layout. */
+    Uint32 metricsSize;
+    Sint64 fontModificationTime;
+    Sint64 fontFileSize;
+    Sint32 fontSize;
+    Uint32 pathLength;
+} FontMetricsCacheHeader;
+
+static char* cacheDirectory = NULL;
+static Bool cacheDirectoryResolved = False;
+
+static const char* getCacheDirectory() {
+    if (cacheDirectoryResolved) { return cacheDirectory; }
+    cacheDirectoryResolved = True;
+    char path[PATH_MAX];
+    const char* directory = getenv("SDL2X11_FONT_CACHE_DIR");
+    const char* base;
+    if (directory != NULL) {
+        if (directory[0] == '\0') { return NULL; }
+        snprintf(path, sizeof(path), "%s", directory);
+    } else if ((base = getenv("XDG_CACHE_HOME")) != NULL && base[0] != '\0') {
+        snprintf(path, sizeof(path), "%s/%s", base, FONT_METRICS_CACHE_NAME);
+    } else if ((base = getenv("HOME")) != NULL && base[0] != '\0') {
+        snprintf(path, sizeof(path), "%s/.cache", base);
+        mkdir(path, 0700);
+        snprintf(path, sizeof(path), "%s/.cache/%s", base, FONT_METRICS_CACHE_NAME);
+    } else {
+        return NULL;
+    }
+    if (mkdir(path, 0700) != 0 && errno != EEXIST) {
+        LOG("Failed to create the font cache directory %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    cacheDirectory = strdup(path);
+    return cacheDirectory;
+}
+
+Bool getFontCacheFilePath(const char* key, const char* suffix, char* cachePath) {
+    const char* directory = getCacheDirectory();
+    if (directory == NULL) { return False; }
+    Uint64 hash = 14695981039346656037ULL; // FNV-1a
+    const char* chr;
+    for (chr = key; *chr != '\0'; chr++) {
+        hash = (hash ^ (Uint8) *chr) * 1099511628211ULL;
+    }
+    return snprintf(cachePath, PATH_MAX, "%s/%016llx%s", directory,
+                    (unsigned long long) hash, suffix) < PATH_MAX;
+}
+
+/* Get the absolute path of the font file and the path of its cache file. */
+static Bool getCachePaths(const char* fontPath, int size, char* absoluteFontPath, char* cachePath) {
+    char suffix[32];
+    if (realpath(fontPath, absoluteFontPath) == NULL) { return False; }
+    snprintf(suffix, sizeof(suffix), "-%d.metrics", size);
+    return getFontCacheFilePath(absoluteFontPath, suffix, cachePath);
+}
+
+Bool loadFontMetrics(const char* fontPath, int size, FontMetrics* metrics) {
+    char absoluteFontPath[PATH_MAX], cachedPath[PATH_MAX], cachePath[PATH_MAX];
+    struct stat fontStat;
+    if (!getCachePaths(fontPath, size, absoluteFontPath, cachePath) || stat(absoluteFontPath, &fontStat) != 0) {
+        return False;
+    }
+    int file = open(cachePath, O_RDONLY);
+    if (file == -1) { return False; }
+    // The metrics are only read, straight into the caller's struct, once the header and the path match.
+    FontMetricsCacheHeader header;
+    size_t pathLength = strlen(absoluteFontPath);
+    off_t metricsOffset = (off_t) sizeof(header), pathOffset = metricsOffset + (off_t) sizeof(FontMetrics);
+    Bool valid = pread(file, &header, sizeof(header), 0) == (ssize_t) sizeof(header)
+                 && memcmp(header.magic, FONT_METRICS_CACHE_MAGIC, sizeof(header.magic)) == 0
+                 && header.version == FONT_METRICS_CACHE_VERSION
+                 && header.metricsSize == sizeof(FontMetrics)
+                 && header.fontModificationTime == (Sint64) fontStat.st_mtime
+                 && header.fontFileSize == (Sint64) fontStat.st_size
+                 && header.fontSize == size
+                 && header.pathLength == pathLength
+                 && pread(file, cachedPath, pathLength, pathOffset) == (ssize_t) pathLength
+                 && memcmp(cachedPath, absoluteFontPath, pathLength) == 0
+                 && pread(file, metrics, sizeof(FontMetrics), metricsOffset) == (ssize_t) sizeof(FontMetrics);
+    close(file);
+    LOG("%s font metrics of %s from %s\n", valid ? "Loaded" : "Ignoring stale", fontPath, cachePath);
+    return valid;
+}
+
+void storeFontMetrics(const char* fontPath, int size, const FontMetrics* metrics) {
+    char absoluteFontPath[PATH_MAX], cachePath[PATH_MAX], temporaryPath[PATH_MAX];
+    struct stat fontStat;
+    if (!getCachePaths(fontPath, size, absoluteFontPath, cachePath) || stat(absoluteFontPath, &fontStat) != 0) {
+        return;
+    }
+    FontMetricsCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FONT_METRICS_CACHE_MAGIC, sizeof(header.magic));
+    header.version = FONT_METRICS_CACHE_VERSION;
+    header.metricsSize = sizeof(FontMetrics);
+    header.fontModificationTime = (Sint64) fontStat.st_mtime;
+    header.fontFileSize = (Sint64) fontStat.st_size;
+    header.fontSize = size;
+    header.pathLength = (Uint32) strlen(absoluteFontPath);
+    // Write to a temporary file first, so other processes never read a partially written file.
+    if (snprintf(temporaryPath, sizeof(temporaryPath), "%s.%d", cachePath, (int) getpid()) >= PATH_MAX) {
+        return;
+    }
+    FILE* file = fopen(temporaryPath, "wb");
+    if (file == NULL) {
+        LOG("Failed to create the font metrics cache %s: %s\n", temporaryPath, strerror(errno));
+        return;
+    }
+    Bool written = fwrite(&header, sizeof(header), 1, file) == 1
+                   && fwrite(metrics, sizeof(FontMetrics), 1, file) == 1
+                   && fwrite(absoluteFontPath, 1, header.pathLength, file) == header.pathLength;
+    if (fclose(file) != 0 || !written || rename(temporaryPath, cachePath) != 0) {
+        LOG("Failed to write the font metrics cache %s\n", cachePath);
+        unlink(temporaryPath);
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef _FONT_METRICS_CACHE_H_
+#define _FONT_METRICS_CACHE_H_
+
+#include <SDL2/SDL.h>
+#include "X11/Xlib.h"
+
+/*
+ * The metrics XQueryFont reports for a font, as they are stored in the cache.
+ * The cache files are kept in SDL2X11_FONT_CACHE_DIR, or in sdl2X11Emulation in the
+ * XDG cache directory if it is not set. Setting SDL2X11_FONT_CACHE_DIR to an empty
+ * string disables the cache.
+ */
+typedef struct {
+    int ascent;
+    int descent;
+    Bool fixedWidth;
+    Bool allCharsExist;
+    unsigned int minChar;
+    unsigned int maxChar;
+    XCharStruct minBounds;
+    XCharStruct maxBounds;
+    /* The metrics of the characters minChar to maxChar. */
+    XCharStruct perChar[256];
+    /* One bit for every character of the BMP that has a glyph in the font. */
+    Uint8 coverage[0x10000 / 8];
+} FontMetrics;
+
+#define IS_CHARACTER_COVERED(metrics, character) \
+    (((metrics)->coverage[(character) / 8] >> ((character) % 8)) & 1)
+
+/* Get the path of a file in the font cache directory that belongs to key. */
+Bool getFontCacheFilePath(const char* key, const char* suffix, char* cachePath);
+Bool loadFontMetrics(const char* fontPath, int size, FontMetrics* metrics);
+void storeFontMetrics(const char* fontPath, int size, const FontMetrics* metrics);
+
+#endif /* _FONT_METRICS_CACHE_H_ */
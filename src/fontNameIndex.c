@@ -0,0 +1,241 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "fontNameIndex.h"
+#include "util.h"
+
+#define BITS_PER_WORD 32
+#define INITIAL_VALUES_CAPACITY 64
+
+/* An interned field value and the sets of names which contain it at each field position. */
+typedef struct {
+    char* value;
+    Uint32* namesWithField[FONT_NAME_INDEX_MAX_FIELDS];
+} FieldValue;
+
+struct FontNameIndex {
+    size_t numNames;
+    size_t numWords;
+    /* The names in lower case. */
+    char** names;
+    /* Names with more than FONT_NAME_INDEX_MAX_FIELDS fields, they are candidates for every pattern. */
+    Uint32* unindexedNames;
+    /* An open addressing hash table of the interned field values. */
+    FieldValue** values;
+    size_t valuesCapacity;
+    size_t numValues;
+};
+
+static char* lowerCaseCopy(const char* string) {
+    char* copy = strdup(string);
+    char* chr;
+    if (copy == NULL) return NULL;
+    for (chr = copy; *chr != '\0'; chr++) {
+        *chr = (char) tolower((unsigned char) *chr);
+    }
+    return copy;
+}
+
+static FieldValue** findValueSlot(FieldValue** values, size_t capacity, const char* value) {
+    Uint32 hash = 2166136261U; // FNV-1a
+    const char* chr;
+    for (chr = value; *chr != '\0'; chr++) {
+        hash = (hash ^ (Uint8) *chr) * 16777619U;
+    }
+    size_t slot = hash & (capacity - 1);
+    while (values[slot] != NULL && strcmp(values[slot]->value, value) != 0) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return &values[slot];
+}
+
+static Bool growValues(FontNameIndex* index) {
+    size_t newCapacity = index->valuesCapacity * 2;
+    FieldValue** newValues = calloc(newCapacity, sizeof(FieldValue*));
+    size_t i;
+    if (newValues == NULL) return False;
+    for (i = 0; i < index->valuesCapacity; i++) {
+        if (index->values[i] != NULL) {
+            *findValueSlot(newValues, newCapacity, index->values[i]->value) = index->values[i];
+        }
+    }
+    free(index->values);
+    index->values = newValues;
+    index->valuesCapacity = newCapacity;
+    return True;
+}
+
+static FieldValue* internValue(FontNameIndex* index, const char* value) {
+    FieldValue** slot = findValueSlot(index->values, index->valuesCapacity, value);
+    if (*slot != NULL) return *slot;
+    // Keep the load factor of the table below one half.
+    if ((index->numValues + 1) * 2 > index->valuesCapacity) {
+        if (!growValues(index)) return NULL;
+        slot = findValueSlot(index->values, index->valuesCapacity, value);
+    }
+    FieldValue* fieldValue = calloc(1, sizeof(FieldValue));
+    if (fieldValue == NULL) return NULL;
+    fieldValue->value = strdup(value);
+    if (fieldValue->value == NULL) {
+        free(fieldValue);
+        return NULL;
+    }
+    *slot = fieldValue;
+    index->numValues++;
+    return fieldValue;
+}
+
+/* Split the lower case name into its fields and add it to the sets of the field values. */
+static Bool indexName(FontNameIndex* index, size_t nameIndex) {
+    const char* name = index->names[nameIndex];
+    Uint32 bit = 1U << (nameIndex % BITS_PER_WORD);
+    size_t word = nameIndex / BITS_PER_WORD;
+    size_t numFields = 1;
+    const char* chr;
+    for (chr = name; *chr != '\0'; chr++) {
+        if (*chr == '-') numFields++;
+    }
+    if (numFields > FONT_NAME_INDEX_MAX_FIELDS) {
+        index->unindexedNames[word] |= bit;
+        return True;
+    }
+    char* fields = strdup(name);
+    if (fields == NULL) return False;
+    char* field = fields;
+    size_t position;
+    for (position = 0; field != NULL; position++) {
+        char* nextField = strchr(field, '-');
+        if (nextField != NULL) *nextField++ = '\0';
+        FieldValue* value = internValue(index, field);
+        if (value == NULL) {
+            free(fields);
+            return False;
+        }
+        if (value->namesWithField[position] == NULL) {
+            value->namesWithField[position] = calloc(index->numWords, sizeof(Uint32));
+            if (value->namesWithField[position] == NULL) {
+                free(fields);
+                return False;
+            }
+        }
+        value->namesWithField[position][word] |= bit;
+        field = nextField;
+    }
+    free(fields);
+    return True;
+}
+
+FontNameIndex* createFontNameIndex(char* const* names, size_t numNames) {
+    FontNameIndex* index = calloc(1, sizeof(FontNameIndex));
+    size_t i;
+    if (index == NULL) return NULL;
+    index->numNames = numNames;
+    index->numWords = MAX(1, (numNames + BITS_PER_WORD - 1) / BITS_PER_WORD);
+    index->names = calloc(MAX(1, numNames), sizeof(char*));
+    index->unindexedNames = calloc(index->numWords, sizeof(Uint32));
+    index->valuesCapacity = INITIAL_VALUES_CAPACITY;
+    index->values = calloc(index->valuesCapacity, sizeof(FieldValue*));
+    if (index->names == NULL || index->unindexedNames == NULL || index->values == NULL) {
+        freeFontNameIndex(index);
+        return NULL;
+    }
+    for (i = 0; i < numNames; i++) {
+        index->names[i] = lowerCaseCopy(names[i]);
+        if (index->names[i] == NULL || !indexName(index, i)) {
+            freeFontNameIndex(index);
+            return NULL;
+        }
+    }
+    LOG("Indexed %zu font names with %zu distinct field values\n", numNames, index->numValues);
+    return index;
+}
+
+/* Only keep the candidates which contain the value in one of the field positions. */
+static void restrictCandidates(const FontNameIndex* index, Uint32* candidates, const char* value,
+                               size_t firstPosition, size_t lastPosition) {
+    const FieldValue* fieldValue = *findValueSlot(index->values, index->valuesCapacity, value);
+    size_t word, position;
+    for (word = 0; word < index->numWords; word++) {
+        Uint32 names = 0;
+        for (position = firstPosition; fieldValue != NULL && position <= lastPosition; position++) {
+            if (fieldValue->namesWithField[position] != NULL) {
+                names |= fieldValue->namesWithField[position][word];
+            }
+        }
+        candidates[word] &= names;
+    }
+}
+
+size_t findFontNames(const FontNameIndex* index, const char* pattern, size_t* matches, size_t maxMatches) {
+    size_t numMatches = 0;
+    size_t word, bit;
+    char* lowerPattern = lowerCaseCopy(pattern);
+    char* segments = lowerCaseCopy(pattern);
+    Uint32* candidates = malloc(index->numWords * sizeof(Uint32));
+    if (lowerPattern == NULL || segments == NULL || candidates == NULL) {
+        free(lowerPattern);
+        free(segments);
+        free(candidates);
+        return 0;
+    }
+    memset(candidates, 0xFF, index->numWords * sizeof(Uint32));
+    // A segment between two dashes without wildcards must be a whole field of a matching name.
+    // It is at the same position in the name until a wildcard in the pattern may have matched
+    // some dashes, after that it can only be at the same or a later position.
+    Bool exactPosition = True;
+    char* segment = segments;
+    size_t position;
+    for (position = 0; segment != NULL && position < FONT_NAME_INDEX_MAX_FIELDS; position++) {
+        char* nextSegment = strchr(segment, '-');
+        if (nextSegment != NULL) *nextSegment++ = '\0';
+        if (strpbrk(segment, "*?") != NULL) {
+            exactPosition = False;
+        } else if (segment[0] != '\0') {
+            restrictCandidates(index, candidates, segment, position,
+                               exactPosition ? position : FONT_NAME_INDEX_MAX_FIELDS - 1);
+        }
+        segment = nextSegment;
+    }
+    if (segment != NULL) {
+        // The pattern has more fields than any indexed name.
+        memset(candidates, 0, index->numWords * sizeof(Uint32));
+    }
+    for (word = 0; word < index->numWords && numMatches < maxMatches; word++) {
+        Uint32 names = candidates[word] | index->unindexedNames[word];
+        for (bit = 0; names != 0 && numMatches < maxMatches; bit++, names >>= 1) {
+            size_t nameIndex = word * BITS_PER_WORD + bit;
+            if ((names & 1) && nameIndex < index->numNames
+                && matchWildcard(lowerPattern, index->names[nameIndex])) {
+                matches[numMatches++] = nameIndex;
+            }
+        }
+    }
+    free(lowerPattern);
+    free(segments);
+    free(candidates);
+    return numMatches;
+}
+
+void freeFontNameIndex(FontNameIndex* index) {
+    size_t i, position;
+    if (index == NULL) return;
+    if (index->names != NULL) {
+        for (i = 0; i < index->numNames; i++) {
+            free(index->names[i]);
+        }
+        free(index->names);
+    }
+    if (index->values != NULL) {
+        for (i = 0; i < index->valuesCapacity; i++) {
+            if (index->values[i] == NULL) continue;
+            for (position = 0; position < FONT_NAME_INDEX_MAX_FIELDS; position++) {
+                free(index->values[i]->namesWithField[position]);
+            }
+            free(index->values[i]->value);
+            free(index->values[i]);
+        }
+        free(index->values);
+    }
+    free(index->unindexedNames);
+    free(index);
+}
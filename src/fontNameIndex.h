@@ -0,0 +1,21 @@
+#ifndef _FONT_NAME_INDEX_H_
+#define _FONT_NAME_INDEX_H_
+
+#include <SDL2/SDL.h>
+#include "X11/Xlib.h"
+
+/*
+ * An index over the fields of XLFD font names. Patterns are matched case insensitive.
+ * Every field of a pattern without wildcards narrows the candidates down to the names
+ * that contain it, only those candidates are matched against the whole pattern.
+ */
+#define FONT_NAME_INDEX_MAX_FIELDS 16
+
+typedef struct FontNameIndex FontNameIndex;
+
+FontNameIndex* createFontNameIndex(char* const* names, size_t numNames);
+/* Store the indices of up to maxMatches names which match the pattern in matches, in ascending order. */
+size_t findFontNames(const FontNameIndex* index, const char* pattern, size_t* matches, size_t maxMatches);
+void freeFontNameIndex(FontNameIndex* index);
+
+#endif /* _FONT_NAME_INDEX_H_ */
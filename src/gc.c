@@ -19,6 +19,7 @@ int XFreeGC(Display* display, GC gc) {
     if (gContext->dashes != NULL) {
         free(gContext->dashes);
     }
+    pixman_region_fini(&gContext->clipRegion);
     free(gContext);
     XExtData* extData = gc->ext_data;
     while (extData != NULL) {
@@ -34,6 +35,35 @@ int XFreeGC(Display* display, GC gc) {
     return 1;
 }
 
+void initGraphicContext(GraphicContext* gc) {
+    gc->dashes = NULL;
+    gc->numDashes = 0;
+    gc->function = GXcopy;
+    gc->planeMask = 0xFFFFFFFF;
+    gc->foreground = 0;
+    gc->background = 1;
+    gc->lineWidth = 0;
+    gc->lineStyle = LineSolid;
+    gc->capStyle = CapButt;
+    gc->joinStyle = JoinMiter;
+    gc->fillStyle = FillSolid;
+    gc->fillRule = EvenOddRule;
+    gc->arcMode = ArcPieSlice;
+    gc->tile = None;
+    gc->stipple = None;
+    gc->tileStipOriginX = 0;
+    gc->tileStipOriginY = 0;
+    gc->font = None;
+    gc->subWindowMode = ClipByChildren;
+    gc->graphicsExposures = True;
+    gc->clipOriginX = 0;
+    gc->clipOriginY = 0;
+    gc->clipMask = None;
+    gc->hasClipRegion = False;
+    pixman_region_init(&gc->clipRegion);
+    gc->dashOffset = 0;
+}
+
 GC XCreateGC(Display* display, Drawable d, unsigned long valuemask, XGCValues* values) {
     // https://tronche.com/gui/x/xlib/GC/XCreateGC.html
     SET_X_SERVER_REQUEST(display, X_CreateGC);
@@ -64,7 +94,7 @@ GC XCreateGC(Display* display, Drawable d, unsigned long valuemask, XGCValues* v
     graphicContextStruct->gid = contextId;
     SET_XID_TYPE(contextId, GRAPHICS_CONTEXT);
     SET_XID_VALUE(contextId, gc);
-    // Initialize default values
+    initGraphicContext(gc);
     gc->dashes = malloc(sizeof(char) * 2);
     if (gc->dashes == NULL) {
         XFreeGC(display, graphicContextStruct);
@@ -74,28 +104,6 @@ GC XCreateGC(Display* display, Drawable d, unsigned long valuemask, XGCValues* v
     gc->numDashes = 2;
     gc->dashes[0] = 4;
     gc->dashes[1] = 4;
-    gc->function = GXcopy;
-    gc->planeMask = 0xFFFFFFFF;
-    gc->foreground = 0;
-    gc->background = 1;
-    gc->lineWidth = 0;
-    gc->lineStyle = LineSolid;
-    gc->capStyle = CapButt;
-    gc->joinStyle = JoinMiter;
-    gc->fillStyle = FillSolid;
-    gc->fillRule = EvenOddRule;
-    gc->arcMode = ArcPieSlice;
-    gc->tile = None;
-    gc->stipple = None;
-    gc->tileStipOriginX = 0;
-    gc->tileStipOriginY = 0;
-    gc->font = None;
-    gc->subWindowMode = ClipByChildren;
-    gc->graphicsExposures = True;
-    gc->clipOriginX = 0;
-    gc->clipOriginY = 0;
-    gc->clipMask = None;
-    gc->dashOffset = 0;
     if (!XChangeGC(display, graphicContextStruct, valuemask, values)) {
         XFreeGC(display, graphicContextStruct);
         return NULL;
@@ -178,7 +186,9 @@ int XChangeGC(Display* display, GC gc, unsigned long valuemask, XGCValues* value
         return 0;
     }
     GraphicContext* graphicContext = GET_GC(gc);
-    if (HAS_VALUE(valuemask, GCFunction)) {graphicContext->function = values->function;}
+    if (HAS_VALUE(valuemask, GCFunction)) {
+        if (!XSetFunction(display, gc, values->function)) return 0;
+    }
     if (HAS_VALUE(valuemask, GCPlaneMask)) {graphicContext->planeMask = values->plane_mask;}
     if (HAS_VALUE(valuemask, GCForeground)) {XSetForeground(display, gc, values->foreground);}
     if (HAS_VALUE(valuemask, GCBackground)) {graphicContext->background = values->background;}
@@ -229,6 +239,11 @@ int XCopyGC(Display *display, GC src, unsigned long valuemask, GC dest) {
     GraphicContext* srcGraphicContext = GET_GC(src);
     gcValues.clip_mask = srcGraphicContext->clipMask;
     if (!XChangeGC(display, dest, valuemask, &gcValues)) return 0;
+    if (HAS_VALUE(valuemask, GCClipMask) && srcGraphicContext->hasClipRegion
+        && !setClipRegion(display, GET_GC(dest), &srcGraphicContext->clipRegion)) {
+        handleOutOfMemory(0, display, 0, 0);
+        return 0;
+    }
     return setDashes(display, GET_GC(dest), srcGraphicContext->dashes, srcGraphicContext->numDashes, False) ? 1 : 0;
 }
 
@@ -303,6 +318,61 @@ int XSetClipMask(Display* display, GC gc, Pixmap pixmap) {
     if (graphicContext->clipMask != None) {XFreePixmap(display, graphicContext->clipMask);}
     SET_X_SERVER_REQUEST(display, X_ChangeGC);
     graphicContext->clipMask = pixmap;
+    graphicContext->hasClipRegion = False;
+    pixman_region_fini(&graphicContext->clipRegion);
+    pixman_region_init(&graphicContext->clipRegion);
+    return 1;
+}
+
+Bool setClipRegion(Display* display, GraphicContext* gc, pixman_region16_t* region) {
+    if (!pixman_region_copy(&gc->clipRegion, region)) { return False; }
+    if (gc->clipMask != None) {
+        XFreePixmap(display, gc->clipMask);
+        gc->clipMask = None;
+    }
+    gc->hasClipRegion = True;
+    return True;
+}
+
+int XSetClipRectangles(Display* display, GC gc, int clip_x_origin, int clip_y_origin, XRectangle* rectangles,
+                       int n, int ordering) {
+    // https://tronche.com/gui/x/xlib/GC/XSetClipRectangles.html
+    SET_X_SERVER_REQUEST(display, X_SetClipRectangles);
+    if (ordering != Unsorted && ordering != YSorted && ordering != YXSorted && ordering != YXBanded) {
+        handleError(0, display, None, 0, BadValue, 0);
+        return 0;
+    }
+    // The rectangles are sorted and merged by pixman, so the ordering doesn't matter.
+    pixman_region16_t region;
+    pixman_box16_t* boxes = malloc(sizeof(pixman_box16_t) * (n > 0 ? n : 1));
+    if (boxes == NULL) {
+        handleOutOfMemory(0, display, 0, 0);
+        return 0;
+    }
+    int i, numBoxes = 0;
+    for (i = 0; i < n; i++) {
+        if (rectangles[i].width == 0 || rectangles[i].height == 0) { continue; }
+        boxes[numBoxes].x1 = rectangles[i].x;
+        boxes[numBoxes].y1 = rectangles[i].y;
+        boxes[numBoxes].x2 = (int16_t) (rectangles[i].x + rectangles[i].width);
+        boxes[numBoxes].y2 = (int16_t) (rectangles[i].y + rectangles[i].height);
+        numBoxes++;
+    }
+    Bool initialized = pixman_region_init_rects(&region, boxes, numBoxes);
+    free(boxes);
+    if (!initialized) {
+        handleOutOfMemory(0, display, 0, 0);
+        return 0;
+    }
+    GraphicContext* graphicContext = GET_GC(gc);
+    Bool success = setClipRegion(display, graphicContext, &region);
+    pixman_region_fini(&region);
+    if (!success) {
+        handleOutOfMemory(0, display, 0, 0);
+        return 0;
+    }
+    graphicContext->clipOriginX = clip_x_origin;
+    graphicContext->clipOriginY = clip_y_origin;
     return 1;
 }
 
@@ -355,7 +425,34 @@ int XSetLineAttributes(Display* display, GC gc, unsigned int linewidth, int line
 }
 
 int XSetFunction(Display *display, GC gc, int function) {
-    (void) display;
+    // https://tronche.com/gui/x/xlib/GC/convenience-functions/XSetFunction.html
+    if (function < GXclear || function > GXset) {
+        handleError(0, display, None, 0, BadValue, 0);
+        return 0;
+    }
     GET_GC(gc)->function = function;
     return 1;
-}
\ No newline at end of file
+}
+
+int XSetState(Display* display, GC gc, unsigned long foreground, unsigned long background, int function,
+              unsigned long plane_mask) {
+    // https://tronche.com/gui/x/xlib/GC/convenience-functions/XSetState.html
+    if (!XSetFunction(display, gc, function)) return 0;
+    XSetForeground(display, gc, foreground);
+    XSetBackground(display, gc, background);
+    XSetPlaneMask(display, gc, plane_mask);
+    return 1;
+}
+int XSetFillRule(Display* display, GC gc, int fill_rule) {
+    // https://tronche.com/gui/x/xlib/GC/convenience-functions/XSetFillRule.html
+    (void) display;
+    GET_GC(gc)->fillRule = fill_rule;
+    return 1;
+}
+
+int XSetArcMode(Display* display, GC gc, int arc_mode) {
+    // https://tronche.com/gui/x/xlib/GC/convenience-functions/XSetArcMode.html
+    (void) display;
+    GET_GC(gc)->arcMode = arc_mode;
+    return 1;
+}
@@ -1,6 +1,7 @@
 #ifndef GC_H
 #define GC_H
 
+#include <pixman.h>
 #include "X11/Xlib.h"
 #include "resourceTypes.h"
 
@@ -30,12 +31,20 @@ typedef struct _GraphicContext {
     int clipOriginX;
     int clipOriginY;
     Pixmap clipMask;
+    /* Set by XSetClipRectangles and XSetRegion, the region is relative to the clip origin. */
+    Bool hasClipRegion;
+    pixman_region16_t clipRegion;
     int dashOffset;
     char* dashes; // If numDashes is uneven, this has to be treated as concatenated with itself.
     size_t numDashes;
     int arcMode;
 } GraphicContext;
 
+/* Set the default values of a graphic context, except for the dashes. */
+void initGraphicContext(GraphicContext* gc);
+/* Replace the clip mask and clip region of the graphic context with the region. */
+Bool setClipRegion(Display* display, GraphicContext* gc, pixman_region16_t* region);
+
 #define GET_GC(gc) GET_GC_FROM_XID(((struct _XGC*) (gc))->gid)
 #define GET_GC_FROM_XID(id) ((GraphicContext*) GET_XID_VALUE(id))
 
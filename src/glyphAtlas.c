@@ -0,0 +1,434 @@
+#include <stdlib.h>
+#include "glyphAtlas.h"
+#include "statistics.h"
+#include "util.h"
+
+#define DEFAULT_MAX_GLYPH_ATLAS_PAGES 4
+#define MAX_GLYPH_ATLAS_PAGES 255
+#define GLYPH_BLOCK_SIZE 256
+#define NUM_GLYPH_BLOCKS (0x10000 / GLYPH_BLOCK_SIZE)
+#define UNKNOWN_CODEPOINT 0xFFFD
+
+#ifdef SDL_TTF_VERSION_ATLEAST
+#  if SDL_TTF_VERSION_ATLEAST(2, 0, 18)
+#    define TTF_GLYPHS_RENDERED_AS_TEXT
+#  endif
+#endif
+
+typedef enum {GlyphUncached = 0, GlyphEmpty, GlyphCached} GlyphState;
+
+typedef struct {
+    Uint8 state;
+    Uint8 page;
+    /* The position of the glyph in its page. */
+    SDL_Rect rect;
+    /* The offset of the rendered glyph from the pen position at the top of the line. */
+    int offsetX;
+    int offsetY;
+    int advance;
+} Glyph;
+
+typedef struct {
+    SDL_Texture* texture;
+    /* Glyphs are packed left to right into shelves, which are stacked top to bottom. */
+    int shelfX;
+    int shelfY;
+    int shelfHeight;
+    unsigned long lastUsed;
+    unsigned long usedPixels;
+} GlyphAtlasPage;
+
+typedef struct GlyphAtlas {
+    TTF_Font* font;
+    SDL_Renderer* renderer;
+    int numPages;
+    int currentPage;
+    GlyphAtlasPage pages[MAX_GLYPH_ATLAS_PAGES];
+    /* The glyphs of the BMP, allocated in blocks of GLYPH_BLOCK_SIZE when first used. */
+    Glyph* blocks[NUM_GLYPH_BLOCKS];
+    struct GlyphAtlas* next;
+} GlyphAtlas;
+
+/* The glyphs of one page that are waiting to be drawn with one geometry submission. */
+typedef struct {
+    GlyphAtlas* atlas;
+    int page;
+    int numGlyphs;
+    int capacity;
+    SDL_Vertex* vertices;
+    int* indices;
+} GlyphBatch;
+
+static GlyphAtlas* glyphAtlases = NULL;
+static int maxGlyphAtlasPages = DEFAULT_MAX_GLYPH_ATLAS_PAGES;
+static unsigned long useCounter = 0;
+static GlyphBatch batch = {NULL, 0, 0, 0, NULL, NULL};
+
+void initGlyphAtlas() {
+    const char* maxPages = getenv("SDL2X11_GLYPH_ATLAS_PAGES");
+    maxGlyphAtlasPages = DEFAULT_MAX_GLYPH_ATLAS_PAGES;
+    if (maxPages != NULL && maxPages[0] != '\0') {
+        maxGlyphAtlasPages = MAX(1, MIN(atoi(maxPages), MAX_GLYPH_ATLAS_PAGES));
+    }
+    LOG("Glyph atlases are limited to %d pages\n", maxGlyphAtlasPages);
+}
+
+static GlyphAtlas* getGlyphAtlas(SDL_Renderer* renderer, TTF_Font* font) {
+    GlyphAtlas* atlas;
+    GlyphAtlas* previous = NULL;
+    for (atlas = glyphAtlases; atlas != NULL; previous = atlas, atlas = atlas->next) {
+        if (atlas->font == font && atlas->renderer == renderer) {
+            if (previous != NULL) {
+                // Move to the front, text is usually drawn with the same few fonts.
+                previous->next = atlas->next;
+                atlas->next = glyphAtlases;
+                glyphAtlases = atlas;
+            }
+            return atlas;
+        }
+    }
+    atlas = calloc(1, sizeof(GlyphAtlas));
+    if (atlas == NULL) { return NULL; }
+    atlas->font = font;
+    atlas->renderer = renderer;
+    atlas->next = glyphAtlases;
+    glyphAtlases = atlas;
+    return atlas;
+}
+
+static void freeGlyphAtlas(GlyphAtlas* atlas) {
+    int i;
+    if (batch.atlas == atlas) {
+        batch.atlas = NULL;
+        batch.numGlyphs = 0;
+    }
+    for (i = 0; i < atlas->numPages; i++) {
+        SDL_DestroyTexture(atlas->pages[i].texture);
+        statistics.glyphAtlasPixelsUsed -= atlas->pages[i].usedPixels;
+    }
+    statistics.glyphAtlasPages -= atlas->numPages;
+    for (i = 0; i < NUM_GLYPH_BLOCKS; i++) {
+        free(atlas->blocks[i]);
+    }
+    free(atlas);
+}
+
+static void freeGlyphAtlases(TTF_Font* font, SDL_Renderer* renderer) {
+    GlyphAtlas** atlasPointer = &glyphAtlases;
+    while (*atlasPointer != NULL) {
+        GlyphAtlas* atlas = *atlasPointer;
+        if (atlas->font == font || atlas->renderer == renderer) {
+            *atlasPointer = atlas->next;
+            freeGlyphAtlas(atlas);
+        } else {
+            atlasPointer = &atlas->next;
+        }
+    }
+    if (glyphAtlases == NULL) {
+        free(batch.vertices);
+        free(batch.indices);
+        batch.vertices = NULL;
+        batch.indices = NULL;
+        batch.capacity = 0;
+    }
+}
+
+size_t getGlyphAtlasMemoryOfFont(TTF_Font* font) {
+    size_t memory = 0;
+    GlyphAtlas* atlas;
+    int i;
+    for (atlas = glyphAtlases; atlas != NULL; atlas = atlas->next) {
+        if (atlas->font != font) { continue; }
+        memory += sizeof(GlyphAtlas) + (size_t) atlas->numPages * GLYPH_ATLAS_PAGE_SIZE * GLYPH_ATLAS_PAGE_SIZE * 4;
+        for (i = 0; i < NUM_GLYPH_BLOCKS; i++) {
+            if (atlas->blocks[i] != NULL) {
+                memory += GLYPH_BLOCK_SIZE * sizeof(Glyph);
+            }
+        }
+    }
+    return memory;
+}
+
+void freeGlyphAtlasesOfFont(TTF_Font* font) {
+    freeGlyphAtlases(font, NULL);
+}
+
+void freeGlyphAtlasesOfRenderer(SDL_Renderer* renderer) {
+    freeGlyphAtlases(NULL, renderer);
+}
+
+static void flushGlyphBatch() {
+    if (batch.atlas == NULL || batch.numGlyphs == 0) { return; }
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (SDL_RenderGeometry(batch.atlas->renderer, batch.atlas->pages[batch.page].texture,
+                           batch.vertices, batch.numGlyphs * 4, batch.indices, batch.numGlyphs * 6) != 0) {
+        LOG("SDL_RenderGeometry failed in %s: %s\n", __func__, SDL_GetError());
+    }
+#endif
+    batch.numGlyphs = 0;
+}
+
+/* Forget all glyphs of the least recently used page and return it, so it can be filled again. */
+static int evictGlyphAtlasPage(GlyphAtlas* atlas) {
+    int i, j, pageIndex = 0;
+    for (i = 1; i < atlas->numPages; i++) {
+        if (atlas->pages[i].lastUsed < atlas->pages[pageIndex].lastUsed) {
+            pageIndex = i;
+        }
+    }
+    if (batch.atlas == atlas && batch.page == pageIndex) {
+        flushGlyphBatch();
+    }
+    for (i = 0; i < NUM_GLYPH_BLOCKS; i++) {
+        if (atlas->blocks[i] == NULL) { continue; }
+        for (j = 0; j < GLYPH_BLOCK_SIZE; j++) {
+            Glyph* glyph = &atlas->blocks[i][j];
+            if (glyph->state == GlyphCached && glyph->page == pageIndex) {
+                glyph->state = GlyphUncached;
+            }
+        }
+    }
+    GlyphAtlasPage* page = &atlas->pages[pageIndex];
+    statistics.glyphAtlasPixelsUsed -= page->usedPixels;
+    statistics.glyphAtlasEvictions++;
+    page->shelfX = 0;
+    page->shelfY = 0;
+    page->shelfHeight = 0;
+    page->usedPixels = 0;
+    return pageIndex;
+}
+
+static int addGlyphAtlasPage(GlyphAtlas* atlas) {
+    if (atlas->numPages >= maxGlyphAtlasPages) {
+        return evictGlyphAtlasPage(atlas);
+    }
+    SDL_Texture* texture = SDL_CreateTexture(atlas->renderer, SDL_PIXELFORMAT_ARGB8888,
+                                             SDL_TEXTUREACCESS_STATIC,
+                                             GLYPH_ATLAS_PAGE_SIZE, GLYPH_ATLAS_PAGE_SIZE);
+    if (texture == NULL) {
+        LOG("SDL_CreateTexture failed in %s: %s\n", __func__, SDL_GetError());
+        return -1;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    GlyphAtlasPage* page = &atlas->pages[atlas->numPages];
+    page->texture = texture;
+    page->shelfX = 0;
+    page->shelfY = 0;
+    page->shelfHeight = 0;
+    page->lastUsed = useCounter;
+    page->usedPixels = 0;
+    statistics.glyphAtlasPages++;
+    return atlas->numPages++;
+}
+
+/* Find space for a glyph of the given size, adding or evicting a page if necessary. */
+static Bool allocateGlyphRect(GlyphAtlas* atlas, int width, int height, Uint8* pageIndex, SDL_Rect* rect) {
+    if (width > GLYPH_ATLAS_PAGE_SIZE || height > GLYPH_ATLAS_PAGE_SIZE) { return False; }
+    GlyphAtlasPage* page = atlas->numPages == 0 ? NULL : &atlas->pages[atlas->currentPage];
+    if (page != NULL && page->shelfX + width > GLYPH_ATLAS_PAGE_SIZE) {
+        page->shelfY += page->shelfHeight;
+        page->shelfX = 0;
+        page->shelfHeight = 0;
+    }
+    if (page == NULL || page->shelfY + height > GLYPH_ATLAS_PAGE_SIZE) {
+        int newPage = addGlyphAtlasPage(atlas);
+        if (newPage == -1) { return False; }
+        atlas->currentPage = newPage;
+        page = &atlas->pages[newPage];
+    }
+    rect->x = page->shelfX;
+    rect->y = page->shelfY;
+    rect->w = width;
+    rect->h = height;
+    page->shelfX += width;
+    page->shelfHeight = MAX(page->shelfHeight, height);
+    page->usedPixels += (unsigned long) (width * height);
+    statistics.glyphAtlasPixelsUsed += (unsigned long) (width * height);
+    *pageIndex = (Uint8) atlas->currentPage;
+    return True;
+}
+
+static Glyph* getGlyph(GlyphAtlas* atlas, Uint16 character) {
+    Glyph* block = atlas->blocks[character / GLYPH_BLOCK_SIZE];
+    if (block == NULL) {
+        block = calloc(GLYPH_BLOCK_SIZE, sizeof(Glyph));
+        if (block == NULL) { return NULL; }
+        atlas->blocks[character / GLYPH_BLOCK_SIZE] = block;
+    }
+    Glyph* glyph = &block[character % GLYPH_BLOCK_SIZE];
+    if (glyph->state != GlyphUncached) {
+        statistics.glyphAtlasHits++;
+        return glyph;
+    }
+    statistics.glyphAtlasMisses++;
+    int minX, maxX, minY, maxY, advance;
+    if (TTF_GlyphMetrics(atlas->font, character, &minX, &maxX, &minY, &maxY, &advance) != 0) {
+        LOG("Failed to determine metrics for character '%u': %s\n", character, TTF_GetError());
+        minX = maxX = minY = maxY = advance = 0;
+    }
+    glyph->state = GlyphEmpty;
+    glyph->advance = advance;
+#ifdef TTF_GLYPHS_RENDERED_AS_TEXT
+    // The glyph is rendered like a one character string,
+    // which SDL_ttf shifts to the right if the glyph has a negative left bearing.
+    glyph->offsetX = MIN(minX, 0);
+    glyph->offsetY = 0;
+#else
+    // Older versions of SDL_ttf only render the bitmap of the glyph.
+    glyph->offsetX = minX;
+    glyph->offsetY = TTF_FontAscent(atlas->font) - maxY;
+#endif
+    if (minX == maxX || minY == maxY) {
+        return glyph;
+    }
+    // The glyph is rendered in white, the coverage is in the alpha channel and gets tinted when drawn.
+    SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+    SDL_Surface* surface = TTF_RenderGlyph_Blended(atlas->font, character, white);
+    if (surface == NULL) {
+        LOG("TTF_RenderGlyph_Blended failed in %s: %s\n", __func__, TTF_GetError());
+        return glyph;
+    }
+    if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+        SDL_Surface* convertedSurface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(surface);
+        if (convertedSurface == NULL) {
+            LOG("SDL_ConvertSurfaceFormat failed in %s: %s\n", __func__, SDL_GetError());
+            return glyph;
+        }
+        surface = convertedSurface;
+    }
+    if (!allocateGlyphRect(atlas, surface->w, surface->h, &glyph->page, &glyph->rect)) {
+        LOG("Failed to allocate space for character '%u' in the glyph atlas\n", character);
+    } else if (SDL_UpdateTexture(atlas->pages[glyph->page].texture, &glyph->rect,
+                                 surface->pixels, surface->pitch) != 0) {
+        LOG("SDL_UpdateTexture failed in %s: %s\n", __func__, SDL_GetError());
+    } else {
+        glyph->state = GlyphCached;
+    }
+    SDL_FreeSurface(surface);
+    return glyph;
+}
+
+static void drawGlyph(GlyphAtlas* atlas, Glyph* glyph, SDL_Color color, int x, int y) {
+    SDL_Rect destRect = {x, y, glyph->rect.w, glyph->rect.h};
+    atlas->pages[glyph->page].lastUsed = useCounter;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (batch.atlas != atlas || batch.page != glyph->page) {
+        flushGlyphBatch();
+        batch.atlas = atlas;
+        batch.page = glyph->page;
+    }
+    if (batch.numGlyphs == batch.capacity) {
+        int capacity = MAX(64, batch.capacity * 2);
+        SDL_Vertex* vertices = realloc(batch.vertices, sizeof(SDL_Vertex) * 4 * capacity);
+        if (vertices != NULL) { batch.vertices = vertices; }
+        int* indices = realloc(batch.indices, sizeof(int) * 6 * capacity);
+        if (indices != NULL) { batch.indices = indices; }
+        if (vertices == NULL || indices == NULL) {
+            LOG("Out of memory: Failed to grow the glyph batch in %s\n", __func__);
+            return;
+        }
+        batch.capacity = capacity;
+    }
+    float textureX = (float) glyph->rect.x / GLYPH_ATLAS_PAGE_SIZE;
+    float textureY = (float) glyph->rect.y / GLYPH_ATLAS_PAGE_SIZE;
+    float textureW = (float) glyph->rect.w / GLYPH_ATLAS_PAGE_SIZE;
+    float textureH = (float) glyph->rect.h / GLYPH_ATLAS_PAGE_SIZE;
+    SDL_Vertex* vertices = &batch.vertices[batch.numGlyphs * 4];
+    int* indices = &batch.indices[batch.numGlyphs * 6];
+    int base = batch.numGlyphs * 4, i;
+    for (i = 0; i < 4; i++) {
+        int right = i == 1 || i == 2, bottom = i >= 2;
+        vertices[i].position.x = (float) (destRect.x + (right ? destRect.w : 0));
+        vertices[i].position.y = (float) (destRect.y + (bottom ? destRect.h : 0));
+        vertices[i].color = color;
+        vertices[i].tex_coord.x = textureX + (right ? textureW : 0.0f);
+        vertices[i].tex_coord.y = textureY + (bottom ? textureH : 0.0f);
+    }
+    indices[0] = base;
+    indices[1] = base + 1;
+    indices[2] = base + 2;
+    indices[3] = base;
+    indices[4] = base + 2;
+    indices[5] = base + 3;
+    batch.numGlyphs++;
+#else
+    SDL_Texture* texture = atlas->pages[glyph->page].texture;
+    SDL_SetTextureColorMod(texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(texture, color.a);
+    if (SDL_RenderCopy(atlas->renderer, texture, &glyph->rect, &destRect) != 0) {
+        LOG("SDL_RenderCopy failed in %s: %s\n", __func__, SDL_GetError());
+    }
+#endif
+}
+
+/* Decode the next character of the UTF-8 string. Invalid sequences decode to U+FFFD like in SDL_ttf. */
+static Uint32 nextCodepoint(const char** string) {
+    const Uint8* bytes = (const Uint8*) *string;
+    Uint32 codepoint = bytes[0];
+    int length, i;
+    if (codepoint < 0x80) {
+        length = 1;
+    } else if ((codepoint & 0xE0) == 0xC0) {
+        length = 2;
+        codepoint &= 0x1F;
+    } else if ((codepoint & 0xF0) == 0xE0) {
+        length = 3;
+        codepoint &= 0x0F;
+    } else if ((codepoint & 0xF8) == 0xF0) {
+        length = 4;
+        codepoint &= 0x07;
+    } else {
+        *string += 1;
+        return UNKNOWN_CODEPOINT;
+    }
+    for (i = 1; i < length; i++) {
+        if ((bytes[i] & 0xC0) != 0x80) {
+            *string += i;
+            return UNKNOWN_CODEPOINT;
+        }
+        codepoint = codepoint << 6 | (bytes[i] & 0x3F);
+    }
+    *string += length;
+    return codepoint;
+}
+
+Bool drawTextWithGlyphAtlas(SDL_Renderer* renderer, TTF_Font* font, const char* string,
+                            SDL_Color color, int x, int y, SDL_Rect* bounds) {
+    const char* character;
+    // The atlas only holds the BMP, leave everything else to SDL_ttf.
+    for (character = string; *character != '\0';) {
+        if (nextCodepoint(&character) > 0xFFFF) { return False; }
+    }
+    GlyphAtlas* atlas = getGlyphAtlas(renderer, font);
+    if (atlas == NULL) { return False; }
+    useCounter++;
+    int penX = x;
+    Uint16 previous = 0;
+    Bool kerning = TTF_GetFontKerning(font) != 0;
+    bounds->x = x;
+    bounds->y = y;
+    bounds->w = 0;
+    bounds->h = TTF_FontHeight(font);
+    for (character = string; *character != '\0';) {
+        Uint16 codepoint = (Uint16) nextCodepoint(&character);
+        if (kerning && previous != 0) {
+            penX += TTF_GetFontKerningSizeGlyphs(font, previous, codepoint);
+        }
+        previous = codepoint;
+        Glyph* glyph = getGlyph(atlas, codepoint);
+        if (glyph == NULL) { continue; }
+        if (glyph->state == GlyphCached) {
+            SDL_Rect glyphBounds = {penX + glyph->offsetX, y + glyph->offsetY, glyph->rect.w, glyph->rect.h};
+            drawGlyph(atlas, glyph, color, glyphBounds.x, glyphBounds.y);
+            if (bounds->w == 0) {
+                *bounds = glyphBounds;
+            } else {
+                SDL_UnionRect(bounds, &glyphBounds, bounds);
+            }
+        }
+        penX += glyph->advance;
+    }
+    flushGlyphBatch();
+    return True;
+}
@@ -0,0 +1,24 @@
+#ifndef _GLYPH_ATLAS_H_
+#define _GLYPH_ATLAS_H_
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "X11/Xlib.h"
+
+/*
+ * Glyph atlases cache the rendered glyphs of a font in textures of a renderer,
+ * so drawing a string only needs one geometry submission per atlas page.
+ * Each atlas keeps at most SDL2X11_GLYPH_ATLAS_PAGES pages (default 4),
+ * the least recently used page is evicted when more are needed.
+ */
+#define GLYPH_ATLAS_PAGE_SIZE 512
+
+void initGlyphAtlas(void);
+Bool drawTextWithGlyphAtlas(SDL_Renderer* renderer, TTF_Font* font, const char* string,
+                            SDL_Color color, int x, int y, SDL_Rect* bounds);
+/* Get the number of bytes used by the glyph atlases of the font, including their textures. */
+size_t getGlyphAtlasMemoryOfFont(TTF_Font* font);
+void freeGlyphAtlasesOfFont(TTF_Font* font);
+void freeGlyphAtlasesOfRenderer(SDL_Renderer* renderer);
+
+#endif /* _GLYPH_ATLAS_H_ */
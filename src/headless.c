@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "headless.h"
+#include "sdl2X11Emulation.h"
+#include "X11/Xutil.h"
+#include "window.h"
+#include "drawing.h"
+#include "errors.h"
+#include "compositor.h"
+#include "util.h"
+
+Bool headlessModeEnabled = False;
+
+/* The video drivers that keep their windows in memory, in order of preference. */
+static const char* HEADLESS_VIDEO_DRIVERS[] = {
+#if SDL_VERSION_ATLEAST(2, 0, 22)
+    "offscreen",
+#endif
+    "dummy",
+};
+
+Bool initVideo() {
+    const char* headless = getenv("SDL2X11_HEADLESS");
+    headlessModeEnabled = headless != NULL && headless[0] != '\0' && strcmp(headless, "0") != 0;
+    if (!headlessModeEnabled) {
+        if (SDL_Init(SDL_INIT_VIDEO) == -1) {
+            LOG("Failed to initialize SDL: %s\n", SDL_GetError());
+            return False;
+        }
+        return True;
+    }
+    // A video driver chosen with SDL_VIDEODRIVER is used as is.
+    Bool chosenDriver = getenv("SDL_VIDEODRIVER") != NULL;
+    size_t i;
+    for (i = 0; i < ARRAY_LENGTH(HEADLESS_VIDEO_DRIVERS); i++) {
+        if (!chosenDriver) {
+            setenv("SDL_VIDEODRIVER", HEADLESS_VIDEO_DRIVERS[i], 1);
+        }
+        int result = SDL_Init(SDL_INIT_VIDEO);
+        if (!chosenDriver) {
+            unsetenv("SDL_VIDEODRIVER");
+        }
+        if (result == 0) {
+            LOG("Running headless with the %s video driver\n", SDL_GetCurrentVideoDriver());
+            return True;
+        }
+        LOG("Failed to initialize SDL headless: %s\n", SDL_GetError());
+        if (chosenDriver) { break; }
+    }
+    return False;
+}
+
+Bool SDL2X11IsHeadless() {
+    return headlessModeEnabled;
+}
+
+/* Write the pixels of an xRGB image with the given number of pixels per row as a binary PPM. */
+static Bool writePPM(FILE* file, const uint32_t* pixels, int stride, int width, int height) {
+    int x, y;
+    unsigned char* row = malloc((size_t) width * 3);
+    if (row == NULL) { return False; }
+    Bool success = fprintf(file, "P6\n%d %d\n255\n", width, height) > 0;
+    for (y = 0; y < height && success; y++) {
+        const uint32_t* pixel = pixels + (size_t) y * stride;
+        for (x = 0; x < width; x++) {
+            row[x * 3] = (unsigned char) (pixel[x] >> 16);
+            row[x * 3 + 1] = (unsigned char) (pixel[x] >> 8);
+            row[x * 3 + 2] = (unsigned char) pixel[x];
+        }
+        success = fwrite(row, 3, (size_t) width, file) == (size_t) width;
+    }
+    free(row);
+    return success;
+}
+
+Status SDL2X11WriteSnapshot(Display* display, Drawable drawable, _Xconst char* fileName) {
+    TYPE_CHECK(drawable, DRAWABLE, display, 0);
+    int x, y, width, height;
+    getDrawableSize(drawable, &width, &height);
+    uint32_t* pixels = NULL;
+    pixman_image_t* frame = NULL;
+    if (compositorEnabled && IS_TYPE(drawable, WINDOW) && drawable != SCREEN_WINDOW) {
+        // The images of the child windows only come together in the frame.
+        SDL_Rect rect = {0, 0, width, height};
+        frame = compositeWindowFrame(GET_WINDOW_STRUCT(drawable), &rect, 1);
+        if (frame == NULL) { return 0; }
+        pixels = pixman_image_get_data(frame);
+    } else {
+        XImage* image = XGetImage(display, drawable, 0, 0, (unsigned int) width, (unsigned int) height, AllPlanes, ZPixmap);
+        if (image == NULL) { return 0; }
+        pixels = malloc(sizeof(uint32_t) * width * height);
+        if (pixels == NULL) {
+            XDestroyImage(image);
+            handleOutOfMemory(0, display, 0, 0);
+            return 0;
+        }
+        for (y = 0; y < height; y++) {
+            for (x = 0; x < width; x++) {
+                pixels[y * width + x] = (uint32_t) XGetPixel(image, x, y);
+            }
+        }
+        XDestroyImage(image);
+    }
+    Bool success = False;
+    FILE* file = fopen(fileName, "wb");
+    if (file == NULL) {
+        LOG("Failed to open %s in %s\n", fileName, __func__);
+    } else {
+        int stride = frame != NULL ? pixman_image_get_stride(frame) / (int) sizeof(uint32_t) : width;
+        success = writePPM(file, pixels, stride, width, height);
+        success = fclose(file) == 0 && success;
+        if (!success) {
+            LOG("Failed to write the snapshot to %s in %s\n", fileName, __func__);
+        }
+    }
+    if (frame == NULL) {
+        free(pixels);
+    }
+    return success;
+}
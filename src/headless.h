@@ -0,0 +1,17 @@
+#ifndef _HEADLESS_H_
+#define _HEADLESS_H_
+
+#include "X11/Xlib.h"
+
+/*
+ * In headless mode, selected with SDL2X11_HEADLESS=1 when the first display is opened, SDL uses
+ * the offscreen or dummy video driver. Top level windows are backed by in-memory window surfaces
+ * and no window of the operating system is ever created, so the emulation can run on machines
+ * without a display. SDL2X11WriteSnapshot can be used to look at the content of the windows.
+ */
+extern Bool headlessModeEnabled;
+
+/* Initialize the SDL video subsystem, with an offscreen driver in headless mode. Returns False on failure. */
+Bool initVideo(void);
+
+#endif /* _HEADLESS_H_ */
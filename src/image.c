@@ -7,6 +7,10 @@
 #include "display.h"
 #include "gc.h"
 #include "colors.h"
+#include "pixmanBackend.h"
+#include "pixelConversion.h"
+#include "image.h"
+#include "texturePool.h"
 
 // Inspired by https://github.com/csulmone/X11/blob/59029dc09211926a5c95ff1dd2b828574fefcde6/libX11-1.5.0/src/ImUtil.c
 
@@ -24,17 +28,31 @@ XImage* XCreateImage(Display* display, Visual* visual, unsigned int depth, int f
     image->height = height;
     image->format = format;
     image->data = data;
-    image->byte_order = MSBFirst;
-    image->bitmap_unit = 8;
+    image->xoffset = offset;
     #if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    image->byte_order = MSBFirst;
     image->bitmap_bit_order = MSBFirst;
     #else
+    image->byte_order = LSBFirst;
     image->bitmap_bit_order = LSBFirst;
     #endif
+    image->bitmap_unit = 8;
     image->depth = depth;
     image->bitmap_pad = bitmap_pad;
     image->bytes_per_line = bytes_per_line;
-    if (format != ZPixmap) {
+    // The pixel values use the layout of colors.h, not the masks of the visual.
+    if (depth > 16) {
+        image->red_mask = 0xFFUL << RED_SHIFT;
+        image->green_mask = 0xFFUL << GREEN_SHIFT;
+        image->blue_mask = 0xFFUL << BLUE_SHIFT;
+    } else if (depth > 8) {
+        image->red_mask = 0xF800;
+        image->green_mask = 0x07E0;
+        image->blue_mask = 0x001F;
+    } else {
+        image->red_mask = image->green_mask = image->blue_mask = 0;
+    }
+    if (format != ZPixmap || depth == 1) {
         image->bits_per_pixel = 1;
     } else {
         if (depth <= 4) {
@@ -48,7 +66,8 @@ XImage* XCreateImage(Display* display, Visual* visual, unsigned int depth, int f
         }
     }
     if (bytes_per_line == 0) {
-        image->bytes_per_line = width * image->bits_per_pixel / 8;
+        int pad = bitmap_pad > 0 ? bitmap_pad : 8;
+        image->bytes_per_line = (int) ((width * image->bits_per_pixel + pad - 1) / pad * pad / 8);
         assert(image->bytes_per_line > 0);
     }
 
@@ -62,63 +81,84 @@ char* getImageDataPointer(XImage* image, unsigned int x, unsigned int y) {
     return pointer + (image->bits_per_pixel / 8) * x;
 }
 
+/* Get the bit of a pixel of an image with one bit per pixel. */
+static Uint8* getImageBit(XImage* image, int x, int y, int* shift) {
+    x += image->xoffset;
+    *shift = image->bitmap_bit_order == MSBFirst ? 7 - (x & 7) : x & 7;
+    return (Uint8*) image->data + image->bytes_per_line * y + (x >> 3);
+}
+
 int XPutPixel(XImage* image, int x, int y, unsigned long pixel) {
     // https://tronche.com/gui/x/xlib/utilities/XPutPixel.html
-//    LOG("%s on %p: %lu (%ld, %ld, %ld)\n", __func__, image, pixel,
-//        (pixel >> 24) & 0xFF, (pixel >> 16) & 0xFF, (pixel >> 8) & 0xFF);
     if (image->data == NULL) {
         LOG("Invalid argument: Got image with NULL data in XPutPixel\n");
         return 0;
     }
-    char* pointer;
-    switch (image->format) {
-        case ZPixmap:
-        case XYBitmap:
-            pointer = getImageDataPointer(image, x, y);
-            if (image->bits_per_pixel == 32) {
-                *((unsigned long*) pointer) = pixel;
-            }
-            break;
-        case XYPixmap:
-            LOG("Warn: Got unimplemented format XYPixmap\n");
-            break;
-        default:
-            LOG("Warn: Got invalid format %d\n", image->format);
-            return 0;
+    if (image->format != ZPixmap && image->format != XYBitmap && image->format != XYPixmap) {
+        LOG("Warn: Got invalid format %d\n", image->format);
+        return 0;
+    }
+    Uint8* pointer;
+    int shift, i, bytes = image->bits_per_pixel / 8;
+    if (image->format == XYPixmap) {
+        // The planes follow each other, the most significant one first.
+        pointer = getImageBit(image, x, y, &shift);
+        for (i = image->depth - 1; i >= 0; i--, pointer += image->bytes_per_line * image->height) {
+            *pointer = (Uint8) ((*pointer & ~(1 << shift)) | ((pixel >> i) & 1) << shift);
+        }
+    } else if (image->bits_per_pixel == 1) {
+        pointer = getImageBit(image, x, y, &shift);
+        *pointer = (Uint8) ((*pointer & ~(1 << shift)) | (pixel & 1) << shift);
+    } else if (image->bits_per_pixel == 4) {
+        pointer = (Uint8*) image->data + image->bytes_per_line * y + x / 2;
+        shift = ((x & 1) != 0) == (image->byte_order == LSBFirst) ? 4 : 0;
+        *pointer = (Uint8) ((*pointer & ~(0xF << shift)) | (pixel & 0xF) << shift);
+    } else {
+        pointer = (Uint8*) getImageDataPointer(image, x, y);
+        for (i = 0; i < bytes; i++) {
+            shift = 8 * (image->byte_order == MSBFirst ? bytes - 1 - i : i);
+            pointer[i] = (Uint8) (pixel >> shift);
+        }
     }
     return 1;
 }
 
 unsigned long XGetPixel(XImage* image, int x, int y) {
     // https://tronche.com/gui/x/xlib/utilities/XGetPixel.html
-    //LOG("%s from %p: x = %d, y = %d\n", __func__, image, x, y);
     if (image->data == NULL) {
         LOG("Invalid argument: Got image with NULL data in XGetPixel\n");
         return 0; // TODO: throw error
     }
-    char* pointer;
-    switch (image->format) {
-        case ZPixmap:
-        case XYBitmap:
-            pointer = getImageDataPointer(image, x, y);
-//            LOG("%s: bits_per_pixel = %d, value = %x (%d)\n", __func__, image->bits_per_pixel, *pointer & 0xFF, (int) *pointer & 0xFF);
-            if (image->bits_per_pixel == 32) {
-                return *((unsigned long*) pointer);
-            } else if (image->bits_per_pixel == 1) {
-                return 0x000000FF | (*pointer << 12) | (*pointer << 8) | (*pointer << 4);
-            }
-            break;
-        case XYPixmap:
-            LOG("Warn: Got unimplemented format XYPixmap\n");
-            break;
-        default:
-            LOG("Warn: Got invalid format %d\n", image->format);
-    }
-    return 0;
+    if (image->format != ZPixmap && image->format != XYBitmap && image->format != XYPixmap) {
+        LOG("Warn: Got invalid format %d\n", image->format);
+        return 0;
+    }
+    Uint8* pointer;
+    int shift, i, bytes = image->bits_per_pixel / 8;
+    unsigned long pixel = 0;
+    if (image->format == XYPixmap) {
+        pointer = getImageBit(image, x, y, &shift);
+        for (i = image->depth - 1; i >= 0; i--, pointer += image->bytes_per_line * image->height) {
+            pixel |= (unsigned long) ((*pointer >> shift) & 1) << i;
+        }
+        return pixel;
+    } else if (image->bits_per_pixel == 1) {
+        pointer = getImageBit(image, x, y, &shift);
+        return (*pointer >> shift) & 1;
+    } else if (image->bits_per_pixel == 4) {
+        pointer = (Uint8*) image->data + image->bytes_per_line * y + x / 2;
+        shift = ((x & 1) != 0) == (image->byte_order == LSBFirst) ? 4 : 0;
+        return (*pointer >> shift) & 0xF;
+    }
+    pointer = (Uint8*) getImageDataPointer(image, x, y);
+    for (i = 0; i < bytes; i++) {
+        shift = 8 * (image->byte_order == MSBFirst ? bytes - 1 - i : i);
+        pixel |= (unsigned long) pointer[i] << shift;
+    }
+    return pixel;
 }
 
 int destroyImage(XImage* image) {
-    // https://tronche.com/gui/x/xlib/utilities/XDestroyImage.html
     if (image->data != NULL) {
         free(image->data);
     }
@@ -126,13 +166,94 @@ int destroyImage(XImage* image) {
     return 1;
 }
 
+int XDestroyImage(XImage* image) {
+    // https://tronche.com/gui/x/xlib/utilities/XDestroyImage.html
+    return image->f.destroy_image(image);
+}
+
+Colormap getDrawableColormap(Drawable drawable) {
+    return IS_TYPE(drawable, WINDOW) ? GET_COLORMAP(drawable) : REAL_COLOR_COLORMAP;
+}
+
+void clipImageRects(const ClipIterator* clip, SDL_Rect* rect, SDL_Rect* destRect) {
+    rect->x += clip->bounds.x - destRect->x;
+    rect->y += clip->bounds.y - destRect->y;
+    rect->w = clip->bounds.w;
+    rect->h = clip->bounds.h;
+    *destRect = clip->bounds;
+}
+
+Bool uploadImage(SDL_Renderer* renderer, XImage* image, const PixelConversion* conversion,
+                 const SDL_Rect* rect, const SDL_Rect* destRect, ClipIterator* clip) {
+    // Images without alpha channel can be copied as they are, SDL ignores the unused byte of RGB888.
+    Uint32 format = conversion->identity && conversion->alpha != 0 ? SDL_PIXELFORMAT_RGB888
+                                                                  : SDL_PIXELFORMAT_ARGB8888;
+    SDL_Texture* texture = acquirePoolTexture(renderer, format, rect->w, rect->h);
+    if (texture == NULL) { return False; }
+    SDL_Rect textureRect = {0, 0, rect->w, rect->h};
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(texture, &textureRect, &pixels, &pitch) != 0) {
+        LOG("SDL_LockTexture failed in %s: %s\n", __func__, SDL_GetError());
+        releasePoolTexture(texture);
+        return False;
+    }
+    if (conversion->identity) {
+        const char* source = getImageDataPointer(image, (unsigned int) rect->x, (unsigned int) rect->y);
+        size_t rowSize = (size_t) rect->w * sizeof(Uint32);
+        int y;
+        for (y = 0; y < rect->h; y++) {
+            memcpy((Uint8*) pixels + y * pitch, source + y * image->bytes_per_line, rowSize);
+        }
+    } else {
+        convertImageToArgb(conversion, image, rect->x, rect->y, rect->w, rect->h, pixels, pitch);
+    }
+    SDL_UnlockTexture(texture);
+    // Putting an image replaces the pixels of the drawable, so the alpha must not be blended.
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+    while (nextClipRect(clip, renderer)) {
+        if (SDL_RenderCopy(renderer, texture, &textureRect, destRect) < 0) {
+            LOG("SDL_RenderCopy failed in %s: %s\n", __func__, SDL_GetError());
+        }
+    }
+    releasePoolTexture(texture);
+    return True;
+}
+
 int XPutImage(Display* display, Drawable drawable, GC gc, XImage* image, int src_x, int src_y,
                int dest_x, int dest_y, unsigned int width, unsigned int height) {
     // https://tronche.com/gui/x/xlib/graphics/XPutImage.html
     SET_X_SERVER_REQUEST(display, X_PutImage);
     TYPE_CHECK(drawable, DRAWABLE, display, 0);
     LOG("%s: Drawing %p on %lu\n", __func__, image, drawable);
-    // TODO: Implement this: Create Uint32* data, Create Texture from data, rendercopy
+    // Only read inside of the image.
+    SDL_Rect rect = {src_x, src_y, (int) width, (int) height};
+    SDL_Rect imageRect = {0, 0, image->width, image->height};
+    if (!SDL_IntersectRect(&rect, &imageRect, &rect)) { return 1; }
+    SDL_Rect destRect = {dest_x + rect.x - src_x, dest_y + rect.y - src_y, rect.w, rect.h};
+    GraphicContext* gContext = GET_GC(gc);
+    PixelConversion conversion;
+    if (!initPixelConversion(&conversion, image, gContext->foreground, gContext->background,
+                             getDrawableColormap(drawable))) {
+        handleError(0, display, drawable, 0, BadMatch, 0);
+        return -1;
+    }
+    ClipIterator clip;
+    if (!initClipIterator(&clip, drawable, gContext, &destRect)) { return 1; }
+    // Only the visible part of the image is converted.
+    clipImageRects(&clip, &rect, &destRect);
+    if (beginSoftwareDrawing(drawable, gContext, &destRect, None, NULL)) {
+        Bool put = pixmanPutImage(drawable, gContext, &clip, image, &conversion, rect.x, rect.y,
+                                  destRect.x, destRect.y, rect.w, rect.h);
+        endSoftwareDrawing();
+        if (!put) {
+            LOG("Failed to put the image in %s\n", __func__);
+            handleError(0, display, drawable, 0, BadDrawable, 0);
+            return -1;
+        }
+        damageDrawable(drawable, destRect.x, destRect.y, rect.w, rect.h);
+        return 1;
+    }
 
     SDL_Renderer* renderer = NULL;
     GET_RENDERER(drawable, renderer);
@@ -141,107 +262,187 @@ int XPutImage(Display* display, Drawable drawable, GC gc, XImage* image, int src
         handleError(0, display, drawable, 0, BadDrawable, 0);
         return -1;
     }
-
-    Uint32* data = malloc(sizeof(Uint32) * width * height);
-    if (data == NULL) {
+    if (!uploadImage(renderer, image, &conversion, &rect, &destRect, &clip)) {
+        LOG("Failed to upload the image in %s: %s\n", __func__, SDL_GetError());
         handleOutOfMemory(0, display, 0, 0);
         return -1;
     }
+    damageDrawable(drawable, destRect.x, destRect.y, rect.w, rect.h);
+    return 1;
+}
 
-    unsigned int x, y;
-    if (image->format == XYBitmap && 0) {
-        GraphicContext* graphicContext = GET_GC(gc);
-        for (x = 0; x < width; x++) {
-            for (y = 0; y < height; y++) {
-                unsigned long color = graphicContext->background;
-                if (XGetPixel(image, src_x + x, src_y + y)) {
-                    color = graphicContext->foreground;
-                }
-                //putPixel(surface, dest_x + x, dest_y + y, color);
-                WARN_UNIMPLEMENTED;
-            }
+int getDrawableDepth(Drawable drawable) {
+    if (IS_TYPE(drawable, PIXMAP)) {
+        return (int) GET_PIXMAP_STRUCT(drawable)->depth;
+    }
+    Window window;
+    for (window = drawable; window != None; window = GET_PARENT(window)) {
+        if (GET_WINDOW_STRUCT(window)->depth != CopyFromParent) {
+            return GET_WINDOW_STRUCT(window)->depth;
         }
+        if (window == SCREEN_WINDOW) { break; }
+    }
+    return SDL_SURFACE_DEPTH;
+}
+
+/*
+ * Get the pixels of the rectangle of the drawable from the memory it is drawn into, if it is
+ * drawn on the CPU. The pixels are 32 bit xRGB, or ARGB if hasAlpha is set.
+ */
+static Uint32* getBackingStorePixels(Drawable drawable, int x, int y, int* pitch, Bool* hasAlpha) {
+    int offsetX, offsetY;
+    if (pixmanBackendEnabled) {
+        pixman_image_t* image = getDrawableImage(drawable, &offsetX, &offsetY);
+        if (image == NULL) { return NULL; }
+        *pitch = pixman_image_get_stride(image);
+        *hasAlpha = False;
+        return (Uint32*) ((Uint8*) pixman_image_get_data(image) + (y + offsetY) * *pitch) + x + offsetX;
+    }
+    if (!IS_TYPE(drawable, WINDOW)) { return NULL; }
+    Window renderWindow = getRenderWindow(drawable, &offsetX, &offsetY);
+    SDL_RendererInfo rendererInfo;
+    SDL_Renderer* renderer = getWindowRenderer(drawable);
+    if (GET_WINDOW_STRUCT(renderWindow)->sdlWindow == NULL || renderer == NULL
+        || SDL_GetRendererInfo(renderer, &rendererInfo) != 0 || !(rendererInfo.flags & SDL_RENDERER_SOFTWARE)) {
+        return NULL;
+    }
+    SDL_Surface* surface = SDL_GetWindowSurface(GET_WINDOW_STRUCT(renderWindow)->sdlWindow);
+    if (surface == NULL || SDL_MUSTLOCK(surface) || (surface->format->format != SDL_PIXELFORMAT_ARGB8888
+                                                     && surface->format->format != SDL_PIXELFORMAT_RGB888)) {
+        return NULL;
+    }
+    #if SDL_VERSION_ATLEAST(2, 0, 10)
+    SDL_RenderFlush(renderer);
+    #endif
+    SDL_Rect viewPort;
+    SDL_RenderGetViewport(renderer, &viewPort);
+    *pitch = surface->pitch;
+    *hasAlpha = surface->format->format == SDL_PIXELFORMAT_ARGB8888;
+    return (Uint32*) ((Uint8*) surface->pixels + (viewPort.y + y) * surface->pitch) + viewPort.x + x;
+}
+
+/* Read the rectangle of the drawable into the image. */
+static Bool readDrawablePixels(Drawable drawable, SDL_Rect* rect, XImage* image, PixelConversion* conversion) {
+    int pitch;
+    Bool hasAlpha;
+    Uint32* pixels = getBackingStorePixels(drawable, rect->x, rect->y, &pitch, &hasAlpha);
+    if (pixels != NULL) {
+        conversion->sourceAlpha = hasAlpha ? 0 : 0xFF000000;
+        convertArgbToImage(conversion, pixels, pitch, image, 0, 0, rect->w, rect->h);
+        return True;
+    }
+    SDL_Renderer* renderer = NULL;
+    GET_RENDERER(drawable, renderer);
+    if (renderer == NULL) {
+        LOG("Failed to get the renderer in %s: %s\n", __func__, SDL_GetError());
+        return False;
+    }
+    // SDL_RenderReadPixels expects the rect relative to the render target, not to the viewport.
+    SDL_Rect viewPort, readRect = *rect;
+    SDL_RenderGetViewport(renderer, &viewPort);
+    readRect.x += viewPort.x;
+    readRect.y += viewPort.y;
+    if (conversion->identity) {
+        // The renderer can write the pixels straight into the image.
+        Uint32 format = image->depth >= 32 ? SDL_PIXELFORMAT_ARGB8888 : SDL_PIXELFORMAT_RGB888;
+        if (SDL_RenderReadPixels(renderer, &readRect, format, image->data, image->bytes_per_line) != 0) {
+            LOG("SDL_RenderReadPixels failed in %s: %s\n", __func__, SDL_GetError());
+            return False;
+        }
+        return True;
+    }
+    pitch = rect->w * (int) sizeof(Uint32);
+    pixels = malloc((size_t) pitch * rect->h);
+    if (pixels == NULL) { return False; }
+    Bool success = SDL_RenderReadPixels(renderer, &readRect, SDL_PIXELFORMAT_ARGB8888, pixels, pitch) == 0;
+    if (success) {
+        convertArgbToImage(conversion, pixels, pitch, image, 0, 0, rect->w, rect->h);
     } else {
-        for (y = 0; y < height; y++) {
-            for (x = 0; x < width; x++) {
-                // FIXME: last pixel is crashing sometimes with memory access violation
-                if (y == height - 1 && x == width - 1) break;
-                unsigned long color = XGetPixel(image, src_x + x, src_y + y);
-                //LOG("PIXEL %s: %d %d %lu (%ld, %ld, %ld)\n", __func__, src_x + x, src_y + y, color, (color >> 24) & 0xFF, (color >> 16) & 0xFF, (color >> 8) & 0xFF);
-                //putPixel(surface, dest_x + x, dest_y + y, XGetPixel(image, src_x + x, src_y + y));
+        LOG("SDL_RenderReadPixels failed in %s: %s\n", __func__, SDL_GetError());
+    }
+    free(pixels);
+    return success;
+}
 
-                data[y * width + x] = GET_RED_FROM_COLOR(color) << 24 | GET_GREEN_FROM_COLOR(color) << 16 | GET_BLUE_FROM_COLOR(color) << 8 | GET_ALPHA_FROM_COLOR(color);
+/* Clear the bits of the image that are not in the plane mask. */
+static void applyPlaneMask(XImage* image, unsigned long plane_mask) {
+    unsigned long depthMask = image->depth >= 32 ? 0xFFFFFFFFUL : (1UL << image->depth) - 1;
+    if ((plane_mask & depthMask) == depthMask) { return; }
+    int x, y, plane;
+    if (image->format == XYPixmap) {
+        size_t planeSize = (size_t) image->bytes_per_line * image->height;
+        for (plane = 0; plane < image->depth; plane++) {
+            if (!(plane_mask & (1UL << (image->depth - 1 - plane)))) {
+                memset(image->data + plane * planeSize, 0, planeSize);
             }
         }
+        return;
     }
+    for (y = 0; y < image->height; y++) {
+        for (x = 0; x < image->width; x++) {
+            XPutPixel(image, x, y, XGetPixel(image, x, y) & plane_mask);
+        }
+    }
+}
 
-    //SDL_RenderClear(renderer);
-    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, width, height);
-    if (texture == NULL) {
-        LOG("SDL_CreateTexture failed: %s\n", SDL_GetError());
-        return -1;
+Bool checkReadableArea(Display* display, Drawable drawable, int x, int y, unsigned int width,
+                       unsigned int height) {
+    if (IS_TYPE(drawable, WINDOW) && drawable == SCREEN_WINDOW) {
+        LOG("Bad argument: Can not read the content of window %lu in %s\n", drawable, __func__);
+        handleError(0, display, drawable, 0, BadMatch, 0);
+        return False;
     }
-    if (SDL_UpdateTexture(texture, NULL, data, width * sizeof(Uint32)) < 0)
-        printf("Update texture failed %s", SDL_GetError());
-    SDL_Rect dst = {dest_x, dest_y, width, height};
-    if (SDL_RenderCopy(renderer, texture, NULL, &dst) < 0) {
-        LOG("SDL_RenderCopy failed: %s\n", SDL_GetError());
-        return -1;
+    SDL_Rect bounds = {0, 0, 0, 0};
+    getDrawableSize(drawable, &bounds.w, &bounds.h);
+    if (width == 0 || height == 0 || x < 0 || y < 0 || x + (int) width > bounds.w || y + (int) height > bounds.h) {
+        LOG("Bad argument: The rectangle is not inside of the drawable in %s\n", __func__);
+        handleError(0, display, drawable, 0, BadMatch, 0);
+        return False;
     }
-    SDL_DestroyTexture(texture);
-    free(data);
-    SDL_RenderPresent(renderer);
-    return 1;
+    return True;
+}
+
+Bool readDrawableImage(Display* display, Drawable drawable, int x, int y, XImage* image,
+                       unsigned long plane_mask) {
+    SDL_Rect rect = {x, y, image->width, image->height};
+    PixelConversion conversion;
+    if (!initPixelConversion(&conversion, image, 1, 0, getDrawableColormap(drawable))
+        || !readDrawablePixels(drawable, &rect, image, &conversion)) {
+        LOG("Failed to read the content of the drawable in %s\n", __func__);
+        handleError(0, display, drawable, 0, BadDrawable, 0);
+        return False;
+    }
+    applyPlaneMask(image, plane_mask);
+    return True;
 }
 
 XImage* XGetImage(Display* display, Drawable drawable, int x, int y, unsigned int width,
                   unsigned int height, unsigned long plane_mask, int format) {
     // https://tronche.com/gui/x/xlib/graphics/XGetImage.html
     SET_X_SERVER_REQUEST(display, X_GetImage);
+    TYPE_CHECK(drawable, DRAWABLE, display, NULL);
     LOG("%s: From %lu\n", __func__, drawable);
-    if (IS_TYPE(drawable, WINDOW) && drawable == SCREEN_WINDOW) {
-        LOG("XGetImage called with SCREEN_WINDOW as argument!\n");
-        // TODO: Handle error and check INPUTONLY
+    if (format != XYPixmap && format != ZPixmap) {
+        handleError(0, display, None, 0, BadValue, 0);
         return NULL;
     }
-    // TODO: Figure this out
-    int depth = 8;
-//    if (drawable->type == PIXMAP) {
-//
-//    }
-    int bytes_per_line = (depth / 8) * width;
-    char* data = malloc(sizeof(char) * width * height);
-    if (data == NULL) {
+    if (!checkReadableArea(display, drawable, x, y, width, height)) { return NULL; }
+    int depth = getDrawableDepth(drawable);
+    Visual* visual = IS_TYPE(drawable, WINDOW) && GET_VISUAL(drawable) != NULL
+                     ? GET_VISUAL(drawable) : DefaultVisual(display, DefaultScreen(display));
+    XImage* image = XCreateImage(display, visual, (unsigned int) depth, format, 0, NULL, width, height, 32, 0);
+    if (image == NULL) { return NULL; }
+    size_t size = (size_t) image->bytes_per_line * height * (format == XYPixmap ? depth : 1);
+    image->data = calloc(size, 1);
+    if (image->data == NULL) {
+        XDestroyImage(image);
         handleOutOfMemory(0, display, 0, 0);
         return NULL;
     }
-    // FIXME: The NULL will cause problems.
-    XImage* image = XCreateImage(display, NULL, depth, format, 0, data, width, height,
-                                 32, bytes_per_line);
-    if (image == NULL) {
-        free(data);
-        return NULL;
-    }
-    //TODO: Implement: Read from Textur into data and Convert from data to image type
-    //SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, GET_SURFACE(drawable)->pixels, GET_SURFACE(drawable)->pitch);
-
-    SDL_Renderer* renderer = NULL;
-    GET_RENDERER(drawable, renderer);
-    if (renderer == NULL) {
-        LOG("Failed to create renderer in %s: %s\n", __func__, SDL_GetError());
-        handleError(0, display, drawable, 0, BadDrawable, 0);
+    if (!readDrawableImage(display, drawable, x, y, image, plane_mask)) {
+        XDestroyImage(image);
         return NULL;
     }
-    SDL_Surface *drawableSurface = getRenderSurface(renderer);
-
-    unsigned int currX, currY;
-    // TODO: Worry about XYPixmap
-//    if (format == XYPixmap) {
-    for (currX = 0; currX < width; currX++) {
-        for (currY = 0; currY < height; currY++) {
-            data[currY * width + currX] = plane_mask & getPixel(drawableSurface, x + currX, y + currY);
-        }
-    }
     return image;
 }
 
@@ -0,0 +1,32 @@
+#ifndef _IMAGE_H_
+#define _IMAGE_H_
+
+#include <SDL2/SDL.h>
+#include "X11/Xlib.h"
+#include "pixelConversion.h"
+#include "clip.h"
+
+char* getImageDataPointer(XImage* image, unsigned int x, unsigned int y);
+int destroyImage(XImage* image);
+Colormap getDrawableColormap(Drawable drawable);
+/*
+ * Copy or convert the rectangle of the image straight into the locked memory of a pool texture
+ * and draw it at the destination rectangle of the renderer, inside of the clip rectangles.
+ */
+Bool uploadImage(SDL_Renderer* renderer, XImage* image, const PixelConversion* conversion,
+                 const SDL_Rect* rect, const SDL_Rect* destRect, ClipIterator* clip);
+/* Shrink the source and destination rectangle of an image to the bounds of the clip iterator. */
+void clipImageRects(const ClipIterator* clip, SDL_Rect* rect, SDL_Rect* destRect);
+/* The depth of the pixmap, or of the first window up the hierarchy that has one. */
+int getDrawableDepth(Drawable drawable);
+/* Check that the rectangle can be read from the drawable, reporting a BadMatch error if not. */
+Bool checkReadableArea(Display* display, Drawable drawable, int x, int y, unsigned int width,
+                       unsigned int height);
+/*
+ * Read the content of the drawable at x, y into the data of the image, which is not reallocated,
+ * and clear the bits that are not in the plane mask. The area must have been checked.
+ */
+Bool readDrawableImage(Display* display, Drawable drawable, int x, int y, XImage* image,
+                       unsigned long plane_mask);
+
+#endif /* _IMAGE_H_ */
@@ -6,6 +6,7 @@
 #include "X11/Xlocale.h"
 #include <stdio.h>
 #include "util.h"
+#include "shm.h"
 
 Window XGetSelectionOwner( register Display *dpy, Atom selection) { LOG("CALL XGetSelectionOwner\n"); return dpy->screens[0].root; }
 
@@ -35,7 +36,6 @@ void XSetWMIconName (
     XSetTextProperty (dpy, w, tp, XA_WM_ICON_NAME);
 }
 
-int XClearWindow ( Display* dpy, Window w) { return XClearArea(dpy, w, 0, 0, 0, 0, False); }
 
 long XMaxRequestSize(Display *dpy) { LOG("CALL XMaxRequestSize\n");  return 0; }
 
@@ -49,7 +49,6 @@ void XLockDisplay( register Display* dpy) { LockDisplay(dpy); }
 
 void XUnlockDisplay( register Display* dpy) { UnlockDisplay(dpy); }
 
-int XSetArcMode ( register Display *dpy, register GC gc, int arc_mode) { LOG("CALL XSetArcMode\n");  return 0; }
 
 int XSetFillStyle ( register Display *dpy, register GC gc, int fill_style) { LOG("CALL XSetFillStyle\n");  return 0; }
 
@@ -67,8 +66,6 @@ int XmbTextPropertyToTextList( Display *dpy, const XTextProperty *text_prop, cha
 
 int XmbTextListToTextProperty( Display *dpy, char **list, int count, XICCEncodingStyle style, XTextProperty *text_prop) { LOG("CALL XmbTextListToTextProperty\n");  return 1; }
 
-int XSetClipRectangles ( register Display *dpy, GC gc, int clip_x_origin, int clip_y_origin, XRectangle *rectangles, int n, int ordering) { LOG("CALL XSetClipRectangles\n");  return 0; }
-
 int XGetScreenSaver( register Display *dpy, /* the following are return only vars */ int *timeout, int *interval, int *prefer_blanking, int *allow_exp) /*boolean */ { LOG("CALL XGetScreenSaver\n");  return 0; }
 
  XExtCodes *XInitExtension (
@@ -128,6 +125,12 @@ Bool XQueryExtension( register Display *dpy, _Xconst char *name, int *major_opco
         *first_error = 0;
         return True;
     }
+    if (strcmp(name, SHMNAME) == 0) {
+        *major_opcode = SHM_MAJOR_OPCODE;
+        *first_event = SHM_FIRST_EVENT;
+        *first_error = SHM_FIRST_ERROR;
+        return True;
+    }
     return False;
 }
 
@@ -137,9 +140,7 @@ Bool XkbUseExtension(Display *dpy, int *major_rtrn, int *minor_rtrn) { LOG("CALL
 
 int XkbTranslateKeySym(Display *dpy, KeySym *sym_rtrn, unsigned int mods, char *buffer, int nbytes, int *extra_rtrn) { LOG("CALL XkbTranslateKeySym\n");  return 0; }
 
-int XDrawPoint( register Display *dpy, Drawable d, GC gc, int x, int y) /* INT16 */ { LOG("CALL XDrawPoint\n");  return 0; }
 
-int XDrawPoints( register Display *dpy, Drawable d, GC gc, XPoint *points, int n_points, int mode) /* CoordMode */ { printf("CALL XDrawPoints\n");  return 0; }
 
 int XStoreColor( register Display *dpy, Colormap cmap, XColor *def) { LOG("CALL XStoreColor\n");  return 0; }
 
@@ -327,7 +328,6 @@ XmbResetIC(XIC ic)
 
 int XWarpPointer( register Display *dpy, Window src_win, Window dest_win, int src_x, int src_y, unsigned int src_width, unsigned int src_height, int dest_x, int dest_y) { LOG("CALL XWarpPointer\n");  return 0; }
 
-int XDrawLine ( register Display *dpy, Drawable d, GC gc, int x1, int y1, int x2, int y2) { LOG("CALL XDrawLine\n");  return 0; }
 
 int XGrabPointer( register Display *dpy, Window grab_window, Bool owner_events, unsigned int event_mask, /* CARD16 */ int pointer_mode, int keyboard_mode, Window confine_to, Cursor curs, Time time) { LOG("CALL XGrabPointer\n");  return 0; }
 
@@ -342,17 +342,12 @@ int XPending(Display *dpy)
     return XEventsQueued(dpy, QueuedAfterFlush);
 }
 
-int XUnloadFont( register Display *dpy, Font font) { printf("CALL XUnloadFont\n");  return 0; }
-
 int XDrawImageString( register Display *dpy, Drawable d, GC gc, int x, int y, _Xconst char *string, int length) { printf("CALL XDrawImageString\n");  return 0; }
 
 Bool XCheckMaskEvent ( register Display *dpy, long mask, /* Selected event mask. */ register XEvent *event) /* XEvent to be filled in. */ { printf("CALL XCheckMaskEvent\n");  return False; }
 
-int XSetState( register Display *dpy, GC gc, unsigned long foreground, unsigned long background, int function, unsigned long planemask) { printf("CALL XSetState\n");  return 0; }
-
 int XMapSubwindows( register Display *dpy, Window win) { printf("CALL XMapSubwindows\n");  return 0; }
 
-int XDrawSegments ( register Display *dpy, Drawable d, GC gc, XSegment *segments, int nsegments) { printf("CALL XDrawSegments\n");  return 0; }
 
 int XGetErrorText( register Display *dpy, register int code, char *buffer, int nbytes) { printf("CALL XGetErrorText\n");  return 0; }
 
@@ -378,7 +373,6 @@ Status XAllocColorPlanes( register Display *dpy, Colormap cmap, Bool contig, uns
 
 XIOErrorHandler XSetIOErrorHandler(XIOErrorHandler handler) { printf("CALL XSetIOErrorHandler\n");  return NULL; }
 
-int XLowerWindow( Display *dpy, Window w) { printf("CALL XLowerWindow\n");  return 0; }
 
 int XGetPointerControl( register Display *dpy, /* the following are return only vars */ int *accel_numer, int *accel_denom, int *threshold) { printf("CALL XGetPointerControl\n");  return 0; }
 
@@ -464,8 +458,6 @@ Status XcmsCIELuvToCIEuvY( XcmsCCC ccc, XcmsColor *pLuv_WhitePt, XcmsColor *pCol
 
 int XRecolorCursor( register Display *dpy, Cursor cursor, XColor *foreground, XColor *background) { printf("CALL XRecolorCursor\n");  return 0; }
 
-int XSubtractRegion( Region regM, Region regS, register Region regD) { printf("CALL XSubtractRegion\n");  return 0; }
-
 int XChangeActivePointerGrab( register Display *dpy, unsigned int event_mask, /* CARD16 */ Cursor curs, Time time) { printf("CALL XChangeActivePointerGrab\n");  return 0; }
 
 Status XQueryBestSize( register Display *dpy, int class, Drawable drawable, unsigned int width, unsigned int height, unsigned int *ret_width, unsigned int *ret_height) { printf("CALL XQueryBestSize\n");  return 0; }
@@ -476,7 +468,6 @@ Status XQueryBestTile( register Display *dpy, Drawable drawable, unsigned int wi
 
 int XChangePointerControl( register Display *dpy, Bool do_acc, Bool do_thresh, int acc_numerator, int acc_denominator, int threshold) { printf("CALL XChangePointerControl\n");  return 0; }
 
-int XDrawArcs( register Display *dpy, Drawable d, GC gc, XArc *arcs, int n_arcs) { printf("CALL XDrawArcs\n");  return 0; }
 
 int XQueryTextExtents ( register Display *dpy, Font fid, register _Xconst char *string, register int nchars, int *dir, int *font_ascent, int *font_descent, register XCharStruct *overall) { printf("CALL XQueryTextExtents\n");  return 0; }
 
@@ -494,7 +485,6 @@ int XChangeSaveSet( register Display *dpy, Window win, int mode) { printf("CALL
 
 int XAddToSaveSet( register Display *dpy, Window win) { printf("CALL XAddToSaveSet\n");  return 0; }
 
-int XSetFillRule ( register Display *dpy, register GC gc, int fill_rule) { printf("CALL XSetFillRule\n");  return 0; }
 
 Status XQueryBestStipple( register Display *dpy, Drawable drawable, unsigned int width, unsigned int height, unsigned int *ret_width, unsigned int *ret_height) { printf("CALL XQueryBestStipple\n");  return 0; }
 
@@ -502,7 +492,6 @@ int XKillClient( register Display *dpy, XID resource) { printf("CALL XKillClient
 
 long XEventMaskOfScreen(Screen *s) { printf("CALL XEventMaskOfScreen\n");  return 0; }
 
-int XDestroyImage( XImage *ximage) { printf("CALL XDestroyImage\n");  return 0; }
 
 int XDrawImageString16( register Display *dpy, Drawable d, GC gc, int x, int y, _Xconst XChar2b *string, int length) { printf("CALL XDrawImageString16\n");  return 0; }
 
@@ -528,14 +517,8 @@ int XcmsScreenNumberOfCCC( XcmsCCC ccc) /* * DESCRIPTION * Queries the screen nu
 
 int XStoreNamedColor( register Display *dpy, Colormap cmap, _Xconst char *name, /* STRING8 */ unsigned long pixel, /* CARD32 */ int flags) /* DoRed, DoGreen, DoBlue */ { printf("CALL XStoreNamedColor\n");  return 0; }
 
-int XUnionRectWithRegion( register XRectangle *rect, Region source, Region dest) { printf("CALL XUnionRectWithRegion\n");  return 0; }
-
-int XTextExtents16 ( XFontStruct *fs, _Xconst XChar2b *string, int nchars, int *dir, /* RETURN font information */ int *font_ascent, /* RETURN font information */ int *font_descent, /* RETURN font information */ register XCharStruct *overall) /* RETURN character information */ { printf("CALL XTextExtents16\n");  return 0; }
-
 int XDrawText( register Display *dpy, Drawable d, GC gc, int x, int y, XTextItem *items, int nitems) { printf("CALL XDrawText\n");  return 0; }
 
-int XTextExtents ( XFontStruct *fs, _Xconst char *string, int nchars, int *dir, /* RETURN font information */ int *font_ascent, /* RETURN font information */ int *font_descent, /* RETURN font information */ register XCharStruct *overall) /* RETURN character information */ { printf("CALL XTextExtents\n");  return 0; }
-
 int XStoreColors( register Display *dpy, Colormap cmap, XColor *defs, int ncolors) { printf("CALL XStoreColors\n");  return 0; }
 
 int XQueryTextExtents16 ( register Display *dpy, Font fid, _Xconst XChar2b *string, register int nchars, int *dir, int *font_ascent, int *font_descent, register XCharStruct *overall) { printf("CALL XQueryTextExtents16\n");  return 0; }
@@ -548,13 +531,11 @@ int XUngrabButton( register Display *dpy, unsigned int button, /* CARD8 */ unsig
 
 int XQueryKeymap( register Display *dpy, char keys[32]) { printf("CALL XQueryKeymap\n");  return 0; }
 
-int XDrawRectangles( register Display *dpy, Drawable d, GC gc, XRectangle *rects, int n_rects) { printf("CALL XDrawRectangles\n");  return 0; }
 
 unsigned long XDisplayMotionBufferSize(Display *dpy) { printf("CALL XDisplayMotionBufferSize\n");  return 0; }
 
 int XSetPointerMapping ( register Display *dpy, _Xconst unsigned char *map, int nmaps) { printf("CALL XSetPointerMapping\n");  return 0; }
 
-int XFillArcs( register Display *dpy, Drawable d, GC gc, XArc *arcs, int n_arcs) { printf("CALL XFillArcs\n");  return 0; }
 
 int XAddHost ( register Display *dpy, XHostAddress *host) { printf("CALL XAddHost\n");  return 0; }
 
@@ -616,8 +597,6 @@ Status XcmsRGBiToCIEXYZ( XcmsCCC ccc, XcmsColor *pXcmsColors_in_out,/* pointer t
 
 int XFontsOfFontSet( XFontSet font_set, XFontStruct ***font_struct_list, char ***font_name_list) { printf("CALL XFontsOfFontSet\n");  return 0; }
 
-Region XPolygonRegion( XPoint *Pts, /* the pts */ int Count, /* number of pts */ int rule) /* winding rule */ { printf("CALL XPolygonRegion\n");  return NULL; }
-
 XrmDatabase XrmGetDatabase( Display *display) { printf("CALL XrmGetDatabase\n");  return NULL; }
 
 void XrmStringToQuarkList( register _Xconst char *name, register XrmQuarkList quarks) /* RETURN */ { printf("CALL XrmStringToQuarkList\n"); }
@@ -677,16 +656,8 @@ Status XGetWMProtocols ( Display *dpy, Window w, Atom **protocols, int *countRet
 
 int XWriteBitmapFile( Display *display, _Xconst char *filename, Pixmap bitmap, unsigned int width, unsigned int height, int x_hot, int y_hot) { printf("CALL XWriteBitmapFile\n");  return 0; }
 
-int XClipBox( Region r, XRectangle *rect) { printf("CALL XClipBox\n");  return 0; }
-
-int XDestroyRegion( Region r) { printf("CALL XDestroyRegion\n");  return 0; }
-
 int XShrinkRegion( Region r, int dx, int dy) { printf("CALL XShrinkRegion\n");  return 0; }
 
-int XEmptyRegion( Region r) { printf("CALL XEmptyRegion\n");  return 0; }
-
-int XRectInRegion( register Region region, int rx, int ry, unsigned int rwidth, unsigned int rheight) { printf("CALL XRectInRegion\n");  return 0; }
-
 Status XGetWMSizeHints ( Display *dpy, Window w, XSizeHints *hints, long *supplied, Atom property) { printf("CALL XGetWMSizeHints\n");  return 0; }
 
 Status XGetWMNormalHints ( Display *dpy, Window w, XSizeHints *hints, long *supplied) { printf("CALL XGetWMNormalHints\n");  return 0; }
@@ -719,16 +690,6 @@ Status XGetWMIconName ( Display *dpy, Window w, XTextProperty *tp) { printf("CAL
 
 Status XGetWMClientMachine ( Display *dpy, Window w, XTextProperty *tp) { printf("CALL XGetWMClientMachine\n");  return 0; }
 
-Region XCreateRegion(void) { printf("CALL XCreateRegion\n");  return NULL; }
-
-int XSetRegion( Display *dpy, GC gc, register Region r) { printf("CALL XSetRegion\n");  return 0; }
-
-int XIntersectRegion( Region reg1, Region reg2, /* source regions */ register Region newReg) /* destination Region */ { printf("CALL XIntersectRegion\n");  return 0; }
-
-int XXorRegion(Region sra, Region srb, Region dr) { printf("CALL XXorRegion\n");  return 0; }
-
-int XEqualRegion(Region r1, Region r2) { printf("CALL XEqualRegion\n");  return 0; }
-
 void XrmSetDatabase( Display *display, XrmDatabase database) { printf("CALL XrmSetDatabase\n"); }
 
 void XrmMergeDatabases( XrmDatabase from, XrmDatabase *into) { printf("CALL XrmMergeDatabases\n"); }
@@ -737,12 +698,6 @@ void XrmQPutResource( XrmDatabase *pdb, XrmBindingList bindings, XrmQuarkList qu
 
 Bool XrmQGetResource( XrmDatabase db, XrmNameList names, XrmClassList classes, XrmRepresentation *pType, /* RETURN */ XrmValuePtr pValue) /* RETURN */ { printf("CALL XrmQGetResource\n");  return False; }
 
-int XOffsetRegion( register Region pRegion, register int x, register int y) { printf("CALL XOffsetRegion\n");  return 0; }
-
-int XUnionRegion( Region reg1, Region reg2, /* source regions */ Region newReg) /* destination Region */ { printf("CALL XUnionRegion\n");  return 0; }
-
-int XPointInRegion( Region pRegion, int x, int y) { printf("CALL XPointInRegion\n");  return 0; }
-
 Atom *XListProperties( register Display *dpy, Window window, int *n_props) /* RETURN */ { printf("CALL XListProperties\n");  return NULL; }
 
 char *XScreenResourceString(Screen *screen) { printf("CALL XScreenResourceString\n");  return NULL; }
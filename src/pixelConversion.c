@@ -0,0 +1,920 @@
+#include <string.h>
+#include "pixelConversion.h"
+#include "colors.h"
+#include "util.h"
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define PIXEL_KERNELS_X86
+#  include <immintrin.h>
+#  define TARGET_SSE2 __attribute__((target("sse2")))
+#  define TARGET_AVX2 __attribute__((target("avx2")))
+#elif SDL_BYTEORDER == SDL_LIL_ENDIAN && defined(__ARM_NEON)
+#  define PIXEL_KERNELS_NEON
+#  include <arm_neon.h>
+#endif
+
+#define OPAQUE_ALPHA 0xFF000000
+#define NATIVE_BYTE_ORDER (SDL_BYTEORDER == SDL_BIG_ENDIAN ? MSBFirst : LSBFirst)
+#define RGB_MASK(shift) ((Uint32) 0xFF << (shift))
+
+typedef struct {
+    PixelRowConverter scalar;
+    PixelRowConverter sse2;
+    PixelRowConverter avx2;
+    PixelRowConverter neon;
+} PixelKernel;
+
+typedef struct {
+    PixelRowWriter scalar;
+    PixelRowWriter sse2;
+    PixelRowWriter avx2;
+    PixelRowWriter neon;
+} PixelWriterKernel;
+
+static const char* PIXEL_KERNEL_LEVEL_NAMES[] = {"scalar", "sse2", "avx2", "neon"};
+static PixelKernelLevel pixelKernelLevel = PIXEL_KERNELS_SCALAR;
+static Bool pixelKernelLevelResolved = False;
+static Uint32 greyScalePalette[256];
+static Uint32 colorPalette[256];
+static Bool palettesInitialized = False;
+
+/* ------------------------------------------------------------------------------------------ */
+/* 32 bits per pixel in the byte order of the host, with the red, green and blue masks of colors.h. */
+
+static void convertRow32Scalar(const PixelConversion* conversion, const Uint8* row, int x,
+                               Uint32* destination, int width) {
+    const Uint32* source = (const Uint32*) row + x;
+    Uint32 alpha = conversion->alpha;
+    int i;
+    for (i = 0; i < width; i++) {
+        destination[i] = source[i] | alpha;
+    }
+}
+
+/* 24 bits per pixel, blue in the first byte. */
+
+static void convertRow24Scalar(const PixelConversion* conversion, const Uint8* row, int x,
+                               Uint32* destination, int width) {
+    const Uint8* source = row + x * 3;
+    Uint32 alpha = conversion->alpha;
+    int i;
+    for (i = 0; i < width; i++, source += 3) {
+        destination[i] = alpha | (Uint32) source[2] << 16 | (Uint32) source[1] << 8 | source[0];
+    }
+}
+
+/* 16 bits per pixel in the byte order of the host with 5 bits red, 6 bits green and 5 bits blue. */
+
+#define EXPAND_565(pixel) ((((pixel) >> 11) << 3 | (pixel) >> 13) << 16 \
+                           | (((pixel) >> 5 & 0x3F) << 2 | ((pixel) >> 9 & 0x3)) << 8 \
+                           | ((pixel) & 0x1F) << 3 | ((pixel) >> 2 & 0x7))
+
+static void convertRow16Scalar(const PixelConversion* conversion, const Uint8* row, int x,
+                               Uint32* destination, int width) {
+    const Uint16* source = (const Uint16*) row + x;
+    Uint32 alpha = conversion->alpha;
+    int i;
+    for (i = 0; i < width; i++) {
+        Uint32 pixel = source[i];
+        destination[i] = alpha | EXPAND_565(pixel);
+    }
+}
+
+/* 8 bits per pixel, looked up in the palette of the colormap. */
+
+static void convertRow8Scalar(const PixelConversion* conversion, const Uint8* row, int x,
+                              Uint32* destination, int width) {
+    const Uint8* source = row + x;
+    const Uint32* palette = conversion->palette;
+    int i;
+    for (i = 0; i < width; i++) {
+        destination[i] = palette[source[i]];
+    }
+}
+
+/* 1 bit per pixel, the set bits get the foreground and the others the background. */
+
+#define BITMAP_BIT(conversion, row, x) \
+    (((row)[(x) >> 3] >> ((conversion)->msbFirst ? 7 - ((x) & 7) : ((x) & 7))) & 1)
+
+static void convertRow1Scalar(const PixelConversion* conversion, const Uint8* row, int x,
+                              Uint32* destination, int width) {
+    int i;
+    for (i = 0; i < width; i++) {
+        destination[i] = BITMAP_BIT(conversion, row, x + i) ? conversion->foreground
+                                                            : conversion->background;
+    }
+}
+
+#if defined(PIXEL_KERNELS_X86) || defined(PIXEL_KERNELS_NEON)
+/*
+ * Convert the leading pixels of a bitmap row until x is at a byte boundary.
+ * Returns the number of converted pixels.
+ */
+static int alignBitmapRow(const PixelConversion* conversion, const Uint8* row, int x,
+                          Uint32* destination, int width) {
+    int count = MIN((8 - (x & 7)) & 7, width);
+    convertRow1Scalar(conversion, row, x, destination, count);
+    return count;
+}
+#endif
+
+/* Any other layout, read pixel by pixel with the byte order and masks of the image. */
+
+static Uint8 scaleChannel(const PixelConversion* conversion, Uint32 pixel, int channel) {
+    Uint32 value = (pixel & conversion->channelMasks[channel]) >> conversion->channelShifts[channel];
+    int bits = conversion->channelBits[channel];
+    if (bits >= 8) { return (Uint8) (value >> (bits - 8)); }
+    if (bits == 0) { return 0; }
+    return (Uint8) (value * 0xFF / ((1u << bits) - 1));
+}
+
+static Uint32 pixelToArgb(const PixelConversion* conversion, Uint32 pixel) {
+    if (conversion->palette != NULL) {
+        return conversion->palette[pixel & 0xFF];
+    }
+    Uint32 alpha = conversion->channelBits[3] != 0
+                   ? (Uint32) scaleChannel(conversion, pixel, 3) << 24 : conversion->alpha;
+    return alpha | (Uint32) scaleChannel(conversion, pixel, 0) << 16
+           | (Uint32) scaleChannel(conversion, pixel, 1) << 8
+           | scaleChannel(conversion, pixel, 2);
+}
+
+static Uint32 unscaleChannel(const PixelConversion* conversion, Uint8 value, int channel) {
+    int bits = conversion->channelBits[channel];
+    Uint32 scaled = bits >= 8 ? (Uint32) value << (bits - 8) : (Uint32) value >> (8 - bits);
+    return (scaled << conversion->channelShifts[channel]) & conversion->channelMasks[channel];
+}
+
+static Uint32 argbToPixel(const PixelConversion* conversion, Uint32 argb) {
+    Uint32 red = argb >> 16 & 0xFF, green = argb >> 8 & 0xFF, blue = argb & 0xFF;
+    if (conversion->palette == greyScalePalette) {
+        return (red * 77 + green * 150 + blue * 29) >> 8;
+    } else if (conversion->palette != NULL) {
+        return (red >> 5) << 5 | (green >> 5) << 2 | blue >> 6;
+    }
+    return unscaleChannel(conversion, (Uint8) red, 0) | unscaleChannel(conversion, (Uint8) green, 1)
+           | unscaleChannel(conversion, (Uint8) blue, 2)
+           | unscaleChannel(conversion, (Uint8) ((argb | conversion->sourceAlpha) >> 24), 3);
+}
+
+static Uint32 readPixel(const PixelConversion* conversion, const Uint8* row, int x) {
+    const Uint8* pointer;
+    switch (conversion->bitsPerPixel) {
+        case 4: {
+            Uint8 byte = row[x >> 1];
+            return (x & 1) == (conversion->msbFirst ? 1 : 0) ? byte & 0xF : byte >> 4;
+        }
+        case 8:
+            return row[x];
+        case 16:
+            pointer = row + x * 2;
+            return conversion->msbFirst ? (Uint32) pointer[0] << 8 | pointer[1]
+                                        : (Uint32) pointer[1] << 8 | pointer[0];
+        case 24:
+            pointer = row + x * 3;
+            return conversion->msbFirst ? (Uint32) pointer[0] << 16 | (Uint32) pointer[1] << 8 | pointer[2]
+                                        : (Uint32) pointer[2] << 16 | (Uint32) pointer[1] << 8 | pointer[0];
+        case 32:
+            pointer = row + x * 4;
+            return conversion->msbFirst
+                   ? (Uint32) pointer[0] << 24 | (Uint32) pointer[1] << 16 | (Uint32) pointer[2] << 8 | pointer[3]
+                   : (Uint32) pointer[3] << 24 | (Uint32) pointer[2] << 16 | (Uint32) pointer[1] << 8 | pointer[0];
+        default:
+            return 0;
+    }
+}
+
+static void writePixel(const PixelConversion* conversion, Uint8* row, int x, Uint32 pixel) {
+    int bytes = conversion->bitsPerPixel / 8, i;
+    if (conversion->bitsPerPixel == 4) {
+        int shift = (x & 1) == (conversion->msbFirst ? 1 : 0) ? 0 : 4;
+        row[x >> 1] = (Uint8) ((row[x >> 1] & ~(0xF << shift)) | (pixel & 0xF) << shift);
+        return;
+    }
+    Uint8* pointer = row + x * bytes;
+    for (i = 0; i < bytes; i++) {
+        pointer[i] = (Uint8) (pixel >> 8 * (conversion->msbFirst ? bytes - 1 - i : i));
+    }
+}
+
+static void convertRowGeneric(const PixelConversion* conversion, const Uint8* row, int x,
+                              Uint32* destination, int width) {
+    int i;
+    for (i = 0; i < width; i++) {
+        destination[i] = pixelToArgb(conversion, readPixel(conversion, row, x + i));
+    }
+}
+
+static void writeRowGeneric(const PixelConversion* conversion, const Uint32* source, Uint8* row, int x,
+                            int width) {
+    int i;
+    for (i = 0; i < width; i++) {
+        writePixel(conversion, row, x + i, argbToPixel(conversion, source[i]));
+    }
+}
+
+/* Bitmaps whose bytes may be swapped within their bitmap unit, and XYPixmap planes. */
+
+#define BIT_BYTE(conversion, bit) (((bit) >> 3) ^ (conversion)->byteIndexMask)
+#define BIT_SHIFT(conversion, bit) ((conversion)->msbFirst ? 7 - ((bit) & 7) : (bit) & 7)
+
+static void convertRow1Generic(const PixelConversion* conversion, const Uint8* row, int x,
+                               Uint32* destination, int width) {
+    int i;
+    for (i = 0; i < width; i++) {
+        int bit = x + i;
+        destination[i] = (row[BIT_BYTE(conversion, bit)] >> BIT_SHIFT(conversion, bit)) & 1
+                         ? conversion->foreground : conversion->background;
+    }
+}
+
+/* A pixel counts as set if any of its color bits is set. */
+static void writeRow1Generic(const PixelConversion* conversion, const Uint32* source, Uint8* row, int x,
+                             int width) {
+    int i;
+    for (i = 0; i < width; i++) {
+        int bit = x + i;
+        Uint8* byte = &row[BIT_BYTE(conversion, bit)];
+        Uint8 mask = (Uint8) (1 << BIT_SHIFT(conversion, bit));
+        *byte = (source[i] & ~conversion->sourceAlpha) != 0 ? *byte | mask : *byte & ~mask;
+    }
+}
+
+/* The planes follow each other, the most significant one first. */
+static void convertRowPlanes(const PixelConversion* conversion, const Uint8* row, int x,
+                             Uint32* destination, int width) {
+    int i, plane;
+    for (i = 0; i < width; i++) {
+        int bit = x + i;
+        Uint32 pixel = 0;
+        const Uint8* planeRow = row;
+        for (plane = conversion->depth - 1; plane >= 0; plane--, planeRow += conversion->planeSize) {
+            pixel |= (Uint32) ((planeRow[BIT_BYTE(conversion, bit)] >> BIT_SHIFT(conversion, bit)) & 1) << plane;
+        }
+        destination[i] = pixelToArgb(conversion, pixel);
+    }
+}
+
+static void writeRowPlanes(const PixelConversion* conversion, const Uint32* source, Uint8* row, int x,
+                           int width) {
+    int i, plane;
+    for (i = 0; i < width; i++) {
+        int bit = x + i;
+        Uint32 pixel = argbToPixel(conversion, source[i]);
+        Uint8 mask = (Uint8) (1 << BIT_SHIFT(conversion, bit));
+        Uint8* planeRow = row;
+        for (plane = conversion->depth - 1; plane >= 0; plane--, planeRow += conversion->planeSize) {
+            Uint8* byte = &planeRow[BIT_BYTE(conversion, bit)];
+            *byte = (pixel >> plane) & 1 ? *byte | mask : *byte & ~mask;
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+/* Writing ARGB8888 pixels into image rows, the layouts are the same as above. */
+
+static void writeRow32Scalar(const PixelConversion* conversion, const Uint32* source, Uint8* row, int x,
+                             int width) {
+    Uint32* destination = (Uint32*) row + x;
+    Uint32 sourceAlpha = conversion->sourceAlpha, alpha = conversion->alpha;
+    int i;
+    for (i = 0; i < width; i++) {
+        destination[i] = (source[i] | sourceAlpha) & ~alpha;
+    }
+}
+
+static void writeRow24Scalar(const PixelConversion* conversion, const Uint32* source, Uint8* row, int x,
+                             int width) {
+    Uint8* destination = row + x * 3;
+    int i;
+    (void) conversion;
+    for (i = 0; i < width; i++, destination += 3) {
+        destination[0] = (Uint8) source[i];
+        destination[1] = (Uint8) (source[i] >> 8);
+        destination[2] = (Uint8) (source[i] >> 16);
+    }
+}
+
+#define PACK_565(pixel) (((pixel) >> 8 & 0xF800) | ((pixel) >> 5 & 0x07E0) | ((pixel) >> 3 & 0x001F))
+
+static void writeRow16Scalar(const PixelConversion* conversion, const Uint32* source, Uint8* row, int x,
+                             int width) {
+    Uint16* destination = (Uint16*) row + x;
+    int i;
+    (void) conversion;
+    for (i = 0; i < width; i++) {
+        destination[i] = (Uint16) PACK_565(source[i]);
+    }
+}
+
+static void writeRow8Scalar(const PixelConversion* conversion, const Uint32* source, Uint8* row, int x,
+                            int width) {
+    Uint8* destination = row + x;
+    int i;
+    for (i = 0; i < width; i++) {
+        destination[i] = (Uint8) argbToPixel(conversion, source[i]);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------ */
+
+#ifdef PIXEL_KERNELS_X86
+
+TARGET_SSE2 static void convertRow32Sse2(const PixelConversion* conversion, const Uint8* row, int x,
+                                         Uint32* destination, int width) {
+    const Uint32* source = (const Uint32*) row + x;
+    __m128i alpha = _mm_set1_epi32((int) conversion->alpha);
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m128i first = _mm_loadu_si128((const __m128i*) (source + i));
+        __m128i second = _mm_loadu_si128((const __m128i*) (source + i + 4));
+        _mm_storeu_si128((__m128i*) (destination + i), _mm_or_si128(first, alpha));
+        _mm_storeu_si128((__m128i*) (destination + i + 4), _mm_or_si128(second, alpha));
+    }
+    convertRow32Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+TARGET_AVX2 static void convertRow32Avx2(const PixelConversion* conversion, const Uint8* row, int x,
+                                         Uint32* destination, int width) {
+    const Uint32* source = (const Uint32*) row + x;
+    __m256i alpha = _mm256_set1_epi32((int) conversion->alpha);
+    int i = 0;
+    for (; i + 16 <= width; i += 16) {
+        __m256i first = _mm256_loadu_si256((const __m256i*) (source + i));
+        __m256i second = _mm256_loadu_si256((const __m256i*) (source + i + 8));
+        _mm256_storeu_si256((__m256i*) (destination + i), _mm256_or_si256(first, alpha));
+        _mm256_storeu_si256((__m256i*) (destination + i + 8), _mm256_or_si256(second, alpha));
+    }
+    convertRow32Sse2(conversion, row, x + i, destination + i, width - i);
+}
+
+/* SSE2 has no byte shuffle, so every pixel is loaded with an unaligned 32 bit load instead. */
+TARGET_SSE2 static void convertRow24Sse2(const PixelConversion* conversion, const Uint8* row, int x,
+                                         Uint32* destination, int width) {
+    const Uint8* source = row + x * 3;
+    __m128i mask = _mm_set1_epi32(0x00FFFFFF);
+    __m128i alpha = _mm_set1_epi32((int) conversion->alpha);
+    int i = 0;
+    Uint32 pixels[4];
+    // The load of the fourth pixel reads one byte of the next pixel.
+    for (; i + 5 <= width; i += 4) {
+        memcpy(&pixels[0], source + i * 3, 4);
+        memcpy(&pixels[1], source + i * 3 + 3, 4);
+        memcpy(&pixels[2], source + i * 3 + 6, 4);
+        memcpy(&pixels[3], source + i * 3 + 9, 4);
+        __m128i value = _mm_loadu_si128((const __m128i*) pixels);
+        _mm_storeu_si128((__m128i*) (destination + i), _mm_or_si128(_mm_and_si128(value, mask), alpha));
+    }
+    convertRow24Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+TARGET_AVX2 static void convertRow24Avx2(const PixelConversion* conversion, const Uint8* row, int x,
+                                         Uint32* destination, int width) {
+    const Uint8* source = row + x * 3;
+    __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                       0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m256i alpha = _mm256_set1_epi32((int) conversion->alpha);
+    int i = 0;
+    // The second 16 byte load of 8 pixels ends 4 bytes after them.
+    for (; i + 10 <= width; i += 8) {
+        __m128i low = _mm_loadu_si128((const __m128i*) (source + i * 3));
+        __m128i high = _mm_loadu_si128((const __m128i*) (source + i * 3 + 12));
+        __m256i value = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        _mm256_storeu_si256((__m256i*) (destination + i),
+                            _mm256_or_si256(_mm256_shuffle_epi8(value, shuffle), alpha));
+    }
+    convertRow24Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+TARGET_SSE2 static void convertRow16Sse2(const PixelConversion* conversion, const Uint8* row, int x,
+                                         Uint32* destination, int width) {
+    const Uint16* source = (const Uint16*) row + x;
+    __m128i greenMask = _mm_set1_epi16(0x3F);
+    __m128i blueMask = _mm_set1_epi16(0x1F);
+    __m128i alpha = _mm_set1_epi16((short) (conversion->alpha >> 16));
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*) (source + i));
+        __m128i red = _mm_srli_epi16(pixels, 11);
+        __m128i green = _mm_and_si128(_mm_srli_epi16(pixels, 5), greenMask);
+        __m128i blue = _mm_and_si128(pixels, blueMask);
+        red = _mm_or_si128(_mm_slli_epi16(red, 3), _mm_srli_epi16(red, 2));
+        green = _mm_or_si128(_mm_slli_epi16(green, 2), _mm_srli_epi16(green, 4));
+        blue = _mm_or_si128(_mm_slli_epi16(blue, 3), _mm_srli_epi16(blue, 2));
+        __m128i greenBlue = _mm_or_si128(_mm_slli_epi16(green, 8), blue);
+        __m128i alphaRed = _mm_or_si128(alpha, red);
+        _mm_storeu_si128((__m128i*) (destination + i), _mm_unpacklo_epi16(greenBlue, alphaRed));
+        _mm_storeu_si128((__m128i*) (destination + i + 4), _mm_unpackhi_epi16(greenBlue, alphaRed));
+    }
+    convertRow16Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+TARGET_AVX2 static void convertRow16Avx2(const PixelConversion* conversion, const Uint8* row, int x,
+                                         Uint32* destination, int width) {
+    const Uint16* source = (const Uint16*) row + x;
+    __m256i greenMask = _mm256_set1_epi16(0x3F);
+    __m256i blueMask = _mm256_set1_epi16(0x1F);
+    __m256i alpha = _mm256_set1_epi16((short) (conversion->alpha >> 16));
+    int i = 0;
+    for (; i + 16 <= width; i += 16) {
+        __m256i pixels = _mm256_loadu_si256((const __m256i*) (source + i));
+        __m256i red = _mm256_srli_epi16(pixels, 11);
+        __m256i green = _mm256_and_si256(_mm256_srli_epi16(pixels, 5), greenMask);
+        __m256i blue = _mm256_and_si256(pixels, blueMask);
+        red = _mm256_or_si256(_mm256_slli_epi16(red, 3), _mm256_srli_epi16(red, 2));
+        green = _mm256_or_si256(_mm256_slli_epi16(green, 2), _mm256_srli_epi16(green, 4));
+        blue = _mm256_or_si256(_mm256_slli_epi16(blue, 3), _mm256_srli_epi16(blue, 2));
+        __m256i greenBlue = _mm256_or_si256(_mm256_slli_epi16(green, 8), blue);
+        __m256i alphaRed = _mm256_or_si256(alpha, red);
+        // The unpacks work within the 128 bit lanes, they yield the pixels 0-3 and 8-11 and 4-7 and 12-15.
+        __m256i low = _mm256_unpacklo_epi16(greenBlue, alphaRed);
+        __m256i high = _mm256_unpackhi_epi16(greenBlue, alphaRed);
+        _mm256_storeu_si256((__m256i*) (destination + i), _mm256_permute2x128_si256(low, high, 0x20));
+        _mm256_storeu_si256((__m256i*) (destination + i + 8), _mm256_permute2x128_si256(low, high, 0x31));
+    }
+    convertRow16Sse2(conversion, row, x + i, destination + i, width - i);
+}
+
+/* SSE2 has no gather, the lookups are only unrolled. */
+TARGET_SSE2 static void convertRow8Sse2(const PixelConversion* conversion, const Uint8* row, int x,
+                                        Uint32* destination, int width) {
+    const Uint8* source = row + x;
+    const Uint32* palette = conversion->palette;
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        __m128i value = _mm_setr_epi32((int) palette[source[i]], (int) palette[source[i + 1]],
+                                       (int) palette[source[i + 2]], (int) palette[source[i + 3]]);
+        _mm_storeu_si128((__m128i*) (destination + i), value);
+    }
+    convertRow8Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+TARGET_AVX2 static void convertRow8Avx2(const PixelConversion* conversion, const Uint8* row, int x,
+                                        Uint32* destination, int width) {
+    const Uint8* source = row + x;
+    const int* palette = (const int*) conversion->palette;
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (source + i)));
+        _mm256_storeu_si256((__m256i*) (destination + i), _mm256_i32gather_epi32(palette, indices, 4));
+    }
+    convertRow8Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+TARGET_SSE2 static void convertRow1Sse2(const PixelConversion* conversion, const Uint8* row, int x,
+                                        Uint32* destination, int width) {
+    int i = alignBitmapRow(conversion, row, x, destination, width);
+    const Uint8* source = row + ((x + i) >> 3);
+    __m128i foreground = _mm_set1_epi32((int) conversion->foreground);
+    __m128i background = _mm_set1_epi32((int) conversion->background);
+    __m128i lowBits = conversion->msbFirst ? _mm_setr_epi32(0x80, 0x40, 0x20, 0x10)
+                                           : _mm_setr_epi32(0x01, 0x02, 0x04, 0x08);
+    __m128i highBits = conversion->msbFirst ? _mm_setr_epi32(0x08, 0x04, 0x02, 0x01)
+                                            : _mm_setr_epi32(0x10, 0x20, 0x40, 0x80);
+    for (; i + 8 <= width; i += 8, source++) {
+        __m128i byte = _mm_set1_epi32(*source);
+        __m128i low = _mm_cmpeq_epi32(_mm_and_si128(byte, lowBits), lowBits);
+        __m128i high = _mm_cmpeq_epi32(_mm_and_si128(byte, highBits), highBits);
+        _mm_storeu_si128((__m128i*) (destination + i),
+                         _mm_or_si128(_mm_and_si128(low, foreground), _mm_andnot_si128(low, background)));
+        _mm_storeu_si128((__m128i*) (destination + i + 4),
+                         _mm_or_si128(_mm_and_si128(high, foreground), _mm_andnot_si128(high, background)));
+    }
+    convertRow1Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+TARGET_AVX2 static void convertRow1Avx2(const PixelConversion* conversion, const Uint8* row, int x,
+                                        Uint32* destination, int width) {
+    int i = alignBitmapRow(conversion, row, x, destination, width);
+    const Uint8* source = row + ((x + i) >> 3);
+    __m256i foreground = _mm256_set1_epi32((int) conversion->foreground);
+    __m256i background = _mm256_set1_epi32((int) conversion->background);
+    __m256i bits = conversion->msbFirst ? _mm256_setr_epi32(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01)
+                                        : _mm256_setr_epi32(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+    for (; i + 8 <= width; i += 8, source++) {
+        __m256i set = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(*source), bits), bits);
+        _mm256_storeu_si256((__m256i*) (destination + i), _mm256_blendv_epi8(background, foreground, set));
+    }
+    convertRow1Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+TARGET_SSE2 static void writeRow32Sse2(const PixelConversion* conversion, const Uint32* source, Uint8* row,
+                                       int x, int width) {
+    Uint32* destination = (Uint32*) row + x;
+    __m128i sourceAlpha = _mm_set1_epi32((int) conversion->sourceAlpha);
+    __m128i alpha = _mm_set1_epi32((int) conversion->alpha);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        __m128i pixels = _mm_or_si128(_mm_loadu_si128((const __m128i*) (source + i)), sourceAlpha);
+        _mm_storeu_si128((__m128i*) (destination + i), _mm_andnot_si128(alpha, pixels));
+    }
+    writeRow32Scalar(conversion, source + i, row, x + i, width - i);
+}
+
+TARGET_AVX2 static void writeRow32Avx2(const PixelConversion* conversion, const Uint32* source, Uint8* row,
+                                       int x, int width) {
+    Uint32* destination = (Uint32*) row + x;
+    __m256i sourceAlpha = _mm256_set1_epi32((int) conversion->sourceAlpha);
+    __m256i alpha = _mm256_set1_epi32((int) conversion->alpha);
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m256i pixels = _mm256_or_si256(_mm256_loadu_si256((const __m256i*) (source + i)), sourceAlpha);
+        _mm256_storeu_si256((__m256i*) (destination + i), _mm256_andnot_si256(alpha, pixels));
+    }
+    writeRow32Sse2(conversion, source + i, row, x + i, width - i);
+}
+
+/* The packed pixels are sign extended first, so the saturating pack keeps all 16 bits. */
+#define PACK_565_SSE2(pixels) _mm_srai_epi32(_mm_slli_epi32(_mm_or_si128(_mm_or_si128( \
+    _mm_and_si128(_mm_srli_epi32(pixels, 8), _mm_set1_epi32(0xF800)), \
+    _mm_and_si128(_mm_srli_epi32(pixels, 5), _mm_set1_epi32(0x07E0))), \
+    _mm_and_si128(_mm_srli_epi32(pixels, 3), _mm_set1_epi32(0x001F))), 16), 16)
+#define PACK_565_AVX2(pixels) _mm256_srai_epi32(_mm256_slli_epi32(_mm256_or_si256(_mm256_or_si256( \
+    _mm256_and_si256(_mm256_srli_epi32(pixels, 8), _mm256_set1_epi32(0xF800)), \
+    _mm256_and_si256(_mm256_srli_epi32(pixels, 5), _mm256_set1_epi32(0x07E0))), \
+    _mm256_and_si256(_mm256_srli_epi32(pixels, 3), _mm256_set1_epi32(0x001F))), 16), 16)
+
+TARGET_SSE2 static void writeRow16Sse2(const PixelConversion* conversion, const Uint32* source, Uint8* row,
+                                       int x, int width) {
+    Uint16* destination = (Uint16*) row + x;
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m128i low = _mm_loadu_si128((const __m128i*) (source + i));
+        __m128i high = _mm_loadu_si128((const __m128i*) (source + i + 4));
+        _mm_storeu_si128((__m128i*) (destination + i), _mm_packs_epi32(PACK_565_SSE2(low), PACK_565_SSE2(high)));
+    }
+    writeRow16Scalar(conversion, source + i, row, x + i, width - i);
+}
+
+TARGET_AVX2 static void writeRow16Avx2(const PixelConversion* conversion, const Uint32* source, Uint8* row,
+                                       int x, int width) {
+    Uint16* destination = (Uint16*) row + x;
+    int i = 0;
+    for (; i + 16 <= width; i += 16) {
+        __m256i low = _mm256_loadu_si256((const __m256i*) (source + i));
+        __m256i high = _mm256_loadu_si256((const __m256i*) (source + i + 8));
+        // The pack works within the 128 bit lanes, so the 64 bit blocks have to be reordered.
+        __m256i packed = _mm256_packs_epi32(PACK_565_AVX2(low), PACK_565_AVX2(high));
+        _mm256_storeu_si256((__m256i*) (destination + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    writeRow16Sse2(conversion, source + i, row, x + i, width - i);
+}
+
+#define SSE2_KERNEL(name) name##Sse2
+#define AVX2_KERNEL(name) name##Avx2
+#else
+#define SSE2_KERNEL(name) NULL
+#define AVX2_KERNEL(name) NULL
+#endif /* PIXEL_KERNELS_X86 */
+
+#ifdef PIXEL_KERNELS_NEON
+
+static void convertRow32Neon(const PixelConversion* conversion, const Uint8* row, int x,
+                             Uint32* destination, int width) {
+    const Uint32* source = (const Uint32*) row + x;
+    uint32x4_t alpha = vdupq_n_u32(conversion->alpha);
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        vst1q_u32(destination + i, vorrq_u32(vld1q_u32(source + i), alpha));
+        vst1q_u32(destination + i + 4, vorrq_u32(vld1q_u32(source + i + 4), alpha));
+    }
+    convertRow32Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+static void convertRow24Neon(const PixelConversion* conversion, const Uint8* row, int x,
+                             Uint32* destination, int width) {
+    const Uint8* source = row + x * 3;
+    uint8x16_t alpha = vdupq_n_u8((Uint8) (conversion->alpha >> 24));
+    int i = 0;
+    for (; i + 16 <= width; i += 16) {
+        uint8x16x3_t planes = vld3q_u8(source + i * 3);
+        uint8x16x4_t pixels = {{planes.val[0], planes.val[1], planes.val[2], alpha}};
+        vst4q_u8((Uint8*) (destination + i), pixels);
+    }
+    convertRow24Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+static void convertRow16Neon(const PixelConversion* conversion, const Uint8* row, int x,
+                             Uint32* destination, int width) {
+    const Uint16* source = (const Uint16*) row + x;
+    uint16x8_t greenMask = vdupq_n_u16(0x3F);
+    uint16x8_t blueMask = vdupq_n_u16(0x1F);
+    uint16x8_t alpha = vdupq_n_u16((Uint16) (conversion->alpha >> 16));
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        uint16x8_t pixels = vld1q_u16(source + i);
+        uint16x8_t red = vshrq_n_u16(pixels, 11);
+        uint16x8_t green = vandq_u16(vshrq_n_u16(pixels, 5), greenMask);
+        uint16x8_t blue = vandq_u16(pixels, blueMask);
+        red = vorrq_u16(vshlq_n_u16(red, 3), vshrq_n_u16(red, 2));
+        green = vorrq_u16(vshlq_n_u16(green, 2), vshrq_n_u16(green, 4));
+        blue = vorrq_u16(vshlq_n_u16(blue, 3), vshrq_n_u16(blue, 2));
+        uint16x8x2_t result = vzipq_u16(vorrq_u16(vshlq_n_u16(green, 8), blue), vorrq_u16(alpha, red));
+        vst1q_u16((Uint16*) (destination + i), result.val[0]);
+        vst1q_u16((Uint16*) (destination + i + 4), result.val[1]);
+    }
+    convertRow16Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+/* NEON has no gather, the lookups are only unrolled. */
+static void convertRow8Neon(const PixelConversion* conversion, const Uint8* row, int x,
+                            Uint32* destination, int width) {
+    const Uint8* source = row + x;
+    const Uint32* palette = conversion->palette;
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        uint32x4_t value = vdupq_n_u32(palette[source[i]]);
+        value = vsetq_lane_u32(palette[source[i + 1]], value, 1);
+        value = vsetq_lane_u32(palette[source[i + 2]], value, 2);
+        value = vsetq_lane_u32(palette[source[i + 3]], value, 3);
+        vst1q_u32(destination + i, value);
+    }
+    convertRow8Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+static void convertRow1Neon(const PixelConversion* conversion, const Uint8* row, int x,
+                            Uint32* destination, int width) {
+    static const Uint32 LSB_FIRST_BITS[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+    static const Uint32 MSB_FIRST_BITS[8] = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
+    int i = alignBitmapRow(conversion, row, x, destination, width);
+    const Uint8* source = row + ((x + i) >> 3);
+    const Uint32* bits = conversion->msbFirst ? MSB_FIRST_BITS : LSB_FIRST_BITS;
+    uint32x4_t lowBits = vld1q_u32(bits);
+    uint32x4_t highBits = vld1q_u32(bits + 4);
+    uint32x4_t foreground = vdupq_n_u32(conversion->foreground);
+    uint32x4_t background = vdupq_n_u32(conversion->background);
+    for (; i + 8 <= width; i += 8, source++) {
+        uint32x4_t byte = vdupq_n_u32(*source);
+        vst1q_u32(destination + i, vbslq_u32(vtstq_u32(byte, lowBits), foreground, background));
+        vst1q_u32(destination + i + 4, vbslq_u32(vtstq_u32(byte, highBits), foreground, background));
+    }
+    convertRow1Scalar(conversion, row, x + i, destination + i, width - i);
+}
+
+static void writeRow32Neon(const PixelConversion* conversion, const Uint32* source, Uint8* row,
+                           int x, int width) {
+    Uint32* destination = (Uint32*) row + x;
+    uint32x4_t sourceAlpha = vdupq_n_u32(conversion->sourceAlpha);
+    uint32x4_t alpha = vdupq_n_u32(conversion->alpha);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        vst1q_u32(destination + i, vbicq_u32(vorrq_u32(vld1q_u32(source + i), sourceAlpha), alpha));
+    }
+    writeRow32Scalar(conversion, source + i, row, x + i, width - i);
+}
+
+static void writeRow16Neon(const PixelConversion* conversion, const Uint32* source, Uint8* row,
+                           int x, int width) {
+    Uint16* destination = (Uint16*) row + x;
+    uint32x4_t redMask = vdupq_n_u32(0xF800);
+    uint32x4_t greenMask = vdupq_n_u32(0x07E0);
+    uint32x4_t blueMask = vdupq_n_u32(0x001F);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        uint32x4_t pixels = vld1q_u32(source + i);
+        uint32x4_t packed = vorrq_u32(vorrq_u32(vandq_u32(vshrq_n_u32(pixels, 8), redMask),
+                                                vandq_u32(vshrq_n_u32(pixels, 5), greenMask)),
+                                      vandq_u32(vshrq_n_u32(pixels, 3), blueMask));
+        vst1_u16(destination + i, vmovn_u32(packed));
+    }
+    writeRow16Scalar(conversion, source + i, row, x + i, width - i);
+}
+
+#define NEON_KERNEL(name) name##Neon
+#else
+#define NEON_KERNEL(name) NULL
+#endif /* PIXEL_KERNELS_NEON */
+
+#define PIXEL_KERNEL(name) {name##Scalar, SSE2_KERNEL(name), AVX2_KERNEL(name), NEON_KERNEL(name)}
+
+static const PixelKernel ROW_32_KERNEL = PIXEL_KERNEL(convertRow32);
+static const PixelKernel ROW_24_KERNEL = PIXEL_KERNEL(convertRow24);
+static const PixelKernel ROW_16_KERNEL = PIXEL_KERNEL(convertRow16);
+static const PixelKernel ROW_8_KERNEL = PIXEL_KERNEL(convertRow8);
+static const PixelKernel ROW_1_KERNEL = PIXEL_KERNEL(convertRow1);
+static const PixelWriterKernel WRITE_ROW_32_KERNEL = PIXEL_KERNEL(writeRow32);
+static const PixelWriterKernel WRITE_ROW_16_KERNEL = PIXEL_KERNEL(writeRow16);
+
+/* ------------------------------------------------------------------------------------------ */
+
+static Bool isPixelKernelLevelSupported(PixelKernelLevel level) {
+    switch (level) {
+        case PIXEL_KERNELS_SCALAR:
+            return True;
+#ifdef PIXEL_KERNELS_X86
+        case PIXEL_KERNELS_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case PIXEL_KERNELS_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#ifdef PIXEL_KERNELS_NEON
+        case PIXEL_KERNELS_NEON:
+            return True;
+#endif
+        default:
+            return False;
+    }
+}
+
+PixelKernelLevel getPixelKernelLevel() {
+    if (pixelKernelLevelResolved) { return pixelKernelLevel; }
+    pixelKernelLevelResolved = True;
+    const char* requestedLevel = getenv("SDL2X11_PIXEL_KERNELS");
+    int level;
+    if (requestedLevel != NULL && requestedLevel[0] != '\0') {
+        for (level = PIXEL_KERNELS_SCALAR; level <= PIXEL_KERNELS_NEON; level++) {
+            if (strcmp(requestedLevel, PIXEL_KERNEL_LEVEL_NAMES[level]) == 0
+                && isPixelKernelLevelSupported((PixelKernelLevel) level)) {
+                pixelKernelLevel = (PixelKernelLevel) level;
+                LOG("Using the %s pixel conversion kernels\n", PIXEL_KERNEL_LEVEL_NAMES[level]);
+                return pixelKernelLevel;
+            }
+        }
+        LOG("Ignoring unsupported SDL2X11_PIXEL_KERNELS %s\n", requestedLevel);
+    }
+    for (level = PIXEL_KERNELS_NEON; level > PIXEL_KERNELS_SCALAR; level--) {
+        if (isPixelKernelLevelSupported((PixelKernelLevel) level)) { break; }
+    }
+    pixelKernelLevel = (PixelKernelLevel) level;
+    LOG("Using the %s pixel conversion kernels\n", PIXEL_KERNEL_LEVEL_NAMES[level]);
+    return pixelKernelLevel;
+}
+
+Bool setPixelKernelLevel(PixelKernelLevel level) {
+    if (!isPixelKernelLevelSupported(level)) { return False; }
+    pixelKernelLevel = level;
+    pixelKernelLevelResolved = True;
+    return True;
+}
+
+const char* getPixelKernelLevelName(PixelKernelLevel level) {
+    return PIXEL_KERNEL_LEVEL_NAMES[level];
+}
+
+static PixelRowConverter selectKernel(const PixelKernel* kernel) {
+    PixelRowConverter converter = NULL;
+    switch (getPixelKernelLevel()) {
+        case PIXEL_KERNELS_AVX2: converter = kernel->avx2; break;
+        case PIXEL_KERNELS_SSE2: converter = kernel->sse2; break;
+        case PIXEL_KERNELS_NEON: converter = kernel->neon; break;
+        default: break;
+    }
+    return converter != NULL ? converter : kernel->scalar;
+}
+
+static PixelRowWriter selectWriterKernel(const PixelWriterKernel* kernel) {
+    PixelRowWriter writer = NULL;
+    switch (getPixelKernelLevel()) {
+        case PIXEL_KERNELS_AVX2: writer = kernel->avx2; break;
+        case PIXEL_KERNELS_SSE2: writer = kernel->sse2; break;
+        case PIXEL_KERNELS_NEON: writer = kernel->neon; break;
+        default: break;
+    }
+    return writer != NULL ? writer : kernel->scalar;
+}
+
+/* ------------------------------------------------------------------------------------------ */
+
+static void initPalettes() {
+    int i;
+    for (i = 0; i < 256; i++) {
+        greyScalePalette[i] = OPAQUE_ALPHA | (Uint32) i << 16 | (Uint32) i << 8 | (Uint32) i;
+        // Three bits red, three bits green and two bits blue.
+        Uint32 red = (i >> 5) * 0xFF / 7, green = (i >> 2 & 0x7) * 0xFF / 7, blue = (i & 0x3) * 0xFF / 3;
+        colorPalette[i] = OPAQUE_ALPHA | red << 16 | green << 8 | blue;
+    }
+    palettesInitialized = True;
+}
+
+static void initChannel(PixelConversion* conversion, int channel, Uint32 mask) {
+    conversion->channelMasks[channel] = mask;
+    conversion->channelShifts[channel] = 0;
+    conversion->channelBits[channel] = 0;
+    if (mask == 0) { return; }
+    while (((mask >> conversion->channelShifts[channel]) & 1) == 0) {
+        conversion->channelShifts[channel]++;
+    }
+    while (((mask >> (conversion->channelShifts[channel] + conversion->channelBits[channel])) & 1) != 0) {
+        conversion->channelBits[channel]++;
+    }
+}
+
+static Bool hasMasks(const XImage* image, Uint32 red, Uint32 green, Uint32 blue) {
+    return image->red_mask == red && image->green_mask == green && image->blue_mask == blue;
+}
+
+Bool initPixelConversion(PixelConversion* conversion, const XImage* image,
+                         unsigned long foreground, unsigned long background, Colormap colormap) {
+    memset(conversion, 0, sizeof(PixelConversion));
+    if (!palettesInitialized) { initPalettes(); }
+    conversion->bitsPerPixel = image->bits_per_pixel;
+    conversion->depth = image->depth;
+    conversion->alpha = image->depth >= 32 ? 0 : OPAQUE_ALPHA;
+    conversion->msbFirst = image->byte_order == MSBFirst;
+    conversion->palette = colormap == GREY_SCALE_COLORMAP ? greyScalePalette : colorPalette;
+    if (image->format == XYBitmap || image->format == XYPixmap || image->depth == 1) {
+        conversion->msbFirst = image->bitmap_bit_order == MSBFirst;
+        if (image->bitmap_unit > 8 && image->byte_order != image->bitmap_bit_order) {
+            conversion->byteIndexMask = image->bitmap_unit / 8 - 1;
+        }
+    }
+    if (image->format == XYBitmap || image->depth == 1) {
+        if (image->format == XYBitmap) {
+            conversion->foreground = OPAQUE_ALPHA | (Uint32) (foreground & 0xFFFFFF);
+            conversion->background = OPAQUE_ALPHA | (Uint32) (background & 0xFFFFFF);
+        } else {
+            // Bitmaps store the pixel values 0 and 1.
+            conversion->foreground = 1;
+            conversion->background = 0;
+        }
+        conversion->writeRow = writeRow1Generic;
+        if (conversion->byteIndexMask != 0) {
+            conversion->convertRow = convertRow1Generic;
+            conversion->name = "1 bpp bitmap with swapped bytes";
+        } else {
+            conversion->convertRow = selectKernel(&ROW_1_KERNEL);
+            conversion->name = "1 bpp bitmap";
+        }
+        return True;
+    }
+    if (image->depth > 8) {
+        conversion->palette = NULL;
+        initChannel(conversion, 0, (Uint32) image->red_mask);
+        initChannel(conversion, 1, (Uint32) image->green_mask);
+        initChannel(conversion, 2, (Uint32) image->blue_mask);
+        if (image->depth >= 32) {
+            initChannel(conversion, 3, ~(Uint32) (image->red_mask | image->green_mask | image->blue_mask));
+        }
+    }
+    if (image->format == XYPixmap) {
+        conversion->planeSize = image->bytes_per_line * image->height;
+        conversion->convertRow = convertRowPlanes;
+        conversion->writeRow = writeRowPlanes;
+        conversion->name = "XYPixmap planes";
+        return True;
+    }
+    if (image->format != ZPixmap) {
+        LOG("Warn: Got invalid format %d\n", image->format);
+        return False;
+    }
+    Uint32 redMask = RGB_MASK(RED_SHIFT), greenMask = RGB_MASK(GREEN_SHIFT), blueMask = RGB_MASK(BLUE_SHIFT);
+    Bool swapBytes = image->byte_order != NATIVE_BYTE_ORDER;
+    if (image->depth <= 8 && (image->bits_per_pixel == 8 || image->bits_per_pixel == 4)) {
+        if (image->bits_per_pixel == 8) {
+            conversion->convertRow = selectKernel(&ROW_8_KERNEL);
+            conversion->writeRow = writeRow8Scalar;
+            conversion->name = "8 bpp colormap";
+        } else {
+            conversion->convertRow = convertRowGeneric;
+            conversion->writeRow = writeRowGeneric;
+            conversion->name = "4 bpp colormap";
+        }
+    } else if (image->bits_per_pixel == 32 && !swapBytes && hasMasks(image, redMask, greenMask, blueMask)) {
+        conversion->convertRow = selectKernel(&ROW_32_KERNEL);
+        conversion->writeRow = selectWriterKernel(&WRITE_ROW_32_KERNEL);
+        conversion->identity = image->xoffset == 0;
+        conversion->name = "32 bpp";
+    } else if (image->bits_per_pixel == 24 && image->byte_order == LSBFirst && SDL_BYTEORDER == SDL_LIL_ENDIAN
+               && hasMasks(image, redMask, greenMask, blueMask)) {
+        conversion->convertRow = selectKernel(&ROW_24_KERNEL);
+        conversion->writeRow = writeRow24Scalar;
+        conversion->name = "24 bpp";
+    } else if (image->bits_per_pixel == 16 && !swapBytes && hasMasks(image, 0xF800, 0x07E0, 0x001F)) {
+        conversion->convertRow = selectKernel(&ROW_16_KERNEL);
+        conversion->writeRow = selectWriterKernel(&WRITE_ROW_16_KERNEL);
+        conversion->name = "16 bpp 565";
+    } else if (image->bits_per_pixel == 16 || image->bits_per_pixel == 24 || image->bits_per_pixel == 32) {
+        conversion->convertRow = convertRowGeneric;
+        conversion->writeRow = writeRowGeneric;
+        conversion->name = "generic";
+    } else {
+        LOG("Warn: Got unimplemented %d bits per pixel with depth %d\n", image->bits_per_pixel, image->depth);
+        return False;
+    }
+    return True;
+}
+
+void convertImageToArgb(const PixelConversion* conversion, const XImage* image, int x, int y,
+                        int width, int height, Uint32* destination, int pitch) {
+    const Uint8* row = (const Uint8*) image->data + (size_t) y * image->bytes_per_line;
+    int i;
+    x += image->xoffset;
+    for (i = 0; i < height; i++) {
+        conversion->convertRow(conversion, row, x, destination, width);
+        row += image->bytes_per_line;
+        destination = (Uint32*) ((Uint8*) destination + pitch);
+    }
+}
+
+void convertArgbToImage(const PixelConversion* conversion, const Uint32* source, int pitch,
+                        XImage* image, int x, int y, int width, int height) {
+    Uint8* row = (Uint8*) image->data + (size_t) y * image->bytes_per_line;
+    int i;
+    x += image->xoffset;
+    for (i = 0; i < height; i++) {
+        conversion->writeRow(conversion, source, row, x, width);
+        row += image->bytes_per_line;
+        source = (const Uint32*) ((const Uint8*) source + pitch);
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef _PIXEL_CONVERSION_H_
+#define _PIXEL_CONVERSION_H_
+
+#include <SDL2/SDL.h>
+#include "X11/Xlib.h"
+
+/*
+ * Bulk conversion of XImage rows into ARGB8888, the pixel layout of the backing stores, and back.
+ * The row converters are selected once per request from the format of the image, the
+ * SIMD variant of the converters once at runtime from the features of the CPU.
+ * SDL2X11_PIXEL_KERNELS can be set to scalar, sse2, avx2 or neon to force a variant.
+ */
+typedef enum {
+    PIXEL_KERNELS_SCALAR,
+    PIXEL_KERNELS_SSE2,
+    PIXEL_KERNELS_AVX2,
+    PIXEL_KERNELS_NEON,
+} PixelKernelLevel;
+
+typedef struct PixelConversion PixelConversion;
+/* Convert width pixels of the image row, starting at the pixel x, into ARGB8888. */
+typedef void (*PixelRowConverter)(const PixelConversion* conversion, const Uint8* row, int x,
+                                  Uint32* destination, int width);
+/* Convert width ARGB8888 pixels into the image row, starting at the pixel x. */
+typedef void (*PixelRowWriter)(const PixelConversion* conversion, const Uint32* source, Uint8* row, int x,
+                               int width);
+
+struct PixelConversion {
+    PixelRowConverter convertRow;
+    PixelRowWriter writeRow;
+    const char* name;
+    /*
+     * True if the rows of the image already are 32 bit xRGB pixels in the byte order of the host,
+     * which can be used without a conversion if the alpha is ignored or the image has a depth of 32.
+     */
+    Bool identity;
+    /*
+     * Or'ed into every converted pixel, so images without an alpha channel are opaque,
+     * and removed from the pixels written into the image.
+     */
+    Uint32 alpha;
+    /* Or'ed into the pixels written into the image, set if their source has no alpha channel. */
+    Uint32 sourceAlpha;
+    /* The colors of the set and unset bits of bitmaps. */
+    Uint32 foreground;
+    Uint32 background;
+    /* The colors of the pixel values of images with a depth of 8 or less. */
+    const Uint32* palette;
+    /* The parameters of the generic converters. */
+    int bitsPerPixel;
+    int depth;
+    /* The size of a plane of XYPixmap images in bytes. */
+    int planeSize;
+    Bool msbFirst;
+    int byteIndexMask;
+    /* The masks of red, green, blue and alpha. */
+    Uint32 channelMasks[4];
+    int channelShifts[4];
+    int channelBits[4];
+};
+
+/*
+ * Select the row converter for the image. The foreground and background are the pixel
+ * values used for the bits of XYBitmap images, colormap is used for images with a depth of 8 or less.
+ */
+Bool initPixelConversion(PixelConversion* conversion, const XImage* image,
+                         unsigned long foreground, unsigned long background, Colormap colormap);
+/* Convert the rectangle of the image into the ARGB8888 destination with the pitch in bytes. */
+void convertImageToArgb(const PixelConversion* conversion, const XImage* image, int x, int y,
+                        int width, int height, Uint32* destination, int pitch);
+/* Convert the ARGB8888 source with the pitch in bytes into the rectangle of the image. */
+void convertArgbToImage(const PixelConversion* conversion, const Uint32* source, int pitch,
+                        XImage* image, int x, int y, int width, int height);
+PixelKernelLevel getPixelKernelLevel(void);
+/* Force the SIMD variant of the converters, returns False if the CPU does not support it. */
+Bool setPixelKernelLevel(PixelKernelLevel level);
+const char* getPixelKernelLevelName(PixelKernelLevel level);
+
+#endif /* _PIXEL_CONVERSION_H_ */
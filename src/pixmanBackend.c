@@ -0,0 +1,739 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pixmanBackend.h"
+#include "drawing.h"
+#include "pixmap.h"
+#include "colors.h"
+#include "gc.h"
+#include "clip.h"
+#include "compositor.h"
+#include "fillPattern.h"
+#include "rasterOp.h"
+#include "texturePool.h"
+#include "statistics.h"
+#include "util.h"
+
+Bool pixmanBackendEnabled = False;
+
+void initRenderBackend() {
+    const char* backend = getenv("SDL2X11_BACKEND");
+    pixmanBackendEnabled = backend != NULL && strcmp(backend, "pixman") == 0;
+    LOG("Using the %s backend\n", pixmanBackendEnabled ? "pixman" : "SDL renderer");
+}
+
+pixman_image_t* createBackingImage(unsigned int width, unsigned int height) {
+    // pixman allocates and clears the pixels if we don't pass any
+    return pixman_image_create_bits(PIXMAN_x8r8g8b8, (int) width, (int) height, NULL, 0);
+}
+
+static uint32_t colorToPixel(unsigned long color) {
+    return 0xFF000000 | GET_RED_FROM_COLOR(color) << 16 | GET_GREEN_FROM_COLOR(color) << 8
+           | GET_BLUE_FROM_COLOR(color);
+}
+
+static pixman_color_t colorToPixmanColor(unsigned long color) {
+    pixman_color_t pixmanColor = {
+            (uint16_t) (GET_RED_FROM_COLOR(color) * 0x101),
+            (uint16_t) (GET_GREEN_FROM_COLOR(color) * 0x101),
+            (uint16_t) (GET_BLUE_FROM_COLOR(color) * 0x101),
+            0xFFFF,
+    };
+    return pixmanColor;
+}
+
+/* Wrap the pixels of a backing image in a surface. The surface must be freed before the image. */
+static SDL_Surface* createSurfaceFromImage(pixman_image_t* image) {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(pixman_image_get_data(image),
+                                                    pixman_image_get_width(image),
+                                                    pixman_image_get_height(image), 32,
+                                                    pixman_image_get_stride(image),
+                                                    0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+    if (surface == NULL) {
+        LOG("SDL_CreateRGBSurfaceFrom failed in %s: %s\n", __func__, SDL_GetError());
+    }
+    return surface;
+}
+
+/*
+ * An area of a drawable of the SDL renderer backend that was read into an image,
+ * so the pixman drawing functions can draw into it with a raster operation.
+ */
+typedef struct {
+    Drawable drawable;
+    SDL_Rect area;
+    pixman_image_t* image;
+} SoftwareImage;
+
+/* The destination and, if it is another drawable, the source of the current software drawing. */
+static SoftwareImage softwareImages[2];
+static int numSoftwareImages = 0;
+
+static pixman_image_t* getSoftwareImage(Drawable drawable, int* offsetX, int* offsetY) {
+    int i;
+    for (i = 0; i < numSoftwareImages; i++) {
+        if (softwareImages[i].drawable == drawable) {
+            *offsetX = -softwareImages[i].area.x;
+            *offsetY = -softwareImages[i].area.y;
+            return softwareImages[i].image;
+        }
+    }
+    LOG("Drawable %lu is not drawn in software in %s\n", drawable, __func__);
+    return NULL;
+}
+
+/* Read the area of the drawable into a new software image. */
+static Bool readSoftwareImage(Drawable drawable, const SDL_Rect* area) {
+    SDL_Renderer* renderer = NULL;
+    GET_RENDERER(drawable, renderer);
+    if (renderer == NULL) { return False; }
+    pixman_image_t* image = pixman_image_create_bits(PIXMAN_x8r8g8b8, area->w, area->h, NULL, 0);
+    if (image == NULL) { return False; }
+    // The area is relative to the viewport of the drawable, SDL_RenderReadPixels to the render target.
+    SDL_Rect viewPort, readRect = *area;
+    SDL_RenderGetViewport(renderer, &viewPort);
+    readRect.x += viewPort.x;
+    readRect.y += viewPort.y;
+    if (SDL_RenderReadPixels(renderer, &readRect, SDL_PIXELFORMAT_ARGB8888, pixman_image_get_data(image),
+                             pixman_image_get_stride(image)) != 0) {
+        LOG("SDL_RenderReadPixels failed in %s: %s\n", __func__, SDL_GetError());
+        pixman_image_unref(image);
+        return False;
+    }
+    statistics.rasterOpPixelsReadBack += (Uint64) area->w * area->h;
+    SoftwareImage* softwareImage = &softwareImages[numSoftwareImages++];
+    softwareImage->drawable = drawable;
+    softwareImage->area = *area;
+    softwareImage->image = image;
+    return True;
+}
+
+/* Write the destination image back to its drawable, unless the drawing failed, and free the images. */
+static void finishSoftwareDrawing(Bool writeBack) {
+    int i;
+    SoftwareImage* destination = &softwareImages[0];
+    if (writeBack && numSoftwareImages > 0) {
+        SDL_Renderer* renderer = NULL;
+        GET_RENDERER(destination->drawable, renderer);
+        SDL_Texture* texture = renderer == NULL ? NULL : uploadToPoolTexture(
+                renderer, SDL_PIXELFORMAT_ARGB8888, pixman_image_get_data(destination->image),
+                pixman_image_get_stride(destination->image), destination->area.w, destination->area.h);
+        if (texture == NULL) {
+            LOG("Failed to upload the software image in %s: %s\n", __func__, SDL_GetError());
+        } else {
+            SDL_Rect srcRect = {0, 0, destination->area.w, destination->area.h};
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+            if (SDL_RenderCopy(renderer, texture, &srcRect, &destination->area) != 0) {
+                LOG("SDL_RenderCopy failed in %s: %s\n", __func__, SDL_GetError());
+            }
+            releasePoolTexture(texture);
+        }
+    }
+    for (i = 0; i < numSoftwareImages; i++) {
+        pixman_image_unref(softwareImages[i].image);
+    }
+    numSoftwareImages = 0;
+}
+
+Bool beginSoftwareDrawing(Drawable drawable, GraphicContext* gContext, const SDL_Rect* area,
+                          Drawable source, const SDL_Rect* sourceArea) {
+    if (pixmanBackendEnabled) { return True; }
+    if (!hasRasterOp(gContext) || SDL_RectEmpty(area)) { return False; }
+    SDL_Rect destinationArea = *area;
+    if (source == drawable) {
+        // The source is read from the destination image, so it has to be in there, too.
+        SDL_UnionRect(&destinationArea, sourceArea, &destinationArea);
+    }
+    if (!readSoftwareImage(drawable, &destinationArea)
+        || (source != None && source != drawable && !readSoftwareImage(source, sourceArea))) {
+        finishSoftwareDrawing(False);
+        return False;
+    }
+    statistics.rasterOpOperations++;
+    return True;
+}
+
+void endSoftwareDrawing(void) {
+    if (!pixmanBackendEnabled) {
+        finishSoftwareDrawing(True);
+    }
+}
+
+pixman_image_t* getDrawableImage(Drawable drawable, int* offsetX, int* offsetY) {
+    if (!pixmanBackendEnabled) {
+        return getSoftwareImage(drawable, offsetX, offsetY);
+    }
+    if (IS_TYPE(drawable, PIXMAP)) {
+        *offsetX = 0;
+        *offsetY = 0;
+        return GET_PIXMAP_STRUCT(drawable)->image;
+    }
+    Window window = getRenderWindow(drawable, offsetX, offsetY);
+    WindowStruct* windowStruct = GET_WINDOW_STRUCT(window);
+    int width, height;
+    GET_WINDOW_DIMS(window, width, height);
+    pixman_image_t* image = windowStruct->backingImage;
+    if (image == NULL || pixman_image_get_width(image) != width
+        || pixman_image_get_height(image) != height) {
+        // The window is new or was resized, keep as much of the old content as possible.
+        pixman_image_t* newImage = createBackingImage((unsigned int) width, (unsigned int) height);
+        if (newImage == NULL) {
+            LOG("Failed to create the backing image of window %lu in %s\n", window, __func__);
+            return image;
+        }
+        if (image != NULL) {
+            pixman_image_composite32(PIXMAN_OP_SRC, image, NULL, newImage, 0, 0, 0, 0, 0, 0,
+                                     width, height);
+            pixman_image_unref(image);
+        }
+        windowStruct->backingImage = image = newImage;
+    }
+    return image;
+}
+
+/*
+ * Get the image to draw a clipped operation into. With a clip mask that is a copy of the bounds
+ * of the operation, endClippedDrawing composites it back through the mask. If the mask can't be
+ * converted, the operation is drawn unclipped.
+ */
+static pixman_image_t* beginClippedDrawing(Drawable drawable, ClipIterator* clip, int* offsetX, int* offsetY) {
+    pixman_image_t* image = getDrawableImage(drawable, offsetX, offsetY);
+    if (image == NULL || clip->mask == None) { return image; }
+    if (getFillPatternImage(clip->mask, True) == NULL) {
+        LOG("Failed to convert the clip mask in %s\n", __func__);
+        clip->mask = None;
+        return image;
+    }
+    pixman_image_t* copy = pixman_image_create_bits(PIXMAN_x8r8g8b8, clip->bounds.w, clip->bounds.h, NULL, 0);
+    if (copy == NULL) { return NULL; }
+    pixman_image_composite32(PIXMAN_OP_SRC, image, NULL, copy, clip->bounds.x + *offsetX,
+                             clip->bounds.y + *offsetY, 0, 0, 0, 0, clip->bounds.w, clip->bounds.h);
+    *offsetX = -clip->bounds.x;
+    *offsetY = -clip->bounds.y;
+    return copy;
+}
+
+/* Finish an operation that was drawn into the image returned by beginClippedDrawing. */
+static void endClippedDrawing(Drawable drawable, ClipIterator* clip, pixman_image_t* image) {
+    if (clip->mask == None) { return; }
+    int offsetX, offsetY;
+    pixman_image_t* destImage = getDrawableImage(drawable, &offsetX, &offsetY);
+    // The mask is owned by the fill pattern cache. The copy is opaque, so it replaces the
+    // pixels of the drawable wherever the mask is set and leaves the others alone.
+    pixman_image_t* mask = getFillPatternImage(clip->mask, True);
+    if (destImage != NULL && mask != NULL) {
+        pixman_image_composite32(PIXMAN_OP_OVER, image, mask, destImage, 0, 0,
+                                 clip->bounds.x - clip->originX, clip->bounds.y - clip->originY,
+                                 clip->bounds.x + offsetX, clip->bounds.y + offsetY,
+                                 clip->bounds.w, clip->bounds.h);
+    }
+    pixman_image_unref(image);
+}
+
+/* Get the part of the rectangle (in drawable coordinates) inside of the image, in image coordinates. */
+static Bool getImageRect(pixman_image_t* image, int offsetX, int offsetY, const SDL_Rect* rect,
+                         SDL_Rect* imageRect) {
+    SDL_Rect offsetRect = {rect->x + offsetX, rect->y + offsetY, rect->w, rect->h};
+    SDL_Rect bounds = {0, 0, pixman_image_get_width(image), pixman_image_get_height(image)};
+    return SDL_IntersectRect(&offsetRect, &bounds, imageRect);
+}
+
+/* Get the position of the coordinate inside of a pattern of the size that repeats from the origin. */
+static int getPatternOffset(int coordinate, int origin, int size) {
+    int offset = (coordinate - origin) % size;
+    return offset < 0 ? offset + size : offset;
+}
+
+static void fillRect(pixman_image_t* image, int offsetX, int offsetY, const SDL_Rect* rect,
+                     const SolidRasterOp* op) {
+    SDL_Rect imageRect;
+    // pixman_fill does not clip
+    if (!getImageRect(image, offsetX, offsetY, rect, &imageRect)) { return; }
+    uint32_t* pixels = pixman_image_get_data(image);
+    int stride = pixman_image_get_stride(image) / (int) sizeof(uint32_t), y;
+    if (op->andBits == 0) {
+        pixman_fill(pixels, stride, 32, imageRect.x, imageRect.y, imageRect.w, imageRect.h, op->xorBits);
+        return;
+    }
+    for (y = imageRect.y; y < imageRect.y + imageRect.h; y++) {
+        applySolidRasterOp(op, &pixels[y * stride + imageRect.x], imageRect.w);
+    }
+}
+
+/* Fill the rectangle with the tile and the raster operation of the graphic context. */
+static void tileRect(pixman_image_t* image, int offsetX, int offsetY, const SDL_Rect* rect,
+                     pixman_image_t* tile, GraphicContext* gContext) {
+    SDL_Rect imageRect;
+    if (!getImageRect(image, offsetX, offsetY, rect, &imageRect)) { return; }
+    uint32_t* pixels = pixman_image_get_data(image);
+    int stride = pixman_image_get_stride(image) / (int) sizeof(uint32_t);
+    uint32_t* tilePixels = pixman_image_get_data(tile);
+    int tileStride = pixman_image_get_stride(tile) / (int) sizeof(uint32_t);
+    int tileWidth = pixman_image_get_width(tile), tileHeight = pixman_image_get_height(tile);
+    int x, y, right = imageRect.x + imageRect.w;
+    for (y = imageRect.y; y < imageRect.y + imageRect.h; y++) {
+        uint32_t* tileRow = &tilePixels[getPatternOffset(y - offsetY, gContext->tileStipOriginY, tileHeight)
+                                        * tileStride];
+        int tileX = getPatternOffset(imageRect.x - offsetX, gContext->tileStipOriginX, tileWidth);
+        for (x = imageRect.x; x < right; x += tileWidth - tileX, tileX = 0) {
+            applyRasterOp(gContext->function, gContext->planeMask, &tileRow[tileX], &pixels[y * stride + x],
+                          MIN(tileWidth - tileX, right - x));
+        }
+    }
+}
+
+/*
+ * Fill the set pixels of the a8 stipple mask in the rectangle with the foreground operation,
+ * and the others with the background operation if it is not NULL.
+ */
+static void stippleRect(pixman_image_t* image, int offsetX, int offsetY, const SDL_Rect* rect,
+                        pixman_image_t* stipple, GraphicContext* gContext, const SolidRasterOp* foreground,
+                        const SolidRasterOp* background) {
+    SDL_Rect imageRect;
+    if (!getImageRect(image, offsetX, offsetY, rect, &imageRect)) { return; }
+    uint32_t* pixels = pixman_image_get_data(image);
+    int stride = pixman_image_get_stride(image) / (int) sizeof(uint32_t);
+    uint8_t* maskPixels = (uint8_t*) pixman_image_get_data(stipple);
+    int maskStride = pixman_image_get_stride(stipple);
+    int maskWidth = pixman_image_get_width(stipple), maskHeight = pixman_image_get_height(stipple);
+    int x, y;
+    for (y = imageRect.y; y < imageRect.y + imageRect.h; y++) {
+        uint8_t* maskRow = &maskPixels[getPatternOffset(y - offsetY, gContext->tileStipOriginY, maskHeight)
+                                       * maskStride];
+        int maskX = getPatternOffset(imageRect.x - offsetX, gContext->tileStipOriginX, maskWidth);
+        uint32_t* row = &pixels[y * stride];
+        for (x = imageRect.x; x < imageRect.x + imageRect.w; x++) {
+            if (maskRow[maskX]) {
+                APPLY_SOLID_RASTER_OP(foreground, row[x]);
+            } else if (background != NULL) {
+                APPLY_SOLID_RASTER_OP(background, row[x]);
+            }
+            if (++maskX == maskWidth) { maskX = 0; }
+        }
+    }
+}
+
+Bool pixmanFillRectangles(Drawable drawable, GraphicContext* gContext, ClipIterator* clip,
+                          const SDL_Rect* rectangles, int nrectangles) {
+    int offsetX, offsetY, i;
+    pixman_image_t* image = beginClippedDrawing(drawable, clip, &offsetX, &offsetY);
+    if (image == NULL) { return False; }
+    pixman_image_t* source = NULL;
+    pixman_image_t* mask = NULL;
+    Bool ownsSource = False;
+    Bool rasterOp = hasRasterOp(gContext);
+    SolidRasterOp foreground = getSolidRasterOp(gContext, colorToPixel(gContext->foreground));
+    SolidRasterOp background = getSolidRasterOp(gContext, colorToPixel(gContext->background));
+    // The tile image and the stipple mask are owned by the fill pattern cache.
+    if (gContext->fillStyle == FillTiled && IS_TYPE(gContext->tile, PIXMAP)) {
+        source = getFillPatternImage(gContext->tile, False);
+    } else if ((gContext->fillStyle == FillStippled || gContext->fillStyle == FillOpaqueStippled)
+               && IS_TYPE(gContext->stipple, PIXMAP)) {
+        mask = getFillPatternImage(gContext->stipple, True);
+        if (mask != NULL && !rasterOp) {
+            pixman_color_t foreground = colorToPixmanColor(gContext->foreground);
+            source = pixman_image_create_solid_fill(&foreground);
+            ownsSource = True;
+        }
+    }
+    while (nextClipRect(clip, NULL)) {
+        for (i = 0; i < nrectangles; i++) {
+            SDL_Rect rect;
+            if (!SDL_IntersectRect(&rectangles[i], &clip->rect, &rect)) { continue; }
+            if (mask != NULL && rasterOp) {
+                stippleRect(image, offsetX, offsetY, &rect, mask, gContext, &foreground,
+                            gContext->fillStyle == FillOpaqueStippled ? &background : NULL);
+            } else if (source == NULL) {
+                fillRect(image, offsetX, offsetY, &rect, &foreground);
+            } else if (mask == NULL && rasterOp) {
+                tileRect(image, offsetX, offsetY, &rect, source, gContext);
+            } else if (mask == NULL) {
+                pixman_image_composite32(PIXMAN_OP_SRC, source, NULL, image,
+                                         rect.x - gContext->tileStipOriginX,
+                                         rect.y - gContext->tileStipOriginY, 0, 0,
+                                         rect.x + offsetX, rect.y + offsetY, rect.w, rect.h);
+            } else {
+                if (gContext->fillStyle == FillOpaqueStippled) {
+                    fillRect(image, offsetX, offsetY, &rect, &background);
+                }
+                pixman_image_composite32(PIXMAN_OP_OVER, source, mask, image, 0, 0,
+                                         rect.x - gContext->tileStipOriginX,
+                                         rect.y - gContext->tileStipOriginY,
+                                         rect.x + offsetX, rect.y + offsetY, rect.w, rect.h);
+            }
+        }
+    }
+    if (ownsSource && source != NULL) { pixman_image_unref(source); }
+    endClippedDrawing(drawable, clip, image);
+    return True;
+}
+
+/*
+ * Draw a one pixel wide line, clipped to bounds (in drawable coordinates).
+ * The end point is left out for lines that are joined to the next one, so that
+ * raster operations like GXxor don't change the joints twice.
+ */
+static void drawLine(pixman_image_t* image, int offsetX, int offsetY, SDL_Rect* bounds,
+                     const SDL_Point* from, const SDL_Point* to, const SolidRasterOp* op, Bool drawLast) {
+    if (from->x == to->x || from->y == to->y) {
+        SDL_Rect rect = {MIN(from->x, to->x), MIN(from->y, to->y),
+                         abs(to->x - from->x) + 1, abs(to->y - from->y) + 1};
+        if (!drawLast) {
+            if (rect.w > 1) {
+                rect.w--;
+                if (to->x < from->x) { rect.x++; }
+            } else if (rect.h > 1) {
+                rect.h--;
+                if (to->y < from->y) { rect.y++; }
+            } else {
+                return;
+            }
+        }
+        if (SDL_IntersectRect(&rect, bounds, &rect)) {
+            fillRect(image, offsetX, offsetY, &rect, op);
+        }
+        return;
+    }
+    uint32_t* pixels = pixman_image_get_data(image);
+    int stride = pixman_image_get_stride(image) / (int) sizeof(uint32_t);
+    int x = from->x, y = from->y;
+    int dx = abs(to->x - x), dy = -abs(to->y - y);
+    int stepX = x < to->x ? 1 : -1, stepY = y < to->y ? 1 : -1;
+    int error = dx + dy, error2;
+    while (True) {
+        Bool last = x == to->x && y == to->y;
+        if ((drawLast || !last) && x >= bounds->x && x < bounds->x + bounds->w
+            && y >= bounds->y && y < bounds->y + bounds->h) {
+            APPLY_SOLID_RASTER_OP(op, pixels[(y + offsetY) * stride + x + offsetX]);
+        }
+        if (last) { break; }
+        error2 = 2 * error;
+        if (error2 >= dy) {
+            error += dy;
+            x += stepX;
+        }
+        if (error2 <= dx) {
+            error += dx;
+            y += stepY;
+        }
+    }
+}
+
+/* Get the part of the clip rectangle that lies inside of the image, lines are clipped to it. */
+static Bool getLineBounds(pixman_image_t* image, int offsetX, int offsetY, const SDL_Rect* clipRect,
+                          SDL_Rect* bounds) {
+    SDL_Rect imageBounds = {-offsetX, -offsetY, pixman_image_get_width(image), pixman_image_get_height(image)};
+    return SDL_IntersectRect(clipRect, &imageBounds, bounds);
+}
+
+Bool pixmanDrawLines(Drawable drawable, GraphicContext* gContext, ClipIterator* clip, SDL_Point* points,
+                     int npoints) {
+    int offsetX, offsetY, i;
+    pixman_image_t* image = beginClippedDrawing(drawable, clip, &offsetX, &offsetY);
+    if (image == NULL) { return False; }
+    SDL_Rect bounds;
+    SolidRasterOp op = getSolidRasterOp(gContext, colorToPixel(gContext->foreground));
+    // The end of a closed line is its start, which is already drawn.
+    Bool closed = npoints > 2 && points[0].x == points[npoints - 1].x && points[0].y == points[npoints - 1].y;
+    while (nextClipRect(clip, NULL)) {
+        if (!getLineBounds(image, offsetX, offsetY, &clip->rect, &bounds)) { continue; }
+        for (i = 1; i < npoints; i++) {
+            drawLine(image, offsetX, offsetY, &bounds, &points[i - 1], &points[i], &op,
+                     i == npoints - 1 && !closed);
+        }
+    }
+    endClippedDrawing(drawable, clip, image);
+    return True;
+}
+
+Bool pixmanDrawSegments(Drawable drawable, GraphicContext* gContext, ClipIterator* clip,
+                        const SDL_Point* endpoints, int nsegments) {
+    int offsetX, offsetY, i;
+    pixman_image_t* image = beginClippedDrawing(drawable, clip, &offsetX, &offsetY);
+    if (image == NULL) { return False; }
+    SDL_Rect bounds;
+    SolidRasterOp op = getSolidRasterOp(gContext, colorToPixel(gContext->foreground));
+    while (nextClipRect(clip, NULL)) {
+        if (!getLineBounds(image, offsetX, offsetY, &clip->rect, &bounds)) { continue; }
+        for (i = 0; i < nsegments; i++) {
+            drawLine(image, offsetX, offsetY, &bounds, &endpoints[2 * i], &endpoints[2 * i + 1], &op, True);
+        }
+    }
+    endClippedDrawing(drawable, clip, image);
+    return True;
+}
+
+Bool pixmanDrawPoints(Drawable drawable, GraphicContext* gContext, ClipIterator* clip, const SDL_Point* points,
+                      int npoints) {
+    int offsetX, offsetY, i;
+    pixman_image_t* image = beginClippedDrawing(drawable, clip, &offsetX, &offsetY);
+    if (image == NULL) { return False; }
+    SDL_Rect bounds;
+    uint32_t* pixels = pixman_image_get_data(image);
+    int stride = pixman_image_get_stride(image) / (int) sizeof(uint32_t);
+    SolidRasterOp op = getSolidRasterOp(gContext, colorToPixel(gContext->foreground));
+    while (nextClipRect(clip, NULL)) {
+        if (!getLineBounds(image, offsetX, offsetY, &clip->rect, &bounds)) { continue; }
+        for (i = 0; i < npoints; i++) {
+            if (SDL_PointInRect(&points[i], &bounds)) {
+                APPLY_SOLID_RASTER_OP(&op, pixels[(points[i].y + offsetY) * stride + points[i].x + offsetX]);
+            }
+        }
+    }
+    endClippedDrawing(drawable, clip, image);
+    return True;
+}
+
+Bool pixmanDrawRectangles(Drawable drawable, GraphicContext* gContext, ClipIterator* clip,
+                          const SDL_Rect* rectangles, int nrectangles) {
+    int offsetX, offsetY, i, j;
+    pixman_image_t* image = beginClippedDrawing(drawable, clip, &offsetX, &offsetY);
+    if (image == NULL) { return False; }
+    SDL_Rect bounds;
+    SolidRasterOp op = getSolidRasterOp(gContext, colorToPixel(gContext->foreground));
+    while (nextClipRect(clip, NULL)) {
+        if (!getLineBounds(image, offsetX, offsetY, &clip->rect, &bounds)) { continue; }
+        for (i = 0; i < nrectangles; i++) {
+            const SDL_Rect* rect = &rectangles[i];
+            if (rect->w <= 0 || rect->h <= 0) { continue; }
+            SDL_Point points[5] = {
+                    {rect->x, rect->y},
+                    {rect->x + rect->w - 1, rect->y},
+                    {rect->x + rect->w - 1, rect->y + rect->h - 1},
+                    {rect->x, rect->y + rect->h - 1},
+                    {rect->x, rect->y},
+            };
+            for (j = 1; j < 5; j++) {
+                drawLine(image, offsetX, offsetY, &bounds, &points[j - 1], &points[j], &op, False);
+            }
+        }
+    }
+    endClippedDrawing(drawable, clip, image);
+    return True;
+}
+
+/* Copy an area between images with the raster operation of the graphic context, which may be NULL. */
+static void copyImageArea(pixman_image_t* srcImage, int srcX, int srcY, pixman_image_t* destImage,
+                          int destX, int destY, int width, int height, GraphicContext* gContext) {
+    if (!hasRasterOp(gContext)) {
+        pixman_image_composite32(PIXMAN_OP_SRC, srcImage, NULL, destImage, srcX, srcY, 0, 0,
+                                 destX, destY, width, height);
+        return;
+    }
+    // Only copy the pixels that are inside of both images, pixman does the same for the fast path.
+    SDL_Rect destRect = {destX, destY, width, height}, srcRect;
+    if (!getImageRect(destImage, 0, 0, &destRect, &destRect)) { return; }
+    srcRect.x = srcX + destRect.x - destX;
+    srcRect.y = srcY + destRect.y - destY;
+    srcRect.w = destRect.w;
+    srcRect.h = destRect.h;
+    if (!getImageRect(srcImage, 0, 0, &srcRect, &srcRect)) { return; }
+    destRect.x += srcRect.x - (srcX + destRect.x - destX);
+    destRect.y += srcRect.y - (srcY + destRect.y - destY);
+    uint32_t* srcPixels = pixman_image_get_data(srcImage);
+    int srcStride = pixman_image_get_stride(srcImage) / (int) sizeof(uint32_t);
+    uint32_t* destPixels = pixman_image_get_data(destImage);
+    int destStride = pixman_image_get_stride(destImage) / (int) sizeof(uint32_t), y;
+    for (y = 0; y < srcRect.h; y++) {
+        applyRasterOp(gContext->function, gContext->planeMask, &srcPixels[(srcRect.y + y) * srcStride + srcRect.x],
+                      &destPixels[(destRect.y + y) * destStride + destRect.x], srcRect.w);
+    }
+}
+
+Bool pixmanCopyArea(Drawable src, Drawable dest, GraphicContext* gContext, ClipIterator* clip,
+                    SDL_Rect* srcRect, SDL_Rect* destRect) {
+    int srcOffsetX, srcOffsetY, destOffsetX, destOffsetY;
+    pixman_image_t* srcImage = getDrawableImage(src, &srcOffsetX, &srcOffsetY);
+    if (srcImage == NULL) { return False; }
+    SDL_Rect rect;
+    if (!SDL_IntersectRect(destRect, &clip->bounds, &rect)) { return True; }
+    pixman_image_t* destImage = beginClippedDrawing(dest, clip, &destOffsetX, &destOffsetY);
+    if (destImage == NULL) { return False; }
+    int srcX = srcRect->x + rect.x - destRect->x + srcOffsetX;
+    int srcY = srcRect->y + rect.y - destRect->y + srcOffsetY;
+    if (srcImage == destImage && clip->boxes == NULL && !hasRasterOp(gContext)) {
+        // Scrolling within one image, the source and destination might overlap.
+        SDL_Surface* surface = createSurfaceFromImage(destImage);
+        if (surface == NULL) { return False; }
+        SDL_Rect moveRect = {srcX, srcY, rect.w, rect.h};
+        moveSurfaceArea(surface, &moveRect, rect.x + destOffsetX, rect.y + destOffsetY);
+        SDL_FreeSurface(surface);
+        return True;
+    }
+    pixman_image_t* copyImage = srcImage;
+    if (srcImage == destImage) {
+        // The clip rectangles are copied one after another, none of them may read what another one wrote,
+        // and the raster operation has to read the destination before it is changed.
+        copyImage = pixman_image_create_bits(PIXMAN_x8r8g8b8, rect.w, rect.h, NULL, 0);
+        if (copyImage == NULL) { return False; }
+        pixman_image_composite32(PIXMAN_OP_SRC, srcImage, NULL, copyImage, srcX, srcY, 0, 0, 0, 0,
+                                 rect.w, rect.h);
+        srcX = srcY = 0;
+    }
+    while (nextClipRect(clip, NULL)) {
+        SDL_Rect part;
+        if (!SDL_IntersectRect(&rect, &clip->rect, &part)) { continue; }
+        copyImageArea(copyImage, srcX + part.x - rect.x, srcY + part.y - rect.y, destImage,
+                      part.x + destOffsetX, part.y + destOffsetY, part.w, part.h, gContext);
+    }
+    if (copyImage != srcImage) { pixman_image_unref(copyImage); }
+    endClippedDrawing(dest, clip, destImage);
+    return True;
+}
+
+Bool pixmanPutImage(Drawable drawable, GraphicContext* gContext, ClipIterator* clip, XImage* image,
+                    const PixelConversion* conversion,
+                    int src_x, int src_y, int dest_x, int dest_y, unsigned int width, unsigned int height) {
+    int offsetX, offsetY;
+    SDL_Rect rect = {dest_x, dest_y, width, height};
+    if (!SDL_IntersectRect(&rect, &clip->bounds, &rect)) { return True; }
+    src_x += rect.x - dest_x;
+    src_y += rect.y - dest_y;
+    pixman_image_t* srcImage;
+    uint32_t* pixels = NULL;
+    if (conversion->identity && image->bytes_per_line % 4 == 0) {
+        // The image data has the same layout as the backing images, so it can be used directly.
+        srcImage = pixman_image_create_bits(PIXMAN_x8r8g8b8, image->width, image->height,
+                                            (uint32_t*) image->data, image->bytes_per_line);
+    } else {
+        pixels = malloc(sizeof(uint32_t) * rect.w * rect.h);
+        if (pixels == NULL) { return False; }
+        convertImageToArgb(conversion, image, src_x, src_y, rect.w, rect.h, pixels,
+                           rect.w * (int) sizeof(uint32_t));
+        srcImage = pixman_image_create_bits(PIXMAN_x8r8g8b8, rect.w, rect.h, pixels,
+                                            rect.w * (int) sizeof(uint32_t));
+        src_x = 0;
+        src_y = 0;
+    }
+    pixman_image_t* destImage = srcImage == NULL ? NULL : beginClippedDrawing(drawable, clip, &offsetX, &offsetY);
+    if (destImage == NULL) {
+        if (srcImage != NULL) { pixman_image_unref(srcImage); }
+        free(pixels);
+        return False;
+    }
+    while (nextClipRect(clip, NULL)) {
+        SDL_Rect part;
+        if (!SDL_IntersectRect(&rect, &clip->rect, &part)) { continue; }
+        copyImageArea(srcImage, src_x + part.x - rect.x, src_y + part.y - rect.y, destImage,
+                      part.x + offsetX, part.y + offsetY, part.w, part.h, gContext);
+    }
+    endClippedDrawing(drawable, clip, destImage);
+    pixman_image_unref(srcImage);
+    free(pixels);
+    return True;
+}
+
+/* Combine the pixels of the surface that are more than half opaque with the raster operation. */
+static void rasterOpSurface(pixman_image_t* destImage, int offsetX, int offsetY, ClipIterator* clip,
+                            GraphicContext* gContext, SDL_Surface* surface, const SDL_Rect* rect, int x, int y) {
+    uint32_t* destPixels = pixman_image_get_data(destImage);
+    int destStride = pixman_image_get_stride(destImage) / (int) sizeof(uint32_t), i, j;
+    SDL_Rect part;
+    while (nextClipRect(clip, NULL)) {
+        if (!SDL_IntersectRect(rect, &clip->rect, &part)
+            || !getImageRect(destImage, offsetX, offsetY, &part, &part)) { continue; }
+        for (j = 0; j < part.h; j++) {
+            Uint32* row = (Uint32*) ((Uint8*) surface->pixels + (part.y - offsetY - y + j) * surface->pitch)
+                          + part.x - offsetX - x;
+            uint32_t* destRow = &destPixels[(part.y + j) * destStride + part.x];
+            for (i = 0; i < part.w; i++) {
+                if (row[i] >> 24 >= 0x80) {
+                    applyRasterOp(gContext->function, gContext->planeMask, &row[i], &destRow[i], 1);
+                }
+            }
+        }
+    }
+}
+
+Bool pixmanCompositeSurface(Drawable drawable, GraphicContext* gContext, ClipIterator* clip, SDL_Surface* surface,
+                            int x, int y) {
+    int offsetX, offsetY, i, j;
+    SDL_Surface* convertedSurface = NULL;
+    if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+        convertedSurface = surface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (surface == NULL) {
+            LOG("SDL_ConvertSurfaceFormat failed in %s: %s\n", __func__, SDL_GetError());
+            return False;
+        }
+    }
+    pixman_image_t* destImage = beginClippedDrawing(drawable, clip, &offsetX, &offsetY);
+    if (destImage == NULL) {
+        if (convertedSurface != NULL) { SDL_FreeSurface(convertedSurface); }
+        return False;
+    }
+    SDL_Rect rect = {x, y, surface->w, surface->h};
+    Bool visible = SDL_IntersectRect(&rect, &clip->bounds, &rect);
+    if (visible && hasRasterOp(gContext)) {
+        LOCK_SURFACE(surface);
+        rasterOpSurface(destImage, offsetX, offsetY, clip, gContext, surface, &rect, x, y);
+        UNLOCK_SURFACE(surface);
+    } else if (visible) {
+        // pixman expects premultiplied alpha, SDL surfaces are not premultiplied.
+        LOCK_SURFACE(surface);
+        for (j = 0; j < surface->h; j++) {
+            Uint32* row = (Uint32*) ((Uint8*) surface->pixels + j * surface->pitch);
+            for (i = 0; i < surface->w; i++) {
+                Uint32 alpha = row[i] >> 24;
+                if (alpha == 0xFF) { continue; }
+                row[i] = alpha << 24 | ((row[i] >> 16 & 0xFF) * alpha / 0xFF) << 16
+                         | ((row[i] >> 8 & 0xFF) * alpha / 0xFF) << 8 | (row[i] & 0xFF) * alpha / 0xFF;
+            }
+        }
+        pixman_image_t* srcImage = pixman_image_create_bits(PIXMAN_a8r8g8b8, surface->w, surface->h,
+                                                            surface->pixels, surface->pitch);
+        SDL_Rect part;
+        while (srcImage != NULL && nextClipRect(clip, NULL)) {
+            if (!SDL_IntersectRect(&rect, &clip->rect, &part)) { continue; }
+            pixman_image_composite32(PIXMAN_OP_OVER, srcImage, NULL, destImage, part.x - x, part.y - y,
+                                     0, 0, part.x + offsetX, part.y + offsetY, part.w, part.h);
+        }
+        if (srcImage != NULL) { pixman_image_unref(srcImage); }
+        UNLOCK_SURFACE(surface);
+    }
+    endClippedDrawing(drawable, clip, destImage);
+    if (convertedSurface != NULL) {
+        SDL_FreeSurface(convertedSurface);
+    }
+    return True;
+}
+
+Bool pixmanMergeWindowImage(Window parent, Window child) {
+    WindowStruct* childWindowStruct = GET_WINDOW_STRUCT(child);
+    SDL_Rect destRect;
+    GET_WINDOW_POS(child, destRect.x, destRect.y);
+    GET_WINDOW_DIMS(child, destRect.w, destRect.h);
+    int offsetX, offsetY;
+    pixman_image_t* parentImage = getDrawableImage(parent, &offsetX, &offsetY);
+    if (parentImage == NULL) { return False; }
+    pixman_image_composite32(PIXMAN_OP_SRC, childWindowStruct->backingImage, NULL, parentImage,
+                             0, 0, 0, 0, destRect.x + offsetX, destRect.y + offsetY,
+                             destRect.w, destRect.h);
+    pixman_image_unref(childWindowStruct->backingImage);
+    childWindowStruct->backingImage = NULL;
+    damageDrawable(parent, destRect.x, destRect.y, destRect.w, destRect.h);
+    return True;
+}
+
+void pixmanPresentWindow(WindowStruct* windowStruct, SDL_Rect* rects, int numRects) {
+    int i;
+    SDL_Surface* windowSurface = SDL_GetWindowSurface(windowStruct->sdlWindow);
+    if (windowSurface == NULL) {
+        LOG("Failed to get the window surface in %s: %s\n", __func__, SDL_GetError());
+        return;
+    }
+    pixman_image_t* image = compositorEnabled ? compositeWindowFrame(windowStruct, rects, numRects)
+                                              : windowStruct->backingImage;
+    if (image == NULL) { return; }
+    SDL_Surface* imageSurface = createSurfaceFromImage(image);
+    if (imageSurface == NULL) { return; }
+    for (i = 0; i < numRects; i++) {
+        SDL_Rect destRect = rects[i];
+        if (SDL_BlitSurface(imageSurface, &rects[i], windowSurface, &destRect) != 0) {
+            LOG("SDL_BlitSurface failed in %s: %s\n", __func__, SDL_GetError());
+        }
+    }
+    SDL_FreeSurface(imageSurface);
+    if (SDL_UpdateWindowSurfaceRects(windowStruct->sdlWindow, rects, numRects) != 0) {
+        LOG("SDL_UpdateWindowSurfaceRects failed in %s: %s\n", __func__, SDL_GetError());
+    }
+}
+
@@ -0,0 +1,56 @@
+#ifndef _PIXMAN_BACKEND_H_
+#define _PIXMAN_BACKEND_H_
+
+#include <SDL2/SDL.h>
+#include <pixman.h>
+#include "X11/Xlib.h"
+#include "window.h"
+#include "pixelConversion.h"
+
+/*
+ * The pixman backend keeps the content of every top level window, unmapped window
+ * and pixmap in a pixman image and draws into it on the CPU. SDL is only used to
+ * blit the damaged parts of the top level windows to the screen.
+ * It is enabled by setting SDL2X11_BACKEND=pixman, the SDL renderer backend is the default.
+ * The SDL renderer backend uses the drawing functions for raster operations, see beginSoftwareDrawing.
+ */
+extern Bool pixmanBackendEnabled;
+
+struct _GraphicContext;
+struct ClipIterator;
+
+void initRenderBackend(void);
+/*
+ * Prepare to draw into the area of the drawable with the drawing functions of this backend.
+ * With the SDL renderer backend this is only done if the graphic context has a raster operation:
+ * the area (and the source area of the source drawable of a copy, or None) is read back into images,
+ * and endSoftwareDrawing writes the destination back. Returns False if the SDL renderer has to draw.
+ */
+Bool beginSoftwareDrawing(Drawable drawable, struct _GraphicContext* gContext, const SDL_Rect* area,
+                          Drawable source, const SDL_Rect* sourceArea);
+void endSoftwareDrawing(void);
+pixman_image_t* createBackingImage(unsigned int width, unsigned int height);
+pixman_image_t* getDrawableImage(Drawable drawable, int* offsetX, int* offsetY);
+/* The drawing functions only draw inside of the clip rectangles of the iterator. */
+Bool pixmanFillRectangles(Drawable drawable, struct _GraphicContext* gContext, struct ClipIterator* clip,
+                          const SDL_Rect* rectangles, int nrectangles);
+Bool pixmanDrawLines(Drawable drawable, struct _GraphicContext* gContext, struct ClipIterator* clip,
+                     SDL_Point* points, int npoints);
+Bool pixmanDrawSegments(Drawable drawable, struct _GraphicContext* gContext, struct ClipIterator* clip,
+                        const SDL_Point* endpoints, int nsegments);
+Bool pixmanDrawPoints(Drawable drawable, struct _GraphicContext* gContext, struct ClipIterator* clip,
+                      const SDL_Point* points, int npoints);
+Bool pixmanDrawRectangles(Drawable drawable, struct _GraphicContext* gContext, struct ClipIterator* clip,
+                          const SDL_Rect* rectangles, int nrectangles);
+/* The graphic context of copies, images and surfaces may be NULL, they are copied with GXcopy then. */
+Bool pixmanCopyArea(Drawable src, Drawable dest, struct _GraphicContext* gContext, struct ClipIterator* clip,
+                    SDL_Rect* srcRect, SDL_Rect* destRect);
+Bool pixmanPutImage(Drawable drawable, struct _GraphicContext* gContext, struct ClipIterator* clip, XImage* image,
+                    const PixelConversion* conversion, int src_x, int src_y, int dest_x, int dest_y,
+                    unsigned int width, unsigned int height);
+Bool pixmanCompositeSurface(Drawable drawable, struct _GraphicContext* gContext, struct ClipIterator* clip,
+                            SDL_Surface* surface, int x, int y);
+Bool pixmanMergeWindowImage(Window parent, Window child);
+void pixmanPresentWindow(WindowStruct* windowStruct, SDL_Rect* rects, int numRects);
+
+#endif /* _PIXMAN_BACKEND_H_ */
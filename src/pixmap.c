@@ -3,6 +3,58 @@
 #include "errors.h"
 #include "resourceTypes.h"
 #include "display.h"
+#include "pixmap.h"
+#include "pixmanBackend.h"
+#include "fillPattern.h"
+#include "clip.h"
+
+static Pixmap createPixmap(Display* display, unsigned int width, unsigned int height,
+                           unsigned int depth) {
+    XID pixmap = ALLOC_XID();
+    if (pixmap == None) {
+        LOG("Out of memory: Could not allocate XID in %s!\n", __func__);
+        handleOutOfMemory(0, display, 0, 0);
+        return None;
+    }
+    PixmapStruct* pixmapStruct = malloc(sizeof(PixmapStruct));
+    if (pixmapStruct == NULL) {
+        LOG("Out of memory: Could not allocate the pixmap struct in %s!\n", __func__);
+        FREE_XID(pixmap);
+        handleOutOfMemory(0, display, 0, 0);
+        return None;
+    }
+    LOG("%s: addr= %lu, w = %d, h = %d\n", __func__, pixmap, width, height);
+    pixmapStruct->texture = NULL;
+    pixmapStruct->image = NULL;
+    pixmapStruct->width = width;
+    pixmapStruct->height = height;
+    pixmapStruct->depth = depth;
+    pixmapStruct->serial = 0;
+    if (pixmanBackendEnabled) {
+        pixmapStruct->image = createBackingImage(width, height);
+        if (pixmapStruct->image == NULL) {
+            LOG("Failed to create the pixman image in %s\n", __func__);
+            free(pixmapStruct);
+            FREE_XID(pixmap);
+            handleOutOfMemory(0, display, 0, 0);
+            return None;
+        }
+    } else {
+        pixmapStruct->texture = SDL_CreateTexture(GET_WINDOW_STRUCT(SCREEN_WINDOW)->sdlRenderer,
+                                                  SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                                  (int) width, (int) height);
+        if (pixmapStruct->texture == NULL) {
+            fprintf(stderr, "SDL_CreateTexture failed in %s: %s\n", __func__, SDL_GetError());
+            free(pixmapStruct);
+            FREE_XID(pixmap);
+            handleOutOfMemory(0, display, 0, 0);
+            return None;
+        }
+    }
+    SET_XID_TYPE(pixmap, PIXMAP);
+    SET_XID_VALUE(pixmap, pixmapStruct);
+    return pixmap;
+}
 
 Pixmap XCreatePixmap(Display* display, Drawable drawable, unsigned int width, unsigned int height,
                      unsigned int depth) {
@@ -20,29 +72,13 @@ Pixmap XCreatePixmap(Display* display, Drawable drawable, unsigned int width, un
         handleError(0, display, None, 0, BadValue, 0);
         return None;
     }
-    XID pixmap = ALLOC_XID();
-    if (pixmap == None) {
-        LOG("Out of memory: Could not allocate XID in XCreatePixmap!\n");
-        handleOutOfMemory(0, display, 0, 0);
-        return None;
+    Pixmap pixmap = createPixmap(display, width, height, depth);
+    if (pixmap != None && !pixmanBackendEnabled) {
+        SDL_Renderer* renderer;
+        GET_RENDERER(pixmap, renderer);
+        setRenderDrawColor(renderer, 0, 255, 0, 255);
+        //SDL_RenderClear(renderer);
     }
-    LOG("%s: addr= %lu, w = %d, h = %d\n", __func__, pixmap, width, height);
-    SDL_Texture* texture = SDL_CreateTexture(GET_WINDOW_STRUCT(SCREEN_WINDOW)->sdlRenderer,
-                                             SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
-                                             (int) width, (int) height);
-    if (texture == NULL) {
-        fprintf(stderr, "SDL_CreateTexture failed in XCreatePixmap: %s\n", SDL_GetError());
-        FREE_XID(pixmap);
-        handleOutOfMemory(0, display, 0, 0);
-        return NULL;
-    }
-    SET_XID_TYPE(pixmap, PIXMAP);
-    SET_XID_VALUE(pixmap, texture);
-
-    SDL_Renderer* renderer;
-    GET_RENDERER(pixmap, renderer);
-    SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
-    //SDL_RenderClear(renderer);
     return pixmap;
 }
 
@@ -50,63 +86,77 @@ int XFreePixmap(Display* display, Pixmap pixmap) {
     // https://tronche.com/gui/x/xlib/pixmap-and-cursor/XFreePixmap.html
     SET_X_SERVER_REQUEST(display, X_FreePixmap);
     TYPE_CHECK(pixmap, PIXMAP, display, 0);
-    SDL_Texture* texture = GET_PIXMAP_TEXTURE(pixmap);
-    free(pixmap);
-    SDL_DestroyTexture(texture);
+    PixmapStruct* pixmapStruct = GET_PIXMAP_STRUCT(pixmap);
+    freeFillPatternsOfPixmap(pixmap);
+    freeClipMaskOfPixmap(pixmap);
+    FREE_XID(pixmap);
+    if (pixmapStruct->texture != NULL) {
+        forgetRenderTarget(pixmapStruct->texture);
+        SDL_DestroyTexture(pixmapStruct->texture);
+    }
+    if (pixmapStruct->image != NULL) {
+        pixman_image_unref(pixmapStruct->image);
+    }
+    free(pixmapStruct);
     return 1;
 }
 
+/* Read the pixels of the pixmap from its texture, without changing the state of the screen renderer. */
+Uint32* readPixmapPixels(PixmapStruct* pixmapStruct) {
+    SDL_Renderer* renderer = GET_WINDOW_STRUCT(SCREEN_WINDOW)->sdlRenderer;
+    Uint32* pixels = malloc(sizeof(Uint32) * pixmapStruct->width * pixmapStruct->height);
+    if (pixels == NULL) { return NULL; }
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_Rect previousViewPort;
+    SDL_RenderGetViewport(renderer, &previousViewPort);
+    if (!setRenderTarget(renderer, pixmapStruct->texture)
+        || SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGBA8888, pixels,
+                                (int) (pixmapStruct->width * sizeof(Uint32))) != 0) {
+        LOG("Failed to read the pixels of the pixmap in %s: %s\n", __func__, SDL_GetError());
+        free(pixels);
+        pixels = NULL;
+    }
+    setRenderTarget(renderer, previousTarget);
+    setRenderViewport(renderer, &previousViewPort);
+    return pixels;
+}
+
+Pixmap copyPixmap(Display* display, Pixmap pixmap) {
+    PixmapStruct* pixmapStruct = GET_PIXMAP_STRUCT(pixmap);
+    Pixmap copy = createPixmap(display, pixmapStruct->width, pixmapStruct->height, pixmapStruct->depth);
+    if (copy != None) {
+        XCopyArea(display, pixmap, copy, NULL, 0, 0, pixmapStruct->width, pixmapStruct->height, 0, 0);
+    }
+    return copy;
+}
+
  Pixmap XCreateBitmapFromData(Display* display, Drawable d, _Xconst char* data,
                               unsigned int width, unsigned int height) {
      // https://tronche.com/gui/x/xlib/utilities/XCreateBitmapFromData.html
      SET_X_SERVER_REQUEST(display, X_CreatePixmap);
-     XID pixmap = ALLOC_XID();
+     Pixmap pixmap = createPixmap(display, width, height, 1);
      if (pixmap == None) {
-         LOG("Out of memory: Could not allocate XID in %s!\n", __func__);
-         handleOutOfMemory(0, display, BadAlloc, 0);
          return None;
      }
-//     SDL_Surface* surface = SDL_CreateRGBSurfaceFrom((void *) data, width, height, 1,
-//                                                     (int) ceilf(width / 8.0f), 0, 0, 0, 1);
-//     if (surface == NULL) {
-//         FREE_XID(pixmap);
-//         LOG("SDL_CreateRGBSurfaceFrom failed in %s: %s\n", __func__, SDL_GetError());
-//         handleOutOfMemory(0, display, BadAlloc, 0);
-//         return None;
-//     }
-
-     SDL_Renderer* renderer = NULL;
-     GET_RENDERER(d, renderer);
-     if (renderer == NULL) {
-         LOG("Failed to create renderer in %s: %s\n", __func__, SDL_GetError());
-         handleError(0, display, d, 0, BadDrawable, 0);
-         return 0;
-     }
-
-     SDL_Texture *image = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
-     if (image == NULL) {
-         LOG("SDL_CreateTextureFromSurface failed in %s: %s\n", __func__, SDL_GetError());
-         FREE_XID(pixmap);
+     // The data is in X bitmap format, rows are padded to full bytes and the first pixel is the lowest bit.
+     Uint32* pixels = malloc(sizeof(Uint32) * width * height);
+     if (pixels == NULL) {
+         XFreePixmap(display, pixmap);
          handleOutOfMemory(0, display, BadAlloc, 0);
          return None;
      }
-
-//     SDL_Texture *image = SDL_CreateTextureFromSurface(renderer, surface);
-//     SDL_FreeSurface(surface);
-//     if (image == NULL) {
-//         LOG("SDL_CreateTextureFromSurface failed in %s: %s\n", __func__, SDL_GetError());
-//         FREE_XID(pixmap);
-//         handleOutOfMemory(0, display, BadAlloc, 0);
-//         return None;
-//     }
-     if (SDL_SetRenderTarget(renderer, image) < 0) {
-         LOG("SDL_SetRenderTarget failed in %s: %s\n", __func__, SDL_GetError());
-         FREE_XID(pixmap);
-         SDL_DestroyTexture(image);
-         handleOutOfMemory(0, display, BadAlloc, 0);
-         return None;
+     unsigned int bytesPerLine = (width + 7) / 8, x, y;
+     for (y = 0; y < height; y++) {
+         for (x = 0; x < width; x++) {
+             pixels[y * width + x] = (data[y * bytesPerLine + x / 8] >> (x % 8)) & 1;
+         }
+     }
+     PixmapStruct* pixmapStruct = GET_PIXMAP_STRUCT(pixmap);
+     if (pixmapStruct->image != NULL) {
+         memcpy(pixman_image_get_data(pixmapStruct->image), pixels, sizeof(Uint32) * width * height);
+     } else if (SDL_UpdateTexture(pixmapStruct->texture, NULL, pixels, width * sizeof(Uint32)) != 0) {
+         LOG("SDL_UpdateTexture failed in %s: %s\n", __func__, SDL_GetError());
      }
-     SET_XID_TYPE(pixmap, PIXMAP);
-     SET_XID_VALUE(pixmap, image);
+     free(pixels);
      return pixmap;
  }
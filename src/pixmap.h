@@ -0,0 +1,27 @@
+#ifndef _PIXMAP_H_
+#define _PIXMAP_H_
+
+#include <SDL2/SDL.h>
+#include <pixman.h>
+#include "resourceTypes.h"
+
+typedef struct {
+    /* The content of the pixmap if the SDL renderer backend is used. */
+    SDL_Texture* texture;
+    /* The content of the pixmap if the pixman backend is used. */
+    pixman_image_t* image;
+    /* The dimensions of the pixmap. */
+    unsigned int width, height;
+    unsigned int depth;
+    /* Incremented whenever the content of the pixmap changes, so caches derived from it can be invalidated. */
+    unsigned long serial;
+} PixmapStruct;
+
+#define GET_PIXMAP_STRUCT(pixmap) ((PixmapStruct*) GET_XID_VALUE(pixmap))
+
+/* Create a new pixmap with the content of the pixmap. */
+Pixmap copyPixmap(Display* display, Pixmap pixmap);
+/* Read the RGBA8888 pixels of the texture of the pixmap. The result must be freed. */
+Uint32* readPixmapPixels(PixmapStruct* pixmapStruct);
+
+#endif /* _PIXMAP_H_ */
@@ -0,0 +1,74 @@
+#include "rasterOp.h"
+
+/* Lists the expression of every function with the source pixel s and the destination pixel d. */
+#define FOR_EACH_FUNCTION(KERNEL) \
+    KERNEL(GXclear, 0) \
+    KERNEL(GXand, s & d) \
+    KERNEL(GXandReverse, s & ~d) \
+    KERNEL(GXcopy, s) \
+    KERNEL(GXandInverted, ~s & d) \
+    KERNEL(GXnoop, d) \
+    KERNEL(GXxor, s ^ d) \
+    KERNEL(GXor, s | d) \
+    KERNEL(GXnor, ~(s | d)) \
+    KERNEL(GXequiv, ~s ^ d) \
+    KERNEL(GXinvert, ~d) \
+    KERNEL(GXorReverse, s | ~d) \
+    KERNEL(GXcopyInverted, ~s) \
+    KERNEL(GXorInverted, ~s | d) \
+    KERNEL(GXnand, ~(s & d)) \
+    KERNEL(GXset, 0xFFFFFFFF)
+
+static uint32_t applyFunction(int function, uint32_t s, uint32_t d) {
+#define PIXEL_KERNEL(function, expression) case function: return (uint32_t) (expression);
+    switch (function) {
+        FOR_EACH_FUNCTION(PIXEL_KERNEL)
+        default: return s;
+    }
+#undef PIXEL_KERNEL
+}
+
+Bool hasRasterOp(const GraphicContext* gContext) {
+    return gContext != NULL && (gContext->function != GXcopy
+                                || (gContext->planeMask & RASTER_OP_PLANES) != RASTER_OP_PLANES);
+}
+
+SolidRasterOp getSolidRasterOp(const GraphicContext* gContext, uint32_t pixel) {
+    SolidRasterOp op = {0, pixel};
+    if (!hasRasterOp(gContext)) { return op; }
+    // Every bit of the result is 0, 1, the destination bit or its inverse,
+    // which is decided by the result for a destination of all zeros and all ones.
+    uint32_t zeros = applyFunction(gContext->function, pixel, 0);
+    uint32_t ones = applyFunction(gContext->function, pixel, 0xFFFFFFFF);
+    uint32_t planes = (uint32_t) gContext->planeMask & RASTER_OP_PLANES;
+    op.andBits = ((zeros ^ ones) & planes) | ~planes;
+    op.xorBits = zeros & planes;
+    return op;
+}
+
+void applySolidRasterOp(const SolidRasterOp* op, uint32_t* dest, int width) {
+    uint32_t andBits = op->andBits, xorBits = op->xorBits;
+    int i;
+    for (i = 0; i < width; i++) {
+        dest[i] = (dest[i] & andBits) ^ xorBits;
+    }
+}
+
+void applyRasterOp(int function, unsigned long planeMask, const uint32_t* src, uint32_t* dest, int width) {
+    uint32_t planes = (uint32_t) planeMask & RASTER_OP_PLANES;
+    int i;
+    // One loop per function without branches in it, so the compiler can vectorize them.
+#define ROW_KERNEL(function, expression) \
+    case function: \
+        for (i = 0; i < width; i++) { \
+            uint32_t s = src[i], d = dest[i]; \
+            (void) s; \
+            dest[i] = (d & ~planes) | ((uint32_t) (expression) & planes); \
+        } \
+        break;
+    switch (function) {
+        FOR_EACH_FUNCTION(ROW_KERNEL)
+        default: break;
+    }
+#undef ROW_KERNEL
+}
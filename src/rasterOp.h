@@ -0,0 +1,32 @@
+#ifndef _RASTER_OP_H_
+#define _RASTER_OP_H_
+
+#include <stdint.h>
+#include "X11/Xlib.h"
+#include "gc.h"
+
+/*
+ * Software kernels for the raster operations (the function of a graphic context) and the plane mask.
+ * They work on rows of 32 bit pixels in CPU memory, of which the 24 color bits are the planes,
+ * the upper 8 bits of the destination are kept. GXcopy to all planes doesn't need them.
+ */
+#define RASTER_OP_PLANES 0x00FFFFFF
+
+/* A raster operation with a constant source pixel reduces to dest = (dest & andBits) ^ xorBits. */
+typedef struct {
+    uint32_t andBits;
+    uint32_t xorBits;
+} SolidRasterOp;
+
+/* Whether drawing with the graphic context (which may be NULL) needs the raster operation kernels. */
+Bool hasRasterOp(const GraphicContext* gContext);
+/* Reduce the raster operation of the graphic context (which may be NULL) for the source pixel. */
+SolidRasterOp getSolidRasterOp(const GraphicContext* gContext, uint32_t pixel);
+/* Combine the pixel into a row of width destination pixels. */
+void applySolidRasterOp(const SolidRasterOp* op, uint32_t* dest, int width);
+/* Combine a row of width source pixels into the destination row with the function and plane mask. */
+void applyRasterOp(int function, unsigned long planeMask, const uint32_t* src, uint32_t* dest, int width);
+
+#define APPLY_SOLID_RASTER_OP(op, pixel) ((pixel) = ((pixel) & (op)->andBits) ^ (op)->xorBits)
+
+#endif /* _RASTER_OP_H_ */
@@ -0,0 +1,389 @@
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rasterizer.h"
+#include "util.h"
+
+#define FULL_CIRCLE (360 * 64)
+
+typedef struct {
+    double x, y;
+} RasterPoint;
+
+/* A non horizontal polygon edge, from its top to its bottom. */
+typedef struct {
+    double yTop, yBottom;
+    double xTop;
+    double dx, dy;
+    /* 1 if the polygon goes down along the edge, -1 if it goes up. */
+    int direction;
+} Edge;
+
+typedef struct {
+    double x;
+    int direction;
+} Crossing;
+
+void initSpanBuffer(SpanBuffer* spans, const SDL_Rect* clip) {
+    memset(spans, 0, sizeof(SpanBuffer));
+    spans->clip = *clip;
+    spans->previousY = INT_MIN;
+}
+
+void freeSpanBuffer(SpanBuffer* spans) {
+    free(spans->rectangles);
+    free(spans->row);
+    free(spans->previousRow);
+    free(spans->currentRow);
+    spans->rectangles = NULL;
+    spans->row = spans->previousRow = spans->currentRow = NULL;
+    spans->numRectangles = spans->capacity = spans->rowLength = spans->rowCapacity = 0;
+}
+
+Bool getSpanBounds(const SpanBuffer* spans, SDL_Rect* bounds) {
+    if (spans->numRectangles == 0) { return False; }
+    *bounds = spans->rectangles[0];
+    int i;
+    for (i = 1; i < spans->numRectangles; i++) {
+        SDL_UnionRect(bounds, &spans->rectangles[i], bounds);
+    }
+    return True;
+}
+
+static void addSpan(SpanBuffer* spans, double left, double right) {
+    // A pixel belongs to the span if its center is inside of it.
+    int clipRight = spans->clip.x + spans->clip.w;
+    int x1 = (int) ceil(MAX(left - 0.5, (double) spans->clip.x));
+    int x2 = (int) ceil(MIN(right - 0.5, (double) clipRight));
+    if (x1 >= x2) { return; }
+    if (spans->rowLength + 2 > spans->rowCapacity) {
+        int capacity = MAX(16, spans->rowCapacity * 2);
+        int* row = realloc(spans->row, sizeof(int) * capacity);
+        int* previousRow = row == NULL ? NULL : realloc(spans->previousRow, sizeof(int) * capacity);
+        int* currentRow = previousRow == NULL ? NULL : realloc(spans->currentRow, sizeof(int) * capacity);
+        if (row != NULL) { spans->row = row; }
+        if (previousRow != NULL) { spans->previousRow = previousRow; }
+        if (currentRow == NULL) {
+            spans->failed = True;
+            return;
+        }
+        spans->currentRow = currentRow;
+        spans->rowCapacity = capacity;
+    }
+    spans->row[spans->rowLength++] = x1;
+    spans->row[spans->rowLength++] = x2;
+}
+
+/* Emit the spans collected for the scanline y as rectangles. */
+static void emitRow(SpanBuffer* spans, int y) {
+    int* row = spans->row;
+    int i, j, length = 0;
+    // Sort the spans by their start and merge the ones that touch.
+    for (i = 2; i < spans->rowLength; i += 2) {
+        int x1 = row[i], x2 = row[i + 1];
+        for (j = i; j > 0 && row[j - 2] > x1; j -= 2) {
+            row[j] = row[j - 2];
+            row[j + 1] = row[j - 1];
+        }
+        row[j] = x1;
+        row[j + 1] = x2;
+    }
+    for (i = 0; i < spans->rowLength; i += 2) {
+        if (length > 0 && row[i] <= row[length - 1]) {
+            row[length - 1] = MAX(row[length - 1], row[i + 1]);
+        } else {
+            row[length++] = row[i];
+            row[length++] = row[i + 1];
+        }
+    }
+    spans->rowLength = 0;
+    if (y < spans->clip.y || y >= spans->clip.y + spans->clip.h) { return; }
+    int previousLength = spans->previousY == y - 1 ? spans->previousRowLength : 0;
+    int previous = 0, currentLength = 0;
+    for (i = 0; i < length; i += 2) {
+        int x = row[i], width = row[i + 1] - row[i];
+        while (previous < previousLength && spans->rectangles[spans->previousRow[previous]].x < x) {
+            previous++;
+        }
+        if (previous < previousLength && spans->rectangles[spans->previousRow[previous]].x == x
+            && spans->rectangles[spans->previousRow[previous]].w == width) {
+            // The span continues the rectangle of the previous scanline.
+            spans->rectangles[spans->previousRow[previous]].h++;
+            spans->currentRow[currentLength++] = spans->previousRow[previous++];
+            continue;
+        }
+        if (spans->numRectangles == spans->capacity) {
+            int capacity = MAX(64, spans->capacity * 2);
+            SDL_Rect* rectangles = realloc(spans->rectangles, sizeof(SDL_Rect) * capacity);
+            if (rectangles == NULL) {
+                spans->failed = True;
+                return;
+            }
+            spans->rectangles = rectangles;
+            spans->capacity = capacity;
+        }
+        SDL_Rect* rectangle = &spans->rectangles[spans->numRectangles];
+        rectangle->x = x;
+        rectangle->y = y;
+        rectangle->w = width;
+        rectangle->h = 1;
+        spans->currentRow[currentLength++] = spans->numRectangles++;
+    }
+    int* swap = spans->previousRow;
+    spans->previousRow = spans->currentRow;
+    spans->currentRow = swap;
+    spans->previousRowLength = currentLength;
+    spans->previousY = y;
+}
+
+static int compareEdges(const void* edge1, const void* edge2) {
+    double yTop1 = ((const Edge*) edge1)->yTop, yTop2 = ((const Edge*) edge2)->yTop;
+    return yTop1 < yTop2 ? -1 : yTop1 > yTop2;
+}
+
+/* Get the first and last scanline whose pixel centers lie in [top, bottom), clipped. */
+static Bool getScanlines(const SpanBuffer* spans, double top, double bottom, int* first, int* last) {
+    double firstRow = MAX(ceil(top - 0.5), (double) spans->clip.y);
+    double lastRow = MIN(ceil(bottom - 0.5) - 1, (double) (spans->clip.y + spans->clip.h - 1));
+    if (firstRow > lastRow) { return False; }
+    *first = (int) firstRow;
+    *last = (int) lastRow;
+    return True;
+}
+
+/* The edge table scanline fill of a polygon, the polygon is closed implicitly. */
+static Bool fillRasterPolygon(SpanBuffer* spans, const RasterPoint* points, int npoints, int fillRule) {
+    if (npoints < 3) { return True; }
+    Edge* edges = malloc(sizeof(Edge) * npoints);
+    int* active = malloc(sizeof(int) * npoints);
+    Crossing* crossings = malloc(sizeof(Crossing) * npoints);
+    if (edges == NULL || active == NULL || crossings == NULL) {
+        free(edges);
+        free(active);
+        free(crossings);
+        spans->failed = True;
+        return False;
+    }
+    int i, j, numEdges = 0;
+    double top = points[0].y, bottom = points[0].y;
+    for (i = 0; i < npoints; i++) {
+        const RasterPoint* from = &points[i];
+        const RasterPoint* to = &points[(i + 1) % npoints];
+        top = MIN(top, from->y);
+        bottom = MAX(bottom, from->y);
+        // Horizontal edges never cross a pixel center vertically.
+        if (from->y == to->y) { continue; }
+        Edge* edge = &edges[numEdges++];
+        edge->direction = from->y < to->y ? 1 : -1;
+        if (edge->direction < 0) {
+            const RasterPoint* swap = from;
+            from = to;
+            to = swap;
+        }
+        edge->yTop = from->y;
+        edge->yBottom = to->y;
+        edge->xTop = from->x;
+        edge->dx = to->x - from->x;
+        edge->dy = to->y - from->y;
+    }
+    qsort(edges, (size_t) numEdges, sizeof(Edge), compareEdges);
+    int first, last, row, nextEdge = 0, numActive = 0;
+    if (getScanlines(spans, top, bottom, &first, &last)) {
+        for (row = first; row <= last && !spans->failed; row++) {
+            double centerY = row + 0.5;
+            // Edges include their top and exclude their bottom.
+            while (nextEdge < numEdges && edges[nextEdge].yTop <= centerY) {
+                active[numActive++] = nextEdge++;
+            }
+            int numCrossings = 0;
+            for (i = 0, j = 0; i < numActive; i++) {
+                const Edge* edge = &edges[active[i]];
+                if (edge->yBottom <= centerY) { continue; }
+                active[j++] = active[i];
+                // Divide last, so crossings exactly at a pixel center are exact for integer vertices.
+                double x = edge->xTop + (centerY - edge->yTop) * edge->dx / edge->dy;
+                int k;
+                for (k = numCrossings; k > 0 && crossings[k - 1].x > x; k--) {
+                    crossings[k] = crossings[k - 1];
+                }
+                crossings[k].x = x;
+                crossings[k].direction = edge->direction;
+                numCrossings++;
+            }
+            numActive = j;
+            if (fillRule == WindingRule) {
+                int winding = 0;
+                double start = 0;
+                for (i = 0; i < numCrossings; i++) {
+                    int previousWinding = winding;
+                    winding += crossings[i].direction;
+                    if (previousWinding == 0) {
+                        start = crossings[i].x;
+                    } else if (winding == 0) {
+                        addSpan(spans, start, crossings[i].x);
+                    }
+                }
+            } else {
+                for (i = 0; i + 1 < numCrossings; i += 2) {
+                    addSpan(spans, crossings[i].x, crossings[i + 1].x);
+                }
+            }
+            emitRow(spans, row);
+        }
+    }
+    free(edges);
+    free(active);
+    free(crossings);
+    return !spans->failed;
+}
+
+Bool fillPolygonSpans(SpanBuffer* spans, const XPoint* points, int npoints, int fillRule) {
+    RasterPoint* rasterPoints = malloc(sizeof(RasterPoint) * MAX(npoints, 1));
+    if (rasterPoints == NULL) {
+        spans->failed = True;
+        return False;
+    }
+    int i;
+    for (i = 0; i < npoints; i++) {
+        rasterPoints[i].x = points[i].x;
+        rasterPoints[i].y = points[i].y;
+    }
+    Bool result = fillRasterPolygon(spans, rasterPoints, npoints, fillRule);
+    free(rasterPoints);
+    return result;
+}
+
+static double angleToRadians(int angle) {
+    return angle * M_PI / (180.0 * 64.0);
+}
+
+/* The number of segments that approximate the arc with an error well below a pixel. */
+static int getArcSegments(double radiusX, double radiusY, double extent) {
+    int segments = (int) ceil(fabs(extent) * 2.0 * sqrt(MAX(MAX(radiusX, radiusY), 1.0)));
+    return MAX(segments, 4);
+}
+
+/*
+ * Write the segments + 1 points of the arc of the ellipse. The angles are those of the
+ * skewed coordinate system of the ellipse, counterclockwise from three o'clock.
+ */
+static void getArcPoints(RasterPoint* points, double centerX, double centerY, double radiusX,
+                         double radiusY, double start, double extent, int segments) {
+    int i;
+    for (i = 0; i <= segments; i++) {
+        double angle = start + extent * i / segments;
+        points[i].x = centerX + radiusX * cos(angle);
+        points[i].y = centerY - radiusY * sin(angle);
+    }
+}
+
+static void fillEllipse(SpanBuffer* spans, double centerX, double centerY, double radiusX, double radiusY) {
+    int first, last, row;
+    if (!getScanlines(spans, centerY - radiusY, centerY + radiusY, &first, &last)) { return; }
+    for (row = first; row <= last && !spans->failed; row++) {
+        double distance = (row + 0.5 - centerY) / radiusY;
+        if (distance * distance < 1.0) {
+            double halfWidth = radiusX * sqrt(1.0 - distance * distance);
+            addSpan(spans, centerX - halfWidth, centerX + halfWidth);
+        }
+        emitRow(spans, row);
+    }
+}
+
+Bool fillArcSpans(SpanBuffer* spans, int x, int y, unsigned int width, unsigned int height,
+                  int angle1, int angle2, int arcMode) {
+    if (width == 0 || height == 0 || angle2 == 0) { return True; }
+    double radiusX = width / 2.0, radiusY = height / 2.0;
+    double centerX = x + radiusX, centerY = y + radiusY;
+    if (abs(angle2) >= FULL_CIRCLE) {
+        fillEllipse(spans, centerX, centerY, radiusX, radiusY);
+        return !spans->failed;
+    }
+    double extent = angleToRadians(angle2);
+    int segments = getArcSegments(radiusX, radiusY, extent);
+    RasterPoint* points = malloc(sizeof(RasterPoint) * (segments + 2));
+    if (points == NULL) {
+        spans->failed = True;
+        return False;
+    }
+    getArcPoints(points, centerX, centerY, radiusX, radiusY, angleToRadians(angle1), extent, segments);
+    int npoints = segments + 1;
+    if (arcMode == ArcPieSlice) {
+        points[npoints].x = centerX;
+        points[npoints].y = centerY;
+        npoints++;
+    }
+    Bool result = fillRasterPolygon(spans, points, npoints, EvenOddRule);
+    free(points);
+    return result;
+}
+
+static int comparePixels(const void* pixel1, const void* pixel2) {
+    const SDL_Point* point1 = pixel1;
+    const SDL_Point* point2 = pixel2;
+    if (point1->y != point2->y) { return point1->y < point2->y ? -1 : 1; }
+    return point1->x < point2->x ? -1 : point1->x > point2->x;
+}
+
+/* Stroke the arc one pixel wide, the pixels of the path are 8-connected. */
+static Bool strokeThinArc(SpanBuffer* spans, double centerX, double centerY, double radiusX, double radiusY,
+                          double start, double extent) {
+    // Successive points of the path are less than a pixel apart.
+    int steps = (int) ceil(fabs(extent) * MAX(radiusX, radiusY)) + 1;
+    SDL_Point* pixels = malloc(sizeof(SDL_Point) * (steps + 1));
+    if (pixels == NULL) {
+        spans->failed = True;
+        return False;
+    }
+    int i, numPixels = 0;
+    for (i = 0; i <= steps; i++) {
+        double angle = start + extent * i / steps;
+        SDL_Point pixel = {(int) floor(centerX + radiusX * cos(angle) + 0.5),
+                           (int) floor(centerY - radiusY * sin(angle) + 0.5)};
+        if (numPixels == 0 || pixel.x != pixels[numPixels - 1].x || pixel.y != pixels[numPixels - 1].y) {
+            pixels[numPixels++] = pixel;
+        }
+    }
+    qsort(pixels, (size_t) numPixels, sizeof(SDL_Point), comparePixels);
+    for (i = 0; i < numPixels && !spans->failed;) {
+        int row = pixels[i].y;
+        while (i < numPixels && pixels[i].y == row) {
+            int runStart = pixels[i].x, runEnd = pixels[i].x;
+            for (i++; i < numPixels && pixels[i].y == row && pixels[i].x <= runEnd + 1; i++) {
+                runEnd = pixels[i].x;
+            }
+            // Spans cover the pixels whose centers are inside of them.
+            addSpan(spans, runStart + 0.5, runEnd + 1.5);
+        }
+        emitRow(spans, row);
+    }
+    free(pixels);
+    return !spans->failed;
+}
+
+Bool strokeArcSpans(SpanBuffer* spans, int x, int y, unsigned int width, unsigned int height,
+                    int angle1, int angle2, int lineWidth) {
+    if (angle2 == 0) { return True; }
+    double radiusX = width / 2.0, radiusY = height / 2.0;
+    double centerX = x + radiusX, centerY = y + radiusY;
+    double start = angleToRadians(angle1);
+    double extent = angleToRadians(MAX(-FULL_CIRCLE, MIN(angle2, FULL_CIRCLE)));
+    if (lineWidth <= 1) {
+        return strokeThinArc(spans, centerX, centerY, radiusX, radiusY, start, extent);
+    }
+    // Wide arcs fill the area between the arcs of the outer and inner edge of the line.
+    double halfWidth = lineWidth / 2.0;
+    int segments = getArcSegments(radiusX + halfWidth, radiusY + halfWidth, extent);
+    RasterPoint* points = malloc(sizeof(RasterPoint) * (segments + 1) * 2);
+    if (points == NULL) {
+        spans->failed = True;
+        return False;
+    }
+    getArcPoints(points, centerX, centerY, radiusX + halfWidth, radiusY + halfWidth, start, extent, segments);
+    getArcPoints(&points[segments + 1], centerX, centerY, MAX(radiusX - halfWidth, 0.0),
+                 MAX(radiusY - halfWidth, 0.0), start + extent, -extent, segments);
+    Bool result = fillRasterPolygon(spans, points, (segments + 1) * 2, EvenOddRule);
+    free(points);
+    return result;
+}
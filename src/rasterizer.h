@@ -0,0 +1,46 @@
+#ifndef _RASTERIZER_H_
+#define _RASTERIZER_H_
+
+#include <SDL2/SDL.h>
+#include "X11/Xlib.h"
+
+/*
+ * A scanline rasterizer for the shapes the backends can't draw themselves. The shapes are
+ * converted into the horizontal spans of the pixels whose centers are inside of them, following
+ * the pixel rules of the X protocol. A span that repeats the span of the previous scanline extends
+ * its rectangle, so a shape is usually filled with far fewer rectangles than it has scanlines,
+ * and all of them can be handed to the backend at once.
+ */
+typedef struct {
+    SDL_Rect* rectangles;
+    int numRectangles;
+    int capacity;
+    /* Only the parts of the spans inside of the clip rectangle are emitted. */
+    SDL_Rect clip;
+    /* The x1, x2 pairs of the spans of the current scanline. */
+    int* row;
+    int rowLength;
+    int rowCapacity;
+    /* The indices of the rectangles that end at the previous scanline, sorted by x. */
+    int* previousRow;
+    int previousRowLength;
+    int* currentRow;
+    int previousY;
+    /* Set if memory ran out, the spans are incomplete. */
+    Bool failed;
+} SpanBuffer;
+
+void initSpanBuffer(SpanBuffer* spans, const SDL_Rect* clip);
+void freeSpanBuffer(SpanBuffer* spans);
+/* Get the bounding box of the emitted rectangles. Returns False if there are none. */
+Bool getSpanBounds(const SpanBuffer* spans, SDL_Rect* bounds);
+/* Fill the polygon with the EvenOddRule or WindingRule. */
+Bool fillPolygonSpans(SpanBuffer* spans, const XPoint* points, int npoints, int fillRule);
+/* Fill the arc as an ArcPieSlice or ArcChord, the angles are in 64ths of a degree. */
+Bool fillArcSpans(SpanBuffer* spans, int x, int y, unsigned int width, unsigned int height,
+                  int angle1, int angle2, int arcMode);
+/* Stroke the arc with the line width, 0 draws a thin line. */
+Bool strokeArcSpans(SpanBuffer* spans, int x, int y, unsigned int width, unsigned int height,
+                    int angle1, int angle2, int lineWidth);
+
+#endif /* _RASTERIZER_H_ */
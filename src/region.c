@@ -3,7 +3,10 @@
 #include <inttypes.h>
 #include <X11/Xregion.h>
 #include <pixman.h>
+#include "display.h"
 #include "drawing.h"
+#include "gc.h"
+#include "rasterizer.h"
 #include "resourceTypes.h"
 
 typedef struct pixman_region16* pRegion;
@@ -14,6 +17,7 @@ typedef struct pixman_region16* pRegion;
 int XDestroyRegion(Region region) {
     // https://tronche.com/gui/x/xlib/utilities/regions/XDestroyRegion.html
     pixman_region_fini(GET_P_REGION(region));
+    free(GET_P_REGION(region));
     return 1;
 }
 
@@ -77,11 +81,79 @@ int XUnionRectWithRegion(XRectangle *rectangle, Region src_region, Region dest_r
                                     rectangle->x, rectangle->y, rectangle->width, rectangle->height) ? 1 : 0;
 }
 
+int XUnionRegion(Region sra, Region srb, Region dr_return) {
+    // https://tronche.com/gui/x/xlib/utilities/regions/XUnionRegion.html
+    return pixman_region_union(GET_P_REGION(dr_return), GET_P_REGION(sra), GET_P_REGION(srb)) ? 1 : 0;
+}
+
+int XXorRegion(Region sra, Region srb, Region dr_return) {
+    // https://tronche.com/gui/x/xlib/utilities/regions/XXorRegion.html
+    pixman_region16_t onlyA, onlyB;
+    pixman_region_init(&onlyA);
+    pixman_region_init(&onlyB);
+    Bool success = pixman_region_subtract(&onlyA, GET_P_REGION(sra), GET_P_REGION(srb))
+                   && pixman_region_subtract(&onlyB, GET_P_REGION(srb), GET_P_REGION(sra))
+                   && pixman_region_union(GET_P_REGION(dr_return), &onlyA, &onlyB);
+    pixman_region_fini(&onlyA);
+    pixman_region_fini(&onlyB);
+    return success ? 1 : 0;
+}
+
+int XOffsetRegion(Region region, int dx, int dy) {
+    // https://tronche.com/gui/x/xlib/utilities/regions/XOffsetRegion.html
+    pixman_region_translate(GET_P_REGION(region), dx, dy);
+    return 1;
+}
+
+int XEqualRegion(Region r1, Region r2) {
+    // https://tronche.com/gui/x/xlib/utilities/regions/XEqualRegion.html
+    return pixman_region_equal(GET_P_REGION(r1), GET_P_REGION(r2)) ? True : False;
+}
+
+Bool XPointInRegion(Region region, int x, int y) {
+    // https://tronche.com/gui/x/xlib/utilities/regions/XPointInRegion.html
+    return pixman_region_contains_point(GET_P_REGION(region), x, y, NULL) ? True : False;
+}
+
+Region XPolygonRegion(XPoint* points, int n, int fill_rule) {
+    // https://tronche.com/gui/x/xlib/utilities/regions/XPolygonRegion.html
+    SDL_Rect clip = {INT16_MIN, INT16_MIN, UINT16_MAX, UINT16_MAX};
+    SpanBuffer spans;
+    initSpanBuffer(&spans, &clip);
+    if (n >= 3) {
+        fillPolygonSpans(&spans, points, n, fill_rule);
+    }
+    pixman_box16_t* boxes = spans.failed ? NULL
+            : malloc(sizeof(pixman_box16_t) * (spans.numRectangles > 0 ? spans.numRectangles : 1));
+    int i;
+    for (i = 0; boxes != NULL && i < spans.numRectangles; i++) {
+        boxes[i].x1 = (int16_t) spans.rectangles[i].x;
+        boxes[i].y1 = (int16_t) spans.rectangles[i].y;
+        boxes[i].x2 = (int16_t) (spans.rectangles[i].x + spans.rectangles[i].w);
+        boxes[i].y2 = (int16_t) (spans.rectangles[i].y + spans.rectangles[i].h);
+    }
+    pRegion region = boxes == NULL ? NULL : malloc(sizeof(struct pixman_region16));
+    if (region != NULL && !pixman_region_init_rects(region, boxes, spans.numRectangles)) {
+        free(region);
+        region = NULL;
+    }
+    free(boxes);
+    freeSpanBuffer(&spans);
+    if (region == NULL) {
+        LOG("Out of memory: Could not allocate Region structure in XPolygonRegion!\n");
+    }
+    return GET_REGION(region);
+}
+
 int XSetRegion(Display* display, GC gc, Region region) {
     // https://tronche.com/gui/x/xlib/utilities/regions/XSetRegion.html
-    pixman_box16_t* extends = pixman_region_extents(GET_P_REGION(region));
-    int width  = abs(extends->x2 - extends->x1);
-    int height = abs(extends->y2 - extends->y1);
-    // TODO: Implement (https://opensource.apple.com/source/X11/X11-0.40.2/xc/lib/X11/Region.c.auto.html)
+    SET_X_SERVER_REQUEST(display, X_SetClipRectangles);
+    GraphicContext* gContext = GET_GC(gc);
+    if (!setClipRegion(display, gContext, GET_P_REGION(region))) {
+        handleOutOfMemory(0, display, 0, 0);
+        return 0;
+    }
+    gContext->clipOriginX = 0;
+    gContext->clipOriginY = 0;
     return 1;
 }
@@ -0,0 +1,196 @@
+#include <stdlib.h>
+#include <string.h>
+#include "rendererState.h"
+#include "statistics.h"
+#include "util.h"
+
+typedef struct RendererState {
+    SDL_Renderer* renderer;
+    /* Which of the states below are known to match the renderer. */
+    Bool targetKnown, viewPortKnown, clipRectKnown, drawColorKnown, blendModeKnown;
+    SDL_Texture* target;
+    /* A viewport with a width of 0 is the whole target. */
+    SDL_Rect viewPort;
+    /* A clip rect with a width of 0 disables clipping. */
+    SDL_Rect clipRect;
+    Uint8 drawColor[4];
+    SDL_BlendMode blendMode;
+    struct RendererState* next;
+} RendererState;
+
+static RendererState* rendererStates = NULL;
+
+static int onWindowEvent(void* userData, SDL_Event* event) {
+    (void) userData;
+    if (event->type == SDL_WINDOWEVENT && event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+        // SDL resets the viewport of the renderer of a window that changed its size.
+        SDL_Window* window = SDL_GetWindowFromID(event->window.windowID);
+        SDL_Renderer* renderer = window == NULL ? NULL : SDL_GetRenderer(window);
+        if (renderer != NULL) {
+            invalidateRendererState(renderer);
+        }
+    }
+    return 1;
+}
+
+void initRendererState() {
+    SDL_DelEventWatch(onWindowEvent, NULL);
+    SDL_AddEventWatch(onWindowEvent, NULL);
+}
+
+static RendererState* getRendererState(SDL_Renderer* renderer) {
+    RendererState** link;
+    for (link = &rendererStates; *link != NULL; link = &(*link)->next) {
+        if ((*link)->renderer == renderer) {
+            RendererState* state = *link;
+            // Move it to the front, drawing mostly goes to one renderer.
+            *link = state->next;
+            state->next = rendererStates;
+            rendererStates = state;
+            return state;
+        }
+    }
+    RendererState* state = calloc(1, sizeof(RendererState));
+    if (state == NULL) { return NULL; }
+    state->renderer = renderer;
+    state->next = rendererStates;
+    rendererStates = state;
+    return state;
+}
+
+/* Count the change and return True if it has to be issued. */
+static Bool countStateChange(Bool redundant) {
+    if (redundant) {
+        statistics.rendererStateChangesSkipped++;
+        return False;
+    }
+    statistics.rendererStateChanges++;
+    return True;
+}
+
+Bool setRenderTarget(SDL_Renderer* renderer, SDL_Texture* texture) {
+    RendererState* state = getRendererState(renderer);
+    if (state != NULL && !countStateChange(state->targetKnown && state->target == texture)) { return True; }
+    if (SDL_SetRenderTarget(renderer, texture) != 0) {
+        if (state != NULL) { state->targetKnown = state->viewPortKnown = state->clipRectKnown = False; }
+        return False;
+    }
+    if (state != NULL) {
+        state->targetKnown = True;
+        state->target = texture;
+        state->viewPortKnown = True;
+        state->viewPort.w = 0;
+        // SDL keeps a separate clip rect for the window, which it restores when switching back to it.
+        state->clipRectKnown = False;
+    }
+    return True;
+}
+
+Bool setRenderViewport(SDL_Renderer* renderer, const SDL_Rect* viewPort) {
+    RendererState* state = getRendererState(renderer);
+    SDL_Rect fullTarget = {0, 0, 0, 0};
+    const SDL_Rect* shadow = viewPort == NULL ? &fullTarget : viewPort;
+    if (state != NULL && !countStateChange(state->viewPortKnown && state->viewPort.x == shadow->x
+                                           && state->viewPort.y == shadow->y && state->viewPort.w == shadow->w
+                                           && state->viewPort.h == shadow->h)) {
+        return True;
+    }
+    if (SDL_RenderSetViewport(renderer, viewPort) != 0) {
+        if (state != NULL) { state->viewPortKnown = False; }
+        return False;
+    }
+    if (state != NULL) {
+        state->viewPortKnown = shadow->w != 0 || viewPort == NULL;
+        state->viewPort = *shadow;
+    }
+    return True;
+}
+
+Bool setRenderClipRect(SDL_Renderer* renderer, const SDL_Rect* clipRect) {
+    RendererState* state = getRendererState(renderer);
+    SDL_Rect noClip = {0, 0, 0, 0};
+    const SDL_Rect* shadow = clipRect == NULL ? &noClip : clipRect;
+    if (state != NULL && !countStateChange(state->clipRectKnown && state->clipRect.x == shadow->x
+                                           && state->clipRect.y == shadow->y && state->clipRect.w == shadow->w
+                                           && state->clipRect.h == shadow->h)) {
+        return True;
+    }
+    if (SDL_RenderSetClipRect(renderer, clipRect) != 0) {
+        if (state != NULL) { state->clipRectKnown = False; }
+        return False;
+    }
+    if (state != NULL) {
+        // An empty clip rect clips everything, it can't share the shadow of no clipping.
+        state->clipRectKnown = shadow->w != 0 || clipRect == NULL;
+        state->clipRect = *shadow;
+    }
+    return True;
+}
+
+Bool setRenderDrawColor(SDL_Renderer* renderer, Uint8 red, Uint8 green, Uint8 blue, Uint8 alpha) {
+    RendererState* state = getRendererState(renderer);
+    Uint8 color[4] = {red, green, blue, alpha};
+    if (state != NULL && !countStateChange(state->drawColorKnown
+                                           && memcmp(state->drawColor, color, sizeof(color)) == 0)) {
+        return True;
+    }
+    if (SDL_SetRenderDrawColor(renderer, red, green, blue, alpha) != 0) {
+        if (state != NULL) { state->drawColorKnown = False; }
+        return False;
+    }
+    if (state != NULL) {
+        state->drawColorKnown = True;
+        memcpy(state->drawColor, color, sizeof(color));
+    }
+    return True;
+}
+
+Bool setRenderDrawBlendMode(SDL_Renderer* renderer, SDL_BlendMode blendMode) {
+    RendererState* state = getRendererState(renderer);
+    if (state != NULL && !countStateChange(state->blendModeKnown && state->blendMode == blendMode)) {
+        return True;
+    }
+    if (SDL_SetRenderDrawBlendMode(renderer, blendMode) != 0) {
+        if (state != NULL) { state->blendModeKnown = False; }
+        return False;
+    }
+    if (state != NULL) {
+        state->blendModeKnown = True;
+        state->blendMode = blendMode;
+    }
+    return True;
+}
+
+void invalidateRendererState(SDL_Renderer* renderer) {
+    RendererState* state;
+    for (state = rendererStates; state != NULL; state = state->next) {
+        if (state->renderer == renderer) {
+            state->targetKnown = state->viewPortKnown = state->clipRectKnown = False;
+            state->drawColorKnown = state->blendModeKnown = False;
+            return;
+        }
+    }
+}
+
+void forgetRenderTarget(SDL_Texture* texture) {
+    RendererState* state;
+    for (state = rendererStates; state != NULL; state = state->next) {
+        if (state->targetKnown && state->target == texture) {
+            // SDL resets the target of the renderer when its target texture is destroyed.
+            state->targetKnown = state->viewPortKnown = state->clipRectKnown = False;
+        }
+    }
+}
+
+void freeRendererStateOfRenderer(SDL_Renderer* renderer) {
+    RendererState** link = &rendererStates;
+    while (*link != NULL) {
+        if ((*link)->renderer == renderer) {
+            RendererState* state = *link;
+            *link = state->next;
+            free(state);
+        } else {
+            link = &(*link)->next;
+        }
+    }
+}
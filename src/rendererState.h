@@ -0,0 +1,27 @@
+#ifndef _RENDERER_STATE_H_
+#define _RENDERER_STATE_H_
+
+#include <SDL2/SDL.h>
+#include "X11/Xlib.h"
+
+/*
+ * A shadow of the render target, viewport, clip rect, draw color and draw blend mode of each renderer.
+ * Setting a state through these functions only calls SDL if it differs from the shadow.
+ * Every change of the state of a renderer has to go through them, or the shadow has to be
+ * invalidated with invalidateRendererState.
+ * Changing the target resets the viewport to the whole target, like SDL does.
+ */
+void initRendererState(void);
+Bool setRenderTarget(SDL_Renderer* renderer, SDL_Texture* texture);
+/* Set the viewport, NULL selects the whole target. */
+Bool setRenderViewport(SDL_Renderer* renderer, const SDL_Rect* viewPort);
+/* Set the clip rect relative to the viewport, NULL disables clipping. */
+Bool setRenderClipRect(SDL_Renderer* renderer, const SDL_Rect* clipRect);
+Bool setRenderDrawColor(SDL_Renderer* renderer, Uint8 red, Uint8 green, Uint8 blue, Uint8 alpha);
+Bool setRenderDrawBlendMode(SDL_Renderer* renderer, SDL_BlendMode blendMode);
+void invalidateRendererState(SDL_Renderer* renderer);
+/* Must be called before destroying a texture that may be a render target. */
+void forgetRenderTarget(SDL_Texture* texture);
+void freeRendererStateOfRenderer(SDL_Renderer* renderer);
+
+#endif /* _RENDERER_STATE_H_ */
@@ -0,0 +1,211 @@
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <string.h>
+#include "X11/Xlib.h"
+#include "X11/extensions/XShm.h"
+#include "shm.h"
+#include "errors.h"
+#include "display.h"
+#include "drawing.h"
+#include "events.h"
+#include "gc.h"
+#include "image.h"
+#include "pixelConversion.h"
+#include "pixmanBackend.h"
+#include "resourceTypes.h"
+#include "util.h"
+
+/*
+ * Get the segment the image was created in by XShmCreateImage and check that the data of the image
+ * lies inside of it. Returns NULL if the image is not a shared image or on errors.
+ */
+static XShmSegmentInfo* getImageSegment(Display* display, XImage* image, unsigned char minorCode) {
+    XShmSegmentInfo* shminfo = (XShmSegmentInfo*) image->obdata;
+    if (shminfo == NULL) {
+        LOG("Bad argument: The image was not created by XShmCreateImage\n");
+        return NULL;
+    }
+    if (!IS_TYPE(shminfo->shmseg, SHM_SEGMENT)) {
+        handleError(0, display, shminfo->shmseg, 0, SHM_FIRST_ERROR + BadShmSeg, minorCode);
+        return NULL;
+    }
+    ShmSegment* segment = GET_XID_VALUE(shminfo->shmseg);
+    size_t size = (size_t) image->bytes_per_line * image->height * (image->format == ZPixmap ? 1 : image->depth);
+    if (image->data < segment->address || (size_t) (image->data - segment->address) + size > segment->size) {
+        LOG("Bad argument: The image does not fit into the shared memory segment\n");
+        handleError(0, display, shminfo->shmseg, 0, BadValue, minorCode);
+        return NULL;
+    }
+    return shminfo;
+}
+
+static void postCompletionEvent(Display* display, Drawable drawable, XShmSegmentInfo* shminfo, XImage* image) {
+    XShmCompletionEvent* event = calloc(1, sizeof(XEvent));
+    if (event == NULL) {
+        handleOutOfMemory(0, display, 0, X_ShmPutImage);
+        return;
+    }
+    event->type = SHM_FIRST_EVENT + ShmCompletion;
+    event->drawable = drawable;
+    event->major_code = SHM_MAJOR_OPCODE;
+    event->minor_code = X_ShmPutImage;
+    event->shmseg = shminfo->shmseg;
+    event->offset = (unsigned long) (image->data - shminfo->shmaddr);
+    if (!enqueueEvent(display, drawable, event)) {
+        free(event);
+    }
+}
+
+Bool XShmQueryExtension(Display* display) {
+    // https://www.x.org/releases/current/doc/xextproto/shm.html
+    return True;
+}
+
+int XShmGetEventBase(Display* display) {
+    return SHM_FIRST_EVENT;
+}
+
+Bool XShmQueryVersion(Display* display, int* majorVersion, int* minorVersion, Bool* sharedPixmaps) {
+    SET_X_SERVER_REQUEST(display, SHM_MAJOR_OPCODE);
+    *majorVersion = SHM_MAJOR_VERSION;
+    *minorVersion = SHM_MINOR_VERSION;
+    *sharedPixmaps = False;
+    return True;
+}
+
+int XShmPixmapFormat(Display* display) {
+    // Shared pixmaps are not supported.
+    return 0;
+}
+
+Bool XShmAttach(Display* display, XShmSegmentInfo* shminfo) {
+    SET_X_SERVER_REQUEST(display, SHM_MAJOR_OPCODE);
+    LOG("%s: Attaching segment %d at %p\n", __func__, shminfo->shmid, shminfo->shmaddr);
+    struct shmid_ds status;
+    if (shminfo->shmaddr == NULL || shmctl(shminfo->shmid, IPC_STAT, &status) != 0) {
+        LOG("Bad argument: Segment %d is not mapped or does not exist in %s\n", shminfo->shmid, __func__);
+        handleError(0, display, None, 0, BadAccess, X_ShmAttach);
+        return False;
+    }
+    XID segmentId = ALLOC_XID();
+    ShmSegment* segment = malloc(sizeof(ShmSegment));
+    if (segmentId == None || segment == NULL) {
+        if (segmentId != None) { FREE_XID(segmentId); }
+        free(segment);
+        handleOutOfMemory(0, display, 0, X_ShmAttach);
+        return False;
+    }
+    segment->shmid = shminfo->shmid;
+    segment->address = shminfo->shmaddr;
+    segment->size = status.shm_segsz;
+    segment->readOnly = shminfo->readOnly;
+    SET_XID_TYPE(segmentId, SHM_SEGMENT);
+    SET_XID_VALUE(segmentId, segment);
+    shminfo->shmseg = segmentId;
+    return True;
+}
+
+Bool XShmDetach(Display* display, XShmSegmentInfo* shminfo) {
+    SET_X_SERVER_REQUEST(display, SHM_MAJOR_OPCODE);
+    if (!IS_TYPE(shminfo->shmseg, SHM_SEGMENT)) {
+        handleError(0, display, shminfo->shmseg, 0, SHM_FIRST_ERROR + BadShmSeg, X_ShmDetach);
+        return False;
+    }
+    free(GET_XID_VALUE(shminfo->shmseg));
+    FREE_XID(shminfo->shmseg);
+    shminfo->shmseg = None;
+    return True;
+}
+
+static int destroyShmImage(XImage* image) {
+    // The data belongs to the shared memory segment of the client.
+    free(image);
+    return 1;
+}
+
+XImage* XShmCreateImage(Display* display, Visual* visual, unsigned int depth, int format, char* data,
+                        XShmSegmentInfo* shminfo, unsigned int width, unsigned int height) {
+    XImage* image = XCreateImage(display, visual, depth, format, 0, data, width, height, 32, 0);
+    if (image == NULL) { return NULL; }
+    image->obdata = (XPointer) shminfo;
+    image->f.destroy_image = destroyShmImage;
+    return image;
+}
+
+Bool XShmPutImage(Display* display, Drawable drawable, GC gc, XImage* image, int src_x, int src_y,
+                  int dst_x, int dst_y, unsigned int src_width, unsigned int src_height, Bool send_event) {
+    SET_X_SERVER_REQUEST(display, SHM_MAJOR_OPCODE);
+    TYPE_CHECK(drawable, DRAWABLE, display, False);
+    LOG("%s: Drawing %p on %lu\n", __func__, image, drawable);
+    XShmSegmentInfo* shminfo = getImageSegment(display, image, X_ShmPutImage);
+    if (shminfo == NULL) { return False; }
+    SDL_Rect rect = {src_x, src_y, (int) src_width, (int) src_height};
+    SDL_Rect imageRect = {0, 0, image->width, image->height};
+    SDL_Rect destRect;
+    GraphicContext* gContext = GET_GC(gc);
+    ClipIterator clip;
+    Bool visible = SDL_IntersectRect(&rect, &imageRect, &rect);
+    if (visible) {
+        destRect = (SDL_Rect) {dst_x + rect.x - src_x, dst_y + rect.y - src_y, rect.w, rect.h};
+        visible = initClipIterator(&clip, drawable, gContext, &destRect);
+    }
+    if (visible) {
+        clipImageRects(&clip, &rect, &destRect);
+        PixelConversion conversion;
+        if (!initPixelConversion(&conversion, image, gContext->foreground, gContext->background,
+                                 getDrawableColormap(drawable))) {
+            handleError(0, display, drawable, 0, BadMatch, X_ShmPutImage);
+            return False;
+        }
+        if (beginSoftwareDrawing(drawable, gContext, &destRect, None, NULL)) {
+            // The pixman backend composites straight from the segment.
+            Bool put = pixmanPutImage(drawable, gContext, &clip, image, &conversion, rect.x, rect.y,
+                                      destRect.x, destRect.y, (unsigned int) rect.w, (unsigned int) rect.h);
+            endSoftwareDrawing();
+            if (!put) {
+                handleError(0, display, drawable, 0, BadDrawable, X_ShmPutImage);
+                return False;
+            }
+        } else {
+            SDL_Renderer* renderer = NULL;
+            GET_RENDERER(drawable, renderer);
+            if (renderer == NULL || !uploadImage(renderer, image, &conversion, &rect, &destRect, &clip)) {
+                LOG("Failed to upload the image in %s: %s\n", __func__, SDL_GetError());
+                handleError(0, display, drawable, 0, BadDrawable, X_ShmPutImage);
+                return False;
+            }
+        }
+        damageDrawable(drawable, destRect.x, destRect.y, destRect.w, destRect.h);
+    }
+    if (send_event) {
+        postCompletionEvent(display, drawable, shminfo, image);
+    }
+    return True;
+}
+
+Bool XShmGetImage(Display* display, Drawable drawable, XImage* image, int x, int y, unsigned long plane_mask) {
+    SET_X_SERVER_REQUEST(display, SHM_MAJOR_OPCODE);
+    TYPE_CHECK(drawable, DRAWABLE, display, False);
+    LOG("%s: From %lu\n", __func__, drawable);
+    if (getImageSegment(display, image, X_ShmGetImage) == NULL) { return False; }
+    if (image->format != ZPixmap && image->format != XYPixmap) {
+        handleError(0, display, None, 0, BadValue, X_ShmGetImage);
+        return False;
+    }
+    if (image->depth != getDrawableDepth(drawable)) {
+        LOG("Bad argument: The depth of the image does not match the drawable in %s\n", __func__);
+        handleError(0, display, drawable, 0, BadMatch, X_ShmGetImage);
+        return False;
+    }
+    if (!checkReadableArea(display, drawable, x, y, (unsigned int) image->width, (unsigned int) image->height)) {
+        return False;
+    }
+    // The pixels are written straight into the shared segment.
+    return readDrawableImage(display, drawable, x, y, image, plane_mask);
+}
+
+Pixmap XShmCreatePixmap(Display* display, Drawable drawable, char* data, XShmSegmentInfo* shminfo,
+                        unsigned int width, unsigned int height, unsigned int depth) {
+    WARN_UNIMPLEMENTED;
+    return None;
+}
@@ -0,0 +1,31 @@
+#ifndef _SHM_H_INTERNAL_
+#define _SHM_H_INTERNAL_
+
+#include "X11/Xlib.h"
+#include "X11/extensions/shm.h"
+
+/*
+ * The emulated MIT-SHM extension. The server shares the address space of the client,
+ * so the images are read from and written into the shared segments of the client directly.
+ */
+#define SHM_MAJOR_OPCODE 130
+#define SHM_FIRST_EVENT LASTEvent
+#define SHM_FIRST_ERROR FirstExtensionError
+
+/* The minor opcodes of the requests. */
+#define X_ShmQueryVersion 0
+#define X_ShmAttach 1
+#define X_ShmDetach 2
+#define X_ShmPutImage 3
+#define X_ShmGetImage 4
+#define X_ShmCreatePixmap 5
+
+typedef struct {
+    int shmid;
+    /* The address of the segment in the client and the size the kernel reports for it. */
+    char* address;
+    size_t size;
+    Bool readOnly;
+} ShmSegment;
+
+#endif /* _SHM_H_INTERNAL_ */
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "statistics.h"
+#include "glyphAtlas.h"
+#include "font.h"
+
+Statistics statistics;
+
+typedef enum {StatisticsDisabled, StatisticsSummary, StatisticsFrames} StatisticsOutput;
+static StatisticsOutput statisticsOutput = StatisticsDisabled;
+/* The renderer state change counters at the end of the previous frame. */
+static unsigned long previousStateChanges = 0;
+static unsigned long previousStateChangesSkipped = 0;
+/* The pixels composited since the end of the previous frame. */
+static unsigned long framePixelsComposited = 0;
+
+void initStatistics() {
+    memset(&statistics, 0, sizeof(statistics));
+    previousStateChanges = previousStateChangesSkipped = 0;
+    framePixelsComposited = 0;
+    const char* output = getenv("SDL2X11_STATISTICS");
+    if (output == NULL || output[0] == '\0' || strcmp(output, "0") == 0) {
+        statisticsOutput = StatisticsDisabled;
+    } else if (strcmp(output, "frames") == 0) {
+        statisticsOutput = StatisticsFrames;
+    } else {
+        statisticsOutput = StatisticsSummary;
+    }
+}
+
+void recordPresentedFrame(unsigned long pixelsPresented) {
+    statistics.frames++;
+    statistics.pixelsPresented += pixelsPresented;
+    statistics.lastFramePixelsPresented = pixelsPresented;
+    if (pixelsPresented > statistics.maxFramePixelsPresented) {
+        statistics.maxFramePixelsPresented = pixelsPresented;
+    }
+    statistics.pixelsComposited += framePixelsComposited;
+    statistics.lastFramePixelsComposited = framePixelsComposited;
+    if (framePixelsComposited > statistics.maxFramePixelsComposited) {
+        statistics.maxFramePixelsComposited = framePixelsComposited;
+    }
+    if (statisticsOutput == StatisticsFrames) {
+        fprintf(stderr, "[SDL2X11] Frame %lu: %lu pixels presented, %lu pixels composited, "
+                "%lu renderer state changes (%lu skipped)\n",
+                statistics.frames, pixelsPresented, framePixelsComposited,
+                statistics.rendererStateChanges - previousStateChanges,
+                statistics.rendererStateChangesSkipped - previousStateChangesSkipped);
+    }
+    previousStateChanges = statistics.rendererStateChanges;
+    previousStateChangesSkipped = statistics.rendererStateChangesSkipped;
+    framePixelsComposited = 0;
+}
+
+void recordCompositedPixels(unsigned long pixels) {
+    framePixelsComposited += pixels;
+}
+
+void printStatistics() {
+    if (statisticsOutput == StatisticsDisabled) { return; }
+    fprintf(stderr, "[SDL2X11] Statistics:\n");
+    fprintf(stderr, "[SDL2X11]   Frames presented: %lu\n", statistics.frames);
+    fprintf(stderr, "[SDL2X11]   Pixels presented: %llu (%llu per frame, max %lu)\n",
+            (unsigned long long) statistics.pixelsPresented,
+            statistics.frames == 0 ? 0ULL :
+            (unsigned long long) statistics.pixelsPresented / statistics.frames,
+            statistics.maxFramePixelsPresented);
+    fprintf(stderr, "[SDL2X11]   Pixels composited: %llu (%llu per frame, max %lu)\n",
+            (unsigned long long) statistics.pixelsComposited,
+            statistics.frames == 0 ? 0ULL :
+            (unsigned long long) statistics.pixelsComposited / statistics.frames,
+            statistics.maxFramePixelsComposited);
+    unsigned long glyphLookups = statistics.glyphAtlasHits + statistics.glyphAtlasMisses;
+    fprintf(stderr, "[SDL2X11]   Glyph atlas: %lu hits, %lu misses (%.1f%% hit rate), %lu evictions\n",
+            statistics.glyphAtlasHits, statistics.glyphAtlasMisses,
+            glyphLookups == 0 ? 0.0 : 100.0 * statistics.glyphAtlasHits / glyphLookups,
+            statistics.glyphAtlasEvictions);
+    fprintf(stderr, "[SDL2X11]   Glyph atlas pages: %lu (%.1f%% occupied)\n", statistics.glyphAtlasPages,
+            statistics.glyphAtlasPages == 0 ? 0.0 : 100.0 * statistics.glyphAtlasPixelsUsed
+                    / (statistics.glyphAtlasPages * GLYPH_ATLAS_PAGE_SIZE * GLYPH_ATLAS_PAGE_SIZE));
+    fprintf(stderr, "[SDL2X11]   Font instances: %lu live, %lu loads shared an instance\n",
+            statistics.fontInstances, statistics.fontInstanceHits);
+    printFontInstanceStatistics();
+    unsigned long textureUploads = statistics.texturePoolHits + statistics.texturePoolMisses;
+    fprintf(stderr, "[SDL2X11]   Texture pool: %lu hits, %lu misses (%.1f%% hit rate), %lu evictions\n",
+            statistics.texturePoolHits, statistics.texturePoolMisses,
+            textureUploads == 0 ? 0.0 : 100.0 * statistics.texturePoolHits / textureUploads,
+            statistics.texturePoolEvictions);
+    fprintf(stderr, "[SDL2X11]   Texture pool textures: %lu (%.1f MiB)\n", statistics.texturePoolTextures,
+            statistics.texturePoolBytes / (1024.0 * 1024.0));
+    fprintf(stderr, "[SDL2X11]   Rasterized shapes: %lu as %lu rectangles\n",
+            statistics.rasterizedShapes, statistics.rasterizedRectangles);
+    unsigned long stateChanges = statistics.rendererStateChanges + statistics.rendererStateChangesSkipped;
+    fprintf(stderr, "[SDL2X11]   Renderer state changes: %lu issued, %lu skipped (%.1f%%)\n",
+            statistics.rendererStateChanges, statistics.rendererStateChangesSkipped,
+            stateChanges == 0 ? 0.0 : 100.0 * statistics.rendererStateChangesSkipped / stateChanges);
+    fprintf(stderr, "[SDL2X11]   Operations clipped away: %lu\n", statistics.clippedOperations);
+    fprintf(stderr, "[SDL2X11]   Raster operations on textures: %lu, %llu pixels read back\n",
+            statistics.rasterOpOperations, (unsigned long long) statistics.rasterOpPixelsReadBack);
+}
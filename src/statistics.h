@@ -0,0 +1,69 @@
+#ifndef _STATISTICS_H_
+#define _STATISTICS_H_
+
+#include <SDL2/SDL.h>
+#include "X11/Xlib.h"
+
+/*
+ * Counters about the work done by the emulation.
+ * They are always collected, set SDL2X11_STATISTICS to print them
+ * when the display is closed or to "frames" to also print every frame.
+ */
+typedef struct {
+    /* The number of frames, a frame is a flush that presented at least one window. */
+    unsigned long frames;
+    /* The number of pixels uploaded to the screen over all frames. */
+    Uint64 pixelsPresented;
+    /* The number of pixels uploaded to the screen in the last frame. */
+    unsigned long lastFramePixelsPresented;
+    /* The largest number of pixels uploaded to the screen in one frame. */
+    unsigned long maxFramePixelsPresented;
+    /* The number of pixels the compositor copied from window images into frames, over all frames and in the last and largest frame. */
+    Uint64 pixelsComposited;
+    unsigned long lastFramePixelsComposited;
+    unsigned long maxFramePixelsComposited;
+    /* The number of glyphs that were found in a glyph atlas. */
+    unsigned long glyphAtlasHits;
+    /* The number of glyphs that had to be rendered and added to a glyph atlas. */
+    unsigned long glyphAtlasMisses;
+    /* The number of glyph atlas pages that were evicted to make room for new glyphs. */
+    unsigned long glyphAtlasEvictions;
+    /* The number of glyph atlas pages that currently exist. */
+    unsigned long glyphAtlasPages;
+    /* The number of pixels of the existing glyph atlas pages that hold glyphs. */
+    unsigned long glyphAtlasPixelsUsed;
+    /* The number of opened fonts, see FontInstance in font.c. */
+    unsigned long fontInstances;
+    /* The number of times XLoadFont could share an already opened font. */
+    unsigned long fontInstanceHits;
+    /* The number of transient uploads that could reuse a texture of the texture pool. */
+    unsigned long texturePoolHits;
+    /* The number of transient uploads that had to create a texture for the texture pool. */
+    unsigned long texturePoolMisses;
+    /* The number of idle pool textures that were freed by trimming or to stay inside of the pool size. */
+    unsigned long texturePoolEvictions;
+    /* The number of textures that currently exist in the texture pool and their size in bytes. */
+    unsigned long texturePoolTextures;
+    unsigned long texturePoolBytes;
+    /* The number of shapes filled or stroked by the scanline rasterizer and the rectangles they became. */
+    unsigned long rasterizedShapes;
+    unsigned long rasterizedRectangles;
+    /* The number of renderer state changes that were issued to SDL or skipped because they changed nothing. */
+    unsigned long rendererStateChanges;
+    unsigned long rendererStateChangesSkipped;
+    /* The number of drawing operations that were clipped away entirely by their graphic context. */
+    unsigned long clippedOperations;
+    /* The number of texture drawing operations that used the raster operation kernels and the pixels they read back. */
+    unsigned long rasterOpOperations;
+    Uint64 rasterOpPixelsReadBack;
+} Statistics;
+
+extern Statistics statistics;
+
+void initStatistics(void);
+void recordPresentedFrame(unsigned long pixelsPresented);
+/* Add pixels the compositor copied to the current frame. */
+void recordCompositedPixels(unsigned long pixels);
+void printStatistics(void);
+
+#endif /* _STATISTICS_H_ */
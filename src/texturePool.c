@@ -0,0 +1,179 @@
+#include <stdlib.h>
+#include <string.h>
+#include "texturePool.h"
+#include "statistics.h"
+#include "util.h"
+
+#define DEFAULT_TEXTURE_POOL_SIZE 64
+/* The smallest size class is 32 pixels. */
+#define MIN_SIZE_CLASS 5
+#define MAX_SIZE_CLASS 14
+
+typedef struct PoolTexture {
+    SDL_Renderer* renderer;
+    SDL_Texture* texture;
+    Uint32 format;
+    int widthClass, heightClass;
+    size_t size;
+    Bool inUse;
+    /* Set if the texture was acquired since the last trim. */
+    Bool used;
+    unsigned long lastUsed;
+    struct PoolTexture* next;
+} PoolTexture;
+
+static PoolTexture* poolTextures = NULL;
+static size_t maxIdleBytes = DEFAULT_TEXTURE_POOL_SIZE * 1024 * 1024;
+static size_t idleBytes = 0;
+static unsigned long useCounter = 0;
+static int framesSinceTrim = 0;
+
+void initTexturePool() {
+    const char* poolSize = getenv("SDL2X11_TEXTURE_POOL_SIZE");
+    maxIdleBytes = DEFAULT_TEXTURE_POOL_SIZE * 1024 * 1024;
+    if (poolSize != NULL && poolSize[0] != '\0') {
+        maxIdleBytes = (size_t) MAX(0, atoi(poolSize)) * 1024 * 1024;
+    }
+    LOG("The texture pool is limited to %lu bytes of idle textures\n", (unsigned long) maxIdleBytes);
+}
+
+static int getSizeClass(int size) {
+    int sizeClass = MIN_SIZE_CLASS;
+    while (sizeClass < MAX_SIZE_CLASS && (1 << sizeClass) < size) {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+/* Unlink the texture from the pool and destroy it. */
+static void freePoolTexture(PoolTexture** link) {
+    PoolTexture* poolTexture = *link;
+    *link = poolTexture->next;
+    if (!poolTexture->inUse) {
+        idleBytes -= poolTexture->size;
+    }
+    statistics.texturePoolTextures--;
+    statistics.texturePoolBytes -= poolTexture->size;
+    SDL_DestroyTexture(poolTexture->texture);
+    free(poolTexture);
+}
+
+/* Free the least recently used idle textures until the idle textures fit into the pool. */
+static void evictIdleTextures() {
+    while (idleBytes > maxIdleBytes) {
+        PoolTexture** oldest = NULL;
+        PoolTexture** link;
+        for (link = &poolTextures; *link != NULL; link = &(*link)->next) {
+            if (!(*link)->inUse && (oldest == NULL || (*link)->lastUsed < (*oldest)->lastUsed)) {
+                oldest = link;
+            }
+        }
+        if (oldest == NULL) { return; }
+        freePoolTexture(oldest);
+        statistics.texturePoolEvictions++;
+    }
+}
+
+SDL_Texture* acquirePoolTexture(SDL_Renderer* renderer, Uint32 format, int width, int height) {
+    if (width > (1 << MAX_SIZE_CLASS) || height > (1 << MAX_SIZE_CLASS)) {
+        LOG("%dx%d pixels are too large for the texture pool\n", width, height);
+        return NULL;
+    }
+    int widthClass = getSizeClass(width);
+    int heightClass = getSizeClass(height);
+    PoolTexture* poolTexture;
+    for (poolTexture = poolTextures; poolTexture != NULL; poolTexture = poolTexture->next) {
+        if (!poolTexture->inUse && poolTexture->renderer == renderer && poolTexture->format == format
+            && poolTexture->widthClass == widthClass && poolTexture->heightClass == heightClass) {
+            break;
+        }
+    }
+    if (poolTexture != NULL) {
+        statistics.texturePoolHits++;
+        idleBytes -= poolTexture->size;
+    } else {
+        statistics.texturePoolMisses++;
+        poolTexture = calloc(1, sizeof(PoolTexture));
+        if (poolTexture == NULL) { return NULL; }
+        poolTexture->texture = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_STREAMING,
+                                                 1 << widthClass, 1 << heightClass);
+        if (poolTexture->texture == NULL) {
+            LOG("SDL_CreateTexture failed in %s: %s\n", __func__, SDL_GetError());
+            free(poolTexture);
+            return NULL;
+        }
+        poolTexture->renderer = renderer;
+        poolTexture->format = format;
+        poolTexture->widthClass = widthClass;
+        poolTexture->heightClass = heightClass;
+        poolTexture->size = (size_t) SDL_BYTESPERPIXEL(format) << (widthClass + heightClass);
+        poolTexture->next = poolTextures;
+        poolTextures = poolTexture;
+        statistics.texturePoolTextures++;
+        statistics.texturePoolBytes += poolTexture->size;
+    }
+    poolTexture->inUse = True;
+    poolTexture->used = True;
+    poolTexture->lastUsed = ++useCounter;
+    return poolTexture->texture;
+}
+
+void releasePoolTexture(SDL_Texture* texture) {
+    PoolTexture* poolTexture;
+    for (poolTexture = poolTextures; poolTexture != NULL; poolTexture = poolTexture->next) {
+        if (poolTexture->texture == texture) { break; }
+    }
+    if (poolTexture == NULL || !poolTexture->inUse) {
+        LOG("Texture %p was not acquired from the texture pool\n", texture);
+        return;
+    }
+    poolTexture->inUse = False;
+    idleBytes += poolTexture->size;
+    evictIdleTextures();
+}
+
+SDL_Texture* uploadToPoolTexture(SDL_Renderer* renderer, Uint32 format, const void* pixels, int pitch,
+                                 int width, int height) {
+    SDL_Texture* texture = acquirePoolTexture(renderer, format, width, height);
+    if (texture == NULL) { return NULL; }
+    SDL_Rect rect = {0, 0, width, height};
+    void* texturePixels;
+    int texturePitch, y;
+    if (SDL_LockTexture(texture, &rect, &texturePixels, &texturePitch) != 0) {
+        LOG("SDL_LockTexture failed in %s: %s\n", __func__, SDL_GetError());
+        releasePoolTexture(texture);
+        return NULL;
+    }
+    size_t rowSize = (size_t) width * SDL_BYTESPERPIXEL(format);
+    for (y = 0; y < height; y++) {
+        memcpy((Uint8*) texturePixels + y * texturePitch, (const Uint8*) pixels + y * pitch, rowSize);
+    }
+    SDL_UnlockTexture(texture);
+    return texture;
+}
+
+void trimTexturePool() {
+    if (++framesSinceTrim < TEXTURE_POOL_TRIM_FRAMES) { return; }
+    framesSinceTrim = 0;
+    PoolTexture** link = &poolTextures;
+    while (*link != NULL) {
+        if (!(*link)->inUse && !(*link)->used) {
+            freePoolTexture(link);
+            statistics.texturePoolEvictions++;
+        } else {
+            (*link)->used = False;
+            link = &(*link)->next;
+        }
+    }
+}
+
+void freeTexturePoolOfRenderer(SDL_Renderer* renderer) {
+    PoolTexture** link = &poolTextures;
+    while (*link != NULL) {
+        if ((*link)->renderer == renderer) {
+            freePoolTexture(link);
+        } else {
+            link = &(*link)->next;
+        }
+    }
+}
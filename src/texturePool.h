@@ -0,0 +1,32 @@
+#ifndef _TEXTURE_POOL_H_
+#define _TEXTURE_POOL_H_
+
+#include <SDL2/SDL.h>
+#include "X11/Xlib.h"
+
+/*
+ * The texture pool keeps the streaming textures that transient uploads (images, text that missed
+ * the glyph atlas, areas copied between renderers) are locked and drawn through.
+ * Textures are bucketed by power of two size classes of their width and height, per renderer
+ * and pixel format. The pool holds at most SDL2X11_TEXTURE_POOL_SIZE MiB (default 64) of idle
+ * textures, and every TEXTURE_POOL_TRIM_FRAMES frames it is trimmed to the high water mark of
+ * the textures that were used since the last trim.
+ */
+#define TEXTURE_POOL_TRIM_FRAMES 120
+
+void initTexturePool(void);
+/*
+ * Get an idle texture of the renderer that is at least width x height pixels large,
+ * only the top left width x height pixels should be locked and drawn.
+ * The texture has to be released with releasePoolTexture after drawing it.
+ */
+SDL_Texture* acquirePoolTexture(SDL_Renderer* renderer, Uint32 format, int width, int height);
+void releasePoolTexture(SDL_Texture* texture);
+/* Get a pool texture with a copy of the pixels in its top left corner. */
+SDL_Texture* uploadToPoolTexture(SDL_Renderer* renderer, Uint32 format, const void* pixels, int pitch,
+                                 int width, int height);
+/* Count a presented frame and trim the pool if a trim period has ended. */
+void trimTexturePool(void);
+void freeTexturePoolOfRenderer(SDL_Renderer* renderer);
+
+#endif /* _TEXTURE_POOL_H_ */
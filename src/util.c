@@ -81,51 +81,26 @@ void freeArray(Array* a) {
 
 Bool matchWildcard(const char* wildcard, const char* string) {
     if (wildcard == NULL || string == NULL) return False;
-    ssize_t lastStar = -1;
-    size_t stringIndex = 0;
-    size_t wildcardIndex = 0;
-    int numCharsNeeded;
-    for (; wildcard[wildcardIndex] != '\0'; wildcardIndex++) {
-        switch (wildcard[wildcardIndex]) {
-            case '*': // TODO: Tis fails for "*ab??" -> "bla-abab--", don't reinvent the wheel and use some code from SO.
-                // Find next character to match
-                lastStar = wildcardIndex;
-                numCharsNeeded = 0;
-                while (True) {
-                    wildcardIndex++;
-                    if (wildcard[wildcardIndex] == '?') {
-                        numCharsNeeded++;
-                    } else if (wildcard[wildcardIndex] == '\0') {
-                        // We have a wildcard with a '*' at the end
-                        return strlen(&string[stringIndex]) >= numCharsNeeded;
-                    } else if (wildcard[wildcardIndex] == '*') {
-                        continue;
-                    } else {
-                        break;
-                    }
-                }
-                while (numCharsNeeded-- > 0 || wildcard[wildcardIndex] != string[stringIndex]) {
-                    if (string[stringIndex] == '\0') return False;
-                    stringIndex++;
-                }
-                break;
-            case '?':
-                if (string[stringIndex] == '\0') {
-                    return False;
-                }
-                break;
-            default:
-                if (wildcard[wildcardIndex] != string[stringIndex]) {
-                    if (string[stringIndex] != '\0' && lastStar != -1) {
-                        wildcardIndex = (size_t) lastStar;
-                    } else {
-                        return False;
-                    }
-                }
+    // The position after the last '*' and the position in the string where its match ends.
+    const char* starWildcard = NULL;
+    const char* starString = NULL;
+    while (*string != '\0') {
+        if (*wildcard == '*') {
+            starWildcard = ++wildcard;
+            starString = string;
+        } else if (*wildcard == '?' || *wildcard == *string) {
+            wildcard++;
+            string++;
+        } else if (starWildcard != NULL) {
+            // Let the last '*' match one more character and try again
+            wildcard = starWildcard;
+            string = ++starString;
+        } else {
+            return False;
         }
-        stringIndex++;
     }
-    return True;
+    while (*wildcard == '*') wildcard++;
+    return *wildcard == '\0';
 }
 
 
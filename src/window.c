@@ -2,11 +2,15 @@
 #include "window.h"
 #include "errors.h"
 #include "drawing.h"
+#include "glyphAtlas.h"
+#include "fillPattern.h"
+#include "texturePool.h"
 #include "atoms.h"
 #include "events.h"
 #include "display.h"
 #include "visual.h"
 #include "input.h"
+#include "compositor.h"
 
 // TODO: Cover cases where top-level window is re-parented and window is converted to top-level window
 
@@ -15,7 +19,14 @@ int XDestroyWindow(Display* display, Window window) {
     SET_X_SERVER_REQUEST(display, X_DestroyWindow);
     TYPE_CHECK(window, WINDOW, display, 0);
     if (window == SCREEN_WINDOW) return 0;
+    WindowStruct* windowStruct = GET_WINDOW_STRUCT(window);
+    Window parent = windowStruct->parent;
+    Bool wasComposited = compositorEnabled && !IS_TOP_LEVEL(window) && windowStruct->mapState == Mapped;
+    SDL_Rect area = {windowStruct->x, windowStruct->y, (int) windowStruct->w, (int) windowStruct->h};
     destroyWindow(display, window, True);
+    if (wasComposited) {
+        damageDrawable(parent, area.x, area.y, (unsigned int) area.w, (unsigned int) area.h);
+    }
     return 1;
 }
 
@@ -148,7 +159,10 @@ int XSetTransientForHint(Display* display, Window window, Window prop_window) {
 
 int XMapRaised(Display* display, Window window) {
     // https://tronche.com/gui/x/xlib/window/XMapRaised.html
-    // TODO: raise the specified window to the top of the stack
+    TYPE_CHECK(window, WINDOW, display, 0);
+    if (window != SCREEN_WINDOW) {
+        restackWindow(window, True);
+    }
     return XMapWindow(display, window);
 }
 
@@ -205,7 +219,7 @@ int XMapWindow(Display* display, Window window) {
                     SDL_DestroyRenderer(newRenderer);
                     return 0;
                 }
-                //SDL_RenderPresent(newRenderer);
+                forgetRenderTarget(windowTexture);
                 SDL_DestroyTexture(windowTexture);
                 SDL_DestroyTexture(oldWindowTexture);
                 windowStruct->sdlRenderer = newRenderer;
@@ -214,6 +228,7 @@ int XMapWindow(Display* display, Window window) {
         }
         windowStruct->sdlWindow = sdlWindow;
         windowStruct->mapState = Mapped;
+        markDrawableDirty(window);
         if (windowStruct->windowName != NULL) {
             free(windowStruct->windowName);
             windowStruct->windowName = NULL;
@@ -253,9 +268,13 @@ int XMapWindow(Display* display, Window window) {
     }
     postEvent(display, window, MapNotify);
     mapRequestedChildren(display, window);
+    if (compositorEnabled) {
+        // The window and its children are recomposited from their kept images.
+        markDrawableDirty(window);
+    }
 
     WindowStruct* windowStruct = GET_WINDOW_STRUCT(window);
-    SDL_Rect exposeRect = {windowStruct->x, windowStruct->y, windowStruct->w, windowStruct->h};
+    SDL_Rect exposeRect = {0, 0, windowStruct->w, windowStruct->h};
     postExposeEvent(display, window, &exposeRect, 1);
 
     //SDL_UpdateWindowSurface(GET_WINDOW_STRUCT(window)->sdlWindow);
@@ -282,9 +301,19 @@ int XUnmapWindow(Display* display, Window window) {
         windowStruct->sdlWindow = NULL;
         SDL_DestroyWindow(sdlWindow);
         if (windowStruct->sdlRenderer != NULL) {
+            freeGlyphAtlasesOfRenderer(windowStruct->sdlRenderer);
+            freeFillPatternsOfRenderer(windowStruct->sdlRenderer);
+            freeTexturePoolOfRenderer(windowStruct->sdlRenderer);
+            freeRendererStateOfRenderer(windowStruct->sdlRenderer);
             SDL_DestroyRenderer(windowStruct->sdlRenderer);
             windowStruct->sdlRenderer = NULL;
         }
+        pixman_region_fini(&windowStruct->damage);
+        pixman_region_init(&windowStruct->damage);
+    } else if (compositorEnabled && GET_WINDOW_STRUCT(GET_PARENT(window))->mapState != UnMapped) {
+        // The compositor kept the content of the parent, it doesn't have to be exposed.
+        postEvent(display, window, UnmapNotify, False);
+        damageDrawable(GET_PARENT(window), windowStruct->x, windowStruct->y, windowStruct->w, windowStruct->h);
     } else if (GET_WINDOW_STRUCT(GET_PARENT(window))->mapState != UnMapped) {
         postEvent(display, window, UnmapNotify, False);
         SDL_Rect exposeRect = {windowStruct->x, windowStruct->y, windowStruct->w, windowStruct->h};
@@ -701,10 +730,20 @@ int XRaiseWindow(Display* display, Window window) {
     // https://tronche.com/gui/x/xlib/window/XRaiseWindow.html
     SET_X_SERVER_REQUEST(display, X_ConfigureWindow);
     TYPE_CHECK(window, WINDOW, display, 0);
+    if (window == SCREEN_WINDOW) { return 1; }
     if (IS_MAPPED_TOP_LEVEL_WINDOW(window)) {
         SDL_RaiseWindow(GET_WINDOW_STRUCT(window)->sdlWindow);
     }
-    // TODO: Rearrange child in child list of parent.
+    restackWindow(window, True);
+    return 1;
+}
+
+int XLowerWindow(Display* display, Window window) {
+    // https://tronche.com/gui/x/xlib/window/XLowerWindow.html
+    SET_X_SERVER_REQUEST(display, X_ConfigureWindow);
+    TYPE_CHECK(window, WINDOW, display, 0);
+    if (window == SCREEN_WINDOW) { return 1; }
+    restackWindow(window, False);
     return 1;
 }
 
@@ -757,7 +796,14 @@ int XSetWindowBackground(Display* display, Window window, unsigned long backgrou
             handleError(0, display, window, 0, BadMatch, 0);
             return 0;
         }
-        GET_WINDOW_STRUCT(window)->backgroundColor = background_pixel;
+        WindowStruct* windowStruct = GET_WINDOW_STRUCT(window);
+        windowStruct->backgroundColor = background_pixel;
+        // The background pixel replaces the background pixmap.
+        if (windowStruct->background != ParentRelative && windowStruct->background != None) {
+            XFreePixmap(display, windowStruct->background);
+        }
+        windowStruct->background = None;
+        windowStruct->hasBackgroundPixel = True;
     }
     return 1;
 }
@@ -774,16 +820,21 @@ int XSetWindowBackgroundPixmap(Display* display, Window window, Pixmap backgroun
             return 0;
         }
         Pixmap previous = windowStruct->background;
-        if (background_pixmap == (Pixmap) ParentRelative) {
-            windowStruct->background = GET_PARENT(window) == None ? None :
-                                             GET_WINDOW_STRUCT(GET_PARENT(window))->background;
+        if (background_pixmap == (Pixmap) ParentRelative || background_pixmap == None) {
+            windowStruct->background = background_pixmap;
         } else {
             TYPE_CHECK(background_pixmap, PIXMAP, display, 0);
-            windowStruct->background = background_pixmap;
+            // The client may free the pixmap right away, so the window keeps its own copy.
+            windowStruct->background = copyPixmap(display, background_pixmap);
+            if (windowStruct->background == None) {
+                windowStruct->background = previous;
+                return 0;
+            }
         }
-        if (previous != None) {
+        if (previous != ParentRelative && previous != None) {
             XFreePixmap(display, previous);
         }
+        windowStruct->hasBackgroundPixel = False;
     }
     return 1;
 }
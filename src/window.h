@@ -2,6 +2,7 @@
 #define _WINDOW_H_
 
 #include <SDL2/SDL.h>
+#include <pixman.h>
 #include "windowDebug.h"
 #include "resourceTypes.h"
 #include "util.h"
@@ -30,6 +31,19 @@ typedef struct {
     SDL_Window* sdlWindow;
     /* The renderer of this window. Only set if sdlWindow or sdlTexture is set. */
     SDL_Renderer* sdlRenderer;
+    /*
+     * The drawing target of the window and its children if the pixman backend is used.
+     * Only set for top level windows and unmapped windows, or for every window with the compositor.
+     */
+    pixman_image_t* backingImage;
+    /* The top level window composited with its children, only used by the compositor. */
+    pixman_image_t* frameImage;
+    /*
+     * The area of the window that was drawn to since it was last presented,
+     * relative to the window. Only used for mapped top level windows, the compositor
+     * adds the damage of their children to it.
+     */
+    pixman_region16_t damage;
     /* The position of this window relative to its parent. */
     int x, y;
     /* The dimensions of this window. */
@@ -38,7 +52,10 @@ typedef struct {
     Visual* visual;
     Colormap colormap;
     unsigned long backgroundColor;
-    Pixmap background; // TODO: Is this even used anywhere?
+    /* Indicates if the background is backgroundColor, which is only the case if background is None. */
+    Bool hasBackgroundPixel;
+    /* The copy of the background pixmap owned by the window, None or ParentRelative. */
+    Pixmap background;
     int colormapWindowsCount;
     Window* colormapWindows;
     Array properties;
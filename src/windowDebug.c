@@ -66,7 +66,7 @@ void drawWindowDebugViewForChild(SDL_Renderer* renderer, Window window, int absP
     GET_WINDOW_DIMS(window, windowRect.w, windowRect.h);
     windowRect.x += absParentX;
     windowRect.y += absParentY;
-    SDL_SetRenderDrawColor(renderer, ((drawColor >> 24) & 0xFF) * 0.9, ((drawColor >> 16) & 0xFF) * 0.9, ((drawColor >> 8) & 0xFF) * 0.9, 0xFF);
+    setRenderDrawColor(renderer, ((drawColor >> 24) & 0xFF) * 0.9, ((drawColor >> 16) & 0xFF) * 0.9, ((drawColor >> 8) & 0xFF) * 0.9, 0xFF);
     SDL_RenderDrawRect(renderer, &windowRect);
     Window* children = GET_CHILDREN(window);
     for (i = 0; i < GET_WINDOW_STRUCT(window)->children.length; i++) {
@@ -82,11 +82,11 @@ void drawWindowDebugView() {
         if (GET_WINDOW_STRUCT(children[i])->sdlRenderer != NULL) {
             windowColor = GET_WINDOW_STRUCT(children[i])->debugId;
             WindowStruct* windowStruct = GET_WINDOW_STRUCT(children[i]);
-            SDL_RenderSetViewport(windowStruct->sdlRenderer, NULL);
+            setRenderViewport(windowStruct->sdlRenderer, NULL);
             SDL_Rect windowRect;
             GET_WINDOW_POS(children[i], windowRect.x, windowRect.y);
             GET_WINDOW_DIMS(children[i], windowRect.w, windowRect.h);
-            SDL_SetRenderDrawColor(windowStruct->sdlRenderer, (windowColor >> 24) & 0xFF,
+            setRenderDrawColor(windowStruct->sdlRenderer, (windowColor >> 24) & 0xFF,
                                    (windowColor >> 16) & 0xFF, (windowColor >> 8) & 0xFF, 0xFF);
             SDL_RenderDrawRect(windowStruct->sdlRenderer, &windowRect);
             Window* topLevelWindowChildren = GET_CHILDREN(children[i]);
@@ -106,7 +106,7 @@ void drawDebugWindowChildSurfacePlanes(Window child) {
     SDL_RenderGetViewport(renderer, &windowRect);
     windowRect.x = 0;
     windowRect.y = 0;
-    SDL_SetRenderDrawColor(renderer, (windowColor >> 24) & 0xFF, (windowColor >> 16) & 0xFF,
+    setRenderDrawColor(renderer, (windowColor >> 24) & 0xFF, (windowColor >> 16) & 0xFF,
                            (windowColor >> 8) & 0xFF, 0x55);
     SDL_RenderFillRect(renderer, &windowRect);
     Window* children = GET_CHILDREN(child);
@@ -123,10 +123,10 @@ void drawDebugWindowSurfacePlanes() {
             SDL_Renderer* renderer = GET_WINDOW_STRUCT(children[i])->sdlRenderer;
             SDL_BlendMode oldBlendMode;
             SDL_GetRenderDrawBlendMode(renderer, &oldBlendMode);
-            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+            setRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
             drawDebugWindowChildSurfacePlanes(children[i]);
             SDL_RenderPresent(renderer);
-            SDL_SetRenderDrawBlendMode(renderer, oldBlendMode);
+            setRenderDrawBlendMode(renderer, oldBlendMode);
         }
     }
 }
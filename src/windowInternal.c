@@ -3,8 +3,13 @@
 //
 #include "windowInternal.h"
 #include "drawing.h"
+#include "glyphAtlas.h"
+#include "fillPattern.h"
+#include "texturePool.h"
 #include "events.h"
 #include "display.h"
+#include "pixmanBackend.h"
+#include "compositor.h"
 
 Window SCREEN_WINDOW = None;
 
@@ -23,7 +28,11 @@ void initWindowStruct(WindowStruct* windowStruct, int x, int y, unsigned int wid
     windowStruct->sdlTexture = NULL;
     windowStruct->sdlWindow = NULL;
     windowStruct->sdlRenderer = NULL;
+    windowStruct->backingImage = NULL;
+    windowStruct->frameImage = NULL;
+    pixman_region_init(&windowStruct->damage);
     windowStruct->backgroundColor = backgroundColor;
+    windowStruct->hasBackgroundPixel = False;
     windowStruct->background = backgroundPixmap;
     windowStruct->colormapWindowsCount = -1;
     windowStruct->colormapWindows = NULL;
@@ -59,6 +68,7 @@ Bool initScreenWindow(Display* display) {
         }
         initWindowStruct(window, 0, 0, GET_DISPLAY(display)->screens[0].width, GET_DISPLAY(display)->screens[0].height,
                          NULL, None, False, 0, None);
+        window->hasBackgroundPixel = True;
         SET_XID_VALUE(SCREEN_WINDOW, window);
 //        window->sdlWindow = SDL_CreateWindow("Internal", SDL_WINDOWPOS_UNDEFINED,
 //                                             SDL_WINDOWPOS_UNDEFINED, 1, 1,
@@ -95,10 +105,19 @@ void destroyScreenWindow(Display* display) {
         for (i = 0; i < windowStruct->children.length; i++) {
             destroyWindow(display, children[i], False);
         }
+        freeScratchTexture();
+        freeGlyphAtlasesOfRenderer(windowStruct->sdlRenderer);
+        freeFillPatternsOfRenderer(windowStruct->sdlRenderer);
+        freeTexturePoolOfRenderer(windowStruct->sdlRenderer);
+        freeRendererStateOfRenderer(windowStruct->sdlRenderer);
+        if (windowStruct->backingImage != NULL) {
+            pixman_image_unref(windowStruct->backingImage);
+        }
         SDL_DestroyRenderer(windowStruct->sdlRenderer);
         windowStruct->sdlRenderer = NULL;
         SDL_DestroyWindow(windowStruct->sdlWindow);
         freeArray(&windowStruct->children);
+        pixman_region_fini(&windowStruct->damage);
         free(windowStruct);
         FREE_XID(SCREEN_WINDOW);
         SCREEN_WINDOW = None;
@@ -196,7 +215,7 @@ void destroyWindow(Display* display, Window window, Bool freeParentData) {
         free(windowStruct->properties.array[i]);
     }
     freeArray(&windowStruct->properties);
-    if (windowStruct->background != None) {
+    if (windowStruct->background != ParentRelative && windowStruct->background != None) {
         XFreePixmap(display, windowStruct->background);
     }
     if (windowStruct->windowName != NULL) {
@@ -206,11 +225,22 @@ void destroyWindow(Display* display, Window window, Bool freeParentData) {
         SDL_FreeSurface(windowStruct->icon);
     }
     if (windowStruct->sdlRenderer != NULL) {
+        freeGlyphAtlasesOfRenderer(windowStruct->sdlRenderer);
+        freeFillPatternsOfRenderer(windowStruct->sdlRenderer);
+        freeTexturePoolOfRenderer(windowStruct->sdlRenderer);
+        freeRendererStateOfRenderer(windowStruct->sdlRenderer);
         SDL_DestroyRenderer(windowStruct->sdlRenderer);
     }
     if (windowStruct->sdlTexture != NULL) {
+        forgetRenderTarget(windowStruct->sdlTexture);
         SDL_DestroyTexture(windowStruct->sdlTexture);
     }
+    if (windowStruct->backingImage != NULL) {
+        pixman_image_unref(windowStruct->backingImage);
+    }
+    if (windowStruct->frameImage != NULL) {
+        pixman_image_unref(windowStruct->frameImage);
+    }
     if (windowStruct->sdlWindow != NULL) {
         SDL_DestroyWindow(windowStruct->sdlWindow);
     }
@@ -219,6 +249,7 @@ void destroyWindow(Display* display, Window window, Bool freeParentData) {
     if (freeParentData) {
         removeChildFromParent(window);
     }
+    pixman_region_fini(&windowStruct->damage);
     free(windowStruct);
     FREE_XID(window);
 }
@@ -266,12 +297,19 @@ void resizeWindowTexture(Window window) {
         SDL_Renderer* windowRenderer;
         GET_RENDERER(window, windowRenderer);
         SDL_RenderCopy(windowRenderer, oldTexture, NULL, &destRect);
+        forgetRenderTarget(oldTexture);
         SDL_DestroyTexture(oldTexture);
+        markDrawableDirty(window);
     }
 }
 
 Bool mergeWindowDrawables(Window parent, Window child) {
+    // The compositor keeps the image of the child.
+    if (compositorEnabled) { return True; }
     WindowStruct* childWindowStruct = GET_WINDOW_STRUCT(child);
+    if (childWindowStruct->backingImage != NULL) {
+        return pixmanMergeWindowImage(parent, child);
+    }
     if (childWindowStruct->sdlTexture == NULL) { return True; }
     SDL_Renderer* parentRenderer = getWindowRenderer(parent);
     if (childWindowStruct->sdlRenderer != NULL) {
@@ -283,15 +321,42 @@ Bool mergeWindowDrawables(Window parent, Window child) {
     if (SDL_RenderCopy(parentRenderer, childWindowStruct->sdlTexture, NULL, &destRect) != 0) {
         return False;
     }
+    damageDrawable(parent, destRect.x, destRect.y, destRect.w, destRect.h);
+    forgetRenderTarget(childWindowStruct->sdlTexture);
     SDL_DestroyTexture(childWindowStruct->sdlTexture);
     childWindowStruct->sdlTexture = NULL;
     if (childWindowStruct->sdlRenderer != NULL) {
+        freeGlyphAtlasesOfRenderer(childWindowStruct->sdlRenderer);
+        freeFillPatternsOfRenderer(childWindowStruct->sdlRenderer);
+        freeTexturePoolOfRenderer(childWindowStruct->sdlRenderer);
+        freeRendererStateOfRenderer(childWindowStruct->sdlRenderer);
         SDL_DestroyRenderer(childWindowStruct->sdlRenderer);
         childWindowStruct->sdlRenderer = NULL;
     }
     return True;
 }
 
+void restackWindow(Window window, Bool raise) {
+    Window parent = GET_PARENT(window);
+    if (parent == None) { return; }
+    Array* siblings = &GET_WINDOW_STRUCT(parent)->children;
+    ssize_t index = findInArray(siblings, (void*) window);
+    if (index == -1) { return; }
+    size_t i = (size_t) index;
+    if (raise) {
+        for (; i + 1 < siblings->length; i++) {
+            swapArray(siblings, i, i + 1);
+        }
+    } else {
+        for (; i > 0; i--) {
+            swapArray(siblings, i, i - 1);
+        }
+    }
+    if (i != (size_t) index && !IS_TOP_LEVEL(window) && GET_WINDOW_STRUCT(window)->mapState == Mapped) {
+        markDrawableDirty(window);
+    }
+}
+
 void mapRequestedChildren(Display* display, Window window) {
     Window* children = GET_CHILDREN(window);
     size_t i;
@@ -327,8 +392,11 @@ Bool configureWindow(Display* display, Window window, unsigned long value_mask,
         if (HAS_VALUE(value_mask, CWY)) {
             y = values->y;
         }
-        x = 0;
-        y = 0;
+        if (!compositorEnabled || IS_TOP_LEVEL(window)) {
+            // Without the compositor a moved child would leave its old content in the parent.
+            x = 0;
+            y = 0;
+        }
         if (isMappedTopLevelWindow) {
             SDL_SetWindowPosition(windowStruct->sdlWindow, x, y);
             SDL_GetWindowPosition(windowStruct->sdlWindow, &windowStruct->x, &windowStruct->y);
@@ -379,6 +447,13 @@ Bool configureWindow(Display* display, Window window, unsigned long value_mask,
     if (!postEvent(display, window, ConfigureNotify)) {
         return False;
     }
+    if (compositorEnabled && !isMappedTopLevelWindow && windowStruct->mapState == Mapped
+        && (unsigned int) oldWidth == windowStruct->w && (unsigned int) oldHeight == windowStruct->h) {
+        // The content of the window was kept, only the old and the new area have to be recomposited.
+        damageDrawable(GET_PARENT(window), oldX, oldY, (unsigned int) oldWidth, (unsigned int) oldHeight);
+        markDrawableDirty(window);
+        return True;
+    }
     if (windowStruct->mapState != UnMapped && (oldX != windowStruct->x || oldY != windowStruct->y
         || oldWidth != windowStruct->w || oldHeight != windowStruct->h)) {
         SDL_Rect exposedRect;  // TODO: Handle whe window shrinks or moves, update parent
@@ -28,6 +28,8 @@ void registerWindowMapping(Window window, Uint32 sdlWindowId);
 Bool isParent(Window window1, Window window2);
 WindowProperty* findProperty(Array* properties, Atom property, size_t* index);
 Bool mergeWindowDrawables(Window parent, Window child);
+/* Move the window to the top (or bottom) of the stack of its siblings. */
+void restackWindow(Window window, Bool raise);
 void mapRequestedChildren(Display* display, Window window);
 Bool configureWindow(Display* display, Window window, unsigned long value_mask, XWindowChanges* values);
 
@@ -0,0 +1,158 @@
+/*
+clip_region.c
+Draws through clip rectangles, clip regions and clip masks into a pixmap and checks with XGetImage
+that only the pixels inside of the clip were changed.
+*/
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <stdio.h>
+#include "pixel_checks.h"
+
+#define SIZE 64
+#define BACKGROUND 0x000000
+#define FOREGROUND 0xFFFFFF
+#define MASK_SIZE 32
+
+static void clearPixmap(Display* display, Pixmap pixmap, GC gc) {
+    XSetClipMask(display, gc, None);
+    XSetForeground(display, gc, BACKGROUND);
+    XFillRectangle(display, pixmap, gc, 0, 0, SIZE, SIZE);
+    XSetForeground(display, gc, FOREGROUND);
+}
+
+/* Check that exactly the pixels inside of the rectangles (relative to the origin) were drawn. */
+static void checkPixels(Display* display, Pixmap pixmap, const char* name, XRectangle* clip, int n,
+                        int originX, int originY) {
+    XImage* image = XGetImage(display, pixmap, 0, 0, SIZE, SIZE, AllPlanes, ZPixmap);
+    if (image == NULL) {
+        printf("%s: XGetImage failed\n", name);
+        failures++;
+        return;
+    }
+    int x, y, i, errors = 0;
+    for (y = 0; y < SIZE; y++) {
+        for (x = 0; x < SIZE; x++) {
+            int inside = 0;
+            for (i = 0; i < n; i++) {
+                int left = clip[i].x + originX, top = clip[i].y + originY;
+                if (x >= left && x < left + clip[i].width && y >= top && y < top + clip[i].height) {
+                    inside = 1;
+                }
+            }
+            unsigned long expected = inside ? FOREGROUND : BACKGROUND;
+            if ((XGetPixel(image, x, y) & 0xFFFFFF) != expected) {
+                errors++;
+            }
+        }
+    }
+    XDestroyImage(image);
+    printf("%s: %s (%d wrong pixels)\n", name, errors == 0 ? "ok" : "FAILED", errors);
+    failures += errors != 0;
+}
+
+/* Create a bitmap in which exactly the pixels inside of the rectangles are set. */
+static Pixmap createMask(Display* display, XRectangle* rectangles, int n) {
+    char data[MASK_SIZE * MASK_SIZE / 8] = {0};
+    int x, y, i;
+    for (i = 0; i < n; i++) {
+        for (y = rectangles[i].y; y < rectangles[i].y + rectangles[i].height; y++) {
+            for (x = rectangles[i].x; x < rectangles[i].x + rectangles[i].width; x++) {
+                data[y * MASK_SIZE / 8 + x / 8] |= (char) (1 << (x % 8));
+            }
+        }
+    }
+    return XCreateBitmapFromData(display, DefaultRootWindow(display), data, MASK_SIZE, MASK_SIZE);
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    Pixmap pixmap = XCreatePixmap(display, DefaultRootWindow(display), SIZE, SIZE,
+                                  DefaultDepth(display, DefaultScreen(display)));
+    GC gc = XCreateGC(display, pixmap, 0, NULL);
+    XRectangle single[] = {{8, 8, 20, 10}};
+    XRectangle several[] = {{0, 0, 10, 10}, {20, 4, 6, 30}, {40, 40, 30, 30}};
+
+    clearPixmap(display, pixmap, gc);
+    XSetClipRectangles(display, gc, 0, 0, single, 1, Unsorted);
+    XFillRectangle(display, pixmap, gc, 0, 0, SIZE, SIZE);
+    checkPixels(display, pixmap, "Fill through one rectangle", single, 1, 0, 0);
+
+    clearPixmap(display, pixmap, gc);
+    XSetClipRectangles(display, gc, 5, 3, several, 3, Unsorted);
+    XFillRectangle(display, pixmap, gc, 0, 0, SIZE, SIZE);
+    checkPixels(display, pixmap, "Fill through rectangles with an origin", several, 3, 5, 3);
+
+    clearPixmap(display, pixmap, gc);
+    Region region = XCreateRegion();
+    int i;
+    for (i = 0; i < 3; i++) {
+        XUnionRectWithRegion(&several[i], region, region);
+    }
+    XSetRegion(display, gc, region);
+    XDestroyRegion(region);
+    for (i = 0; i < SIZE; i++) {
+        XDrawLine(display, pixmap, gc, 0, i, SIZE - 1, i);
+    }
+    checkPixels(display, pixmap, "Lines through a region", several, 3, 0, 0);
+
+    Pixmap source = XCreatePixmap(display, DefaultRootWindow(display), SIZE, SIZE,
+                                  DefaultDepth(display, DefaultScreen(display)));
+    clearPixmap(display, source, gc);
+    XFillRectangle(display, source, gc, 0, 0, SIZE, SIZE);
+    clearPixmap(display, pixmap, gc);
+    XSetClipRectangles(display, gc, 0, 0, several, 3, Unsorted);
+    XCopyArea(display, source, pixmap, gc, 0, 0, SIZE, SIZE, 0, 0);
+    checkPixels(display, pixmap, "Copy through rectangles", several, 3, 0, 0);
+
+    XRectangle masked[] = {{4, 4, 8, 8}, {16, 10, 10, 12}};
+    Pixmap mask = createMask(display, masked, 2);
+    clearPixmap(display, pixmap, gc);
+    XSetClipMask(display, gc, mask);
+    XSetClipOrigin(display, gc, 10, 20);
+    XCopyArea(display, source, pixmap, gc, 0, 0, SIZE, SIZE, 0, 0);
+    checkPixels(display, pixmap, "Copy through a clip mask", masked, 2, 10, 20);
+
+    // Drawing into the mask has to change the clip.
+    GC maskGc = XCreateGC(display, mask, 0, NULL);
+    XSetForeground(display, maskGc, 0);
+    XFillRectangle(display, mask, maskGc, 0, 0, MASK_SIZE, MASK_SIZE);
+    XSetForeground(display, maskGc, 1);
+    XRectangle redrawn[] = {{0, 0, 6, 6}};
+    XFillRectangles(display, mask, maskGc, redrawn, 1);
+    XFreeGC(display, maskGc);
+    GC plainGc = XCreateGC(display, pixmap, 0, NULL);
+    XSetForeground(display, plainGc, BACKGROUND);
+    XFillRectangle(display, pixmap, plainGc, 0, 0, SIZE, SIZE);
+    XFreeGC(display, plainGc);
+    XFillRectangle(display, pixmap, gc, 0, 0, SIZE, SIZE);
+    checkPixels(display, pixmap, "Fill through a changed clip mask", redrawn, 1, 10, 20);
+
+    // Check the pixels on both sides of the edges of the mask.
+    clearPixmap(display, pixmap, gc);
+    XSetClipMask(display, gc, mask);
+    for (i = 0; i < SIZE; i++) {
+        XDrawLine(display, pixmap, gc, 0, i, SIZE - 1, i);
+    }
+    expectPixel(display, pixmap, 10, 20, FOREGROUND, "Lines through a clip mask");
+    expectPixel(display, pixmap, 15, 25, FOREGROUND, "Lines through a clip mask");
+    expectPixel(display, pixmap, 9, 20, BACKGROUND, "Lines through a clip mask");
+    expectPixel(display, pixmap, 16, 25, BACKGROUND, "Lines through a clip mask");
+    expectPixel(display, pixmap, 15, 26, BACKGROUND, "Lines through a clip mask");
+    XSetClipOrigin(display, gc, 0, 0);
+    XFreePixmap(display, source);
+
+    clearPixmap(display, pixmap, gc);
+    XSetClipRectangles(display, gc, 0, 0, NULL, 0, Unsorted);
+    XFillRectangle(display, pixmap, gc, 0, 0, SIZE, SIZE);
+    checkPixels(display, pixmap, "Fill through an empty clip", NULL, 0, 0, 0);
+
+    XFreeGC(display, gc);
+    XFreePixmap(display, pixmap);
+    XCloseDisplay(display);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+/*
+compositor.c
+Stacks two overlapping child windows, then raises, lowers and moves them and checks the pixels of the
+frame the compositor composites for their top level window. The content drawn into a covered window
+must come back when it is uncovered, without the client redrawing it.
+Run it with SDL2X11_BACKEND=pixman SDL2X11_COMPOSITOR=1.
+*/
+
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "window.h"
+#include "compositor.h"
+#include "pixel_checks.h"
+
+#define WIDTH 96
+#define HEIGHT 64
+#define BACKGROUND 0x336699
+#define LOWER_BACKGROUND 0xC04020
+#define UPPER_BACKGROUND 0x20A040
+#define FOREGROUND 0xF0E010
+
+static pixman_image_t* frame = NULL;
+
+/* Composite the whole frame of the top level window. */
+static Bool compositeFrame(Display* display, Window window) {
+    XSync(display, False);
+    SDL_Rect rect = {0, 0, WIDTH, HEIGHT};
+    frame = compositeWindowFrame(GET_WINDOW_STRUCT(window), &rect, 1);
+    if (frame == NULL) {
+        printf("Compositing the frame: FAILED\n");
+        return False;
+    }
+    return True;
+}
+
+/* Check the color of a pixel of the last composited frame. */
+static void expectFramePixel(int x, int y, unsigned long expected, const char* name) {
+    const uint32_t* row = (const uint32_t*) ((const char*) pixman_image_get_data(frame)
+                                            + y * pixman_image_get_stride(frame));
+    expectColor(row[x] & 0xFFFFFF, x, y, expected, name);
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    if (!compositorEnabled) {
+        fprintf(stderr, "The compositor is disabled, run with SDL2X11_BACKEND=pixman SDL2X11_COMPOSITOR=1\n");
+        return 1;
+    }
+    int screen = DefaultScreen(display);
+    Window window = XCreateSimpleWindow(display, RootWindow(display, screen), 0, 0, WIDTH, HEIGHT, 0,
+                                        BlackPixel(display, screen), BACKGROUND);
+    // The windows overlap in the area from (32, 16) to (48, 48), the upper one is created last.
+    Window lower = XCreateSimpleWindow(display, window, 8, 8, 40, 40, 0,
+                                       BlackPixel(display, screen), LOWER_BACKGROUND);
+    Window upper = XCreateSimpleWindow(display, window, 32, 16, 40, 40, 0,
+                                       BlackPixel(display, screen), UPPER_BACKGROUND);
+    XMapWindow(display, window);
+    XMapWindow(display, lower);
+    XMapWindow(display, upper);
+    GC gc = XCreateGC(display, upper, 0, NULL);
+    XSetForeground(display, gc, FOREGROUND);
+    XFillRectangle(display, upper, gc, 0, 0, 8, 8);
+
+    if (!compositeFrame(display, window)) { return 1; }
+    expectFramePixel(12, 12, LOWER_BACKGROUND, "Stacked windows");
+    expectFramePixel(34, 18, FOREGROUND, "Stacked windows");
+    expectFramePixel(40, 30, UPPER_BACKGROUND, "Stacked windows");
+    expectFramePixel(68, 50, UPPER_BACKGROUND, "Stacked windows");
+    expectFramePixel(90, 60, BACKGROUND, "Stacked windows");
+
+    XRaiseWindow(display, lower);
+    if (!compositeFrame(display, window)) { return 1; }
+    expectFramePixel(34, 18, LOWER_BACKGROUND, "Raised lower window");
+    expectFramePixel(40, 30, LOWER_BACKGROUND, "Raised lower window");
+    expectFramePixel(68, 50, UPPER_BACKGROUND, "Raised lower window");
+
+    XLowerWindow(display, lower);
+    if (!compositeFrame(display, window)) { return 1; }
+    expectFramePixel(34, 18, FOREGROUND, "Lowered lower window");
+    expectFramePixel(40, 30, UPPER_BACKGROUND, "Lowered lower window");
+    expectFramePixel(12, 12, LOWER_BACKGROUND, "Lowered lower window");
+
+    XMoveWindow(display, upper, 52, 16);
+    if (!compositeFrame(display, window)) { return 1; }
+    expectFramePixel(34, 18, LOWER_BACKGROUND, "Moved upper window");
+    expectFramePixel(40, 30, LOWER_BACKGROUND, "Moved upper window");
+    expectFramePixel(34, 50, BACKGROUND, "Moved upper window");
+    expectFramePixel(49, 50, BACKGROUND, "Moved upper window");
+    expectFramePixel(54, 18, FOREGROUND, "Moved upper window");
+    expectFramePixel(70, 30, UPPER_BACKGROUND, "Moved upper window");
+
+    XFreeGC(display, gc);
+    XDestroyWindow(display, window);
+    XCloseDisplay(display);
+    printf("%s\n", failures == 0 ? "Composited frames ok" : "Composited frames FAILED");
+    return failures == 0 ? 0 : 1;
+}
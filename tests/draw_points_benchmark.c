@@ -0,0 +1,84 @@
+/*
+draw_points_benchmark.c
+Draws frames of 100000 points, 10000 segments and 10000 rectangles into a window,
+like a scatter plot or graph widget, and reports the time per frame.
+*/
+
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define WIDTH 800
+#define HEIGHT 600
+#define FRAMES 60
+#define POINTS 100000
+#define SEGMENTS 10000
+#define RECTANGLES 10000
+
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static XPoint points[POINTS];
+static XSegment segments[SEGMENTS];
+static XRectangle rectangles[RECTANGLES];
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    int screen = DefaultScreen(display);
+    Window window = XCreateSimpleWindow(display, RootWindow(display, screen), 0, 0, WIDTH, HEIGHT, 0,
+                                        BlackPixel(display, screen), WhitePixel(display, screen));
+    XMapWindow(display, window);
+    GC gc = XCreateGC(display, window, 0, NULL);
+    int i, frame;
+    srand(42);
+    for (i = 0; i < SEGMENTS; i++) {
+        segments[i].x1 = (short) (rand() % WIDTH);
+        segments[i].y1 = (short) (rand() % HEIGHT);
+        segments[i].x2 = (short) (segments[i].x1 + rand() % 41 - 20);
+        segments[i].y2 = (short) (segments[i].y1 + rand() % 41 - 20);
+    }
+    for (i = 0; i < RECTANGLES; i++) {
+        rectangles[i].x = (short) (rand() % WIDTH);
+        rectangles[i].y = (short) (rand() % HEIGHT);
+        rectangles[i].width = (unsigned short) (rand() % 20 + 1);
+        rectangles[i].height = (unsigned short) (rand() % 20 + 1);
+    }
+    double pointTime = 0, segmentTime = 0, rectangleTime = 0;
+    for (frame = 0; frame < FRAMES; frame++) {
+        for (i = 0; i < POINTS; i++) {
+            points[i].x = (short) (rand() % WIDTH);
+            points[i].y = (short) (rand() % HEIGHT);
+        }
+        XClearWindow(display, window);
+        XSetForeground(display, gc, 0x2060C0);
+        double start = now();
+        XDrawPoints(display, window, gc, points, POINTS, CoordModeOrigin);
+        XSync(display, False);
+        pointTime += now() - start;
+        XSetForeground(display, gc, 0xC04020);
+        start = now();
+        XDrawSegments(display, window, gc, segments, SEGMENTS);
+        XSync(display, False);
+        segmentTime += now() - start;
+        XSetForeground(display, gc, 0x20A040);
+        start = now();
+        XDrawRectangles(display, window, gc, rectangles, RECTANGLES);
+        XSync(display, False);
+        rectangleTime += now() - start;
+    }
+    printf("%d points:     %.3f ms per frame\n", POINTS, pointTime / FRAMES * 1000);
+    printf("%d segments:   %.3f ms per frame\n", SEGMENTS, segmentTime / FRAMES * 1000);
+    printf("%d rectangles: %.3f ms per frame\n", RECTANGLES, rectangleTime / FRAMES * 1000);
+    XFreeGC(display, gc);
+    XDestroyWindow(display, window);
+    XCloseDisplay(display);
+    return 0;
+}
@@ -0,0 +1,77 @@
+/*
+fill_shapes.c
+Fills polygons and arcs into a pixmap and checks pixels with XGetImage: the fill rule decides whether
+the center of a pentagram is filled, the arc mode whether the center of an arc is filled, and arcs
+of 360 and 0 degrees fill the whole ellipse or nothing.
+*/
+
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include "pixel_checks.h"
+
+#define SIZE 64
+#define BACKGROUND 0x000000
+#define FOREGROUND 0xFFFFFF
+
+static void clear(Display* display, Pixmap pixmap, GC gc) {
+    XSetForeground(display, gc, BACKGROUND);
+    XFillRectangle(display, pixmap, gc, 0, 0, SIZE, SIZE);
+    XSetForeground(display, gc, FOREGROUND);
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    Pixmap pixmap = XCreatePixmap(display, DefaultRootWindow(display), SIZE, SIZE,
+                                  DefaultDepth(display, DefaultScreen(display)));
+    GC gc = XCreateGC(display, pixmap, 0, NULL);
+
+    // A pentagram around (32, 32), its center is enclosed twice.
+    XPoint pentagram[] = {{32, 4}, {48, 55}, {5, 23}, {59, 23}, {16, 55}};
+    clear(display, pixmap, gc);
+    XSetFillRule(display, gc, EvenOddRule);
+    XFillPolygon(display, pixmap, gc, pentagram, 5, Complex, CoordModeOrigin);
+    expectPixel(display, pixmap, 32, 32, BACKGROUND, "Pentagram with EvenOddRule");
+    expectPixel(display, pixmap, 32, 12, FOREGROUND, "Pentagram with EvenOddRule");
+    expectPixel(display, pixmap, 2, 2, BACKGROUND, "Pentagram with EvenOddRule");
+    clear(display, pixmap, gc);
+    XSetFillRule(display, gc, WindingRule);
+    XFillPolygon(display, pixmap, gc, pentagram, 5, Complex, CoordModeOrigin);
+    expectPixel(display, pixmap, 32, 32, FOREGROUND, "Pentagram with WindingRule");
+    expectPixel(display, pixmap, 32, 12, FOREGROUND, "Pentagram with WindingRule");
+    expectPixel(display, pixmap, 2, 2, BACKGROUND, "Pentagram with WindingRule");
+
+    // The upper right quarter of a circle around (32, 32), the chord goes from (64, 32) to (32, 0).
+    clear(display, pixmap, gc);
+    XSetArcMode(display, gc, ArcPieSlice);
+    XFillArc(display, pixmap, gc, 0, 0, SIZE, SIZE, 0, 90 * 64);
+    expectPixel(display, pixmap, 40, 24, FOREGROUND, "Quarter arc with ArcPieSlice");
+    expectPixel(display, pixmap, 52, 14, FOREGROUND, "Quarter arc with ArcPieSlice");
+    expectPixel(display, pixmap, 20, 44, BACKGROUND, "Quarter arc with ArcPieSlice");
+    clear(display, pixmap, gc);
+    XSetArcMode(display, gc, ArcChord);
+    XFillArc(display, pixmap, gc, 0, 0, SIZE, SIZE, 0, 90 * 64);
+    expectPixel(display, pixmap, 40, 24, BACKGROUND, "Quarter arc with ArcChord");
+    expectPixel(display, pixmap, 52, 14, FOREGROUND, "Quarter arc with ArcChord");
+    expectPixel(display, pixmap, 20, 44, BACKGROUND, "Quarter arc with ArcChord");
+
+    clear(display, pixmap, gc);
+    XFillArc(display, pixmap, gc, 0, 0, SIZE, SIZE, 45 * 64, 360 * 64);
+    expectPixel(display, pixmap, 32, 32, FOREGROUND, "Arc of 360 degrees");
+    expectPixel(display, pixmap, 32, 58, FOREGROUND, "Arc of 360 degrees");
+    expectPixel(display, pixmap, 10, 32, FOREGROUND, "Arc of 360 degrees");
+    expectPixel(display, pixmap, 2, 2, BACKGROUND, "Arc of 360 degrees");
+    clear(display, pixmap, gc);
+    XFillArc(display, pixmap, gc, 0, 0, SIZE, SIZE, 45 * 64, 0);
+    expectPixel(display, pixmap, 32, 32, BACKGROUND, "Arc of 0 degrees");
+    expectPixel(display, pixmap, 48, 16, BACKGROUND, "Arc of 0 degrees");
+
+    XFreeGC(display, gc);
+    XFreePixmap(display, pixmap);
+    XCloseDisplay(display);
+    printf("%s\n", failures == 0 ? "All shapes ok" : "Some shapes FAILED");
+    return failures == 0 ? 0 : 1;
+}
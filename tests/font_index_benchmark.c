@@ -0,0 +1,106 @@
+/*
+font_index_benchmark.c
+Measures how long scanning a font directory with 1000 fonts takes, once without an
+index of the directory and once with the index that the first scan wrote.
+Run it from a directory that contains fonts/FreeMono.ttf.
+*/
+
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+
+#define NUM_FONTS 1000
+#define FONT_PATH "fonts/FreeMono.ttf"
+
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static char* readFile(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    fseek(file, 0, SEEK_END);
+    *size = (size_t) ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = malloc(*size);
+    if (data != NULL && fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+static void removeDirectory(const char* directory) {
+    char path[4096];
+    struct dirent* entry;
+    DIR* dir = opendir(directory);
+    if (dir == NULL) return;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        unlink(path);
+    }
+    closedir(dir);
+    rmdir(directory);
+}
+
+static double scanFontDirectory(Display* display, char* directory, int* numFonts) {
+    // Reset to the default path first, so the fonts of the directory are not in the font cache.
+    XSetFontPath(display, NULL, 0);
+    double start = now();
+    XSetFontPath(display, &directory, 1);
+    double time = now() - start;
+    XFreeFontNames(XListFonts(display, "*", NUM_FONTS * 2, numFonts));
+    return time;
+}
+
+int main() {
+    char fontDirectory[] = "/tmp/font-index-benchmark-XXXXXX";
+    char cacheDirectory[] = "/tmp/font-index-benchmark-cache-XXXXXX";
+    char path[4096];
+    size_t fontSize;
+    int i, numFonts;
+    char* fontData = readFile(FONT_PATH, &fontSize);
+    if (fontData == NULL) {
+        fprintf(stderr, "Failed to read %s\n", FONT_PATH);
+        return 1;
+    }
+    if (mkdtemp(fontDirectory) == NULL || mkdtemp(cacheDirectory) == NULL) {
+        fprintf(stderr, "Failed to create the temporary directories\n");
+        return 1;
+    }
+    for (i = 0; i < NUM_FONTS; i++) {
+        snprintf(path, sizeof(path), "%s/font%04d.ttf", fontDirectory, i);
+        FILE* file = fopen(path, "wb");
+        if (file == NULL || fwrite(fontData, 1, fontSize, file) != fontSize) {
+            fprintf(stderr, "Failed to write %s\n", path);
+            return 1;
+        }
+        fclose(file);
+    }
+    free(fontData);
+    // Start with an empty cache, so the first scan has to open every font.
+    setenv("SDL2X11_FONT_CACHE_DIR", cacheDirectory, 1);
+
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    double coldTime = scanFontDirectory(display, fontDirectory, &numFonts);
+    printf("Without index: %8.2f ms (%d fonts)\n", coldTime * 1000, numFonts);
+    double warmTime = scanFontDirectory(display, fontDirectory, &numFonts);
+    printf("With index:    %8.2f ms (%d fonts), %.1fx\n", warmTime * 1000, numFonts, coldTime / warmTime);
+    XCloseDisplay(display);
+
+    removeDirectory(fontDirectory);
+    removeDirectory(cacheDirectory);
+    return 0;
+}
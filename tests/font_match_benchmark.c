@@ -0,0 +1,81 @@
+/*
+font_match_benchmark.c
+Compares matching XLFD patterns with the font name index against matching
+every name with matchWildcard, over a generated set of 40000 font names.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "fontNameIndex.h"
+#include "util.h"
+
+#define NUM_FOUNDRIES 10
+#define NUM_FAMILIES 100
+#define NUM_SIZES 10
+#define NUM_NAMES (NUM_FOUNDRIES * NUM_FAMILIES * 2 * 2 * NUM_SIZES)
+#define ITERATIONS 20
+
+static const char* PATTERNS[] = {
+    "-*-family42-bold-r-*-*-12-*",
+    "-foundry3-family7-medium-i-normal--16-0-0-0-p-0-iso10646-1",
+    "-*-family99-*",
+    "*-bold-i-*-20-*",
+    "*",
+};
+
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+int main() {
+    static char* names[NUM_NAMES];
+    static size_t matches[NUM_NAMES];
+    size_t numNames = 0, numMatches = 0, i, j;
+    int foundry, family, bold, italic, size, iteration;
+    for (foundry = 0; foundry < NUM_FOUNDRIES; foundry++) {
+        for (family = 0; family < NUM_FAMILIES; family++) {
+            for (bold = 0; bold < 2; bold++) {
+                for (italic = 0; italic < 2; italic++) {
+                    for (size = 0; size < NUM_SIZES; size++) {
+                        names[numNames] = malloc(128);
+                        snprintf(names[numNames++], 128, "-foundry%d-family%d-%s-%c-normal--%d-0-0-0-p-0-iso10646-1",
+                                 foundry, family, bold ? "bold" : "medium", italic ? 'i' : 'r', 8 + size * 2);
+                    }
+                }
+            }
+        }
+    }
+    double start = now();
+    FontNameIndex* index = createFontNameIndex(names, numNames);
+    if (index == NULL) {
+        fprintf(stderr, "Failed to create the font name index\n");
+        return 1;
+    }
+    printf("Indexed %zu names in %.2f ms\n", numNames, (now() - start) * 1000);
+    for (i = 0; i < ARRAY_LENGTH(PATTERNS); i++) {
+        start = now();
+        for (iteration = 0; iteration < ITERATIONS; iteration++) {
+            numMatches = findFontNames(index, PATTERNS[i], matches, numNames);
+        }
+        double indexTime = (now() - start) / ITERATIONS;
+        size_t numScanMatches = 0;
+        start = now();
+        for (iteration = 0; iteration < ITERATIONS; iteration++) {
+            numScanMatches = 0;
+            for (j = 0; j < numNames; j++) {
+                if (matchWildcard(PATTERNS[i], names[j])) numScanMatches++;
+            }
+        }
+        double scanTime = (now() - start) / ITERATIONS;
+        printf("%-60s %5zu matches: index %8.3f ms, scan %8.3f ms (%5zu matches), %6.1fx\n",
+               PATTERNS[i], numMatches, indexTime * 1000, scanTime * 1000, numScanMatches, scanTime / indexTime);
+    }
+    freeFontNameIndex(index);
+    for (i = 0; i < numNames; i++) {
+        free(names[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+get_image.c
+Puts an image into a pixmap and reads parts of it back with XGetImage
+in ZPixmap and XYPixmap format, checking that the pixels survive the round trip.
+*/
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WIDTH 64
+#define HEIGHT 48
+
+static unsigned long getTestPixel(int x, int y) {
+    return (unsigned long) ((x * 4) << 16 | (y * 5) << 8 | ((x + y) * 2));
+}
+
+static int checkImage(XImage* image, int offsetX, int offsetY, const char* name) {
+    int x, y, errors = 0;
+    for (y = 0; y < image->height; y++) {
+        for (x = 0; x < image->width; x++) {
+            unsigned long pixel = XGetPixel(image, x, y) & 0xFFFFFF;
+            unsigned long expected = getTestPixel(offsetX + x, offsetY + y);
+            if (pixel != expected && errors++ < 5) {
+                printf("%s: pixel %d, %d is %06lx, expected %06lx\n", name, x, y, pixel, expected);
+            }
+        }
+    }
+    printf("%s: %s\n", name, errors == 0 ? "OK" : "FAILED");
+    return errors;
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    int screen = DefaultScreen(display);
+    int depth = DefaultDepth(display, screen);
+    Pixmap pixmap = XCreatePixmap(display, RootWindow(display, screen), WIDTH, HEIGHT, depth);
+    GC gc = XCreateGC(display, pixmap, 0, NULL);
+    XImage* image = XCreateImage(display, DefaultVisual(display, screen), depth, ZPixmap, 0, NULL,
+                                 WIDTH, HEIGHT, 32, 0);
+    image->data = malloc(image->bytes_per_line * HEIGHT);
+    int x, y, errors = 0;
+    for (y = 0; y < HEIGHT; y++) {
+        for (x = 0; x < WIDTH; x++) {
+            XPutPixel(image, x, y, getTestPixel(x, y));
+        }
+    }
+    XPutImage(display, pixmap, gc, image, 0, 0, 0, 0, WIDTH, HEIGHT);
+    XDestroyImage(image);
+
+    image = XGetImage(display, pixmap, 0, 0, WIDTH, HEIGHT, AllPlanes, ZPixmap);
+    errors += image == NULL ? 1 : checkImage(image, 0, 0, "ZPixmap");
+    if (image != NULL) { XDestroyImage(image); }
+    image = XGetImage(display, pixmap, 10, 7, 13, 5, AllPlanes, ZPixmap);
+    errors += image == NULL ? 1 : checkImage(image, 10, 7, "ZPixmap rectangle");
+    if (image != NULL) { XDestroyImage(image); }
+    image = XGetImage(display, pixmap, 3, 20, 30, 9, AllPlanes, XYPixmap);
+    errors += image == NULL ? 1 : checkImage(image, 3, 20, "XYPixmap rectangle");
+    if (image != NULL) { XDestroyImage(image); }
+
+    // A child window is drawn into its parent, it has to read its own pixels and not the ones of the parent.
+    Window window = XCreateSimpleWindow(display, RootWindow(display, screen), 0, 0, WIDTH + 40, HEIGHT + 30, 0,
+                                        BlackPixel(display, screen), 0x000000);
+    Window child = XCreateSimpleWindow(display, window, 40, 30, WIDTH, HEIGHT, 0,
+                                       BlackPixel(display, screen), 0x000000);
+    XSetWindowAttributes attributes;
+    attributes.override_redirect = True;
+    XChangeWindowAttributes(display, window, CWOverrideRedirect, &attributes);
+    XMapWindow(display, window);
+    XMapWindow(display, child);
+    XCopyArea(display, pixmap, child, gc, 0, 0, WIDTH, HEIGHT, 0, 0);
+    XSync(display, False);
+    image = XGetImage(display, child, 0, 0, WIDTH, HEIGHT, AllPlanes, ZPixmap);
+    errors += image == NULL ? 1 : checkImage(image, 0, 0, "Child window");
+    if (image != NULL) { XDestroyImage(image); }
+    image = XGetImage(display, child, 10, 7, 13, 5, AllPlanes, ZPixmap);
+    errors += image == NULL ? 1 : checkImage(image, 10, 7, "Child window rectangle");
+    if (image != NULL) { XDestroyImage(image); }
+    XDestroyWindow(display, window);
+
+    XFreeGC(display, gc);
+    XFreePixmap(display, pixmap);
+    XCloseDisplay(display);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+/*
+headless_snapshot.c
+Draws into a window with a child window, writes a snapshot of the window with SDL2X11WriteSnapshot
+and checks the pixels of the PPM file. Run it with SDL2X11_HEADLESS=1 on machines without a display.
+*/
+
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdl2X11Emulation.h"
+#include "pixel_checks.h"
+
+#define WIDTH 96
+#define HEIGHT 64
+#define BACKGROUND 0x336699
+#define CHILD_BACKGROUND 0xC04020
+#define FOREGROUND 0x20A040
+
+/* Check the color of a pixel of the snapshot. */
+static void expectSnapshotPixel(const unsigned char* pixels, int x, int y, unsigned long expected) {
+    const unsigned char* pixel = pixels + (y * WIDTH + x) * 3;
+    expectColor((unsigned long) pixel[0] << 16 | pixel[1] << 8 | pixel[2], x, y, expected, "Snapshot");
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    printf("Running %s\n", SDL2X11IsHeadless() ? "headless" : "with a display");
+    int screen = DefaultScreen(display);
+    Window window = XCreateSimpleWindow(display, RootWindow(display, screen), 0, 0, WIDTH, HEIGHT, 0,
+                                        BlackPixel(display, screen), BACKGROUND);
+    Window child = XCreateSimpleWindow(display, window, 48, 16, 32, 32, 0,
+                                       BlackPixel(display, screen), CHILD_BACKGROUND);
+    XMapWindow(display, window);
+    XMapWindow(display, child);
+    GC gc = XCreateGC(display, window, 0, NULL);
+    XSetForeground(display, gc, FOREGROUND);
+    XFillRectangle(display, window, gc, 8, 8, 16, 16);
+    XFillRectangle(display, child, gc, 0, 0, 8, 8);
+    XSync(display, False);
+
+    const char* fileName = "headless_snapshot.ppm";
+    if (!SDL2X11WriteSnapshot(display, window, fileName)) {
+        printf("SDL2X11WriteSnapshot: FAILED\n");
+        return 1;
+    }
+    FILE* file = fopen(fileName, "rb");
+    int width = 0, height = 0, maxValue = 0;
+    static unsigned char pixels[WIDTH * HEIGHT * 3];
+    if (file == NULL || fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) != 3 || fgetc(file) == EOF
+        || width != WIDTH || height != HEIGHT || maxValue != 255
+        || fread(pixels, 3, WIDTH * HEIGHT, file) != WIDTH * HEIGHT) {
+        printf("Reading the snapshot: FAILED\n");
+        return 1;
+    }
+    fclose(file);
+    remove(fileName);
+    expectSnapshotPixel(pixels, 2, 2, BACKGROUND);
+    expectSnapshotPixel(pixels, 10, 10, FOREGROUND);
+    expectSnapshotPixel(pixels, 50, 18, FOREGROUND);
+    expectSnapshotPixel(pixels, 70, 40, CHILD_BACKGROUND);
+    expectSnapshotPixel(pixels, 90, 60, BACKGROUND);
+
+    XFreeGC(display, gc);
+    XDestroyWindow(display, window);
+    XCloseDisplay(display);
+    printf("%s\n", failures == 0 ? "Snapshot ok" : "Snapshot FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+/*
+move_window_benchmark.c
+Moves and restacks two overlapping child windows of a window and reports the time per frame and how
+many Expose events the client would have to redraw. Run it with SDL2X11_BACKEND=pixman, SDL2X11_COMPOSITOR=1
+and SDL2X11_STATISTICS=1 to compare the pixels composited per frame with the compositor.
+*/
+
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#define WIDTH 800
+#define HEIGHT 600
+#define CHILD_WIDTH 200
+#define CHILD_HEIGHT 150
+#define FRAMES 300
+
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static int countExposures(Display* display) {
+    XEvent event;
+    int exposures = 0;
+    while (XPending(display)) {
+        XNextEvent(display, &event);
+        exposures += event.type == Expose;
+    }
+    return exposures;
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    int screen = DefaultScreen(display);
+    Window window = XCreateSimpleWindow(display, RootWindow(display, screen), 0, 0, WIDTH, HEIGHT, 0,
+                                        BlackPixel(display, screen), 0x204060);
+    Window children[2];
+    int i, frame;
+    for (i = 0; i < 2; i++) {
+        children[i] = XCreateSimpleWindow(display, window, 100 * i, 50 * i, CHILD_WIDTH, CHILD_HEIGHT, 0,
+                                          BlackPixel(display, screen), i == 0 ? 0xC04020 : 0x20A040);
+        XSelectInput(display, children[i], ExposureMask);
+        XMapWindow(display, children[i]);
+    }
+    XSelectInput(display, window, ExposureMask);
+    XMapWindow(display, window);
+    GC gc = XCreateGC(display, window, 0, NULL);
+    XSetForeground(display, gc, 0xFFFFFF);
+    for (i = 0; i < 2; i++) {
+        XFillRectangle(display, children[i], gc, 10, 10, CHILD_WIDTH - 20, CHILD_HEIGHT - 20);
+    }
+    XSync(display, False);
+    countExposures(display);
+    int moveExposures = 0, restackExposures = 0;
+    double moveTime = 0, restackTime = 0;
+    for (frame = 0; frame < FRAMES; frame++) {
+        double start = now();
+        XMoveWindow(display, children[0], frame % (WIDTH - CHILD_WIDTH), (frame * 3) % (HEIGHT - CHILD_HEIGHT));
+        XSync(display, False);
+        moveTime += now() - start;
+        moveExposures += countExposures(display);
+        start = now();
+        XRaiseWindow(display, children[frame % 2]);
+        XSync(display, False);
+        restackTime += now() - start;
+        restackExposures += countExposures(display);
+    }
+    printf("Move:    %.3f ms per frame, %.1f exposures per frame\n", moveTime / FRAMES * 1000,
+           (double) moveExposures / FRAMES);
+    printf("Restack: %.3f ms per frame, %.1f exposures per frame\n", restackTime / FRAMES * 1000,
+           (double) restackExposures / FRAMES);
+    XFreeGC(display, gc);
+    XDestroyWindow(display, window);
+    XCloseDisplay(display);
+    return 0;
+}
@@ -0,0 +1,34 @@
+#ifndef _PIXEL_CHECKS_H_
+#define _PIXEL_CHECKS_H_
+
+/*
+ * Pixel checks of the self-checking tests. Every check that fails is printed and counted in
+ * failures, the test exits with 1 if any of them failed.
+ */
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+/* Check the color of a pixel that was read back, the position is only used for the message. */
+static inline void expectColor(unsigned long color, int x, int y, unsigned long expected, const char* name) {
+    if (color != expected) {
+        printf("%s: FAILED, pixel (%d, %d) is 0x%06lx instead of 0x%06lx\n", name, x, y, color, expected);
+        failures++;
+    }
+}
+
+/* Read a pixel of the drawable with XGetImage and check its color. */
+static inline void expectPixel(Display* display, Drawable drawable, int x, int y, unsigned long expected,
+                               const char* name) {
+    XImage* image = XGetImage(display, drawable, x, y, 1, 1, AllPlanes, ZPixmap);
+    unsigned long pixel = image == NULL ? ~expected : XGetPixel(image, 0, 0) & 0xFFFFFF;
+    if (image != NULL) {
+        XDestroyImage(image);
+    }
+    expectColor(pixel, x, y, expected, name);
+}
+
+#endif /* _PIXEL_CHECKS_H_ */
@@ -0,0 +1,149 @@
+/*
+pixel_kernels.c
+Converts image rows with every SIMD variant of the pixel conversion kernels the CPU supports
+and compares the results with the scalar kernels, for odd widths and unaligned rows.
+setPixelKernelLevel forces each variant like SDL2X11_PIXEL_KERNELS does.
+*/
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pixelConversion.h"
+#include "util.h"
+
+#define IMAGE_WIDTH 80
+#define HEIGHT 3
+/* The rows of the images start one byte after an aligned address. */
+#define MISALIGNMENT 1
+
+typedef struct {
+    const char* name;
+    int format;
+    int depth;
+    int bitsPerPixel;
+    unsigned long redMask;
+    unsigned long greenMask;
+    unsigned long blueMask;
+} ImageFormat;
+
+static const ImageFormat FORMATS[] = {
+    {"32 bpp ZPixmap", ZPixmap, 24, 32, 0xFF0000, 0x00FF00, 0x0000FF},
+    {"24 bpp ZPixmap", ZPixmap, 24, 24, 0xFF0000, 0x00FF00, 0x0000FF},
+    {"16 bpp 565 ZPixmap", ZPixmap, 16, 16, 0xF800, 0x07E0, 0x001F},
+    {"8 bpp ZPixmap", ZPixmap, 8, 8, 0, 0, 0},
+    {"1 bpp XYBitmap", XYBitmap, 1, 1, 0, 0, 0},
+};
+
+static const int WIDTHS[] = {1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 65, 67};
+static const int OFFSETS[] = {0, 1, 3, 5};
+
+static int failures = 0;
+
+static XImage* createImage(Display* display, const ImageFormat* format, char** buffer) {
+    XImage* image = XCreateImage(display, DefaultVisual(display, DefaultScreen(display)), format->depth,
+                                 format->format, 0, NULL, IMAGE_WIDTH, HEIGHT, 32, 0);
+    if (image == NULL) { return NULL; }
+    image->bits_per_pixel = format->bitsPerPixel;
+    image->bytes_per_line = (IMAGE_WIDTH * format->bitsPerPixel + 31) / 32 * 4;
+    *buffer = malloc((size_t) image->bytes_per_line * HEIGHT + MISALIGNMENT);
+    if (*buffer == NULL) {
+        XDestroyImage(image);
+        return NULL;
+    }
+    image->data = *buffer + MISALIGNMENT;
+    image->red_mask = format->redMask;
+    image->green_mask = format->greenMask;
+    image->blue_mask = format->blueMask;
+    int i;
+    for (i = 0; i < image->bytes_per_line * HEIGHT; i++) {
+        image->data[i] = (char) rand();
+    }
+    return image;
+}
+
+static void destroyImage(XImage* image, char* buffer) {
+    image->data = NULL;
+    XDestroyImage(image);
+    free(buffer);
+}
+
+/* Convert the rows with the scalar kernels and the kernels of the level and compare the results. */
+static void checkLevel(XImage* image, PixelKernelLevel level, const char* formatName) {
+    static Uint32 expected[IMAGE_WIDTH * HEIGHT + 1], actual[IMAGE_WIDTH * HEIGHT + 1];
+    static Uint32 source[IMAGE_WIDTH * HEIGHT + 1];
+    size_t dataSize = (size_t) image->bytes_per_line * HEIGHT;
+    char* originalData = malloc(dataSize);
+    char* expectedData = malloc(dataSize);
+    if (originalData == NULL || expectedData == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    memcpy(originalData, image->data, dataSize);
+    size_t i, j;
+    for (i = 0; i < ARRAY_LENGTH(source); i++) {
+        source[i] = (Uint32) rand() << 16 ^ (Uint32) rand();
+    }
+    for (i = 0; i < ARRAY_LENGTH(WIDTHS); i++) {
+        for (j = 0; j < ARRAY_LENGTH(OFFSETS); j++) {
+            int width = WIDTHS[i], x = OFFSETS[j];
+            // The destination and source pixels are not aligned to 16 bytes either.
+            int pitch = width * (int) sizeof(Uint32);
+            PixelConversion conversion;
+            memset(expected, 0, sizeof(expected));
+            memset(actual, 0, sizeof(actual));
+            setPixelKernelLevel(PIXEL_KERNELS_SCALAR);
+            initPixelConversion(&conversion, image, 0xFFFFFF, 0x000000, None);
+            convertImageToArgb(&conversion, image, x, 0, width, HEIGHT, expected + 1, pitch);
+            convertArgbToImage(&conversion, source + 1, pitch, image, x, 0, width, HEIGHT);
+            memcpy(expectedData, image->data, dataSize);
+            memcpy(image->data, originalData, dataSize);
+            setPixelKernelLevel(level);
+            initPixelConversion(&conversion, image, 0xFFFFFF, 0x000000, None);
+            convertImageToArgb(&conversion, image, x, 0, width, HEIGHT, actual + 1, pitch);
+            convertArgbToImage(&conversion, source + 1, pitch, image, x, 0, width, HEIGHT);
+            if (memcmp(expected, actual, sizeof(expected)) != 0) {
+                printf("%s %s: converting %d pixels at %d: FAILED\n", formatName,
+                       getPixelKernelLevelName(level), width, x);
+                failures++;
+            }
+            if (memcmp(expectedData, image->data, dataSize) != 0) {
+                printf("%s %s: writing %d pixels at %d: FAILED\n", formatName,
+                       getPixelKernelLevelName(level), width, x);
+                failures++;
+            }
+            memcpy(image->data, originalData, dataSize);
+        }
+    }
+    free(originalData);
+    free(expectedData);
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    srand(42);
+    size_t i;
+    int level, levels = 0;
+    for (i = 0; i < ARRAY_LENGTH(FORMATS); i++) {
+        char* buffer;
+        XImage* image = createImage(display, &FORMATS[i], &buffer);
+        if (image == NULL) {
+            fprintf(stderr, "Failed to create the %s image\n", FORMATS[i].name);
+            return 1;
+        }
+        for (level = PIXEL_KERNELS_SSE2; level <= PIXEL_KERNELS_NEON; level++) {
+            if (!setPixelKernelLevel((PixelKernelLevel) level)) { continue; }
+            checkLevel(image, (PixelKernelLevel) level, FORMATS[i].name);
+            levels += i == 0;
+        }
+        destroyImage(image, buffer);
+    }
+    XCloseDisplay(display);
+    printf("Compared %d SIMD variants with the scalar kernels: %s\n", levels, failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+/*
+put_image_benchmark.c
+Measures the throughput of the pixel conversion kernels for every image format
+XPutImage converts, with every SIMD variant the CPU supports, and of XPutImage
+into a pixmap with the selected variant.
+*/
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "pixelConversion.h"
+#include "util.h"
+
+#define WIDTH 1024
+#define HEIGHT 768
+#define ITERATIONS 50
+
+typedef struct {
+    const char* name;
+    int format;
+    int depth;
+    int bitsPerPixel;
+    unsigned long redMask;
+    unsigned long greenMask;
+    unsigned long blueMask;
+} ImageFormat;
+
+static const ImageFormat FORMATS[] = {
+    {"32 bpp ZPixmap", ZPixmap, 24, 32, 0xFF0000, 0x00FF00, 0x0000FF},
+    {"24 bpp ZPixmap", ZPixmap, 24, 24, 0xFF0000, 0x00FF00, 0x0000FF},
+    {"16 bpp 565 ZPixmap", ZPixmap, 16, 16, 0xF800, 0x07E0, 0x001F},
+    {"8 bpp ZPixmap", ZPixmap, 8, 8, 0, 0, 0},
+    {"1 bpp XYBitmap", XYBitmap, 1, 1, 0, 0, 0},
+};
+
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static XImage* createImage(Display* display, const ImageFormat* format) {
+    XImage* image = XCreateImage(display, DefaultVisual(display, DefaultScreen(display)), format->depth,
+                                 format->format, 0, NULL, WIDTH, HEIGHT, 32, 0);
+    if (image == NULL) { return NULL; }
+    // XCreateImage chooses the bits per pixel from the depth, 24 bpp images are packed.
+    image->bits_per_pixel = format->bitsPerPixel;
+    image->bytes_per_line = (WIDTH * format->bitsPerPixel + 31) / 32 * 4;
+    image->data = malloc((size_t) image->bytes_per_line * HEIGHT);
+    if (image->data == NULL) {
+        XDestroyImage(image);
+        return NULL;
+    }
+    image->red_mask = format->redMask;
+    image->green_mask = format->greenMask;
+    image->blue_mask = format->blueMask;
+    int i;
+    for (i = 0; i < image->bytes_per_line * HEIGHT; i++) {
+        image->data[i] = (char) rand();
+    }
+    return image;
+}
+
+static double megabytesPerSecond(const XImage* image, double seconds) {
+    return (double) image->bytes_per_line * HEIGHT * ITERATIONS / seconds / (1024 * 1024);
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    Window root = DefaultRootWindow(display);
+    Pixmap pixmap = XCreatePixmap(display, root, WIDTH, HEIGHT, DefaultDepth(display, DefaultScreen(display)));
+    GC gc = XCreateGC(display, pixmap, 0, NULL);
+    Uint32* pixels = malloc(sizeof(Uint32) * WIDTH * HEIGHT);
+    if (pixels == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    PixelKernelLevel defaultLevel = getPixelKernelLevel();
+    size_t i;
+    int level, iteration;
+    for (i = 0; i < ARRAY_LENGTH(FORMATS); i++) {
+        XImage* image = createImage(display, &FORMATS[i]);
+        if (image == NULL) {
+            fprintf(stderr, "Failed to create the %s image\n", FORMATS[i].name);
+            return 1;
+        }
+        for (level = PIXEL_KERNELS_SCALAR; level <= PIXEL_KERNELS_NEON; level++) {
+            if (!setPixelKernelLevel((PixelKernelLevel) level)) { continue; }
+            PixelConversion conversion;
+            if (!initPixelConversion(&conversion, image, 0xFFFFFF, 0x000000, None)) {
+                fprintf(stderr, "No conversion for the %s image\n", FORMATS[i].name);
+                return 1;
+            }
+            double start = now();
+            for (iteration = 0; iteration < ITERATIONS; iteration++) {
+                convertImageToArgb(&conversion, image, 0, 0, WIDTH, HEIGHT, pixels, WIDTH * sizeof(Uint32));
+            }
+            printf("%-20s %-6s %8.1f MB/s (%s)\n", FORMATS[i].name, getPixelKernelLevelName((PixelKernelLevel) level),
+                   megabytesPerSecond(image, now() - start), conversion.name);
+        }
+        setPixelKernelLevel(defaultLevel);
+        double start = now();
+        for (iteration = 0; iteration < ITERATIONS; iteration++) {
+            XPutImage(display, pixmap, gc, image, 0, 0, 0, 0, WIDTH, HEIGHT);
+        }
+        XSync(display, False);
+        printf("%-20s XPutImage %8.1f MB/s\n", FORMATS[i].name, megabytesPerSecond(image, now() - start));
+        XDestroyImage(image);
+    }
+    free(pixels);
+    XFreeGC(display, gc);
+    XFreePixmap(display, pixmap);
+    XCloseDisplay(display);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+raster_op.c
+Draws with raster operations and plane masks into a pixmap and checks the resulting pixels with XGetImage:
+filling twice with GXxor restores the content, the corners of outlines and the joints of lines are only
+changed once, and copies combine the source with the destination. A child window must combine with its own
+pixels and not with the ones of its parent.
+*/
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <stdio.h>
+#include "pixel_checks.h"
+
+#define SIZE 64
+#define BACKGROUND 0x336699
+#define XOR_BACKGROUND (BACKGROUND ^ 0xFFFFFF)
+
+static void reset(Display* display, Drawable drawable, GC gc) {
+    XSetFunction(display, gc, GXcopy);
+    XSetPlaneMask(display, gc, AllPlanes);
+    XSetForeground(display, gc, BACKGROUND);
+    XFillRectangle(display, drawable, gc, 0, 0, SIZE, SIZE);
+    XSetForeground(display, gc, 0xFFFFFF);
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    int depth = DefaultDepth(display, DefaultScreen(display));
+    Pixmap pixmap = XCreatePixmap(display, DefaultRootWindow(display), SIZE, SIZE, depth);
+    GC gc = XCreateGC(display, pixmap, 0, NULL);
+
+    reset(display, pixmap, gc);
+    XSetFunction(display, gc, GXxor);
+    XFillRectangle(display, pixmap, gc, 10, 10, 20, 20);
+    expectPixel(display, pixmap, 15, 15, XOR_BACKGROUND, "Fill with GXxor");
+    expectPixel(display, pixmap, 5, 5, BACKGROUND, "Fill with GXxor");
+    XFillRectangle(display, pixmap, gc, 10, 10, 20, 20);
+    expectPixel(display, pixmap, 15, 15, BACKGROUND, "Fill twice with GXxor");
+
+    reset(display, pixmap, gc);
+    XSetFunction(display, gc, GXinvert);
+    XSetPlaneMask(display, gc, 0x00FF00);
+    XFillRectangle(display, pixmap, gc, 0, 0, SIZE, SIZE);
+    expectPixel(display, pixmap, 20, 20, BACKGROUND ^ 0x00FF00, "Fill with GXinvert and a plane mask");
+
+    reset(display, pixmap, gc);
+    XSetFunction(display, gc, GXxor);
+    XDrawRectangle(display, pixmap, gc, 10, 10, 30, 20);
+    expectPixel(display, pixmap, 10, 10, XOR_BACKGROUND, "Outline with GXxor");
+    expectPixel(display, pixmap, 20, 10, XOR_BACKGROUND, "Outline with GXxor");
+    expectPixel(display, pixmap, 20, 20, BACKGROUND, "Outline with GXxor");
+    XDrawRectangle(display, pixmap, gc, 10, 10, 30, 20);
+    expectPixel(display, pixmap, 10, 10, BACKGROUND, "Outline twice with GXxor");
+
+    reset(display, pixmap, gc);
+    XSetFunction(display, gc, GXxor);
+    XPoint points[] = {{5, 5}, {30, 5}, {30, 30}};
+    XDrawLines(display, pixmap, gc, points, 3, CoordModeOrigin);
+    expectPixel(display, pixmap, 30, 5, XOR_BACKGROUND, "Joint of lines with GXxor");
+    expectPixel(display, pixmap, 30, 30, XOR_BACKGROUND, "End of lines with GXxor");
+
+    Pixmap source = XCreatePixmap(display, DefaultRootWindow(display), SIZE, SIZE, depth);
+    XSetFunction(display, gc, GXcopy);
+    XSetForeground(display, gc, 0x0F0F0F);
+    XFillRectangle(display, source, gc, 0, 0, SIZE, SIZE);
+    reset(display, pixmap, gc);
+    XSetFunction(display, gc, GXand);
+    XCopyArea(display, source, pixmap, gc, 0, 0, SIZE / 2, SIZE / 2, 0, 0);
+    expectPixel(display, pixmap, 10, 10, BACKGROUND & 0x0F0F0F, "Copy with GXand");
+    expectPixel(display, pixmap, 40, 40, BACKGROUND, "Copy with GXand");
+    XSetFunction(display, gc, GXor);
+    XCopyArea(display, pixmap, pixmap, gc, 0, 0, SIZE / 2, SIZE / 2, SIZE / 2, SIZE / 2);
+    expectPixel(display, pixmap, 40, 40, BACKGROUND | (BACKGROUND & 0x0F0F0F), "Copy within a pixmap with GXor");
+    XFreePixmap(display, source);
+
+    // The child window is drawn into its parent at an offset.
+    int screen = DefaultScreen(display);
+    Window window = XCreateSimpleWindow(display, RootWindow(display, screen), 0, 0, SIZE + 24, SIZE + 16, 0,
+                                        BlackPixel(display, screen), 0x000000);
+    Window child = XCreateSimpleWindow(display, window, 24, 16, SIZE, SIZE, 0,
+                                       BlackPixel(display, screen), BACKGROUND);
+    XSetWindowAttributes attributes;
+    attributes.override_redirect = True;
+    XChangeWindowAttributes(display, window, CWOverrideRedirect, &attributes);
+    XMapWindow(display, window);
+    XMapWindow(display, child);
+    XSync(display, False);
+    reset(display, child, gc);
+    XSetFunction(display, gc, GXxor);
+    XFillRectangle(display, child, gc, 10, 10, 20, 20);
+    XSync(display, False);
+    expectPixel(display, child, 15, 15, XOR_BACKGROUND, "Fill a child window with GXxor");
+    expectPixel(display, child, 5, 5, BACKGROUND, "Fill a child window with GXxor");
+    expectPixel(display, window, 15, 15, 0x000000, "Fill a child window with GXxor");
+    XDestroyWindow(display, window);
+
+    XFreeGC(display, gc);
+    XFreePixmap(display, pixmap);
+    XCloseDisplay(display);
+    printf("%s\n", failures == 0 ? "All raster operations ok" : "Some raster operations FAILED");
+    return failures == 0 ? 0 : 1;
+}
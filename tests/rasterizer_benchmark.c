@@ -0,0 +1,125 @@
+/*
+rasterizer_benchmark.c
+Measures how many polygons and arcs per second the scanline rasterizer converts into spans,
+and how many XFillPolygon, XFillArc and XDrawArc can draw into a pixmap.
+*/
+
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "rasterizer.h"
+
+#define WIDTH 1024
+#define HEIGHT 768
+#define SHAPES 2000
+#define POLYGON_POINTS 12
+
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static XPoint polygons[SHAPES][POLYGON_POINTS];
+static XArc arcs[SHAPES];
+
+static void createShapes() {
+    int i, j;
+    srand(42);
+    for (i = 0; i < SHAPES; i++) {
+        int x = rand() % (WIDTH - 200), y = rand() % (HEIGHT - 200);
+        for (j = 0; j < POLYGON_POINTS; j++) {
+            polygons[i][j].x = (short) (x + rand() % 200);
+            polygons[i][j].y = (short) (y + rand() % 200);
+        }
+        arcs[i].x = (short) x;
+        arcs[i].y = (short) y;
+        arcs[i].width = (unsigned short) (20 + rand() % 180);
+        arcs[i].height = (unsigned short) (20 + rand() % 180);
+        arcs[i].angle1 = (short) (rand() % (360 * 64));
+        arcs[i].angle2 = (short) (rand() % (360 * 64));
+    }
+}
+
+typedef enum { POLYGON, PIE_SLICE, CHORD, THIN_ARC, WIDE_ARC } ShapeKind;
+
+static const char* SHAPE_NAMES[] = {"Polygon", "Pie slice", "Chord", "Thin arc", "Wide arc"};
+
+static void rasterizeShape(SpanBuffer* spans, ShapeKind kind, int i) {
+    XArc* arc = &arcs[i];
+    switch (kind) {
+        case POLYGON:
+            fillPolygonSpans(spans, polygons[i], POLYGON_POINTS, i % 2 ? WindingRule : EvenOddRule);
+            break;
+        case PIE_SLICE:
+        case CHORD:
+            fillArcSpans(spans, arc->x, arc->y, arc->width, arc->height, arc->angle1, arc->angle2,
+                         kind == PIE_SLICE ? ArcPieSlice : ArcChord);
+            break;
+        case THIN_ARC:
+        case WIDE_ARC:
+            strokeArcSpans(spans, arc->x, arc->y, arc->width, arc->height, arc->angle1, arc->angle2,
+                           kind == THIN_ARC ? 0 : 8);
+            break;
+    }
+}
+
+static void drawShape(Display* display, Pixmap pixmap, GC gc, ShapeKind kind, int i) {
+    XArc* arc = &arcs[i];
+    switch (kind) {
+        case POLYGON:
+            XSetFillRule(display, gc, i % 2 ? WindingRule : EvenOddRule);
+            XFillPolygon(display, pixmap, gc, polygons[i], POLYGON_POINTS, Complex, CoordModeOrigin);
+            break;
+        case PIE_SLICE:
+        case CHORD:
+            XSetArcMode(display, gc, kind == PIE_SLICE ? ArcPieSlice : ArcChord);
+            XFillArc(display, pixmap, gc, arc->x, arc->y, arc->width, arc->height, arc->angle1, arc->angle2);
+            break;
+        case THIN_ARC:
+        case WIDE_ARC:
+            XSetLineAttributes(display, gc, kind == THIN_ARC ? 0 : 8, LineSolid, CapButt, JoinMiter);
+            XDrawArc(display, pixmap, gc, arc->x, arc->y, arc->width, arc->height, arc->angle1, arc->angle2);
+            break;
+    }
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    Pixmap pixmap = XCreatePixmap(display, DefaultRootWindow(display), WIDTH, HEIGHT,
+                                  DefaultDepth(display, DefaultScreen(display)));
+    GC gc = XCreateGC(display, pixmap, 0, NULL);
+    XSetForeground(display, gc, 0x3366CC);
+    createShapes();
+    SDL_Rect clip = {0, 0, WIDTH, HEIGHT};
+    int kind, i;
+    for (kind = POLYGON; kind <= WIDE_ARC; kind++) {
+        unsigned long rectangles = 0;
+        double start = now();
+        for (i = 0; i < SHAPES; i++) {
+            SpanBuffer spans;
+            initSpanBuffer(&spans, &clip);
+            rasterizeShape(&spans, (ShapeKind) kind, i);
+            rectangles += (unsigned long) spans.numRectangles;
+            freeSpanBuffer(&spans);
+        }
+        double rasterizeTime = now() - start;
+        start = now();
+        for (i = 0; i < SHAPES; i++) {
+            drawShape(display, pixmap, gc, (ShapeKind) kind, i);
+        }
+        XSync(display, False);
+        double drawTime = now() - start;
+        printf("%-10s rasterized %10.0f/s (%5.1f rectangles each), drawn %10.0f/s\n", SHAPE_NAMES[kind],
+               SHAPES / rasterizeTime, (double) rectangles / SHAPES, SHAPES / drawTime);
+    }
+    XFreeGC(display, gc);
+    XFreePixmap(display, pixmap);
+    XCloseDisplay(display);
+    return 0;
+}
@@ -0,0 +1,120 @@
+/*
+shm_image.c
+Pushes 1080p frames from a shared memory segment into a pixmap with XShmPutImage, waits for
+the completion event, and reads a part back into a second segment with XShmGetImage.
+*/
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <stdio.h>
+#include <time.h>
+
+#define WIDTH 1920
+#define HEIGHT 1080
+#define FRAMES 30
+#define READ_WIDTH 320
+#define READ_HEIGHT 200
+
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static unsigned long getTestPixel(int x, int y, int frame) {
+    return (unsigned long) ((x & 0xFF) << 16 | (y & 0xFF) << 8 | (frame & 0xFF));
+}
+
+static XImage* createShmImage(Display* display, XShmSegmentInfo* shminfo, int width, int height) {
+    int screen = DefaultScreen(display);
+    XImage* image = XShmCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen),
+                                    ZPixmap, NULL, shminfo, width, height);
+    if (image == NULL) { return NULL; }
+    shminfo->shmid = shmget(IPC_PRIVATE, (size_t) image->bytes_per_line * height, IPC_CREAT | 0600);
+    if (shminfo->shmid < 0) {
+        XDestroyImage(image);
+        return NULL;
+    }
+    shminfo->shmaddr = image->data = shmat(shminfo->shmid, NULL, 0);
+    shminfo->readOnly = False;
+    if (shminfo->shmaddr == (char*) -1 || !XShmAttach(display, shminfo)) {
+        shmctl(shminfo->shmid, IPC_RMID, NULL);
+        XDestroyImage(image);
+        return NULL;
+    }
+    XSync(display, False);
+    // The segment is freed as soon as both sides have detached it.
+    shmctl(shminfo->shmid, IPC_RMID, NULL);
+    return image;
+}
+
+static void destroyShmImage(Display* display, XShmSegmentInfo* shminfo, XImage* image) {
+    XShmDetach(display, shminfo);
+    XDestroyImage(image);
+    shmdt(shminfo->shmaddr);
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    if (!XShmQueryExtension(display)) {
+        fprintf(stderr, "The MIT-SHM extension is not available\n");
+        return 1;
+    }
+    int screen = DefaultScreen(display);
+    Pixmap pixmap = XCreatePixmap(display, RootWindow(display, screen), WIDTH, HEIGHT,
+                                  DefaultDepth(display, screen));
+    GC gc = XCreateGC(display, pixmap, 0, NULL);
+    XShmSegmentInfo frameInfo, readInfo;
+    XImage* frame = createShmImage(display, &frameInfo, WIDTH, HEIGHT);
+    XImage* readBack = createShmImage(display, &readInfo, READ_WIDTH, READ_HEIGHT);
+    if (frame == NULL || readBack == NULL) {
+        fprintf(stderr, "Failed to create the shared images\n");
+        return 1;
+    }
+    int completionType = XShmGetEventBase(display) + ShmCompletion;
+    int x, y, i, errors = 0;
+    double pushTime = 0;
+    for (i = 0; i < FRAMES; i++) {
+        for (y = 0; y < HEIGHT; y++) {
+            for (x = 0; x < WIDTH; x++) {
+                XPutPixel(frame, x, y, getTestPixel(x, y, i));
+            }
+        }
+        double start = now();
+        XShmPutImage(display, pixmap, gc, frame, 0, 0, 0, 0, WIDTH, HEIGHT, True);
+        XEvent event;
+        XNextEvent(display, &event);
+        pushTime += now() - start;
+        if (event.type != completionType) {
+            printf("Got event %d instead of the completion event\n", event.type);
+            errors++;
+        }
+    }
+    printf("1080p frame push: %.3f ms\n", pushTime / FRAMES * 1000);
+
+    XShmGetImage(display, pixmap, readBack, 100, 50, AllPlanes);
+    for (y = 0; y < READ_HEIGHT; y++) {
+        for (x = 0; x < READ_WIDTH; x++) {
+            unsigned long pixel = XGetPixel(readBack, x, y) & 0xFFFFFF;
+            unsigned long expected = getTestPixel(100 + x, 50 + y, FRAMES - 1);
+            if (pixel != expected && errors++ < 5) {
+                printf("Pixel %d, %d is %06lx, expected %06lx\n", x, y, pixel, expected);
+            }
+        }
+    }
+    printf("XShmGetImage: %s\n", errors == 0 ? "OK" : "FAILED");
+
+    destroyShmImage(display, &readInfo, readBack);
+    destroyShmImage(display, &frameInfo, frame);
+    XFreeGC(display, gc);
+    XFreePixmap(display, pixmap);
+    XCloseDisplay(display);
+    return errors == 0 ? 0 : 1;
+}
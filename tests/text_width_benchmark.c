@@ -0,0 +1,72 @@
+/*
+text_width_benchmark.c
+Compares measuring text with XTextWidth, which sums up the metrics tables of the font,
+against measuring the same text with TTF_SizeUTF8.
+Run it from a directory that contains fonts/FreeMono.ttf.
+*/
+
+#include <X11/Xlib.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ITERATIONS 100000
+#define FONT_PATH "fonts/FreeMono.ttf"
+#define FONT_SIZE 12
+
+static const char* SAMPLE_TEXTS[] = {
+    "OK",
+    "Cancel",
+    "The quick brown fox jumps over the lazy dog",
+    "Gr\xc3\xb6\xc3\x9f" "e \xc3\xa4ndern: \xc3\x84\xc3\x96\xc3\x9c \xe2\x82\xac 1.234,56",
+};
+
+static double nanosecondsPerCall(Uint64 start, Uint64 end) {
+    return (double) (end - start) * 1e9 / (double) SDL_GetPerformanceFrequency() / ITERATIONS;
+}
+
+int main() {
+    Display* display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        fprintf(stderr, "Failed to open the display\n");
+        return 1;
+    }
+    XFontStruct* fontStruct = XLoadQueryFont(display, "fixed");
+    TTF_Font* font = TTF_OpenFont(FONT_PATH, FONT_SIZE);
+    if (fontStruct == NULL || font == NULL) {
+        fprintf(stderr, "Failed to load %s\n", FONT_PATH);
+        return 1;
+    }
+    volatile int sink = 0;
+    size_t i;
+    int iteration;
+    for (i = 0; i < sizeof(SAMPLE_TEXTS) / sizeof(SAMPLE_TEXTS[0]); i++) {
+        const char* text = SAMPLE_TEXTS[i];
+        int length = (int) strlen(text);
+        int tableWidth = XTextWidth(fontStruct, text, length);
+        int ttfWidth = 0;
+        TTF_SizeUTF8(font, text, &ttfWidth, NULL);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (iteration = 0; iteration < ITERATIONS; iteration++) {
+            sink += XTextWidth(fontStruct, text, length);
+        }
+        double tableTime = nanosecondsPerCall(start, SDL_GetPerformanceCounter());
+
+        start = SDL_GetPerformanceCounter();
+        for (iteration = 0; iteration < ITERATIONS; iteration++) {
+            int width;
+            TTF_SizeUTF8(font, text, &width, NULL);
+            sink += width;
+        }
+        double ttfTime = nanosecondsPerCall(start, SDL_GetPerformanceCounter());
+
+        printf("%2d characters: XTextWidth %8.1f ns (width %4d), TTF_SizeUTF8 %8.1f ns (width %4d), %5.1fx\n",
+               length, tableTime, tableWidth, ttfTime, ttfWidth, ttfTime / tableTime);
+    }
+    TTF_CloseFont(font);
+    XFreeFont(display, fontStruct);
+    XCloseDisplay(display);
+    return 0;
+}